@@ -48,6 +48,34 @@ Plane new_plane(float3 n, float d) {
     return plane;
 }
 
+// 量子化した頂点を元に戻すための情報
+struct VertexDecode {
+    float3 position_offset;  // 位置に足す値
+    uint normal_encoding;  // 0:そのまま、1:八面体
+    float3 position_scale;  // 位置に掛ける値
+    float _position_scale;
+};
+
+// 八面体に写した法線を元に戻す
+float3 decode_octahedral(float2 e) {
+    float3 n = float3(e, 1.f - abs(e.x) - abs(e.y));
+    const float t = max(-n.z, 0.f);
+    n.x += n.x >= 0.f ? -t : t;
+    n.y += n.y >= 0.f ? -t : t;
+    return normalize(n);
+}
+
+// 頂点の位置を元に戻す
+float3 decode_position(VertexDecode decode, float3 position) {
+    return decode.position_offset + position * decode.position_scale;
+}
+
+// 頂点の法線を元に戻す
+// 八面体のときはxyだけを使う
+float3 decode_normal(VertexDecode decode, float3 normal) {
+    return decode.normal_encoding != 0 ? decode_octahedral(normal.xy) : normal;
+}
+
 // push constant
 struct PushConstant {
     uint draw_id;
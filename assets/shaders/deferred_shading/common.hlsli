@@ -26,4 +26,6 @@ cbuffer SceneConstant : register(b7) {
 // テクニックの定数
 cbuffer TechConstant : register(b15) {
     int MODE;  // 表示するモード
+    int3 _pad;
+    float2 UV_SCALE;  // 描画した範囲が占めるテクスチャ座標の割合
 };
@@ -34,7 +34,8 @@ void main(in PSInput i, out PSOutput o) {
   const uint draw_id = G.draw_id;  // 0番
 
   // 深度を取り出す
-  const float2 texcoord = i.position_ndc.xy * 0.5f + float2(0.5f, 0.5f);
+  // Gバッファは内部解像度の範囲にしか描画されていないので、その範囲に収める
+  const float2 texcoord = (i.position_ndc.xy * 0.5f + float2(0.5f, 0.5f)) * UV_SCALE;
   const float depth = DEPTH.Sample(SAMPLER, texcoord);
 
   // シェーディングしなくてもよいならば、早めに脱出する
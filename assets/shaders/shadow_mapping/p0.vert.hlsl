@@ -18,10 +18,15 @@ struct VSOutput {
 
 // t
 [[vk::binding(0)]] StructuredBuffer<ShadowCaster> SHADOW_CASTERS : register(t0);
+[[vk::binding(7)]] StructuredBuffer<VertexDecode> VERTEX_DECODES : register(t7);
 
 void main(in VSInput i, out VSOutput o) {
+  // 頂点を元に戻す
+  const VertexDecode decode = VERTEX_DECODES[G.draw_id];
+  const float3 position_w = decode_position(decode, i.position);
+
   const float4x4 view_proj = SHADOW_CASTERS[SHADOW_CASTER_INDEX].view_proj;
-  float4 position_c = mul(float4(i.position, 1.f), view_proj);
+  float4 position_c = mul(float4(position_w, 1.f), view_proj);
 
   o.position = position_c;
 }
@@ -24,11 +24,17 @@ struct VSOutput {
 
 // t
 [[vk::binding(3)]] StructuredBuffer<ShadowCaster> SHADOW_CASTERS : register(t3);
+[[vk::binding(7)]] StructuredBuffer<VertexDecode> VERTEX_DECODES : register(t7);
 
 void main(in VSInput i, out VSOutput o) {
-  const float4 position_c = mul(float4(i.position, 1.f), CAMERA.view_proj);
+  // 頂点を元に戻す
+  const VertexDecode decode = VERTEX_DECODES[G.draw_id];
+  const float3 position_w = decode_position(decode, i.position);
+  const float3 normal_w = decode_normal(decode, i.normal);
+
+  const float4 position_c = mul(float4(position_w, 1.f), CAMERA.view_proj);
 
   o.position = position_c;
-  o.position_w = i.position;
-  o.normal_w = i.normal;
+  o.position_w = position_w;
+  o.normal_w = normal_w;
 }
@@ -17,6 +17,13 @@ struct VSOutput {
 // b
 [[vk::binding(0)]] ConstantBuffer<Camera> CAMERA : register(b0);
 
+// t
+[[vk::binding(7)]] StructuredBuffer<VertexDecode> VERTEX_DECODES : register(t7);
+
 void main(in VSInput i, out VSOutput o) {
-    o.position = mul(float4(i.position, 1.f), CAMERA.view_proj);
+    // 頂点を元に戻す
+    const VertexDecode decode = VERTEX_DECODES[G.draw_id];
+    const float3 position_w = decode_position(decode, i.position);
+
+    o.position = mul(float4(position_w, 1.f), CAMERA.view_proj);
 }
@@ -18,8 +18,12 @@ struct PSOutput {
 // t
 [[vk::binding(8)]] Texture2D<float4> RT0 : register(t8);
 
+// s
+SamplerState SAMPLER : register(s8);
+
 void main(in PSInput i, out PSOutput o) {
     uint2 size;
     RT0.GetDimensions(size.x, size.y);
-    o.frag_color = RT0.Load(int3(i.texcoord * size, 0));
+    // 内部解像度で描画した範囲だけを画面全体に拡大する
+    o.frag_color = RT0.Sample(SAMPLER, i.texcoord * (float2(PIXEL_COUNT) / float2(size)));
 }
@@ -23,16 +23,24 @@ struct VSOutput {
 // b
 [[vk::binding(0)]] ConstantBuffer<Camera> CAMERA : register(b0);
 
+// t
+[[vk::binding(7)]] StructuredBuffer<VertexDecode> VERTEX_DECODES : register(t7);
+
 void main(in VSInput i, out VSOutput o) {
+  // 頂点を元に戻す
+  const VertexDecode decode = VERTEX_DECODES[G.draw_id];
+  const float3 position_w = decode_position(decode, i.position);
+  const float3 normal_w = decode_normal(decode, i.normal);
+
   // 各空間の位置を計算する
-  float3 position_v = mul(float4(i.position, 1.f), CAMERA.view).xyz;
-  float4 position_ch = mul(float4(i.position, 1.f), CAMERA.view_proj);
+  float3 position_v = mul(float4(position_w, 1.f), CAMERA.view).xyz;
+  float4 position_ch = mul(float4(position_w, 1.f), CAMERA.view_proj);
   float3 position_c = position_ch.xyz / position_ch.w;
 
   // 出力する
   o.position = position_ch;
-  o.position_w = i.position;
-  o.normal_w = i.normal;
+  o.position_w = position_w;
+  o.normal_w = normal_w;
   o.position_v = position_v;
   o.position_ch = position_ch;
 }
@@ -1,13 +1,22 @@
 #pragma once
 
+#include <atomic>
+#include <future>
 #include <memory>
 #include <map>
 #include <string>
 #include <cstdint>
+#include <chrono>
 #ifdef WIN32
 #include <Windows.h>
 #endif
 #include <GLFW/glfw3.h>
+#include "frame_stats.hpp"
+#include "frame_pipeline.hpp"
+#include "thread_pool.hpp"
+#include "technique_cache.hpp"
+#include "dynamic_resolution.hpp"
+#include "frame_limiter.hpp"
 
 namespace rtdemo {
 class Scene;
@@ -32,6 +41,20 @@ class Application final {
    */
   bool init(size_t screen_width, size_t screen_height);
 
+  /**
+   * @brief ウィンドウを持たないオフスクリーン環境で初期化する
+   * 
+   * EGLのsurfacelessプラットフォームでコンテキストを生成し、
+   * バックバッファとしてpbufferを用意する。GUIは初期化しない。
+   * GLの呼び出し先に何もしないバックエンドを選んでいれば、コンテキストも生成しない。
+   * 
+   * @param screen_width バックバッファの幅
+   * @param screen_height バックバッファの高さ
+   * @return true 成功した
+   * @return false 失敗した
+   */
+  bool init_headless(size_t screen_width, size_t screen_height);
+
   /**
    * @brief 破棄する
    */
@@ -45,6 +68,37 @@ class Application final {
    */
   bool update();
 
+  /**
+   * @brief 現在のシーンとテクニックで1フレーム分を描画する
+   * 
+   * ワーカースレッドが作ったパケットをGPUに転送して描画し、次のフレームの更新をワーカースレッドで始める。
+   * GUIの更新と描画は含まない。
+   */
+  void render();
+
+  /**
+   * @brief 描画結果をバックバッファに表示する
+   */
+  void present();
+
+  /**
+   * @brief 現在のシーンを切り替える
+   * 
+   * @param name シーン名
+   * @return true 成功した
+   * @return false 失敗した
+   */
+  bool select_scene(const std::string& name);
+
+  /**
+   * @brief 現在のテクニックを切り替える
+   * 
+   * @param name テクニック名
+   * @return true 成功した
+   * @return false 失敗した
+   */
+  bool select_technique(const std::string& name);
+
   /**
    * @brief 一覧にシーンを登録する
    * 
@@ -73,13 +127,110 @@ class Application final {
     return screen_height_;
   }
 
+  bool is_headless() const noexcept {
+    return headless_;
+  }
+
+  /**
+   * @brief update()ごとに計測したフレーム時間の統計を取得する
+   */
+  const FrameStats& frame_stats() const noexcept {
+    return frame_stats_;
+  }
+
+  FrameStats& frame_stats() noexcept {
+    return frame_stats_;
+  }
+
+  /**
+   * @brief テクニックの内部解像度を選ぶ仕組みを取得する
+   */
+  DynamicResolution& dynamic_resolution() noexcept {
+    return dynamic_resolution_;
+  }
+
+  /**
+   * @brief GPUに積まれるフレームの数を制限する仕組みを取得する
+   */
+  FrameLimiter& frame_limiter() noexcept {
+    return frame_limiter_;
+  }
+
  private:
   using SceneMap = std::map<std::string, std::shared_ptr<Scene>>;
   using TechniqueMap = std::map<std::string, std::shared_ptr<Technique>>;
 
+  static constexpr size_t LOADER_THREAD_COUNT = 2;  ///< シーンを読み込むスレッドの数
+  static constexpr size_t UPLOAD_RING_FRAME_SIZE = 1 << 20;  ///< 1フレームで書き換えられる定数とSSBOの大きさ[byte]
+  static constexpr size_t GUI_TOP_GL_CALL_COUNT = 5;  ///< GUIに表示する、呼び出し回数の多いGLの関数の数
+
+  /**
+   * @brief EGLのsurfacelessプラットフォームでコンテキストを生成し、GLEWを初期化する
+   * 
+   * @param screen_width pbufferの幅
+   * @param screen_height pbufferの高さ
+   * @return true 成功した
+   * @return false 失敗した
+   */
+  bool create_egl_context(size_t screen_width, size_t screen_height);
+
+  /**
+   * @brief 現在のシーンを切り替える
+   */
+  bool select_scene(SceneMap::const_iterator iter);
+
+  /**
+   * @brief シーンをローダースレッドで読み込み始める
+   * 
+   * 読み込みが終わるまでは、今のシーンを描画し続ける。
+   * 
+   * @return true 読み込みを開始した
+   * @return false すでに読み込み中か、選択中のシーンだった
+   */
+  bool request_scene(SceneMap::const_iterator iter);
+
+  /**
+   * @brief 読み込みが終わっていれば、シーンを切り替える
+   */
+  void update_loading();
+
+  /**
+   * @brief 読み込み中のシーンがあれば、読み込みが終わるまで待って切り替える
+   */
+  void wait_loading();
+
+  /**
+   * @brief 現在のテクニックを切り替える
+   * 
+   * 古いテクニックのリソースはTechniqueCacheに残す。
+   */
+  bool select_technique(TechniqueMap::const_iterator iter);
+
+  /**
+   * @brief 現在のシーンとテクニックで描画して、ドライバにシェーダのコンパイルを済ませさせる
+   */
+  void warm_up();
+
+  /**
+   * @brief 現在の内部解像度を含むフレームの大きさを取得する
+   */
+  FrameSize frame_size() const noexcept;
+
   GLFWwindow* window_ = nullptr;  ///< ウィンドウハンドル
+  bool headless_ = false;  ///< オフスクリーンで動作しているか
+  void* egl_display_ = nullptr;  ///< EGLDisplay
+  void* egl_context_ = nullptr;  ///< EGLContext
+  void* egl_surface_ = nullptr;  ///< EGLSurface(pbuffer)
   uint32_t screen_width_ = 0;  ///< バックバッファの幅
   uint32_t screen_height_ = 0;  ///< バックバッファの高さ
+  FrameStats frame_stats_;  ///< フレーム時間の統計
+  FramePipeline frame_pipeline_;  ///< シーンの更新とGLへの発行のパイプライン
+  ThreadPool loader_pool_;  ///< シーンを読み込むスレッド
+  TechniqueCache technique_cache_;  ///< 最近使ったテクニック
+  DynamicResolution dynamic_resolution_;  ///< GPU時間から内部解像度を選ぶ
+  uint64_t last_resolved_frame_index_ = 0;  ///< 内部解像度の選択に使った最後のGPU計測結果
+  FrameLimiter frame_limiter_;  ///< GPUに積まれるフレームの数を制限する
+  std::chrono::steady_clock::time_point last_frame_tp_;  ///< 前回update()を呼び出した時刻
 
   // 実体
   SceneMap scene_map_;  ///< シーンを名前で検索するためのマップ
@@ -88,5 +239,11 @@ class Application final {
   // 更新や表示を行う対象
   SceneMap::const_iterator current_scene_;  ///< 現在のシーン
   TechniqueMap::const_iterator current_technique_;  ///< 現在のテクニック
+  std::string technique_tag_;  ///< 現在のテクニックのResourceTrackerのタグ。毎フレーム作らないように残す
+
+  // 読み込み中のシーン
+  SceneMap::const_iterator loading_scene_;  ///< 読み込み中のシーン。なければscene_map_.end()
+  std::future<bool> loading_future_;  ///< Scene::loadの結果
+  std::atomic<float> loading_progress_{0.f};  ///< 読み込みの進捗
 };
 }  // namespace rtdemo
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include "frame_stats.hpp"
+
+namespace rtdemo {
+/**
+ * @brief ベンチマークの設定
+ */
+struct BenchmarkDesc {
+  std::string scene_name;  ///< 描画するシーン名
+  std::string technique_name;  ///< 適用するテクニック名
+  uint32_t screen_width = 1280;  ///< バックバッファの幅
+  uint32_t screen_height = 720;  ///< バックバッファの高さ
+  size_t warmup_frame_count = 10;  ///< 計測前に捨てるフレーム数
+  size_t frame_count = 300;  ///< 計測するフレーム数
+  double frame_budget = 1000.0 / 60.0;  ///< ヒッチとみなすフレーム時間[ms]
+  std::filesystem::path output_path = "benchmark.json";  ///< 結果を書き出すファイルパス
+  std::filesystem::path trace_path;  ///< CPUトレースを書き出すファイルパス。空なら記録しない
+  std::filesystem::path capture_path;  ///< GLの呼び出しを記録するファイルパス。空なら記録しない
+  size_t capture_frame_count = 0;  ///< GLの呼び出しを記録するフレーム数。0なら計測するすべてのフレーム
+};
+
+/**
+ * @brief GUIを介さずにシーンとテクニックの組を描画して時間を計測する
+ * 
+ * Applicationを初期化してから使う。
+ */
+class Benchmark final {
+ public:
+  /**
+   * @brief フレームごとの計測結果
+   */
+  struct FrameRecord {
+    double cpu_time = 0.0;  ///< CPUの処理時間[ms]
+    double gpu_time = 0.0;  ///< GPUの処理時間[ms]
+    uint64_t gl_call_count = 0;  ///< 呼び出したGLの関数の数。数えていなければ0
+  };
+
+  /**
+   * @brief パスごとの計測結果
+   */
+  struct PassRecord {
+    std::string name;  ///< パス名
+    uint32_t depth = 0;  ///< スコープの深さ
+    double sum_time = 0.0;  ///< GPU時間の合計[ms]
+    size_t count = 0;  ///< 計測したフレーム数
+  };
+
+  explicit Benchmark(BenchmarkDesc desc) : desc_(std::move(desc)) {}
+
+  /**
+   * @brief シーンとテクニックを用意し、フレームを描画して計測する
+   * 
+   * @return true 成功した
+   * @return false 失敗した
+   */
+  bool run();
+
+  /**
+   * @brief 計測結果をJSONとして書き出す
+   * 
+   * @return true 成功した
+   * @return false 失敗した
+   */
+  bool save() const;
+
+  const std::vector<FrameRecord>& records() const noexcept {
+    return records_;
+  }
+
+  const std::vector<PassRecord>& pass_records() const noexcept {
+    return pass_records_;
+  }
+
+  /**
+   * @brief 計測したフレームのCPU時間の統計
+   */
+  const FrameStats& cpu_stats() const noexcept {
+    return cpu_stats_;
+  }
+
+  /**
+   * @brief 計測したフレームのGPU時間の統計
+   */
+  const FrameStats& gpu_stats() const noexcept {
+    return gpu_stats_;
+  }
+
+ private:
+  static constexpr size_t QUERY_COUNT = 4;  ///< GPU時間を読み戻すまでに待つフレーム数
+
+  BenchmarkDesc desc_;
+  std::vector<FrameRecord> records_;
+  std::vector<PassRecord> pass_records_;
+  FrameStats cpu_stats_;  ///< CPU時間の統計
+  FrameStats gpu_stats_;  ///< GPU時間の統計
+};
+}  // namespace rtdemo
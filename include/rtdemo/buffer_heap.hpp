@@ -0,0 +1,106 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "garie.hpp"
+
+namespace rtdemo::util {
+/**
+ * @brief 少数の大きなバッファを切り分けて、頂点やインデックスなどの変更しないデータを置くヒープ
+ * 
+ * 大きさPAGE_SIZEのバッファ(ページ)をGL_DYNAMIC_STORAGE_BITで確保し、空き範囲のリストから割り当てる。
+ * メッシュやシーンごとにGLオブジェクトを作らないので、たくさんのメッシュを読み込んでもバッファが増えない。
+ * PAGE_SIZEより大きな割り当てには、専用のページを確保する。
+ * 
+ * 返すgarie::BufferViewはバッファを所有しないので、使い終わったらfree()で返す。
+ * 
+ * ResourceTrackerには、割り当てた範囲をallocate()を呼び出したときのScopeのタグに、空き範囲を"buffer heap"に数える。
+ */
+class BufferHeap final {
+ public:
+  static constexpr size_t PAGE_SIZE = 16 << 20;  ///< ページの大きさ[byte]
+  static constexpr size_t MIN_ALIGNMENT = 16;  ///< 割り当てのアラインメントの最小値[byte]
+
+  /**
+   * @brief インスタンスを取得する
+   * 
+   * @return BufferHeap&
+   */
+  static BufferHeap& get() noexcept;
+
+  /**
+   * @brief すべてのページを破棄する
+   * 
+   * GLコンテキストを破棄する前に呼び出す。割り当てたBufferViewはすべて使えなくなる。
+   */
+  void clear();
+
+  /**
+   * @brief 範囲を割り当てる
+   * 
+   * @param target バインドするターゲット。GL_UNIFORM_BUFFERとGL_SHADER_STORAGE_BUFFERではオフセットのアラインメントを合わせる。
+   * @param size 大きさ[byte]
+   * @param data 初期値。nullptrであれば未初期化
+   * @return garie::BufferView 割り当てた範囲。sizeが0なら空
+   */
+  garie::BufferView allocate(GLenum target, size_t size, const void* data = nullptr);
+
+  /**
+   * @brief 範囲を返す
+   * 
+   * @param view allocateで割り当てた範囲。空なら何もしない
+   */
+  void free(const garie::BufferView& view);
+
+  /**
+   * @brief 確保しているGPUメモリの合計を取得する
+   */
+  size_t memory_usage() const noexcept {
+    return memory_usage_;
+  }
+
+  /**
+   * @brief 現在のウィンドウにGUIを描画する
+   */
+  void update_gui() const;
+
+ private:
+  /**
+   * @brief 割り当て元のバッファ
+   */
+  struct Page {
+    garie::Buffer buffer;  ///< バッファ
+    size_t size = 0;  ///< 大きさ[byte]
+    size_t used = 0;  ///< 割り当てた大きさ[byte]
+    size_t block_count = 0;  ///< 割り当てた範囲の数
+    std::map<size_t, size_t> free_ranges;  ///< 空き範囲のオフセットから大きさへのマップ
+  };
+
+  BufferHeap() = default;
+
+  /**
+   * @brief ページを確保する
+   */
+  Page& add_page(size_t size);
+
+  /**
+   * @brief ページの空き範囲から割り当てる
+   * 
+   * @return size_t 割り当てたオフセット。入りきらなければSIZE_MAX
+   */
+  static size_t allocate_range(Page& page, size_t size, size_t alignment);
+
+  /**
+   * @brief 範囲をページの空き範囲に戻し、隣と結合する
+   */
+  static void free_range(Page& page, size_t offset, size_t size);
+
+  std::vector<std::unique_ptr<Page>> pages_;  ///< ページ。BufferViewが参照するので要素を動かさない
+  GLint uniform_alignment_ = 0;  ///< GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT。0なら未取得
+  GLint storage_alignment_ = 0;  ///< GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+  size_t memory_usage_ = 0;  ///< 確保しているGPUメモリの合計[byte]
+};
+}  // namespace rtdemo::util
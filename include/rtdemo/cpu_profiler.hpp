@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+
+namespace rtdemo {
+/**
+ * @brief スコープごとのCPU時間を記録するプロファイラ
+ * 
+ * スレッドごとのバッファにイベントを記録し、chrome://tracingやPerfettoで読める形式で書き出す。
+ * 記録していない間のスコープは時刻を取得しない。
+ */
+class CpuProfiler final {
+ public:
+  /**
+   * @brief 計測するスコープ
+   */
+  class Scope final {
+   public:
+    explicit Scope(const char* name) noexcept
+        : name_(name), begin_(CpuProfiler::get().is_capturing() ? now() : -1) {}
+
+    Scope(const Scope&) = delete;
+
+    ~Scope() noexcept {
+      if (begin_ >= 0) CpuProfiler::get().record(name_, begin_, now());
+    }
+
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    const char* name_;  ///< スコープ名
+    int64_t begin_;  ///< 開始時刻[ns]。記録しないなら負の値
+  };
+
+  /**
+   * @brief インスタンスを取得する
+   * 
+   * @return CpuProfiler&
+   */
+  static CpuProfiler& get() noexcept;
+
+  /**
+   * @brief プロファイラが生成されてからの経過時間を取得する
+   * 
+   * @return int64_t 経過時間[ns]
+   */
+  static int64_t now() noexcept;
+
+  /**
+   * @brief 呼び出したスレッドに名前を付ける
+   * 
+   * @param name スレッド名
+   */
+  void set_thread_name(std::string name);
+
+  /**
+   * @brief 記録を開始する
+   * 
+   * 以前に記録したイベントは破棄する。
+   */
+  void start_capture();
+
+  /**
+   * @brief 記録を停止する
+   */
+  void stop_capture();
+
+  bool is_capturing() const noexcept {
+    return capturing_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief イベントを記録する
+   * 
+   * @param name スコープ名。書き出すまで有効でなければならない。
+   * @param begin 開始時刻[ns]
+   * @param end 終了時刻[ns]
+   */
+  void record(const char* name, int64_t begin, int64_t end);
+
+  /**
+   * @brief 記録したイベントをChrome Trace Event形式で書き出す
+   * 
+   * @param path ファイルパス
+   * @return true 成功した
+   * @return false 失敗した
+   */
+  bool save(const std::filesystem::path& path) const;
+
+  /**
+   * @brief 記録したイベントの数を取得する
+   */
+  size_t event_count() const;
+
+  /**
+   * @brief GUIを更新する
+   */
+  void update_gui();
+
+ private:
+  static constexpr size_t MAX_EVENT_COUNT = 1 << 20;  ///< スレッドごとに記録できるイベントの最大数
+
+  /**
+   * @brief 記録したイベント
+   */
+  struct Event {
+    const char* name;  ///< スコープ名
+    int64_t begin;  ///< 開始時刻[ns]
+    int64_t end;  ///< 終了時刻[ns]
+  };
+
+  /**
+   * @brief スレッドごとのバッファ
+   */
+  struct ThreadBuffer {
+    uint32_t id = 0;  ///< スレッド番号
+    std::string name;  ///< スレッド名
+    mutable std::mutex mutex;  ///< eventsを保護する
+    std::vector<Event> events;  ///< 記録したイベント
+  };
+
+  /**
+   * @brief 呼び出したスレッドのバッファを取得する
+   */
+  ThreadBuffer& thread_buffer();
+
+  mutable std::mutex mutex_;  ///< thread_buffers_を保護する
+  std::vector<std::shared_ptr<ThreadBuffer>> thread_buffers_;
+  std::atomic<bool> capturing_{false};  ///< 記録中か
+  std::filesystem::path output_path_ = "cpu_trace.json";  ///< GUIから書き出すファイルパス
+};
+}  // namespace rtdemo
+
+#ifndef RT_PROFILE_CONCAT
+#define RT_PROFILE_CONCAT_IMPL(a, b) a##b
+#define RT_PROFILE_CONCAT(a, b) RT_PROFILE_CONCAT_IMPL(a, b)
+#endif
+
+/**
+ * @brief 現在のスコープのCPU時間を記録するマクロ
+ */
+#define RT_CPU_SCOPE(name) \
+  ::rtdemo::CpuProfiler::Scope RT_PROFILE_CONCAT(rt_cpu_scope_, __LINE__)(name)
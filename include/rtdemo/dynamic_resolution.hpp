@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+
+namespace rtdemo {
+/**
+ * @brief GPU時間が目標に収まるように内部解像度の倍率を選ぶ
+ * 
+ * テクニックはレンダターゲットを画面の大きさで確保したまま、
+ * ビューポートで倍率をかけた部分だけに描画し、最後のパスで画面に拡大する。
+ * したがって、倍率を変えてもレンダターゲットは作り直さない。
+ */
+class DynamicResolution final {
+ public:
+  /**
+   * @brief GPU時間から倍率を更新する
+   * 
+   * @param gpu_time 1フレームのGPU時間[ms]
+   */
+  void update(double gpu_time);
+
+  /**
+   * @brief 倍率を最大に戻して平滑化した時間を破棄する
+   */
+  void reset();
+
+  /**
+   * @brief 大きさに倍率をかける
+   * 
+   * @param size 画面上の大きさ
+   * @return uint32_t 内部の大きさ
+   */
+  uint32_t scale(uint32_t size) const noexcept;
+
+  /**
+   * @brief 現在のウィンドウにGUIを描画する
+   */
+  void update_gui();
+
+  void set_enabled(bool enabled) noexcept {
+    enabled_ = enabled;
+  }
+
+  bool is_enabled() const noexcept {
+    return enabled_;
+  }
+
+  /**
+   * @brief 目標とするGPU時間を設定する
+   * 
+   * @param target_time 目標[ms]
+   */
+  void set_target_time(double target_time) noexcept {
+    target_time_ = target_time;
+  }
+
+  double target_time() const noexcept {
+    return target_time_;
+  }
+
+  /**
+   * @brief 倍率の範囲を設定する
+   */
+  void set_scale_range(float min_scale, float max_scale) noexcept;
+
+  float scale_factor() const noexcept {
+    return scale_;
+  }
+
+ private:
+  static constexpr double HEADROOM = 0.9;  ///< 目標のうち実際に使う割合
+  static constexpr double SMOOTHING = 0.1;  ///< GPU時間を平滑化する係数
+  static constexpr float MAX_STEP = 0.05f;  ///< 1回の更新で変える倍率の最大値
+  static constexpr float DEAD_ZONE = 0.02f;  ///< この差より小さければ倍率を変えない
+
+  bool enabled_ = false;  ///< 倍率を変えるか
+  double target_time_ = 1000.0 / 60.0;  ///< 目標とするGPU時間[ms]
+  double average_time_ = 0.0;  ///< 平滑化したGPU時間[ms]
+  float min_scale_ = 0.5f;  ///< 倍率の最小値
+  float max_scale_ = 1.f;  ///< 倍率の最大値
+  float scale_ = 1.f;  ///< 現在の倍率
+};
+}  // namespace rtdemo
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <cstdint>
+#include "garie.hpp"
+
+namespace rtdemo {
+/**
+ * @brief GPUに積まれるフレームの数をフェンスで制限し、入力から表示までの遅延を計測する
+ * 
+ * フレームの終わりにフェンスを置き、終わっていないフレームが上限に達していれば、最も古いフレームを待つ。
+ * 上限を小さくすると遅延が減るが、CPUとGPUが並列に動く余地も減る。
+ * 
+ * 遅延は入力を読んだ時刻から、そのフレームのフェンスが通ったのを確認した時刻までとする。
+ * 待たずに通っていたフェンスは次のフレームの終わりに確認するので、その分だけ長めに計測される。
+ */
+class FrameLimiter final {
+ public:
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  static constexpr uint32_t DEFAULT_MAX_FRAMES_IN_FLIGHT = 2;  ///< 既定の上限
+  static constexpr uint32_t MAX_FRAMES_IN_FLIGHT_LIMIT = 8;  ///< 設定できる上限の最大値。UploadRingはこの数に合わせて領域を確保する
+
+  /**
+   * @brief このフレームで入力を読んだ時刻を記録する
+   */
+  void set_input_time(TimePoint tp) noexcept {
+    input_tp_ = tp;
+    has_input_ = true;
+  }
+
+  /**
+   * @brief フレームの終わりにフェンスを置き、上限を超えていれば古いフレームを待つ
+   * 
+   * すべてのGLコマンドを発行した後に呼び出す。
+   */
+  void end_frame();
+
+  /**
+   * @brief 待っているフェンスを破棄する
+   * 
+   * GLコンテキストを破棄する前に呼び出す。
+   */
+  void clear();
+
+  /**
+   * @brief 現在のウィンドウにGUIを描画する
+   */
+  void update_gui();
+
+  /**
+   * @brief 終わっていないフレームの上限を設定する
+   * 
+   * @param count 上限。0であれば制限しないが、UploadRingの領域の数でMAX_FRAMES_IN_FLIGHT_LIMITまでに抑えられる
+   */
+  void set_max_frames_in_flight(uint32_t count) noexcept;
+
+  uint32_t max_frames_in_flight() const noexcept {
+    return max_frames_in_flight_;
+  }
+
+  /**
+   * @brief 平滑化した、フェンスを待った時間[ms]
+   */
+  double average_wait_time() const noexcept {
+    return average_wait_time_;
+  }
+
+  /**
+   * @brief 平滑化した、入力から表示までの遅延[ms]
+   */
+  double average_latency() const noexcept {
+    return average_latency_;
+  }
+
+ private:
+  static constexpr double SMOOTHING = 0.1;  ///< 時間を平滑化する係数
+
+  /**
+   * @brief 終わっていないフレーム
+   */
+  struct Frame {
+    GLsync fence = nullptr;  ///< フレームの終わりに置いたフェンス
+    TimePoint input_tp;  ///< 入力を読んだ時刻
+  };
+
+  /**
+   * @brief 終わったフレームの遅延を記録してフェンスを破棄する
+   */
+  void retire(const Frame& frame, TimePoint now);
+
+  std::deque<Frame> frames_;  ///< 終わっていないフレーム
+  uint32_t max_frames_in_flight_ = DEFAULT_MAX_FRAMES_IN_FLIGHT;  ///< 終わっていないフレームの上限
+  TimePoint input_tp_;  ///< このフレームで入力を読んだ時刻
+  bool has_input_ = false;  ///< このフレームで入力を読んだか
+  TimePoint last_end_tp_;  ///< 前回end_frame()を抜けた時刻
+  double last_wait_time_ = 0.0;  ///< 前のフレームでフェンスを待った時間[ms]
+  double average_wait_time_ = 0.0;  ///< 平滑化したフェンスを待った時間[ms]
+  double last_latency_ = 0.0;  ///< 最後に終わったフレームの遅延[ms]
+  double average_latency_ = 0.0;  ///< 平滑化した遅延[ms]
+};
+}  // namespace rtdemo
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "types.hpp"
+
+namespace rtdemo {
+/**
+ * @brief フレームの解像度
+ */
+struct FrameSize {
+  uint32_t screen_width = 0;  ///< バックバッファの幅
+  uint32_t screen_height = 0;  ///< バックバッファの高さ
+  uint32_t render_width = 0;  ///< 内部のレンダターゲットに描画する幅
+  uint32_t render_height = 0;  ///< 内部のレンダターゲットに描画する高さ
+};
+
+/**
+ * @brief 1フレームの描画に必要な状態
+ * 
+ * Scene::updateとTechnique::updateがワーカースレッドで書き込み、
+ * Scene::uploadとTechnique::uploadがGLのスレッドで読み出す。
+ * 使い回すので、vectorの容量は確保したまま残る。
+ */
+struct FramePacket {
+  static constexpr size_t MAX_TECHNIQUE_CONSTANT_SIZE = 256;  ///< テクニックの定数の最大サイズ
+
+  uint64_t frame_index = 0;  ///< フレーム番号
+  uint32_t screen_width = 0;  ///< バックバッファの幅
+  uint32_t screen_height = 0;  ///< バックバッファの高さ
+  uint32_t render_width = 0;  ///< 内部のレンダターゲットに描画する幅。screen_width以下
+  uint32_t render_height = 0;  ///< 内部のレンダターゲットに描画する高さ。screen_height以下
+  Camera camera{};  ///< カメラ
+  std::vector<PointLight> lights;  ///< 点光源
+  std::vector<ShadowCaster> shadow_casters;  ///< シャドウキャスタ
+  alignas(16) std::array<std::byte, MAX_TECHNIQUE_CONSTANT_SIZE> technique_constant{};  ///< テクニックの定数
+  size_t technique_constant_size = 0;  ///< テクニックの定数のサイズ
+
+  /**
+   * @brief フレームの解像度を設定する
+   */
+  void set_size(const FrameSize& size) noexcept {
+    screen_width = size.screen_width;
+    screen_height = size.screen_height;
+    render_width = size.render_width;
+    render_height = size.render_height;
+  }
+
+  /**
+   * @brief 次のフレームを書き込むために中身を空にする
+   */
+  void clear() noexcept {
+    camera = Camera{};
+    lights.clear();
+    shadow_casters.clear();
+    technique_constant_size = 0;
+  }
+
+  /**
+   * @brief テクニックの定数を書き込む
+   */
+  template <typename T>
+  void set_technique_constant(const T& value) noexcept {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(sizeof(T) <= MAX_TECHNIQUE_CONSTANT_SIZE);
+    std::memcpy(technique_constant.data(), &value, sizeof(T));
+    technique_constant_size = sizeof(T);
+  }
+
+  /**
+   * @brief テクニックの定数を読み出す
+   */
+  template <typename T>
+  T get_technique_constant() const noexcept {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(sizeof(T) <= MAX_TECHNIQUE_CONSTANT_SIZE);
+    T value{};
+    std::memcpy(&value, technique_constant.data(), std::min(sizeof(T), technique_constant_size));
+    return value;
+  }
+};
+}  // namespace rtdemo
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+#include "frame_packet.hpp"
+
+namespace rtdemo {
+class Scene;
+class Technique;
+
+/**
+ * @brief シーンの更新とGLへの発行をパイプライン化する
+ * 
+ * フレームNをGLに発行している間に、ワーカースレッドでフレームN+1のパケットを作る。
+ * パケットは発行中のものと作成中のものの2つを交互に使う。
+ * ワーカースレッドを止めている間は、acquireが呼び出し元のスレッドでパケットを作る。
+ */
+class FramePipeline final {
+ public:
+  static constexpr size_t PACKET_COUNT = 2;  ///< パケットの数
+
+  FramePipeline() = default;
+
+  FramePipeline(const FramePipeline&) = delete;
+
+  ~FramePipeline() noexcept {
+    stop();
+  }
+
+  FramePipeline& operator=(const FramePipeline&) = delete;
+
+  /**
+   * @brief ワーカースレッドを起動する
+   * 
+   * @return true 成功した
+   * @return false 失敗した
+   */
+  bool start();
+
+  /**
+   * @brief ワーカースレッドを停止する
+   */
+  void stop();
+
+  /**
+   * @brief ワーカースレッドの処理が終わるまで待つ
+   * 
+   * 戻ったあとは、次にkickを呼び出すまでシーンやテクニックの状態を書き換えてよい。
+   */
+  void wait();
+
+  /**
+   * @brief 作成済みのパケットを破棄する
+   * 
+   * シーンやテクニックを切り替える前に呼び出す。
+   */
+  void reset();
+
+  /**
+   * @brief 描画するフレームのパケットを取得する
+   * 
+   * kickで作成したパケットがなければ、この場で作成する。
+   * 
+   * @return const FramePacket& 次にacquireを呼び出すまで有効なパケット
+   */
+  const FramePacket& acquire(Scene& scene, Technique& technique, const FrameSize& size);
+
+  /**
+   * @brief 次のフレームのパケットをワーカースレッドで作成し始める
+   * 
+   * ワーカースレッドを止めていれば何もしない。
+   */
+  void kick(Scene& scene, Technique& technique, const FrameSize& size);
+
+  bool is_running() const noexcept {
+    return thread_.joinable();
+  }
+
+  /**
+   * @brief 直近のacquireでワーカースレッドを待った時間を取得する
+   * 
+   * @return double 待った時間[ms]
+   */
+  double last_wait_time() const noexcept {
+    return last_wait_time_;
+  }
+
+ private:
+  /**
+   * @brief ワーカースレッドの処理
+   */
+  void run();
+
+  /**
+   * @brief パケットを作成する
+   */
+  static void build(FramePacket& packet, Scene& scene, Technique& technique);
+
+  std::thread thread_;  ///< ワーカースレッド
+  std::mutex mutex_;  ///< 以下のメンバを保護する
+  std::condition_variable cv_;
+  Scene* scene_ = nullptr;  ///< 作成中のパケットを書き込むシーン
+  Technique* technique_ = nullptr;  ///< 作成中のパケットを書き込むテクニック
+  bool busy_ = false;  ///< ワーカースレッドが作成中か
+  bool ready_ = false;  ///< kickで作成したパケットが未使用か
+  bool quit_ = false;  ///< ワーカースレッドを終了するか
+
+  std::array<FramePacket, PACKET_COUNT> packets_;
+  size_t current_ = 0;  ///< 描画するパケット
+  uint64_t frame_index_ = 0;  ///< 次に作成するパケットのフレーム番号
+  double last_wait_time_ = 0.0;  ///< 直近のacquireで待った時間[ms]
+};
+}  // namespace rtdemo
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace rtdemo {
+/**
+ * @brief フレーム時間の統計
+ * 
+ * 直近HISTORY_SIZEフレームのリングバッファと、resetしてからの全フレームを数える
+ * 対数ヒストグラム(HDR Histogramと同様の指数+仮数のバケット)を持つ。
+ * フレーム時間が予算を超えたフレームはヒッチとして数える。
+ */
+class FrameStats final {
+ public:
+  static constexpr size_t HISTORY_SIZE = 512;  ///< リングバッファに保持するフレーム数
+  static constexpr size_t HITCH_HISTORY_SIZE = 16;  ///< 保持するヒッチの数
+
+  /**
+   * @brief 統計値
+   */
+  struct Summary {
+    size_t count = 0;  ///< フレーム数
+    double mean = 0.0;  ///< 平均[ms]
+    double min = 0.0;  ///< 最小[ms]
+    double p50 = 0.0;  ///< 50パーセンタイル[ms]
+    double p95 = 0.0;  ///< 95パーセンタイル[ms]
+    double p99 = 0.0;  ///< 99パーセンタイル[ms]
+    double max = 0.0;  ///< 最大[ms]
+    size_t hitch_count = 0;  ///< 予算を超えたフレーム数
+  };
+
+  /**
+   * @brief ヒッチの記録
+   */
+  struct Hitch {
+    uint64_t frame_index = 0;  ///< フレーム番号
+    float time = 0.f;  ///< フレーム時間[ms]
+  };
+
+  /**
+   * @brief フレーム時間を追加する
+   * 
+   * @param time フレーム時間[ms]
+   */
+  void add(double time);
+
+  /**
+   * @brief すべての記録を破棄する
+   */
+  void reset();
+
+  /**
+   * @brief resetしてからの全フレームの統計値を計算する
+   * 
+   * パーセンタイルはヒストグラムから求めるので、バケットの幅(約3%)の誤差を持つ。
+   * 
+   * @return Summary 統計値
+   */
+  Summary summary() const;
+
+  /**
+   * @brief 直近のフレームの統計値を計算する
+   * 
+   * @return Summary 統計値
+   */
+  Summary recent_summary() const;
+
+  /**
+   * @brief resetしてからの全フレームのパーセンタイルを計算する
+   * 
+   * @param p 0から1の割合
+   * @return double フレーム時間[ms]
+   */
+  double percentile(double p) const;
+
+  /**
+   * @brief フレーム時間の予算を設定する
+   * 
+   * @param budget 予算[ms]
+   */
+  void set_budget(double budget) noexcept {
+    budget_ = budget;
+  }
+
+  double budget() const noexcept {
+    return budget_;
+  }
+
+  /**
+   * @brief 直近のフレーム時間を古い順に並べたときの先頭を返す
+   * 
+   * history()と組み合わせてImGui::PlotLinesのvalues_offsetに渡す。
+   */
+  size_t history_offset() const noexcept {
+    return history_count_ < HISTORY_SIZE ? 0 : history_head_;
+  }
+
+  /**
+   * @brief 直近のフレーム時間のリングバッファ
+   */
+  const std::array<float, HISTORY_SIZE>& history() const noexcept {
+    return history_;
+  }
+
+  size_t history_count() const noexcept {
+    return history_count_;
+  }
+
+  /**
+   * @brief 直近のヒッチのリングバッファ
+   */
+  const std::array<Hitch, HITCH_HISTORY_SIZE>& hitches() const noexcept {
+    return hitches_;
+  }
+
+  /**
+   * @brief 現在のウィンドウに統計値とグラフを描画する
+   */
+  void update_gui();
+
+  uint64_t frame_count() const noexcept {
+    return count_;
+  }
+
+ private:
+  static constexpr int MIN_EXPONENT = -6;  ///< ヒストグラムの下限(2^-6[ms])
+  static constexpr int MAX_EXPONENT = 14;  ///< ヒストグラムの上限(2^14[ms])
+  static constexpr size_t SUB_BUCKET_COUNT = 32;  ///< 2の冪ごとのバケット数
+  static constexpr size_t BUCKET_COUNT = (MAX_EXPONENT - MIN_EXPONENT) * SUB_BUCKET_COUNT;
+
+  /**
+   * @brief 値を格納するバケットの番号を計算する
+   */
+  static size_t bucket_index(double time) noexcept;
+
+  /**
+   * @brief バケットの代表値を計算する
+   */
+  static double bucket_value(size_t index) noexcept;
+
+  // resetしてからの全フレーム
+  std::array<uint32_t, BUCKET_COUNT> buckets_{};  ///< ヒストグラム
+  uint64_t count_ = 0;  ///< フレーム数
+  double sum_ = 0.0;  ///< 合計[ms]
+  double min_ = 0.0;  ///< 最小[ms]
+  double max_ = 0.0;  ///< 最大[ms]
+  uint64_t hitch_count_ = 0;  ///< ヒッチの数
+
+  // 直近のフレーム
+  std::array<float, HISTORY_SIZE> history_{};  ///< フレーム時間のリングバッファ
+  size_t history_head_ = 0;  ///< 次に書き込む位置
+  size_t history_count_ = 0;  ///< 書き込まれた数
+  std::array<Hitch, HITCH_HISTORY_SIZE> hitches_{};  ///< ヒッチのリングバッファ
+
+  double budget_ = 1000.0 / 60.0;  ///< フレーム時間の予算[ms]
+};
+}  // namespace rtdemo
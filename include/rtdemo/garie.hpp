@@ -1,17 +1,508 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <set>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <GL/glew.h>
+#include "gl_dispatch.hpp"
 
 // OpenGLのRAIIラッパー
+//
+// GARIE_USE_DSAを定義すると、GL 4.5のDirect State Accessでオブジェクトを生成、編集する。
+// 定義しなければ、編集のたびにオブジェクトをバインドする。
+// どちらの場合も、編集のためのバインドが描画に使うバインドを壊さないようにしている。
 namespace garie {
+/**
+ * @brief GLオブジェクトの破棄を、GPUがそのフレームを処理し終えるまで遅らせるキュー
+ * 
+ * invalidate()などでフレームの途中に破棄したオブジェクトも、GPUが使い終わるまで残す。
+ * end_frame()でフレームの終わりにフェンスを置き、フェンスを通ったフレームのオブジェクトを破棄する。
+ */
+class DeletionQueue final {
+ public:
+  using DeleteFunc = void (*)(GLuint);
+
+  static DeletionQueue& get() noexcept {
+    static DeletionQueue self;
+    return self;
+  }
+
+  /**
+   * @brief 破棄を遅らせるかを設定する
+   * 
+   * 遅らせない場合、push()ですぐに破棄する。
+   */
+  void set_deferred(bool deferred) noexcept {
+    if (!deferred) flush();
+    deferred_ = deferred;
+  }
+
+  /**
+   * @brief 破棄するオブジェクトを追加する
+   * 
+   * @param func オブジェクトを破棄する関数
+   * @param id GLオブジェクトID
+   */
+  void push(DeleteFunc func, GLuint id) {
+    if (!deferred_) {
+      func(id);
+      return;
+    }
+    if (frames_.empty() || frames_.back().fence) frames_.emplace_back();
+    frames_.back().entries.push_back(Entry{func, id});
+    pending_count_++;
+  }
+
+  /**
+   * @brief このフレームで追加したオブジェクトにフェンスを置き、GPUが使い終わったものを破棄する
+   * 
+   * すべてのGLコマンドを発行した後に呼び出す。
+   */
+  void end_frame() {
+    if (!frames_.empty() && !frames_.back().fence) {
+      frames_.back().fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    last_retired_count_ = 0;
+    while (!frames_.empty() && glClientWaitSync(frames_.front().fence, 0, 0) != GL_TIMEOUT_EXPIRED) {
+      retire(frames_.front());
+      frames_.pop_front();
+    }
+  }
+
+  /**
+   * @brief 待たずにすべてのオブジェクトを破棄する
+   * 
+   * GLコンテキストを破棄する前に呼び出す。
+   */
+  void flush() {
+    last_retired_count_ = 0;
+    for (auto& frame : frames_) retire(frame);
+    frames_.clear();
+  }
+
+  /**
+   * @brief 破棄を待っているオブジェクトの数
+   */
+  size_t pending_count() const noexcept {
+    return pending_count_;
+  }
+
+  /**
+   * @brief 最後のend_frame()で破棄したオブジェクトの数
+   */
+  size_t last_retired_count() const noexcept {
+    return last_retired_count_;
+  }
+
+ private:
+  /**
+   * @brief 破棄を待っているオブジェクト
+   */
+  struct Entry {
+    DeleteFunc func;  ///< 破棄する関数
+    GLuint id;  ///< GLオブジェクトID
+  };
+
+  /**
+   * @brief 同じフェンスで破棄するオブジェクト
+   */
+  struct Frame {
+    GLsync fence = nullptr;  ///< フレームの終わりのフェンス。nullptrなら追加中
+    std::vector<Entry> entries;  ///< 破棄するオブジェクト
+  };
+
+  DeletionQueue() = default;
+
+  void retire(Frame& frame) noexcept {
+    for (const auto& entry : frame.entries) entry.func(entry.id);
+    if (frame.fence) glDeleteSync(frame.fence);
+    pending_count_ -= frame.entries.size();
+    last_retired_count_ += frame.entries.size();
+  }
+
+  std::deque<Frame> frames_;  ///< 破棄を待っているフレーム
+  bool deferred_ = true;  ///< 破棄を遅らせるか
+  size_t pending_count_ = 0;  ///< 破棄を待っているオブジェクトの数
+  size_t last_retired_count_ = 0;  ///< 最後に破棄したオブジェクトの数
+};
+
+/**
+ * @brief まとめて生成しておいたGLオブジェクトの名前
+ * 
+ * 名前が尽きたらBATCH_SIZE個ずつglGen*(glCreate*)で補充する。
+ * 生成したすべてのプールを覚えておき、clear_all()で使わなかった名前を破棄する。
+ */
+class NamePool final {
+ public:
+  using GenFunc = void (*)(GLsizei, GLuint*);
+  using DeleteFunc = void (*)(GLsizei, const GLuint*);
+
+  static constexpr GLsizei BATCH_SIZE = 16;  ///< 一度に生成する数
+
+  NamePool(GenFunc gen, DeleteFunc del) : gen_(gen), del_(del) {
+    pools().push_back(this);
+  }
+
+  NamePool(const NamePool&) = delete;
+
+  NamePool& operator=(const NamePool&) = delete;
+
+  /**
+   * @brief 名前を1つ取り出す
+   */
+  GLuint acquire() {
+    if (names_.empty()) {
+      names_.resize(BATCH_SIZE);
+      gen_(BATCH_SIZE, names_.data());
+    }
+    const GLuint id = names_.back();
+    names_.pop_back();
+    return id;
+  }
+
+  /**
+   * @brief 使わなかった名前を破棄する
+   */
+  void clear() noexcept {
+    if (!names_.empty()) del_(static_cast<GLsizei>(names_.size()), names_.data());
+    names_.clear();
+  }
+
+  /**
+   * @brief すべてのプールの使わなかった名前を破棄する
+   * 
+   * GLコンテキストを破棄する前に呼び出す。
+   */
+  static void clear_all() noexcept {
+    for (auto pool : pools()) pool->clear();
+  }
+
+ private:
+  static std::vector<NamePool*>& pools() noexcept {
+    static std::vector<NamePool*> pools;
+    return pools;
+  }
+
+  GenFunc gen_;  ///< まとめて生成する関数
+  DeleteFunc del_;  ///< まとめて破棄する関数
+  std::vector<GLuint> names_;  ///< 使っていない名前
+};
+
+/**
+ * @brief GLオブジェクトの種類
+ */
+enum class ResourceType : uint32_t {
+  SHADER,
+  PROGRAM,
+  BUFFER,
+  VERTEX_ARRAY,
+  TEXTURE,
+  QUERY,
+  SAMPLER,
+  FRAMEBUFFER,
+  COUNT,
+};
+
+/**
+ * @brief 生きているGLオブジェクトを、種類、大きさ、持ち主のタグ、生成した場所とともに記録する
+ * 
+ * Objectが生成と破棄のたびに登録と削除をする。大きさはBuffer::storage()とTexture::storage_*()で設定する。
+ * 持ち主のタグはScopeで指定し、指定がなければ"other"になる。
+ * ヒープやプールが貸し出した範囲はadd_allocation()で借り手のタグに数え、元のオブジェクトには残りだけを数える。
+ * 共有されたサンプラは、最初に生成したときのタグに数える。
+ * GLを呼び出すスレッドは1つである前提で、排他制御はしない。
+ */
+class ResourceTracker final {
+ public:
+  /**
+   * @brief 生きているGLオブジェクト
+   */
+  struct Record {
+    ResourceType type = ResourceType::COUNT;  ///< 種類
+    GLuint id = 0;  ///< GLオブジェクトID
+    size_t size = 0;  ///< 確保した大きさ[byte]。不明であれば0
+    size_t allocated = 0;  ///< 貸し出して借り手のタグに数えている大きさ[byte]
+    std::string_view tag;  ///< 持ち主のタグ
+    std::source_location site;  ///< 生成した場所
+  };
+
+  /**
+   * @brief オブジェクトの数と大きさの合計
+   */
+  struct Totals {
+    size_t count = 0;  ///< オブジェクトと貸し出した範囲の数
+    size_t size = 0;  ///< 大きさの合計[byte]
+  };
+
+  /**
+   * @brief 生存期間の間、生成したオブジェクトに持ち主のタグを付ける
+   * 
+   * 入れ子にすると内側のタグが優先される。
+   */
+  class Scope final {
+   public:
+    explicit Scope(std::string_view tag) {
+      auto& tracker = ResourceTracker::get();
+      // 毎フレーム張るスコープもあるので、既にあるタグは文字列を作らずに使う
+      auto iter = tracker.tags_.find(tag);
+      if (iter == tracker.tags_.end()) iter = tracker.tags_.emplace(tag).first;
+      tracker.tag_stack_.push_back(*iter);
+    }
+
+    Scope(const Scope&) = delete;
+
+    ~Scope() noexcept {
+      ResourceTracker::get().tag_stack_.pop_back();
+    }
+
+    Scope& operator=(const Scope&) = delete;
+  };
+
+  static ResourceTracker& get() noexcept {
+    static ResourceTracker self;
+    return self;
+  }
+
+  /**
+   * @brief 生成したオブジェクトを登録する
+   * 
+   * @param type 種類
+   * @param id GLオブジェクトID
+   * @param site 生成した場所
+   */
+  void add(ResourceType type, GLuint id, const std::source_location& site) {
+    if (!id) return;
+    records_[key(type, id)] = Record{type, id, 0, 0, current_tag(), site};
+  }
+
+  /**
+   * @brief 破棄したオブジェクトの登録を、貸し出した範囲とともに消す
+   */
+  void remove(ResourceType type, GLuint id) noexcept {
+    const uint64_t k = key(type, id);
+    records_.erase(k);
+    auto first = allocations_.lower_bound({k, 0});
+    auto last = first;
+    while (last != allocations_.end() && last->first.first == k) ++last;
+    allocations_.erase(first, last);
+  }
+
+  /**
+   * @brief オブジェクトの一部を貸し出したことを登録する
+   * 
+   * 貸し出した範囲は、Scopeで指定されている借り手のタグに数える。
+   * 
+   * @param type 貸し出したオブジェクトの種類
+   * @param id 貸し出したオブジェクトのID
+   * @param offset 範囲の先頭[byte]。オブジェクトの中で範囲を区別する
+   * @param size 範囲の大きさ[byte]
+   */
+  void add_allocation(ResourceType type, GLuint id, size_t offset, size_t size) {
+    auto iter = records_.find(key(type, id));
+    if (iter == records_.end()) return;
+    auto [allocation, inserted] = allocations_.try_emplace({key(type, id), offset});
+    if (!inserted) iter->second.allocated -= allocation->second.size;
+    allocation->second = Allocation{type, size, current_tag()};
+    iter->second.allocated += size;
+  }
+
+  /**
+   * @brief 返却された範囲の登録を消す
+   */
+  void remove_allocation(ResourceType type, GLuint id, size_t offset) noexcept {
+    auto allocation = allocations_.find({key(type, id), offset});
+    if (allocation == allocations_.end()) return;
+    auto iter = records_.find(key(type, id));
+    if (iter != records_.end()) iter->second.allocated -= allocation->second.size;
+    allocations_.erase(allocation);
+  }
+
+  /**
+   * @brief オブジェクトが確保した大きさを設定する
+   * 
+   * @param size 大きさ[byte]
+   */
+  void set_size(ResourceType type, GLuint id, size_t size) noexcept {
+    auto iter = records_.find(key(type, id));
+    if (iter != records_.end()) iter->second.size = size;
+  }
+
+  /**
+   * @brief 生きているオブジェクトの数
+   */
+  size_t count() const noexcept {
+    return records_.size();
+  }
+
+  /**
+   * @brief すべてのオブジェクトと貸し出した範囲の合計
+   */
+  Totals totals() const noexcept {
+    Totals totals;
+    for (const auto& [k, record] : records_) add_to(totals, record);
+    for (const auto& [k, allocation] : allocations_) add_to(totals, allocation);
+    return totals;
+  }
+
+  /**
+   * @brief タグが付いたオブジェクトと貸し出した範囲の合計
+   */
+  Totals totals(std::string_view tag) const noexcept {
+    Totals totals;
+    for (const auto& [k, record] : records_) {
+      if (record.tag == tag) add_to(totals, record);
+    }
+    for (const auto& [k, allocation] : allocations_) {
+      if (allocation.tag == tag) add_to(totals, allocation);
+    }
+    return totals;
+  }
+
+  /**
+   * @brief 種類ごとの合計。貸し出した範囲は元のオブジェクトの種類に数える
+   */
+  std::array<Totals, static_cast<size_t>(ResourceType::COUNT)> totals_by_type() const noexcept {
+    std::array<Totals, static_cast<size_t>(ResourceType::COUNT)> totals{};
+    for (const auto& [k, record] : records_) add_to(totals[static_cast<size_t>(record.type)], record);
+    for (const auto& [k, allocation] : allocations_) add_to(totals[static_cast<size_t>(allocation.type)], allocation);
+    return totals;
+  }
+
+  /**
+   * @brief タグごとの合計を、大きさの降順で返す
+   */
+  std::vector<std::pair<std::string_view, Totals>> totals_by_tag() const {
+    std::vector<std::pair<std::string_view, Totals>> totals;
+    auto find = [&](std::string_view tag) {
+      auto iter = std::find_if(totals.begin(), totals.end(), [&](const auto& entry) {
+        return entry.first == tag;
+      });
+      if (iter == totals.end()) iter = totals.insert(totals.end(), {tag, Totals{}});
+      return iter;
+    };
+    for (const auto& [k, record] : records_) add_to(find(record.tag)->second, record);
+    for (const auto& [k, allocation] : allocations_) add_to(find(allocation.tag)->second, allocation);
+    std::sort(totals.begin(), totals.end(), [](const auto& lhs, const auto& rhs) {
+      return lhs.second.size > rhs.second.size;
+    });
+    return totals;
+  }
+
+  /**
+   * @brief 生きているオブジェクトを、タグと生成した場所の順に並べて返す
+   */
+  std::vector<Record> records() const {
+    std::vector<Record> records;
+    records.reserve(records_.size());
+    for (const auto& [k, record] : records_) records.push_back(record);
+    std::sort(records.begin(), records.end(), [](const Record& lhs, const Record& rhs) {
+      if (lhs.tag != rhs.tag) return lhs.tag < rhs.tag;
+      const int file = std::strcmp(lhs.site.file_name(), rhs.site.file_name());
+      if (file != 0) return file < 0;
+      if (lhs.site.line() != rhs.site.line()) return lhs.site.line() < rhs.site.line();
+      return lhs.id < rhs.id;
+    });
+    return records;
+  }
+
+  /**
+   * @brief 種類の名前
+   */
+  static const char* type_name(ResourceType type) noexcept {
+    switch (type) {
+      case ResourceType::SHADER:
+        return "shader";
+      case ResourceType::PROGRAM:
+        return "program";
+      case ResourceType::BUFFER:
+        return "buffer";
+      case ResourceType::VERTEX_ARRAY:
+        return "vertex array";
+      case ResourceType::TEXTURE:
+        return "texture";
+      case ResourceType::QUERY:
+        return "query";
+      case ResourceType::SAMPLER:
+        return "sampler";
+      case ResourceType::FRAMEBUFFER:
+        return "framebuffer";
+      case ResourceType::COUNT:
+        break;
+    }
+    return "unknown";
+  }
+
+ private:
+  static constexpr std::string_view DEFAULT_TAG = "other";  ///< Scopeの外で生成したオブジェクトのタグ
+
+  /**
+   * @brief オブジェクトから貸し出した範囲
+   */
+  struct Allocation {
+    ResourceType type = ResourceType::COUNT;  ///< 貸し出したオブジェクトの種類
+    size_t size = 0;  ///< 大きさ[byte]
+    std::string_view tag;  ///< 借り手のタグ
+  };
+
+  ResourceTracker() = default;
+
+  /**
+   * @brief 種類ごとに名前空間が異なるので、種類とIDを組にしたキー
+   */
+  static uint64_t key(ResourceType type, GLuint id) noexcept {
+    return (static_cast<uint64_t>(type) << 32) | id;
+  }
+
+  /**
+   * @brief Scopeで指定されているタグ
+   */
+  std::string_view current_tag() const noexcept {
+    return tag_stack_.empty() ? DEFAULT_TAG : tag_stack_.back();
+  }
+
+  /**
+   * @brief オブジェクトは、貸し出していない残りの大きさだけを数える
+   */
+  static void add_to(Totals& totals, const Record& record) noexcept {
+    totals.count++;
+    totals.size += record.size - std::min(record.allocated, record.size);
+  }
+
+  static void add_to(Totals& totals, const Allocation& allocation) noexcept {
+    totals.count++;
+    totals.size += allocation.size;
+  }
+
+  std::unordered_map<uint64_t, Record> records_;  ///< 種類とIDごとのオブジェクト
+  std::map<std::pair<uint64_t, size_t>, Allocation> allocations_;  ///< 種類とIDとオフセットごとの貸し出した範囲
+  std::set<std::string, std::less<>> tags_;  ///< タグの文字列の置き場所。Recordが参照する
+  std::vector<std::string_view> tag_stack_;  ///< Scopeで指定されたタグ
+};
+
 /**
  * @brief GLオブジェクト
  * 
- * DerivedはObject<Derived>を継承し、Object<Derived>からアクセス可能な以下のメソッドを持つ。
- * - `GLuint gen_impl()`:GLオブジェクトを生成する
+ * DerivedはObject<Derived>を継承し、Object<Derived>からアクセス可能な以下のメンバを持つ。
+ * - `GLuint gen_impl(Args...)`:GLオブジェクトを生成する。引数はgen_at()に渡したもの
  * - `void delete_impl(GLuint)`:GLオブジェクトを破棄する
+ * - `ResourceType RESOURCE_TYPE`:ResourceTrackerに登録する種類
+ * 
+ * 破棄はDeletionQueueに積み、GPUがそのフレームを処理し終えてからdelete_implを呼び出す。
+ * 生成してから破棄するまで、ResourceTrackerに登録しておく。
  * 
  * @tparam Derived 派生先の型
  */
@@ -27,14 +518,14 @@ class Object {
   }
 
   ~Object() noexcept {
-    if (id_) Derived::delete_impl(id_);
+    del();
   }
 
   Object& operator=(const Object&) = delete;
 
   Object& operator=(Object&& other) noexcept {
     if (other.id_ != id_) {
-      if (id_) Derived::delete_impl(id_);
+      del();
       id_ = other.id_;
       other.id_ = 0;
     }
@@ -47,9 +538,11 @@ class Object {
 
   /**
    * @brief 生成する
+   * 
+   * @param site 生成した場所。ResourceTrackerに記録する
    */
-  void gen() noexcept {
-    id_ = Derived::gen_impl();
+  void gen(const std::source_location& site = std::source_location::current()) noexcept {
+    gen_at(site);
   }
 
   /**
@@ -57,7 +550,8 @@ class Object {
    */
   void del() noexcept {
     if (id_) {
-      Derived::delete_impl(id_);
+      ResourceTracker::get().remove(Derived::RESOURCE_TYPE, id_);
+      DeletionQueue::get().push(&Derived::delete_impl, id_);
       id_ = 0;
     }
   }
@@ -71,10 +565,568 @@ class Object {
     return id_;
   }
 
+ protected:
+  /**
+   * @brief 生成してResourceTrackerに登録する
+   * 
+   * @param site 生成した場所
+   * @param args Derived::gen_implに渡す引数
+   */
+  template <typename... Args>
+  void gen_at(const std::source_location& site, Args... args) noexcept {
+    id_ = Derived::gen_impl(args...);
+    ResourceTracker::get().add(Derived::RESOURCE_TYPE, id_, site);
+  }
+
+  /**
+   * @brief 確保した大きさをResourceTrackerに設定する
+   */
+  void set_resource_size(size_t size) const noexcept {
+    ResourceTracker::get().set_size(Derived::RESOURCE_TYPE, id_, size);
+  }
+
  private:
   GLuint id_ = 0;  ///< GLオブジェクトID
 };
 
+namespace detail {
+/**
+ * @brief 内部フォーマットの1テクセルあたりの大きさ
+ * 
+ * @return size_t 大きさ[byte]。知らないフォーマットなら0
+ */
+inline size_t texel_size(GLenum internal_format) noexcept {
+  switch (internal_format) {
+    case GL_R8:
+      return 1;
+    case GL_RG8:
+    case GL_R16F:
+    case GL_DEPTH_COMPONENT16:
+      return 2;
+    case GL_RGBA8:
+    case GL_RGB10_A2:
+    case GL_R11F_G11F_B10F:
+    case GL_RG16F:
+    case GL_R32F:
+    case GL_DEPTH24_STENCIL8:
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH_COMPONENT32F:
+      return 4;
+    case GL_RGBA16F:
+    case GL_RG32F:
+    case GL_DEPTH32F_STENCIL8:
+      return 8;
+    case GL_RGBA32F:
+      return 16;
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief glTexStorage*で確保するミップマップ全体の大きさ
+ * 
+ * 2D配列とキューブマップ配列のdepthはレイヤー数として縮小しない。
+ * 
+ * @return size_t 大きさ[byte]。知らないフォーマットなら0
+ */
+inline size_t texture_storage_size(GLenum target, GLsizei levels, GLenum internal_format,
+                                   GLsizei width, GLsizei height, GLsizei depth) noexcept {
+  const bool reduce_depth = target == GL_TEXTURE_3D;
+  const size_t faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+  size_t texel_count = 0;
+  for (GLsizei level = 0; level < levels; ++level) {
+    const size_t w = std::max(width >> level, 1);
+    const size_t h = std::max(height >> level, 1);
+    const size_t d = reduce_depth ? std::max(depth >> level, 1) : static_cast<size_t>(depth);
+    texel_count += w * h * d;
+  }
+  return texel_count * faces * texel_size(internal_format);
+}
+
+/**
+ * @brief ハッシュ値を混ぜる
+ */
+template <typename T>
+void hash_combine(size_t& seed, const T& value) noexcept {
+  seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+/**
+ * @brief ステートオブジェクトがキャッシュで共有されているかを表すフラグ
+ * 
+ * コピーしたオブジェクトは共有されていないので、コピーや代入では値を引き継がない。
+ */
+struct SharedFlag {
+  bool value = false;  ///< キャッシュで共有されているか
+
+  SharedFlag() = default;
+
+  SharedFlag(const SharedFlag&) noexcept {}
+
+  SharedFlag& operator=(const SharedFlag&) noexcept {
+    return *this;
+  }
+
+  /**
+   * @brief ステートオブジェクトの内容の比較に影響しないように、常に等しいとみなす
+   */
+  bool operator==(const SharedFlag&) const noexcept {
+    return true;
+  }
+};
+}  // namespace detail
+
+/**
+ * @brief GLの状態を覚えておき、変わらない状態を設定する呼び出しを省くキャッシュ
+ * 
+ * ステートオブジェクトのapply()やProgram::use()などはこのクラスを経由して状態を設定する。
+ * GLコンテキストは1つだけなので、シングルトンにしている。
+ * garieを経由せずに状態を変えたときは、invalidate()を呼び出して覚えている状態を捨てる。
+ */
+class StateCache final {
+ public:
+  static constexpr GLuint MAX_DRAW_BUFFERS = 8;  ///< 覚えておくカラーアタッチメントの数
+  static constexpr GLuint MAX_TEXTURE_UNITS = 32;  ///< 覚えておくテクスチャユニットの数
+  static constexpr GLuint MAX_BUFFER_BINDINGS = 32;  ///< 覚えておくUBOとSSBOのバインディングポイントの数
+
+  /**
+   * @brief ステートオブジェクトの種類
+   */
+  enum class Group : size_t {
+    RASTERIZATION,  ///< RasterizationState
+    COLOR_BLEND,  ///< ColorBlendState
+    DEPTH_STENCIL,  ///< DepthStencilState
+    COUNT,
+  };
+
+  /**
+   * @brief インスタンスを取得する
+   * 
+   * @return StateCache&
+   */
+  static StateCache& get() noexcept {
+    static StateCache self;
+    return self;
+  }
+
+  /**
+   * @brief 覚えている状態をすべて捨てる
+   * 
+   * 次の呼び出しは必ずGLに発行される。
+   */
+  void invalidate() noexcept {
+    *this = StateCache(emitted_count_, skipped_count_, last_emitted_count_, last_skipped_count_);
+  }
+
+  /**
+   * @brief フレームの終わりに、呼び出しの数を確定させてリセットする
+   */
+  void end_frame() noexcept {
+    last_emitted_count_ = emitted_count_;
+    last_skipped_count_ = skipped_count_;
+    emitted_count_ = 0;
+    skipped_count_ = 0;
+  }
+
+  /**
+   * @brief 前のフレームでGLに発行した呼び出しの数
+   */
+  size_t last_emitted_count() const noexcept {
+    return last_emitted_count_;
+  }
+
+  /**
+   * @brief 前のフレームで省いた呼び出しの数
+   */
+  size_t last_skipped_count() const noexcept {
+    return last_skipped_count_;
+  }
+
+  /**
+   * @brief 共有されたステートオブジェクトが適用済みで、その後に状態が変わっていないかを調べる
+   * 
+   * 共有されたステートオブジェクトは変更されないので、フィールドを比べずにポインタで比べる。
+   * 
+   * @return true 適用済み。apply()を省いてよい
+   */
+  bool is_applied(Group group, const void* state) noexcept {
+    const bool applied = applied_[static_cast<size_t>(group)] == state;
+    if (applied) skipped_count_++;
+    return applied;
+  }
+
+  /**
+   * @brief 共有されたステートオブジェクトを適用したことを記録する
+   */
+  void set_applied(Group group, const void* state) noexcept {
+    applied_[static_cast<size_t>(group)] = state;
+  }
+
+  /**
+   * @brief 機能を有効化(無効化)する
+   * 
+   * @param cap 機能のenum。覚えていない機能であれば、そのまま発行する。
+   * @param enabled 有効化するか
+   */
+  void enable(GLenum cap, bool enabled) noexcept {
+    const size_t index = cap_index(cap);
+    if (index < caps_.size() && !filter(cap_group(index), caps_[index], enabled)) return;
+    if (enabled) {
+      glEnable(cap);
+    } else {
+      glDisable(cap);
+    }
+  }
+
+  /**
+   * @brief アタッチメントごとのブレンドを有効化(無効化)する
+   */
+  void enable_blend(GLuint index, bool enabled) noexcept {
+    if (index < MAX_DRAW_BUFFERS && !filter(Group::COLOR_BLEND, blends_[index].enabled, enabled)) return;
+    if (enabled) {
+      glEnablei(GL_BLEND, index);
+    } else {
+      glDisablei(GL_BLEND, index);
+    }
+  }
+
+  void blend_func(GLuint index, GLenum src_color, GLenum dst_color, GLenum src_alpha, GLenum dst_alpha) noexcept {
+    if (index < MAX_DRAW_BUFFERS && !filter(Group::COLOR_BLEND, blends_[index].func, {src_color, dst_color, src_alpha, dst_alpha})) return;
+    glBlendFuncSeparatei(index, src_color, dst_color, src_alpha, dst_alpha);
+  }
+
+  void blend_equation(GLuint index, GLenum color_op, GLenum alpha_op) noexcept {
+    if (index < MAX_DRAW_BUFFERS && !filter(Group::COLOR_BLEND, blends_[index].equation, {color_op, alpha_op})) return;
+    glBlendEquationSeparatei(index, color_op, alpha_op);
+  }
+
+  void color_mask(GLuint index, const std::array<GLboolean, 4>& mask) noexcept {
+    if (index < MAX_DRAW_BUFFERS && !filter(Group::COLOR_BLEND, blends_[index].color_mask, mask)) return;
+    glColorMaski(index, mask[0], mask[1], mask[2], mask[3]);
+  }
+
+  /**
+   * @brief すべてのカラーアタッチメントの書き込みマスクを設定する
+   */
+  void color_mask(const std::array<GLboolean, 4>& mask) noexcept {
+    bool changed = false;
+    for (auto& blend : blends_) changed |= blend.color_mask.set(mask);
+    if (!count(changed)) return;
+    touch(Group::COLOR_BLEND);
+    glColorMask(mask[0], mask[1], mask[2], mask[3]);
+  }
+
+  void polygon_mode(GLenum mode) noexcept {
+    if (!filter(Group::RASTERIZATION, polygon_mode_, mode)) return;
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+  }
+
+  void cull_face(GLenum mode) noexcept {
+    if (!filter(Group::RASTERIZATION, cull_face_, mode)) return;
+    glCullFace(mode);
+  }
+
+  void front_face(GLenum mode) noexcept {
+    if (!filter(Group::RASTERIZATION, front_face_, mode)) return;
+    glFrontFace(mode);
+  }
+
+  void polygon_offset(GLfloat factor, GLfloat units) noexcept {
+    if (!filter(Group::RASTERIZATION, polygon_offset_, {factor, units})) return;
+    glPolygonOffset(factor, units);
+  }
+
+  void line_width(GLfloat width) noexcept {
+    if (!filter(Group::RASTERIZATION, line_width_, width)) return;
+    glLineWidth(width);
+  }
+
+  void depth_mask(GLboolean flag) noexcept {
+    if (!filter(Group::DEPTH_STENCIL, depth_mask_, flag)) return;
+    glDepthMask(flag);
+  }
+
+  void depth_func(GLenum func) noexcept {
+    if (!filter(Group::DEPTH_STENCIL, depth_func_, func)) return;
+    glDepthFunc(func);
+  }
+
+  void depth_range(GLfloat near_val, GLfloat far_val) noexcept {
+    if (!filter(Group::DEPTH_STENCIL, depth_range_, {near_val, far_val})) return;
+    glDepthRangef(near_val, far_val);
+  }
+
+  /**
+   * @brief ステンシル処理を設定する
+   * 
+   * @param face GL_FRONTかGL_BACKかGL_FRONT_AND_BACK
+   */
+  void stencil_op(GLenum face, GLenum fail_op, GLenum depth_fail_op, GLenum pass_op) noexcept {
+    if (!filter_face(face, &StencilFace::op, {fail_op, depth_fail_op, pass_op})) return;
+    glStencilOpSeparate(face, fail_op, depth_fail_op, pass_op);
+  }
+
+  void stencil_func(GLenum face, GLenum func, GLint reference, GLuint mask) noexcept {
+    if (!filter_face(face, &StencilFace::func, {func, static_cast<GLuint>(reference), mask})) return;
+    glStencilFuncSeparate(face, func, reference, mask);
+  }
+
+  void stencil_mask(GLenum face, GLuint mask) noexcept {
+    if (!filter_face(face, &StencilFace::mask, mask)) return;
+    glStencilMaskSeparate(face, mask);
+  }
+
+  void use_program(GLuint id) noexcept {
+    if (!filter(program_, id)) return;
+    glUseProgram(id);
+  }
+
+  /**
+   * @brief UBOかSSBOをバインディングポイントにバインドする
+   * 
+   * @param target GL_UNIFORM_BUFFERかGL_SHADER_STORAGE_BUFFER。それ以外はそのまま発行する。
+   */
+  void bind_buffer_base(GLenum target, GLuint index, GLuint id) noexcept {
+    Cached<GLuint>* binding = buffer_binding(target, index);
+    if (binding && !filter(*binding, id)) return;
+    glBindBufferBase(target, index, id);
+  }
+
+  /**
+   * @brief glBindBufferRangeでバインドしたバインディングポイントを、覚えていない状態にする
+   */
+  void forget_buffer_binding(GLenum target, GLuint index) noexcept {
+    if (Cached<GLuint>* binding = buffer_binding(target, index)) binding->known = false;
+  }
+
+  /**
+   * @brief テクスチャユニットを選んでテクスチャをバインドする
+   */
+  void bind_texture(GLuint unit, GLenum target, GLuint id) noexcept {
+    const size_t index = texture_target_index(target);
+    if (unit < MAX_TEXTURE_UNITS && index < TEXTURE_TARGET_COUNT) {
+      if (!filter(textures_[unit][index], id)) return;
+    } else {
+      // 覚えていないバインドでも、アクティブなユニットは変わる
+      count(true);
+    }
+    if (filter(active_texture_, unit)) glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(target, id);
+  }
+
+  /**
+   * @brief アクティブなテクスチャユニットに直接バインドしたことを記録する
+   */
+  void texture_bound(GLenum target, GLuint id) noexcept {
+    const size_t index = texture_target_index(target);
+    if (index >= TEXTURE_TARGET_COUNT) return;
+    if (active_texture_.known && active_texture_.value < MAX_TEXTURE_UNITS) {
+      textures_[active_texture_.value][index].set(id);
+    } else {
+      for (auto& unit : textures_) unit[index].known = false;
+    }
+  }
+
+  void bind_sampler(GLuint unit, GLuint id) noexcept {
+    if (unit < MAX_TEXTURE_UNITS && !filter(samplers_[unit], id)) return;
+    glBindSampler(unit, id);
+  }
+
+  /**
+   * @brief 破棄するプログラムを覚えている状態から除く
+   * 
+   * 破棄したIDは新しいオブジェクトに再利用されるので、同じIDでもバインドを省いてはならない。
+   */
+  void forget_program(GLuint id) noexcept {
+    forget(program_, id);
+  }
+
+  /**
+   * @brief 破棄するバッファを覚えている状態から除く
+   */
+  void forget_buffer(GLuint id) noexcept {
+    for (auto& bindings : buffers_) {
+      for (auto& binding : bindings) forget(binding, id);
+    }
+  }
+
+  /**
+   * @brief 破棄するテクスチャを覚えている状態から除く
+   */
+  void forget_texture(GLuint id) noexcept {
+    for (auto& unit : textures_) {
+      for (auto& binding : unit) forget(binding, id);
+    }
+  }
+
+  /**
+   * @brief 破棄するサンプラを覚えている状態から除く
+   */
+  void forget_sampler(GLuint id) noexcept {
+    for (auto& binding : samplers_) forget(binding, id);
+  }
+
+ private:
+  /**
+   * @brief 覚えている値
+   */
+  template <typename T>
+  struct Cached {
+    T value{};  ///< 最後に設定した値
+    bool known = false;  ///< valueがGLの状態と一致しているか
+
+    /**
+     * @brief 値を設定する
+     * 
+     * @return true GLの呼び出しが必要
+     * @return false 同じ値が設定済み
+     */
+    bool set(const T& new_value) noexcept {
+      if (known && value == new_value) return false;
+      value = new_value;
+      known = true;
+      return true;
+    }
+  };
+
+  /**
+   * @brief カラーアタッチメントごとのブレンドの状態
+   */
+  struct Blend {
+    Cached<bool> enabled;  ///< ブレンドが有効か
+    Cached<std::array<GLenum, 4>> func;  ///< ブレンド係数
+    Cached<std::array<GLenum, 2>> equation;  ///< ブレンド式
+    Cached<std::array<GLboolean, 4>> color_mask;  ///< 書き込みマスク
+  };
+
+  /**
+   * @brief 面ごとのステンシルの状態
+   */
+  struct StencilFace {
+    Cached<std::array<GLenum, 3>> op;  ///< ステンシル処理
+    Cached<std::array<GLuint, 3>> func;  ///< 比較関数と参照値とマスク
+    Cached<GLuint> mask;  ///< 書き込みマスク
+  };
+
+  static constexpr GLenum CAPS[] = {
+      GL_DEPTH_CLAMP, GL_RASTERIZER_DISCARD, GL_CULL_FACE,
+      GL_POLYGON_OFFSET_POINT, GL_POLYGON_OFFSET_LINE, GL_POLYGON_OFFSET_FILL,
+      GL_DEPTH_TEST, GL_STENCIL_TEST, GL_SCISSOR_TEST,
+  };  ///< 覚えておく機能
+  static constexpr GLenum TEXTURE_TARGETS[] = {
+      GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_2D_ARRAY,
+      GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_MULTISAMPLE, GL_TEXTURE_BUFFER,
+  };  ///< 覚えておくテクスチャのターゲット
+  static constexpr size_t TEXTURE_TARGET_COUNT = std::size(TEXTURE_TARGETS);
+
+  StateCache() = default;
+
+  StateCache(size_t emitted_count, size_t skipped_count, size_t last_emitted_count, size_t last_skipped_count) noexcept
+      : emitted_count_(emitted_count), skipped_count_(skipped_count),
+        last_emitted_count_(last_emitted_count), last_skipped_count_(last_skipped_count) {}
+
+  static size_t cap_index(GLenum cap) noexcept {
+    return std::find(std::begin(CAPS), std::end(CAPS), cap) - std::begin(CAPS);
+  }
+
+  static size_t texture_target_index(GLenum target) noexcept {
+    return std::find(std::begin(TEXTURE_TARGETS), std::end(TEXTURE_TARGETS), target) - std::begin(TEXTURE_TARGETS);
+  }
+
+  Cached<GLuint>* buffer_binding(GLenum target, GLuint index) noexcept {
+    if (index >= MAX_BUFFER_BINDINGS) return nullptr;
+    if (target == GL_UNIFORM_BUFFER) return &buffers_[0][index];
+    if (target == GL_SHADER_STORAGE_BUFFER) return &buffers_[1][index];
+    return nullptr;
+  }
+
+  /**
+   * @brief 呼び出しを数える
+   * 
+   * @param emit GLに発行するか
+   * @return bool emitをそのまま返す
+   */
+  bool count(bool emit) noexcept {
+    if (emit) {
+      emitted_count_++;
+    } else {
+      skipped_count_++;
+    }
+    return emit;
+  }
+
+  template <typename T>
+  bool filter(Cached<T>& cached, const T& value) noexcept {
+    return count(cached.set(value));
+  }
+
+  /**
+   * @brief 呼び出しを数え、発行するならグループの適用済みのステートオブジェクトを忘れる
+   */
+  template <typename T>
+  bool filter(Group group, Cached<T>& cached, const T& value) noexcept {
+    const bool emit = filter(cached, value);
+    if (emit) touch(group);
+    return emit;
+  }
+
+  template <typename T>
+  bool filter_face(GLenum face, Cached<T> StencilFace::*member, const T& value) noexcept {
+    bool changed = false;
+    if (face == GL_FRONT || face == GL_FRONT_AND_BACK) changed |= (stencil_[0].*member).set(value);
+    if (face == GL_BACK || face == GL_FRONT_AND_BACK) changed |= (stencil_[1].*member).set(value);
+    if (changed) touch(Group::DEPTH_STENCIL);
+    return count(changed);
+  }
+
+  void touch(Group group) noexcept {
+    if (group != Group::COUNT) applied_[static_cast<size_t>(group)] = nullptr;
+  }
+
+  /**
+   * @brief 機能がどのステートオブジェクトで設定されるか
+   */
+  static Group cap_group(size_t index) noexcept {
+    switch (CAPS[index]) {
+      case GL_DEPTH_TEST:
+      case GL_STENCIL_TEST:
+        return Group::DEPTH_STENCIL;
+      case GL_SCISSOR_TEST:
+        return Group::COUNT;
+      default:
+        return Group::RASTERIZATION;
+    }
+  }
+
+  template <typename T>
+  static void forget(Cached<T>& cached, GLuint id) noexcept {
+    if (cached.value == id) cached.known = false;
+  }
+
+  std::array<Cached<bool>, std::size(CAPS)> caps_;  ///< 機能の有効無効
+  std::array<Blend, MAX_DRAW_BUFFERS> blends_;  ///< ブレンド
+  Cached<GLenum> polygon_mode_;  ///< ポリゴンモード
+  Cached<GLenum> cull_face_;  ///< カリングする面
+  Cached<GLenum> front_face_;  ///< 表面の向き
+  Cached<std::array<GLfloat, 2>> polygon_offset_;  ///< デプスバイアス
+  Cached<GLfloat> line_width_;  ///< 線の幅
+  Cached<GLboolean> depth_mask_;  ///< 深度の書き込み
+  Cached<GLenum> depth_func_;  ///< 深度の比較関数
+  Cached<std::array<GLfloat, 2>> depth_range_;  ///< 深度の範囲
+  std::array<StencilFace, 2> stencil_;  ///< 表面と裏面のステンシル
+  Cached<GLuint> program_;  ///< 使用中のプログラム
+  std::array<std::array<Cached<GLuint>, MAX_BUFFER_BINDINGS>, 2> buffers_;  ///< UBOとSSBOのバインディングポイント
+  Cached<GLuint> active_texture_;  ///< アクティブなテクスチャユニット
+  std::array<std::array<Cached<GLuint>, TEXTURE_TARGET_COUNT>, MAX_TEXTURE_UNITS> textures_;  ///< ユニットとターゲットごとのテクスチャ
+  std::array<Cached<GLuint>, MAX_TEXTURE_UNITS> samplers_;  ///< ユニットごとのサンプラ
+  std::array<const void*, static_cast<size_t>(Group::COUNT)> applied_{};  ///< 最後に適用した共有ステートオブジェクト
+  size_t emitted_count_ = 0;  ///< このフレームでGLに発行した呼び出しの数
+  size_t skipped_count_ = 0;  ///< このフレームで省いた呼び出しの数
+  size_t last_emitted_count_ = 0;  ///< 前のフレームでGLに発行した呼び出しの数
+  size_t last_skipped_count_ = 0;  ///< 前のフレームで省いた呼び出しの数
+};
+
 /**
  * @brief シェーダオブジェクト
  * 
@@ -134,6 +1186,8 @@ class Shader : public Object<Shader<TYPE>> {
  private:
   friend class Object<Shader<TYPE>>;
 
+  static constexpr ResourceType RESOURCE_TYPE = ResourceType::SHADER;
+
   static GLuint gen_impl() noexcept {
     return glCreateShader(TYPE);
   }
@@ -187,7 +1241,7 @@ class Program : public Object<Program> {
   }
 
   void use() const noexcept {
-    glUseProgram(id());
+    StateCache::get().use_program(id());
   }
 
   void uniform_block_binding(GLuint index, GLuint binding) const noexcept {
@@ -200,47 +1254,147 @@ class Program : public Object<Program> {
   }
 
  private:
-  friend class Object<Program>;
+  friend class Object<Program>;
+
+  static constexpr ResourceType RESOURCE_TYPE = ResourceType::PROGRAM;
+
+  static GLuint gen_impl() noexcept {
+    return glCreateProgram();
+  }
+
+  static void delete_impl(GLuint id) noexcept {
+    StateCache::get().forget_program(id);
+    return glDeleteProgram(id);
+  }
+};
+
+/**
+ * @brief バッファ
+ * 
+ */
+class Buffer : public Object<Buffer> {
+ public:
+  void bind(GLenum target) const noexcept {
+    glBindBuffer(target, id());
+  }
+
+  void bind_base(GLenum target, GLuint index) const noexcept {
+    StateCache::get().bind_buffer_base(target, index, id());
+  }
+
+  void bind_range(GLenum target, GLuint index, GLintptr offset,
+                  GLsizeiptr size) const noexcept {
+    StateCache::get().forget_buffer_binding(target, index);
+    glBindBufferRange(target, index, id(), offset, size);
+  }
+
+  /**
+   * @brief 変更できない領域を確保する
+   * 
+   * @param size 大きさ[byte]
+   * @param data 初期値。nullptrであれば未初期化
+   * @param flags GL_MAP_WRITE_BITなどの使用方法
+   */
+  void storage(GLsizeiptr size, const void* data, GLbitfield flags) const noexcept {
+#ifdef GARIE_USE_DSA
+    glNamedBufferStorage(id(), size, data, flags);
+#else
+    glBindBuffer(EDIT_TARGET, id());
+    glBufferStorage(EDIT_TARGET, size, data, flags);
+#endif
+    set_resource_size(static_cast<size_t>(size));
+  }
+
+  /**
+   * @brief 領域の一部を書き換える
+   * 
+   * storage()ではGL_DYNAMIC_STORAGE_BITを指定しておく。
+   */
+  void sub_data(GLintptr offset, GLsizeiptr size, const void* data) const noexcept {
+#ifdef GARIE_USE_DSA
+    glNamedBufferSubData(id(), offset, size, data);
+#else
+    glBindBuffer(EDIT_TARGET, id());
+    glBufferSubData(EDIT_TARGET, offset, size, data);
+#endif
+  }
+
+  /**
+   * @brief マップする
+   * 
+   * @return void* マップした領域へのポインタ。失敗すればnullptr
+   */
+  void* map(GLintptr offset, GLsizeiptr length, GLbitfield access) const noexcept {
+#ifdef GARIE_USE_DSA
+    return glMapNamedBufferRange(id(), offset, length, access);
+#else
+    glBindBuffer(EDIT_TARGET, id());
+    return glMapBufferRange(EDIT_TARGET, offset, length, access);
+#endif
+  }
+
+  /**
+   * @brief アンマップする
+   * 
+   * @return GLboolean 内容が壊れていなければGL_TRUE
+   */
+  GLboolean unmap() const noexcept {
+#ifdef GARIE_USE_DSA
+    return glUnmapNamedBuffer(id());
+#else
+    glBindBuffer(EDIT_TARGET, id());
+    return glUnmapBuffer(EDIT_TARGET);
+#endif
+  }
+
+ private:
+  friend class Object<Buffer>;
 
-  static GLuint gen_impl() noexcept {
-    return glCreateProgram();
+  static constexpr ResourceType RESOURCE_TYPE = ResourceType::BUFFER;
+
+#ifndef GARIE_USE_DSA
+  // VAOに記録されるGL_ELEMENT_ARRAY_BUFFERなどを避けて、描画に影響しないターゲットで編集する
+  static constexpr GLenum EDIT_TARGET = GL_COPY_WRITE_BUFFER;
+#endif
+
+  static GLuint gen_impl() {
+    static NamePool pool(
+        [](GLsizei n, GLuint* ids) {
+#ifdef GARIE_USE_DSA
+          glCreateBuffers(n, ids);
+#else
+          glGenBuffers(n, ids);
+#endif
+        },
+        [](GLsizei n, const GLuint* ids) { glDeleteBuffers(n, ids); });
+    return pool.acquire();
   }
 
   static void delete_impl(GLuint id) noexcept {
-    return glDeleteProgram(id);
+    StateCache::get().forget_buffer(id);
+    return glDeleteBuffers(1, &id);
   }
 };
 
 /**
- * @brief バッファ
+ * @brief バッファの一部の範囲
  * 
+ * バッファを所有しない。大きなバッファを切り分けて使うときに、範囲をまとめて持ち回る。
  */
-class Buffer : public Object<Buffer> {
- public:
-  void bind(GLenum target) const noexcept {
-    glBindBuffer(target, id());
-  }
-
-  void bind_base(GLenum target, GLuint index) const noexcept {
-    glBindBufferBase(target, index, id());
-  }
-
-  void bind_range(GLenum target, GLuint index, GLintptr offset,
-                  GLsizeiptr size) const noexcept {
-    glBindBufferRange(target, index, id(), offset, size);
-  }
-
- private:
-  friend class Object<Buffer>;
+struct BufferView {
+  const Buffer* buffer = nullptr;  ///< 範囲を含むバッファ
+  GLintptr offset = 0;  ///< バッファ内のオフセット[byte]
+  GLsizeiptr size = 0;  ///< 大きさ[byte]
 
-  static GLuint gen_impl() noexcept {
-    GLuint id = 0;
-    glGenBuffers(1, &id);
-    return id;
+  explicit operator bool() const noexcept {
+    return buffer != nullptr;
   }
 
-  static void delete_impl(GLuint id) noexcept {
-    return glDeleteBuffers(1, &id);
+  /**
+   * @brief 範囲をバインディングポイントにバインドする
+   */
+  void bind(GLenum target, GLuint index) const noexcept {
+    if (buffer) buffer->bind_range(target, index, offset, size);
   }
 };
 
@@ -257,10 +1411,19 @@ class VertexArray : public Object<VertexArray> {
  private:
   friend class Object<VertexArray>;
 
-  static GLuint gen_impl() noexcept {
-    GLuint id = 0;
-    glGenVertexArrays(1, &id);
-    return id;
+  static constexpr ResourceType RESOURCE_TYPE = ResourceType::VERTEX_ARRAY;
+
+  static GLuint gen_impl() {
+    static NamePool pool(
+        [](GLsizei n, GLuint* ids) {
+#ifdef GARIE_USE_DSA
+          glCreateVertexArrays(n, ids);
+#else
+          glGenVertexArrays(n, ids);
+#endif
+        },
+        [](GLsizei n, const GLuint* ids) { glDeleteVertexArrays(n, ids); });
+    return pool.acquire();
   }
 
   static void delete_impl(GLuint id) noexcept {
@@ -275,12 +1438,17 @@ class VertexArray : public Object<VertexArray> {
 class VertexArrayBuilder {
  public:
   /**
-   * @brief VAOを生成し、バインドする
+   * @brief VAOを生成する
    * 
+   * GARIE_USE_DSAを定義していなければ、build()までVAOをバインドする。
+   * 
+   * @param site 生成した場所。ResourceTrackerに記録する
    */
-  VertexArrayBuilder() {
-    vao_.gen();
+  explicit VertexArrayBuilder(const std::source_location& site = std::source_location::current()) {
+    vao_.gen(site);
+#ifndef GARIE_USE_DSA
     vao_.bind();
+#endif
   }
 
   ~VertexArrayBuilder() noexcept = default;
@@ -292,7 +1460,11 @@ class VertexArrayBuilder {
    * @return VertexArrayBuilder& 自身を返す
    */
   VertexArrayBuilder& index_buffer(const Buffer& buffer) noexcept {
+#ifdef GARIE_USE_DSA
+    glVertexArrayElementBuffer(vao_.id(), buffer.id());
+#else
     buffer.bind(GL_ELEMENT_ARRAY_BUFFER);
+#endif
     return *this;
   }
 
@@ -303,7 +1475,11 @@ class VertexArrayBuilder {
    * @return VertexArrayBuilder& 自身を返す
    */
   VertexArrayBuilder& vertex_buffer(const Buffer& buffer) noexcept {
+#ifdef GARIE_USE_DSA
+    vertex_buffer_ = buffer.id();
+#else
     buffer.bind(GL_ARRAY_BUFFER);
+#endif
     return *this;
   }
 
@@ -322,10 +1498,19 @@ class VertexArrayBuilder {
   VertexArrayBuilder& attribute(GLuint index, GLint size, GLenum type,
                                 GLboolean normalized, GLsizei stride,
                                 GLsizeiptr offset, GLuint divisor) noexcept {
+#ifdef GARIE_USE_DSA
+    // glVertexAttribPointerと同じく、属性ごとに同じ番号のバインディングを使う
+    glVertexArrayVertexBuffer(vao_.id(), index, vertex_buffer_, offset, stride);
+    glVertexArrayAttribFormat(vao_.id(), index, size, type, normalized, 0);
+    glVertexArrayAttribBinding(vao_.id(), index, index);
+    glVertexArrayBindingDivisor(vao_.id(), index, divisor);
+    glEnableVertexArrayAttrib(vao_.id(), index);
+#else
     glEnableVertexAttribArray(index);
     glVertexAttribPointer(index, size, type, normalized, stride,
                           reinterpret_cast<void*>(offset));
     glVertexAttribDivisor(index, divisor);
+#endif
     return *this;
   }
 
@@ -335,12 +1520,17 @@ class VertexArrayBuilder {
    * @return VertexArray VAOを返す
    */
   VertexArray build() noexcept {
+#ifndef GARIE_USE_DSA
     glBindVertexArray(0);
+#endif
     return std::move(vao_);
   }
 
  private:
   VertexArray vao_;
+#ifdef GARIE_USE_DSA
+  GLuint vertex_buffer_ = 0;  ///< attribute()が参照する頂点バッファ
+#endif
 };
 
 /**
@@ -349,13 +1539,31 @@ class VertexArrayBuilder {
  */
 class Texture : public Object<Texture> {
  public:
+  /**
+   * @brief 生成する
+   * 
+   * @param target GL_TEXTURE_2Dなどのターゲット。後から変えられない。
+   * @param site 生成した場所。ResourceTrackerに記録する
+   */
+  void gen(GLenum target, const std::source_location& site = std::source_location::current()) noexcept {
+    gen_at(site, target);
+    target_ = target;
+  }
+
+  /**
+   * @brief 生成時のターゲットを返す
+   */
+  GLenum target() const noexcept {
+    return target_;
+  }
+
   void bind(GLenum target) const noexcept {
     glBindTexture(target, id());
+    StateCache::get().texture_bound(target, id());
   }
 
   void active(GLuint index, GLenum target) const noexcept {
-    glActiveTexture(GL_TEXTURE0 + index);
-    glBindTexture(target, id());
+    StateCache::get().bind_texture(index, target, id());
   }
 
   void bind_image(GLuint unit, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format) const noexcept {
@@ -370,18 +1578,137 @@ class Texture : public Object<Texture> {
     glBindImageTexture(unit, id(), 0, GL_TRUE, 0, access, format);
   }
 
+  void storage_2d(GLsizei levels, GLenum internal_format, GLsizei width, GLsizei height) const noexcept {
+#ifdef GARIE_USE_DSA
+    glTextureStorage2D(id(), levels, internal_format, width, height);
+#else
+    bind(target_);
+    glTexStorage2D(target_, levels, internal_format, width, height);
+#endif
+    set_resource_size(detail::texture_storage_size(target_, levels, internal_format, width, height, 1));
+  }
+
+  void storage_3d(GLsizei levels, GLenum internal_format, GLsizei width, GLsizei height, GLsizei depth) const noexcept {
+#ifdef GARIE_USE_DSA
+    glTextureStorage3D(id(), levels, internal_format, width, height, depth);
+#else
+    bind(target_);
+    glTexStorage3D(target_, levels, internal_format, width, height, depth);
+#endif
+    set_resource_size(detail::texture_storage_size(target_, levels, internal_format, width, height, depth));
+  }
+
+  void storage_2d_multisample(GLsizei samples, GLenum internal_format, GLsizei width, GLsizei height,
+                              GLboolean fixed_sample_locations = GL_TRUE) const noexcept {
+#ifdef GARIE_USE_DSA
+    glTextureStorage2DMultisample(id(), samples, internal_format, width, height, fixed_sample_locations);
+#else
+    bind(target_);
+    glTexStorage2DMultisample(target_, samples, internal_format, width, height, fixed_sample_locations);
+#endif
+    set_resource_size(detail::texture_storage_size(target_, 1, internal_format, width, height, 1) * samples);
+  }
+
+  void sub_image_2d(GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+                    GLenum format, GLenum type, const void* pixels) const noexcept {
+#ifdef GARIE_USE_DSA
+    glTextureSubImage2D(id(), level, x, y, width, height, format, type, pixels);
+#else
+    bind(target_);
+    glTexSubImage2D(target_, level, x, y, width, height, format, type, pixels);
+#endif
+  }
+
  private:
   friend class Object<Texture>;
 
-  static GLuint gen_impl() noexcept {
+  static constexpr ResourceType RESOURCE_TYPE = ResourceType::TEXTURE;
+
+  static GLuint gen_impl(GLenum target) {
+#ifdef GARIE_USE_DSA
+    // glCreateTexturesはターゲットごとに生成するので、まとめて生成しない
     GLuint id = 0;
-    glGenTextures(1, &id);
+    glCreateTextures(target, 1, &id);
+#else
+    static NamePool pool(
+        [](GLsizei n, GLuint* ids) { glGenTextures(n, ids); },
+        [](GLsizei n, const GLuint* ids) { glDeleteTextures(n, ids); });
+    const GLuint id = pool.acquire();
+    glBindTexture(target, id);
+    StateCache::get().texture_bound(target, id);
+#endif
     return id;
   }
 
   static void delete_impl(GLuint id) noexcept {
+    StateCache::get().forget_texture(id);
     return glDeleteTextures(1, &id);
   }
+
+  GLenum target_ = GL_NONE;  ///< 生成時のターゲット
+};
+
+/**
+ * @brief クエリ
+ * 
+ */
+class Query : public Object<Query> {
+ public:
+  void begin(GLenum target) const noexcept {
+    glBeginQuery(target, id());
+  }
+
+  void end(GLenum target) const noexcept {
+    glEndQuery(target);
+  }
+
+  /**
+   * @brief GPUの時刻を記録する
+   */
+  void timestamp() const noexcept {
+    glQueryCounter(id(), GL_TIMESTAMP);
+  }
+
+  /**
+   * @brief 結果が利用可能かを調べる
+   * 
+   * @return true 利用可能
+   * @return false まだGPUで処理中
+   */
+  bool available() const noexcept {
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(id(), GL_QUERY_RESULT_AVAILABLE, &available);
+    return available == GL_TRUE;
+  }
+
+  /**
+   * @brief 結果を取得する
+   * 
+   * 結果が利用可能になるまでブロックする。
+   * 
+   * @return GLuint64 結果
+   */
+  GLuint64 result() const noexcept {
+    GLuint64 result = 0;
+    glGetQueryObjectui64v(id(), GL_QUERY_RESULT, &result);
+    return result;
+  }
+
+ private:
+  friend class Object<Query>;
+
+  static constexpr ResourceType RESOURCE_TYPE = ResourceType::QUERY;
+
+  static GLuint gen_impl() {
+    static NamePool pool(
+        [](GLsizei n, GLuint* ids) { glGenQueries(n, ids); },
+        [](GLsizei n, const GLuint* ids) { glDeleteQueries(n, ids); });
+    return pool.acquire();
+  }
+
+  static void delete_impl(GLuint id) noexcept {
+    return glDeleteQueries(1, &id);
+  }
 };
 
 /**
@@ -391,7 +1718,7 @@ class Texture : public Object<Texture> {
 class Sampler : public Object<Sampler> {
  public:
   void bind(GLuint unit) const noexcept {
-    glBindSampler(unit, id());
+    StateCache::get().bind_sampler(unit, id());
   }
 
   void parameter(GLenum pname, GLfloat param) const noexcept {
@@ -425,110 +1752,289 @@ class Sampler : public Object<Sampler> {
  private:
   friend class Object<Sampler>;
 
-  static GLuint gen_impl() noexcept {
-    GLuint id = 0;
-    glGenSamplers(1, &id);
-    return id;
+  static constexpr ResourceType RESOURCE_TYPE = ResourceType::SAMPLER;
+
+  static GLuint gen_impl() {
+    static NamePool pool(
+        [](GLsizei n, GLuint* ids) {
+#ifdef GARIE_USE_DSA
+          glCreateSamplers(n, ids);
+#else
+          glGenSamplers(n, ids);
+#endif
+        },
+        [](GLsizei n, const GLuint* ids) { glDeleteSamplers(n, ids); });
+    return pool.acquire();
   }
 
   static void delete_impl(GLuint id) noexcept {
+    StateCache::get().forget_sampler(id);
     return glDeleteSamplers(1, &id);
   }
 };
 
 /**
- * @brief サンプラを構築するビルダークラス
+ * @brief サンプラのパラメータ
  * 
+ * 既定値はGLの初期値に合わせている。
  */
-class SamplerBuilder final {
+struct SamplerDesc {
+  /**
+   * @brief 境界色の型
+   */
+  enum class BorderType : uint32_t {
+    FLOAT,  ///< glSamplerParameterfv
+    INT,  ///< glSamplerParameteriv(正規化される)
+    INTEGER_INT,  ///< glSamplerParameterIiv
+    INTEGER_UINT,  ///< glSamplerParameterIuiv
+  };
+
+  GLenum min_filter = GL_NEAREST_MIPMAP_LINEAR;  ///< 縮小フィルタ
+  GLenum mag_filter = GL_LINEAR;  ///< 拡大フィルタ
+  GLenum wrap_s = GL_REPEAT;  ///< S方向のラップモード
+  GLenum wrap_t = GL_REPEAT;  ///< T方向のラップモード
+  GLenum wrap_r = GL_REPEAT;  ///< R方向のラップモード
+  GLfloat min_lod = -1000.f;  ///< LODの最小値
+  GLfloat max_lod = 1000.f;  ///< LODの最大値
+  GLfloat lod_bias = 0.f;  ///< LODバイアス
+  BorderType border_type = BorderType::FLOAT;  ///< 境界色の型
+  std::array<uint32_t, 4> border_color{};  ///< 境界色。border_typeの型のビット列
+
+  bool operator==(const SamplerDesc&) const noexcept = default;
+
+  size_t hash() const noexcept {
+    size_t seed = 0;
+    detail::hash_combine(seed, min_filter);
+    detail::hash_combine(seed, mag_filter);
+    detail::hash_combine(seed, wrap_s);
+    detail::hash_combine(seed, wrap_t);
+    detail::hash_combine(seed, wrap_r);
+    detail::hash_combine(seed, min_lod);
+    detail::hash_combine(seed, max_lod);
+    detail::hash_combine(seed, lod_bias);
+    detail::hash_combine(seed, static_cast<uint32_t>(border_type));
+    for (const auto bits : border_color) detail::hash_combine(seed, bits);
+    return seed;
+  }
+
+  /**
+   * @brief パラメータを設定したサンプラを生成する
+   * 
+   * @param site 生成した場所。ResourceTrackerに記録する
+   */
+  Sampler create(const std::source_location& site = std::source_location::current()) const {
+    Sampler sampler;
+    sampler.gen(site);
+    sampler.parameter(GL_TEXTURE_MIN_FILTER, min_filter);
+    sampler.parameter(GL_TEXTURE_MAG_FILTER, mag_filter);
+    sampler.parameter(GL_TEXTURE_WRAP_S, wrap_s);
+    sampler.parameter(GL_TEXTURE_WRAP_T, wrap_t);
+    sampler.parameter(GL_TEXTURE_WRAP_R, wrap_r);
+    sampler.parameter(GL_TEXTURE_MIN_LOD, min_lod);
+    sampler.parameter(GL_TEXTURE_MAX_LOD, max_lod);
+    sampler.parameter(GL_TEXTURE_LOD_BIAS, lod_bias);
+    switch (border_type) {
+      case BorderType::FLOAT:
+        sampler.parameter(GL_TEXTURE_BORDER_COLOR, reinterpret_cast<const GLfloat*>(border_color.data()));
+        break;
+      case BorderType::INT:
+        sampler.parameter(GL_TEXTURE_BORDER_COLOR, reinterpret_cast<const GLint*>(border_color.data()));
+        break;
+      case BorderType::INTEGER_INT:
+        sampler.parameter_int(GL_TEXTURE_BORDER_COLOR, reinterpret_cast<const GLint*>(border_color.data()));
+        break;
+      case BorderType::INTEGER_UINT:
+        sampler.parameter_int(GL_TEXTURE_BORDER_COLOR, border_color.data());
+        break;
+    }
+    return sampler;
+  }
+};
+
+/**
+ * @brief パラメータが同じサンプラを共有するキャッシュ
+ * 
+ * 使う側がstd::shared_ptrを持ち、キャッシュは弱参照だけを持つ。
+ * すべての使う側が手放したサンプラは、DeletionQueueを通して破棄される。
+ */
+class SamplerCache final {
  public:
+  static SamplerCache& get() noexcept {
+    static SamplerCache self;
+    return self;
+  }
+
   /**
-   * @brief サンプラを生成する
+   * @brief パラメータが同じサンプラを探し、なければ生成する
    * 
+   * @param desc パラメータ
+   * @param site 生成するときに、ResourceTrackerに記録する場所
+   * @return std::shared_ptr<const Sampler> 共有されたサンプラ
+   */
+  std::shared_ptr<const Sampler> acquire(const SamplerDesc& desc,
+                                         const std::source_location& site = std::source_location::current()) {
+    auto& bucket = buckets_[desc.hash()];
+    bucket.erase(std::remove_if(bucket.begin(), bucket.end(), [](const Entry& entry) {
+      return entry.sampler.expired();
+    }), bucket.end());
+    for (const auto& entry : bucket) {
+      if (entry.desc == desc) {
+        hit_count_++;
+        return entry.sampler.lock();
+      }
+    }
+    auto sampler = std::make_shared<const Sampler>(desc.create(site));
+    bucket.push_back(Entry{desc, sampler});
+    created_count_++;
+    return sampler;
+  }
+
+  /**
+   * @brief 生きているサンプラの数
+   */
+  size_t size() const noexcept {
+    size_t size = 0;
+    for (const auto& [hash, bucket] : buckets_) {
+      size += std::count_if(bucket.begin(), bucket.end(), [](const Entry& entry) {
+        return !entry.sampler.expired();
+      });
+    }
+    return size;
+  }
+
+  /**
+   * @brief 既存のサンプラを返した回数
+   */
+  size_t hit_count() const noexcept {
+    return hit_count_;
+  }
+
+  /**
+   * @brief サンプラを生成した回数
    */
-  SamplerBuilder() {
-    sampler_.gen();
+  size_t created_count() const noexcept {
+    return created_count_;
   }
 
+ private:
+  /**
+   * @brief 共有しているサンプラ
+   */
+  struct Entry {
+    SamplerDesc desc;  ///< パラメータ
+    std::weak_ptr<const Sampler> sampler;  ///< サンプラ
+  };
+
+  SamplerCache() = default;
+
+  std::unordered_map<size_t, std::vector<Entry>> buckets_;  ///< ハッシュ値ごとのサンプラ
+  size_t hit_count_ = 0;  ///< 既存のサンプラを返した回数
+  size_t created_count_ = 0;  ///< サンプラを生成した回数
+};
+
+/**
+ * @brief サンプラを構築するビルダークラス
+ * 
+ * パラメータを記録しておき、build()で生成するか、build_shared()で共有する。
+ */
+class SamplerBuilder final {
+ public:
+  SamplerBuilder() = default;
+
   ~SamplerBuilder() = default;
 
   SamplerBuilder& lod_bias(const GLfloat* values) noexcept {
-    sampler_.parameter(GL_TEXTURE_LOD_BIAS, values);
+    desc_.lod_bias = values[0];
     return *this;
   }
 
   SamplerBuilder& min_filter(GLenum mode) noexcept {
-    sampler_.parameter(GL_TEXTURE_MIN_FILTER, mode);
+    desc_.min_filter = mode;
     return *this;
   }
 
   SamplerBuilder& mag_filter(GLenum mode) noexcept {
-    sampler_.parameter(GL_TEXTURE_MAG_FILTER, mode);
+    desc_.mag_filter = mode;
     return *this;
   }
 
   SamplerBuilder& lod(GLfloat min_lod, GLfloat max_lod) noexcept {
-    sampler_.parameter(GL_TEXTURE_MIN_LOD, min_lod);
-    sampler_.parameter(GL_TEXTURE_MAX_LOD, max_lod);
+    desc_.min_lod = min_lod;
+    desc_.max_lod = max_lod;
     return *this;
   }
 
   SamplerBuilder& min_lod(GLfloat lod) noexcept {
-    sampler_.parameter(GL_TEXTURE_MIN_LOD, lod);
+    desc_.min_lod = lod;
     return *this;
   }
 
   SamplerBuilder& max_lod(GLfloat lod) noexcept {
-    sampler_.parameter(GL_TEXTURE_MAX_LOD, lod);
+    desc_.max_lod = lod;
     return *this;
   }
 
   SamplerBuilder& wrap_s(GLenum mode) noexcept {
-    sampler_.parameter(GL_TEXTURE_WRAP_S, mode);
+    desc_.wrap_s = mode;
     return *this;
   }
 
   SamplerBuilder& wrap_t(GLenum mode) noexcept {
-    sampler_.parameter(GL_TEXTURE_WRAP_T, mode);
+    desc_.wrap_t = mode;
     return *this;
   }
 
   SamplerBuilder& wrap_r(GLenum mode) noexcept {
-    sampler_.parameter(GL_TEXTURE_WRAP_R, mode);
+    desc_.wrap_r = mode;
     return *this;
   }
 
   SamplerBuilder& border_color(const GLfloat* color) noexcept {
-    sampler_.parameter(GL_TEXTURE_BORDER_COLOR, color);
-    return *this;
+    return set_border_color(SamplerDesc::BorderType::FLOAT, color);
   }
 
   SamplerBuilder& border_color(const GLint* color) noexcept {
-    sampler_.parameter(GL_TEXTURE_BORDER_COLOR, color);
-    return *this;
+    return set_border_color(SamplerDesc::BorderType::INT, color);
   }
 
   SamplerBuilder& border_color_int(const GLint* color) noexcept {
-    sampler_.parameter_int(GL_TEXTURE_BORDER_COLOR, color);
-    return *this;
+    return set_border_color(SamplerDesc::BorderType::INTEGER_INT, color);
   }
 
   SamplerBuilder& border_color_int(const GLuint* color) noexcept {
-    sampler_.parameter_int(GL_TEXTURE_BORDER_COLOR, color);
-    return *this;
+    return set_border_color(SamplerDesc::BorderType::INTEGER_UINT, color);
   }
 
   /**
-   * @brief 状態を確定させる
+   * @brief サンプラを生成する
    * 
+   * @param site 生成した場所。ResourceTrackerに記録する
    * @return Sampler サンプラ
    */
-  Sampler build() noexcept {
-    return std::move(sampler_);
+  Sampler build(const std::source_location& site = std::source_location::current()) {
+    return desc_.create(site);
+  }
+
+  /**
+   * @brief パラメータが同じサンプラと共有する
+   * 
+   * @param site 生成するときに、ResourceTrackerに記録する場所
+   * @return std::shared_ptr<const Sampler> 共有されたサンプラ
+   */
+  std::shared_ptr<const Sampler> build_shared(const std::source_location& site = std::source_location::current()) {
+    return SamplerCache::get().acquire(desc_, site);
   }
 
  private:
-  Sampler sampler_;
+  template <typename T>
+  SamplerBuilder& set_border_color(SamplerDesc::BorderType type, const T* color) noexcept {
+    static_assert(sizeof(T) == sizeof(uint32_t));
+    desc_.border_type = type;
+    std::memcpy(desc_.border_color.data(), color, sizeof(desc_.border_color));
+    return *this;
+  }
+
+  SamplerDesc desc_;
 };
 
 /**
@@ -544,10 +2050,19 @@ class Framebuffer final : public Object<Framebuffer> {
  private:
   friend class Object<Framebuffer>;
 
-  static GLuint gen_impl() noexcept {
-    GLuint id = 0;
-    glGenFramebuffers(1, &id);
-    return id;
+  static constexpr ResourceType RESOURCE_TYPE = ResourceType::FRAMEBUFFER;
+
+  static GLuint gen_impl() {
+    static NamePool pool(
+        [](GLsizei n, GLuint* ids) {
+#ifdef GARIE_USE_DSA
+          glCreateFramebuffers(n, ids);
+#else
+          glGenFramebuffers(n, ids);
+#endif
+        },
+        [](GLsizei n, const GLuint* ids) { glDeleteFramebuffers(n, ids); });
+    return pool.acquire();
   }
 
   static void delete_impl(GLuint id) noexcept {
@@ -561,9 +2076,18 @@ class Framebuffer final : public Object<Framebuffer> {
  */
 class FramebufferBuilder final {
  public:
-  FramebufferBuilder() {
-    framebuffer_.gen();
+  /**
+   * @brief フレームバッファを生成する
+   * 
+   * GARIE_USE_DSAを定義していなければ、build()までGL_FRAMEBUFFERにバインドする。
+   * 
+   * @param site 生成した場所。ResourceTrackerに記録する
+   */
+  explicit FramebufferBuilder(const std::source_location& site = std::source_location::current()) {
+    framebuffer_.gen(site);
+#ifndef GARIE_USE_DSA
     framebuffer_.bind(GL_FRAMEBUFFER);
+#endif
   }
 
   FramebufferBuilder(const FramebufferBuilder&) = delete;
@@ -576,49 +2100,60 @@ class FramebufferBuilder final {
 
   FramebufferBuilder& operator=(FramebufferBuilder&&) = delete;
 
+  /**
+   * @brief IDでテクスチャを取り付ける
+   * 
+   * @param attachment GL_COLOR_ATTACHMENTiなど。カラーアタッチメントは呼び出した順にglDrawBuffersに並ぶ。
+   * @param texture テクスチャID
+   * @param level ミップマップレベル
+   */
+  FramebufferBuilder& attachment(GLenum attachment, GLuint texture,
+                                 GLint level = 0) noexcept {
+    attach(attachment, texture, level);
+    if (attachment != GL_DEPTH_ATTACHMENT && attachment != GL_STENCIL_ATTACHMENT &&
+        attachment != GL_DEPTH_STENCIL_ATTACHMENT) {
+      draw_buffers_.push_back(attachment);
+    }
+    return *this;
+  }
+
   FramebufferBuilder& color_texture(GLuint index, const Texture& texture,
                                     GLint level = 0) noexcept {
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + index,
-                         texture.id(), level);
+    attach(GL_COLOR_ATTACHMENT0 + index, texture.id(), level);
     draw_buffers_.push_back(GL_COLOR_ATTACHMENT0 + index);
     return *this;
   }
 
   FramebufferBuilder& depth_texture(const Texture& texture,
                                     GLint level = 0) noexcept {
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture.id(),
-                         level);
+    attach(GL_DEPTH_ATTACHMENT, texture.id(), level);
     return *this;
   }
 
   FramebufferBuilder& depthstencil_texture(const Texture& texture,
                                            GLint level = 0) noexcept {
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
-                         texture.id(), level);
+    attach(GL_DEPTH_STENCIL_ATTACHMENT, texture.id(), level);
     return *this;
   }
 
   FramebufferBuilder& color_texture_2d(GLuint index, GLenum target,
                                        const Texture& texture,
                                        GLint level = 0) noexcept {
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + index, target,
-                           texture.id(), level);
+    attach_2d(GL_COLOR_ATTACHMENT0 + index, target, texture.id(), level);
     draw_buffers_.push_back(GL_COLOR_ATTACHMENT0 + index);
     return *this;
   }
 
   FramebufferBuilder& depth_texture_2d(GLenum target, const Texture& texture,
                                        GLint level = 0) noexcept {
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, target,
-                           texture.id(), level);
+    attach_2d(GL_DEPTH_ATTACHMENT, target, texture.id(), level);
     return *this;
   }
 
   FramebufferBuilder& depthstencil_texture_2d(GLenum target,
                                               const Texture& texture,
                                               GLint level = 0) noexcept {
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, target,
-                           texture.id(), level);
+    attach_2d(GL_DEPTH_STENCIL_ATTACHMENT, target, texture.id(), level);
     return *this;
   }
 
@@ -626,8 +2161,7 @@ class FramebufferBuilder final {
                                           const Texture& texture,
                                           GLint level = 0,
                                           GLint layer = 0) noexcept {
-    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + index,
-                              texture.id(), level, layer);
+    attach_layer(GL_COLOR_ATTACHMENT0 + index, texture.id(), level, layer);
     draw_buffers_.push_back(GL_COLOR_ATTACHMENT0 + index);
     return *this;
   }
@@ -635,8 +2169,7 @@ class FramebufferBuilder final {
   FramebufferBuilder& depth_texture_layer(GLenum target, const Texture& texture,
                                           GLint level = 0,
                                           GLint layer = 0) noexcept {
-    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture.id(),
-                              level, layer);
+    attach_layer(GL_DEPTH_ATTACHMENT, texture.id(), level, layer);
     return *this;
   }
 
@@ -644,23 +2177,110 @@ class FramebufferBuilder final {
                                                  const Texture& texture,
                                                  GLint level = 0,
                                                  GLint layer = 0) noexcept {
-    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
-                              texture.id(), level, layer);
+    attach_layer(GL_DEPTH_STENCIL_ATTACHMENT, texture.id(), level, layer);
     return *this;
   }
 
-  Framebuffer build() noexcept {
+  /**
+   * @brief 状態を確定させる
+   * 
+   * @param status nullptrでなければ、glCheckFramebufferStatusの結果を書き出す
+   * @return Framebuffer フレームバッファ
+   */
+  Framebuffer build(GLenum* status = nullptr) noexcept {
+#ifdef GARIE_USE_DSA
+    glNamedFramebufferDrawBuffers(framebuffer_.id(), static_cast<GLsizei>(draw_buffers_.size()), draw_buffers_.data());
+    const GLenum result = glCheckNamedFramebufferStatus(framebuffer_.id(), GL_FRAMEBUFFER);
+#else
     glDrawBuffers(static_cast<GLsizei>(draw_buffers_.size()), draw_buffers_.data());
     const GLenum result = glCheckFramebufferStatus(GL_FRAMEBUFFER);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+#endif
+    if (status) *status = result;
     return std::move(framebuffer_);
   }
 
  private:
+  void attach(GLenum attachment, GLuint texture, GLint level) noexcept {
+#ifdef GARIE_USE_DSA
+    glNamedFramebufferTexture(framebuffer_.id(), attachment, texture, level);
+#else
+    glFramebufferTexture(GL_FRAMEBUFFER, attachment, texture, level);
+#endif
+  }
+
+  void attach_2d(GLenum attachment, GLenum target, GLuint texture, GLint level) noexcept {
+#ifdef GARIE_USE_DSA
+    // DSAにはターゲットを取る関数がないので、キューブマップの面はレイヤーとして取り付ける
+    if (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z) {
+      glNamedFramebufferTextureLayer(framebuffer_.id(), attachment, texture, level,
+                                     static_cast<GLint>(target - GL_TEXTURE_CUBE_MAP_POSITIVE_X));
+    } else {
+      glNamedFramebufferTexture(framebuffer_.id(), attachment, texture, level);
+    }
+#else
+    glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, target, texture, level);
+#endif
+  }
+
+  void attach_layer(GLenum attachment, GLuint texture, GLint level, GLint layer) noexcept {
+#ifdef GARIE_USE_DSA
+    glNamedFramebufferTextureLayer(framebuffer_.id(), attachment, texture, level, layer);
+#else
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, attachment, texture, level, layer);
+#endif
+  }
+
   Framebuffer framebuffer_;
   std::vector<GLenum> draw_buffers_;
 };
 
+/**
+ * @brief 内容が同じステートオブジェクトを1つにまとめて共有するキャッシュ
+ * 
+ * 共有したオブジェクトは変更せず、破棄もしない。GLオブジェクトではないので、コンテキストを作り直しても使える。
+ * 共有したオブジェクトのapply()は、StateCacheがポインタで比べて省く。
+ * 
+ * @tparam T ステートオブジェクトの型。`size_t hash()`と`operator==`を持つ
+ */
+template <typename T>
+class StateObjectCache final {
+ public:
+  static StateObjectCache& get() noexcept {
+    static StateObjectCache self;
+    return self;
+  }
+
+  /**
+   * @brief 内容が同じオブジェクトを探し、なければ登録する
+   * 
+   * @return const T& 共有されたオブジェクト。アドレスは変わらない
+   */
+  const T& intern(const T& state) {
+    auto& bucket = buckets_[state.hash()];
+    for (const auto& shared : bucket) {
+      if (*shared == state) return *shared;
+    }
+    auto shared = std::make_unique<T>(state);
+    shared->shared_.value = true;
+    size_++;
+    return *bucket.emplace_back(std::move(shared));
+  }
+
+  /**
+   * @brief 共有しているオブジェクトの数
+   */
+  size_t size() const noexcept {
+    return size_;
+  }
+
+ private:
+  StateObjectCache() = default;
+
+  std::unordered_map<size_t, std::vector<std::unique_ptr<T>>> buckets_;  ///< ハッシュ値ごとの共有しているオブジェクト
+  size_t size_ = 0;  ///< 共有しているオブジェクトの数
+};
+
 /**
  * @brief ラスタライザーステート
  * 
@@ -672,43 +2292,44 @@ class RasterizationState final {
    * 
    */
   void apply() const noexcept {
-    if (is_depth_clamp_enabled_) {
-      glEnable(GL_DEPTH_CLAMP);
-    } else {
-      glDisable(GL_DEPTH_CLAMP);
-    }
-
-    if (is_rasterizer_discard_enabled_) {
-      glEnable(GL_RASTERIZER_DISCARD);
-    } else {
-      glDisable(GL_RASTERIZER_DISCARD);
-    }
-
-    glPolygonMode(GL_FRONT_AND_BACK, polygon_mode_);
-    if (cull_mode_ != GL_NONE) {
-      glEnable(GL_CULL_FACE);
-      glCullFace(cull_mode_);
-    } else {
-      glDisable(GL_CULL_FACE);
-    }
-    glFrontFace(front_face_);
-    if (is_depth_bias_enabled_) {
-      glEnable(GL_POLYGON_OFFSET_POINT);
-      glEnable(GL_POLYGON_OFFSET_LINE);
-      glEnable(GL_POLYGON_OFFSET_FILL);
-    } else {
-      glDisable(GL_POLYGON_OFFSET_POINT);
-      glDisable(GL_POLYGON_OFFSET_LINE);
-      glDisable(GL_POLYGON_OFFSET_FILL);
-    }
-    glPolygonOffset(depth_bias_constant_, depth_bias_slope_);
+    auto& cache = StateCache::get();
+    if (shared_.value && cache.is_applied(StateCache::Group::RASTERIZATION, this)) return;
+    cache.enable(GL_DEPTH_CLAMP, is_depth_clamp_enabled_);
+    cache.enable(GL_RASTERIZER_DISCARD, is_rasterizer_discard_enabled_);
+    cache.polygon_mode(polygon_mode_);
+    cache.enable(GL_CULL_FACE, cull_mode_ != GL_NONE);
+    if (cull_mode_ != GL_NONE) cache.cull_face(cull_mode_);
+    cache.front_face(front_face_);
+    cache.enable(GL_POLYGON_OFFSET_POINT, is_depth_bias_enabled_);
+    cache.enable(GL_POLYGON_OFFSET_LINE, is_depth_bias_enabled_);
+    cache.enable(GL_POLYGON_OFFSET_FILL, is_depth_bias_enabled_);
+    cache.polygon_offset(depth_bias_constant_, depth_bias_slope_);
     // glPolygonOffsetClamp(depth_bias_constant_, depth_bias_slope_,
     // depth_bias_clamp_);
-    glLineWidth(line_width_);
+    cache.line_width(line_width_);
+    if (shared_.value) cache.set_applied(StateCache::Group::RASTERIZATION, this);
+  }
+
+  bool operator==(const RasterizationState&) const noexcept = default;
+
+  size_t hash() const noexcept {
+    size_t seed = 0;
+    detail::hash_combine(seed, is_depth_clamp_enabled_);
+    detail::hash_combine(seed, is_rasterizer_discard_enabled_);
+    detail::hash_combine(seed, polygon_mode_);
+    detail::hash_combine(seed, cull_mode_);
+    detail::hash_combine(seed, front_face_);
+    detail::hash_combine(seed, is_depth_bias_enabled_);
+    detail::hash_combine(seed, depth_bias_constant_);
+    detail::hash_combine(seed, depth_bias_clamp_);
+    detail::hash_combine(seed, depth_bias_slope_);
+    detail::hash_combine(seed, line_width_);
+    return seed;
   }
 
  private:
   friend class RasterizationStateBuilder;
+  friend class StateObjectCache<RasterizationState>;
 
   bool is_depth_clamp_enabled_ = false;
   bool is_rasterizer_discard_enabled_ = false;
@@ -720,6 +2341,7 @@ class RasterizationState final {
   GLfloat depth_bias_clamp_ = 0.f;
   GLfloat depth_bias_slope_ = 0.f;
   GLfloat line_width_ = 1.f;
+  detail::SharedFlag shared_;  ///< StateObjectCacheで共有されているか
 };
 
 /**
@@ -772,6 +2394,15 @@ class RasterizationStateBuilder final {
     return std::move(state_);
   }
 
+  /**
+   * @brief 内容が同じステートと共有する
+   * 
+   * @return const RasterizationState& 共有されたステート
+   */
+  const RasterizationState& build_shared() {
+    return StateObjectCache<RasterizationState>::get().intern(state_);
+  }
+
  private:
   RasterizationState state_;
 };
@@ -783,18 +2414,28 @@ class RasterizationStateBuilder final {
 class ColorBlendAttachmentState final {
  public:
   void apply(GLuint index) const noexcept {
+    auto& cache = StateCache::get();
+    cache.enable_blend(index, is_enabled_);
     if (is_enabled_) {
-      glEnablei(GL_BLEND, index);
-      glBlendFuncSeparatei(index, src_color_, dst_color_, src_alpha_,
-                           dst_alpha_);
-      glBlendEquationSeparatei(index, color_op_, alpha_op_);
-      glColorMaski(index, color_write_mask_[0], color_write_mask_[1],
-                   color_write_mask_[2], color_write_mask_[3]);
-    } else {
-      glDisablei(GL_BLEND, index);
+      cache.blend_func(index, src_color_, dst_color_, src_alpha_, dst_alpha_);
+      cache.blend_equation(index, color_op_, alpha_op_);
+      cache.color_mask(index, color_write_mask_);
     }
   }
 
+  bool operator==(const ColorBlendAttachmentState&) const noexcept = default;
+
+  void hash(size_t& seed) const noexcept {
+    detail::hash_combine(seed, is_enabled_);
+    detail::hash_combine(seed, src_color_);
+    detail::hash_combine(seed, dst_color_);
+    detail::hash_combine(seed, color_op_);
+    detail::hash_combine(seed, src_alpha_);
+    detail::hash_combine(seed, dst_alpha_);
+    detail::hash_combine(seed, alpha_op_);
+    for (const auto mask : color_write_mask_) detail::hash_combine(seed, mask);
+  }
+
  private:
   friend class ColorBlendStateBuilder;
 
@@ -816,16 +2457,29 @@ class ColorBlendAttachmentState final {
 class ColorBlendState final {
  public:
   void apply() const noexcept {
+    auto& cache = StateCache::get();
+    if (shared_.value && cache.is_applied(StateCache::Group::COLOR_BLEND, this)) return;
     for (GLuint i = 0; i < attachments_.size(); ++i) {
       const auto& attachment = attachments_[i];
       attachment.apply(i);
     }
+    if (shared_.value) cache.set_applied(StateCache::Group::COLOR_BLEND, this);
+  }
+
+  bool operator==(const ColorBlendState&) const noexcept = default;
+
+  size_t hash() const noexcept {
+    size_t seed = 0;
+    for (const auto& attachment : attachments_) attachment.hash(seed);
+    return seed;
   }
 
  private:
   friend class ColorBlendStateBuilder;
+  friend class StateObjectCache<ColorBlendState>;
 
   std::array<ColorBlendAttachmentState, 8> attachments_;
+  detail::SharedFlag shared_;  ///< StateObjectCacheで共有されているか
 };
 
 /**
@@ -855,6 +2509,15 @@ class ColorBlendStateBuilder final {
     return std::move(state_);
   }
 
+  /**
+   * @brief 内容が同じステートと共有する
+   * 
+   * @return const ColorBlendState& 共有されたステート
+   */
+  const ColorBlendState& build_shared() {
+    return StateObjectCache<ColorBlendState>::get().intern(state_);
+  }
+
  private:
   ColorBlendState state_;
 };
@@ -866,9 +2529,22 @@ class ColorBlendStateBuilder final {
 class StencilOpState final {
  public:
   void apply(GLenum face) const noexcept {
-    glStencilOpSeparate(face, fail_op_, depth_fail_op_, pass_op_);
-    glStencilFuncSeparate(face, compare_op_, reference_, compare_mask_);
-    glStencilMaskSeparate(face, write_mask_);
+    auto& cache = StateCache::get();
+    cache.stencil_op(face, fail_op_, depth_fail_op_, pass_op_);
+    cache.stencil_func(face, compare_op_, reference_, compare_mask_);
+    cache.stencil_mask(face, write_mask_);
+  }
+
+  bool operator==(const StencilOpState&) const noexcept = default;
+
+  void hash(size_t& seed) const noexcept {
+    detail::hash_combine(seed, fail_op_);
+    detail::hash_combine(seed, pass_op_);
+    detail::hash_combine(seed, depth_fail_op_);
+    detail::hash_combine(seed, compare_op_);
+    detail::hash_combine(seed, compare_mask_);
+    detail::hash_combine(seed, write_mask_);
+    detail::hash_combine(seed, reference_);
   }
 
  private:
@@ -890,28 +2566,40 @@ class StencilOpState final {
 class DepthStencilState final {
  public:
   void apply() const noexcept {
-    if (is_depth_test_enabled_) {
-      glEnable(GL_DEPTH_TEST);
-    } else {
-      glDisable(GL_DEPTH_TEST);
-    }
-    if (is_depth_write_enabled_) {
-      glDepthMask(GL_TRUE);
-    } else {
-      glDepthMask(GL_FALSE);
-    }
-    glDepthFunc(depth_compare_op_);
+    auto& cache = StateCache::get();
+    if (shared_.value && cache.is_applied(StateCache::Group::DEPTH_STENCIL, this)) return;
+    cache.enable(GL_DEPTH_TEST, is_depth_test_enabled_);
+    cache.depth_mask(is_depth_write_enabled_ ? GL_TRUE : GL_FALSE);
+    cache.depth_func(depth_compare_op_);
     front_.apply(GL_FRONT);
     back_.apply(GL_BACK);
     if (is_depth_bounds_test_enabled_) {
-      glDepthRangef(min_depth_bounds_, max_depth_bounds_);
+      cache.depth_range(min_depth_bounds_, max_depth_bounds_);
     } else {
-      glDepthRangef(0.f, 1.f);
+      cache.depth_range(0.f, 1.f);
     }
+    if (shared_.value) cache.set_applied(StateCache::Group::DEPTH_STENCIL, this);
+  }
+
+  bool operator==(const DepthStencilState&) const noexcept = default;
+
+  size_t hash() const noexcept {
+    size_t seed = 0;
+    detail::hash_combine(seed, is_depth_test_enabled_);
+    detail::hash_combine(seed, is_depth_write_enabled_);
+    detail::hash_combine(seed, depth_compare_op_);
+    detail::hash_combine(seed, is_depth_bounds_test_enabled_);
+    detail::hash_combine(seed, is_stencil_test_enabled_);
+    front_.hash(seed);
+    back_.hash(seed);
+    detail::hash_combine(seed, min_depth_bounds_);
+    detail::hash_combine(seed, max_depth_bounds_);
+    return seed;
   }
 
  private:
   friend class DepthStencilStateBuilder;
+  friend class StateObjectCache<DepthStencilState>;
 
   bool is_depth_test_enabled_ = false;
   bool is_depth_write_enabled_ = false;
@@ -922,6 +2610,7 @@ class DepthStencilState final {
   StencilOpState back_;
   GLfloat min_depth_bounds_ = 0.f;
   GLfloat max_depth_bounds_ = 1.f;
+  detail::SharedFlag shared_;  ///< StateObjectCacheで共有されているか
 };
 
 /**
@@ -992,6 +2681,15 @@ class DepthStencilStateBuilder final {
     return std::move(state_);
   }
 
+  /**
+   * @brief 内容が同じステートと共有する
+   * 
+   * @return const DepthStencilState& 共有されたステート
+   */
+  const DepthStencilState& build_shared() {
+    return StateObjectCache<DepthStencilState>::get().intern(state_);
+  }
+
  private:
   DepthStencilState state_;
 };
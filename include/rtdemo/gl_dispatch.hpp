@@ -0,0 +1,547 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <GL/glew.h>
+
+// garieとアプリケーションが呼び出すGLの関数
+//
+// X(戻り値の型, glを除いた関数名, 引数リスト, 呼び出しの引数)の形で並べる。
+// 新しいGLの関数を呼び出すときは、こことファイル末尾のリダイレクトの両方に追加する。
+#define GARIE_GL_FUNCTIONS(X) \
+  X(void, ActiveTexture, (GLenum texture), (texture)) \
+  X(void, AttachShader, (GLuint program, GLuint shader), (program, shader)) \
+  X(void, BeginQuery, (GLenum target, GLuint id), (target, id)) \
+  X(void, BindBuffer, (GLenum target, GLuint buffer), (target, buffer)) \
+  X(void, BindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer)) \
+  X(void, BindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size), (target, index, buffer, offset, size)) \
+  X(void, BindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer)) \
+  X(void, BindImageTexture, (GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format), (unit, texture, level, layered, layer, access, format)) \
+  X(void, BindSampler, (GLuint unit, GLuint sampler), (unit, sampler)) \
+  X(void, BindTexture, (GLenum target, GLuint texture), (target, texture)) \
+  X(void, BindVertexArray, (GLuint array), (array)) \
+  X(void, BlendEquationSeparatei, (GLuint buf, GLenum modeRGB, GLenum modeAlpha), (buf, modeRGB, modeAlpha)) \
+  X(void, BlendFuncSeparatei, (GLuint buf, GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha), (buf, srcRGB, dstRGB, srcAlpha, dstAlpha)) \
+  X(void, BufferStorage, (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags), (target, size, data, flags)) \
+  X(void, BufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void *data), (target, offset, size, data)) \
+  X(GLenum, CheckFramebufferStatus, (GLenum target), (target)) \
+  X(GLenum, CheckNamedFramebufferStatus, (GLuint framebuffer, GLenum target), (framebuffer, target)) \
+  X(void, Clear, (GLbitfield mask), (mask)) \
+  X(void, ClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha)) \
+  X(void, ClearDepthf, (GLfloat d), (d)) \
+  X(void, ClearStencil, (GLint s), (s)) \
+  X(GLenum, ClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout)) \
+  X(void, ColorMask, (GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha), (red, green, blue, alpha)) \
+  X(void, ColorMaski, (GLuint index, GLboolean r, GLboolean g, GLboolean b, GLboolean a), (index, r, g, b, a)) \
+  X(void, CompileShader, (GLuint shader), (shader)) \
+  X(void, CreateBuffers, (GLsizei n, GLuint *buffers), (n, buffers)) \
+  X(void, CreateFramebuffers, (GLsizei n, GLuint *framebuffers), (n, framebuffers)) \
+  X(GLuint, CreateProgram, (void), ()) \
+  X(void, CreateSamplers, (GLsizei n, GLuint *samplers), (n, samplers)) \
+  X(GLuint, CreateShader, (GLenum type), (type)) \
+  X(void, CreateTextures, (GLenum target, GLsizei n, GLuint *textures), (target, n, textures)) \
+  X(void, CreateVertexArrays, (GLsizei n, GLuint *arrays), (n, arrays)) \
+  X(void, CullFace, (GLenum mode), (mode)) \
+  X(void, DeleteBuffers, (GLsizei n, const GLuint *buffers), (n, buffers)) \
+  X(void, DeleteFramebuffers, (GLsizei n, const GLuint *framebuffers), (n, framebuffers)) \
+  X(void, DeleteProgram, (GLuint program), (program)) \
+  X(void, DeleteQueries, (GLsizei n, const GLuint *ids), (n, ids)) \
+  X(void, DeleteSamplers, (GLsizei count, const GLuint *samplers), (count, samplers)) \
+  X(void, DeleteShader, (GLuint shader), (shader)) \
+  X(void, DeleteSync, (GLsync sync), (sync)) \
+  X(void, DeleteTextures, (GLsizei n, const GLuint *textures), (n, textures)) \
+  X(void, DeleteVertexArrays, (GLsizei n, const GLuint *arrays), (n, arrays)) \
+  X(void, DepthFunc, (GLenum func), (func)) \
+  X(void, DepthMask, (GLboolean flag), (flag)) \
+  X(void, DepthRangef, (GLfloat n, GLfloat f), (n, f)) \
+  X(void, Disable, (GLenum cap), (cap)) \
+  X(void, Disablei, (GLenum target, GLuint index), (target, index)) \
+  X(void, DispatchCompute, (GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z), (num_groups_x, num_groups_y, num_groups_z)) \
+  X(void, DrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count)) \
+  X(void, DrawBuffers, (GLsizei n, const GLenum *bufs), (n, bufs)) \
+  X(void, DrawElements, (GLenum mode, GLsizei count, GLenum type, const void *indices), (mode, count, type, indices)) \
+  X(void, DrawElementsIndirect, (GLenum mode, GLenum type, const void *indirect), (mode, type, indirect)) \
+  X(void, DrawElementsInstancedBaseVertexBaseInstance, (GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount, GLint basevertex, GLuint baseinstance), (mode, count, type, indices, instancecount, basevertex, baseinstance)) \
+  X(void, Enable, (GLenum cap), (cap)) \
+  X(void, EnableVertexArrayAttrib, (GLuint vaobj, GLuint index), (vaobj, index)) \
+  X(void, EnableVertexAttribArray, (GLuint index), (index)) \
+  X(void, Enablei, (GLenum target, GLuint index), (target, index)) \
+  X(void, EndQuery, (GLenum target), (target)) \
+  X(GLsync, FenceSync, (GLenum condition, GLbitfield flags), (condition, flags)) \
+  X(void, Flush, (void), ()) \
+  X(void, FramebufferTexture, (GLenum target, GLenum attachment, GLuint texture, GLint level), (target, attachment, texture, level)) \
+  X(void, FramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level), (target, attachment, textarget, texture, level)) \
+  X(void, FramebufferTextureLayer, (GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer), (target, attachment, texture, level, layer)) \
+  X(void, FrontFace, (GLenum mode), (mode)) \
+  X(void, GenBuffers, (GLsizei n, GLuint *buffers), (n, buffers)) \
+  X(void, GenFramebuffers, (GLsizei n, GLuint *framebuffers), (n, framebuffers)) \
+  X(void, GenQueries, (GLsizei n, GLuint *ids), (n, ids)) \
+  X(void, GenSamplers, (GLsizei count, GLuint *samplers), (count, samplers)) \
+  X(void, GenTextures, (GLsizei n, GLuint *textures), (n, textures)) \
+  X(void, GenVertexArrays, (GLsizei n, GLuint *arrays), (n, arrays)) \
+  X(void, GenerateMipmap, (GLenum target), (target)) \
+  X(void, GetIntegerv, (GLenum pname, GLint *data), (pname, data)) \
+  X(void, GetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog), (program, bufSize, length, infoLog)) \
+  X(void, GetProgramiv, (GLuint program, GLenum pname, GLint *params), (program, pname, params)) \
+  X(void, GetQueryObjectui64v, (GLuint id, GLenum pname, GLuint64 *params), (id, pname, params)) \
+  X(void, GetQueryObjectuiv, (GLuint id, GLenum pname, GLuint *params), (id, pname, params)) \
+  X(void, GetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog), (shader, bufSize, length, infoLog)) \
+  X(void, GetShaderiv, (GLuint shader, GLenum pname, GLint *params), (shader, pname, params)) \
+  X(const GLubyte *, GetString, (GLenum name), (name)) \
+  X(void, LineWidth, (GLfloat width), (width)) \
+  X(void, LinkProgram, (GLuint program), (program)) \
+  X(void *, MapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), (target, offset, length, access)) \
+  X(void *, MapNamedBufferRange, (GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access), (buffer, offset, length, access)) \
+  X(void, MemoryBarrier, (GLbitfield barriers), (barriers)) \
+  X(void, NamedBufferStorage, (GLuint buffer, GLsizeiptr size, const void *data, GLbitfield flags), (buffer, size, data, flags)) \
+  X(void, NamedBufferSubData, (GLuint buffer, GLintptr offset, GLsizeiptr size, const void *data), (buffer, offset, size, data)) \
+  X(void, NamedFramebufferDrawBuffers, (GLuint framebuffer, GLsizei n, const GLenum *bufs), (framebuffer, n, bufs)) \
+  X(void, NamedFramebufferTexture, (GLuint framebuffer, GLenum attachment, GLuint texture, GLint level), (framebuffer, attachment, texture, level)) \
+  X(void, NamedFramebufferTextureLayer, (GLuint framebuffer, GLenum attachment, GLuint texture, GLint level, GLint layer), (framebuffer, attachment, texture, level, layer)) \
+  X(void, PolygonMode, (GLenum face, GLenum mode), (face, mode)) \
+  X(void, PolygonOffset, (GLfloat factor, GLfloat units), (factor, units)) \
+  X(void, QueryCounter, (GLuint id, GLenum target), (id, target)) \
+  X(void, SamplerParameterIiv, (GLuint sampler, GLenum pname, const GLint *param), (sampler, pname, param)) \
+  X(void, SamplerParameterIuiv, (GLuint sampler, GLenum pname, const GLuint *param), (sampler, pname, param)) \
+  X(void, SamplerParameterf, (GLuint sampler, GLenum pname, GLfloat param), (sampler, pname, param)) \
+  X(void, SamplerParameterfv, (GLuint sampler, GLenum pname, const GLfloat *param), (sampler, pname, param)) \
+  X(void, SamplerParameteri, (GLuint sampler, GLenum pname, GLint param), (sampler, pname, param)) \
+  X(void, SamplerParameteriv, (GLuint sampler, GLenum pname, const GLint *param), (sampler, pname, param)) \
+  X(void, Scissor, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height)) \
+  X(void, ScissorIndexedv, (GLuint index, const GLint *v), (index, v)) \
+  X(void, ShaderBinary, (GLsizei count, const GLuint *shaders, GLenum binaryFormat, const void *binary, GLsizei length), (count, shaders, binaryFormat, binary, length)) \
+  X(void, ShaderSource, (GLuint shader, GLsizei count, const GLchar *const*string, const GLint *length), (shader, count, string, length)) \
+  X(void, ShaderStorageBlockBinding, (GLuint program, GLuint storageBlockIndex, GLuint storageBlockBinding), (program, storageBlockIndex, storageBlockBinding)) \
+  X(void, SpecializeShader, (GLuint shader, const GLchar *pEntryPoint, GLuint numSpecializationConstants, const GLuint *pConstantIndex, const GLuint *pConstantValue), (shader, pEntryPoint, numSpecializationConstants, pConstantIndex, pConstantValue)) \
+  X(void, StencilFuncSeparate, (GLenum face, GLenum func, GLint ref, GLuint mask), (face, func, ref, mask)) \
+  X(void, StencilMaskSeparate, (GLenum face, GLuint mask), (face, mask)) \
+  X(void, StencilOpSeparate, (GLenum face, GLenum sfail, GLenum dpfail, GLenum dppass), (face, sfail, dpfail, dppass)) \
+  X(void, TexStorage2D, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height), (target, levels, internalformat, width, height)) \
+  X(void, TexStorage2DMultisample, (GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLboolean fixedsamplelocations), (target, samples, internalformat, width, height, fixedsamplelocations)) \
+  X(void, TexStorage3D, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth), (target, levels, internalformat, width, height, depth)) \
+  X(void, TexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels), (target, level, xoffset, yoffset, width, height, format, type, pixels)) \
+  X(void, TextureStorage2D, (GLuint texture, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height), (texture, levels, internalformat, width, height)) \
+  X(void, TextureStorage2DMultisample, (GLuint texture, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLboolean fixedsamplelocations), (texture, samples, internalformat, width, height, fixedsamplelocations)) \
+  X(void, TextureStorage3D, (GLuint texture, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth), (texture, levels, internalformat, width, height, depth)) \
+  X(void, TextureSubImage2D, (GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels), (texture, level, xoffset, yoffset, width, height, format, type, pixels)) \
+  X(void, Uniform1ui, (GLint location, GLuint v0), (location, v0)) \
+  X(void, UniformBlockBinding, (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding), (program, uniformBlockIndex, uniformBlockBinding)) \
+  X(void, UniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+  X(GLboolean, UnmapBuffer, (GLenum target), (target)) \
+  X(GLboolean, UnmapNamedBuffer, (GLuint buffer), (buffer)) \
+  X(void, UseProgram, (GLuint program), (program)) \
+  X(void, VertexArrayAttribBinding, (GLuint vaobj, GLuint attribindex, GLuint bindingindex), (vaobj, attribindex, bindingindex)) \
+  X(void, VertexArrayAttribFormat, (GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLboolean normalized, GLuint relativeoffset), (vaobj, attribindex, size, type, normalized, relativeoffset)) \
+  X(void, VertexArrayBindingDivisor, (GLuint vaobj, GLuint bindingindex, GLuint divisor), (vaobj, bindingindex, divisor)) \
+  X(void, VertexArrayElementBuffer, (GLuint vaobj, GLuint buffer), (vaobj, buffer)) \
+  X(void, VertexArrayVertexBuffer, (GLuint vaobj, GLuint bindingindex, GLuint buffer, GLintptr offset, GLsizei stride), (vaobj, bindingindex, buffer, offset, stride)) \
+  X(void, VertexAttribDivisor, (GLuint index, GLuint divisor), (index, divisor)) \
+  X(void, VertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer), (index, size, type, normalized, stride, pointer)) \
+  X(void, Viewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height)) \
+  X(void, ViewportIndexedfv, (GLuint index, const GLfloat *v), (index, v))
+
+namespace garie {
+/**
+ * @brief GlTable内の関数の番号
+ */
+enum class GlFunction : uint16_t {
+#define GARIE_GL_FUNCTION_ENTRY(ret, name, params, args) name,
+  GARIE_GL_FUNCTIONS(GARIE_GL_FUNCTION_ENTRY)
+#undef GARIE_GL_FUNCTION_ENTRY
+  COUNT,
+};
+
+/**
+ * @brief GLの関数テーブル
+ * 
+ * 各メンバはglを除いた名前の関数ポインタ。
+ */
+struct GlTable {
+#define GARIE_GL_TABLE_ENTRY(ret, name, params, args) ret (GLAPIENTRY* name) params = nullptr;
+  GARIE_GL_FUNCTIONS(GARIE_GL_TABLE_ENTRY)
+#undef GARIE_GL_TABLE_ENTRY
+};
+
+/**
+ * @brief GLの呼び出し先のテーブル
+ * 
+ * このヘッダをインクルードした翻訳単位では、glで始まる呼び出しがすべてこのテーブルを経由する。
+ * GlDispatch::load()で読み込むまでは空なので、GLEWの初期化前と同じく呼び出してはならない。
+ */
+inline GlTable gl_table;
+
+/**
+ * @brief GLの呼び出し先を切り替える
+ * 
+ * 次のバックエンドを選べる。
+ * - REAL:GLEWが読み込んだドライバの関数
+ * - NOOP:何もしない関数。オブジェクト名を払い出し、マップはホストメモリで済ませるので、ドライバなしでフレームを回せる
+ * 
+ * どちらのバックエンドにも、関数ごとに呼び出し回数を数える層を重ねられる。
+ */
+class GlDispatch final {
+ public:
+  /**
+   * @brief 呼び出し先
+   */
+  enum class Backend : uint32_t {
+    REAL,  ///< ドライバ
+    NOOP,  ///< 何もしない
+  };
+
+  static GlDispatch& get() noexcept {
+    static GlDispatch self;
+    return self;
+  }
+
+  /**
+   * @brief バックエンドを選ぶ
+   * 
+   * load()の前に呼び出す。
+   * 
+   * @param backend 呼び出し先
+   * @param counting 呼び出し回数を数えるか
+   */
+  void select(Backend backend, bool counting) noexcept {
+    backend_ = backend;
+    counting_ = counting;
+  }
+
+  /**
+   * @brief 選んだバックエンドの関数をテーブルに読み込む
+   * 
+   * REALではGLEWの初期化後に呼び出す。
+   * 
+   * @return true 成功した
+   * @return false ドライバが提供しない関数があった。missing_function()で名前を取得できる
+   */
+  bool load();
+
+  Backend backend() const noexcept {
+    return backend_;
+  }
+
+  bool is_counting() const noexcept {
+    return counting_;
+  }
+
+  /**
+   * @brief load()で見つからなかった関数の名前
+   */
+  const char* missing_function() const noexcept {
+    return missing_function_;
+  }
+
+  /**
+   * @brief フレームの終わりに、呼び出し回数を確定させてリセットする
+   * 
+   * GLの呼び出しを記録していれば、フレームの区切りも記録する。
+   */
+  void end_frame();
+
+  /**
+   * @brief 前のフレームで呼び出したGLの関数の数
+   * 
+   * 数えていなければ0
+   */
+  uint64_t last_call_count() const noexcept {
+    return last_call_count_;
+  }
+
+  /**
+   * @brief 前のフレームで呼び出し回数が多かった関数
+   * 
+   * @param count 最大の数
+   * @return std::vector<std::pair<const char*, uint64_t>> 関数名と回数の組。回数の多い順
+   */
+  std::vector<std::pair<const char*, uint64_t>> last_top_calls(size_t count) const;
+
+  /**
+   * @brief バックエンドの名前
+   */
+  static const char* backend_name(Backend backend) noexcept;
+
+  /**
+   * @brief 関数名
+   * 
+   * @param function 関数の番号
+   * @return const char* glで始まる関数名
+   */
+  static const char* function_name(GlFunction function) noexcept;
+
+ private:
+  GlDispatch() = default;
+
+  Backend backend_ = Backend::REAL;  ///< 呼び出し先
+  bool counting_ = false;  ///< 呼び出し回数を数えるか
+  const char* missing_function_ = nullptr;  ///< 見つからなかった関数の名前
+  uint64_t last_call_count_ = 0;  ///< 前のフレームで呼び出した数
+};
+}  // namespace garie
+
+// glで始まる呼び出しをテーブルに向ける
+// テーブルを作る翻訳単位ではGARIE_GL_DISPATCH_NO_REDIRECTを定義して、GLEWの関数を参照する
+#ifndef GARIE_GL_DISPATCH_NO_REDIRECT
+#undef glActiveTexture
+#define glActiveTexture ::garie::gl_table.ActiveTexture
+#undef glAttachShader
+#define glAttachShader ::garie::gl_table.AttachShader
+#undef glBeginQuery
+#define glBeginQuery ::garie::gl_table.BeginQuery
+#undef glBindBuffer
+#define glBindBuffer ::garie::gl_table.BindBuffer
+#undef glBindBufferBase
+#define glBindBufferBase ::garie::gl_table.BindBufferBase
+#undef glBindBufferRange
+#define glBindBufferRange ::garie::gl_table.BindBufferRange
+#undef glBindFramebuffer
+#define glBindFramebuffer ::garie::gl_table.BindFramebuffer
+#undef glBindImageTexture
+#define glBindImageTexture ::garie::gl_table.BindImageTexture
+#undef glBindSampler
+#define glBindSampler ::garie::gl_table.BindSampler
+#undef glBindTexture
+#define glBindTexture ::garie::gl_table.BindTexture
+#undef glBindVertexArray
+#define glBindVertexArray ::garie::gl_table.BindVertexArray
+#undef glBlendEquationSeparatei
+#define glBlendEquationSeparatei ::garie::gl_table.BlendEquationSeparatei
+#undef glBlendFuncSeparatei
+#define glBlendFuncSeparatei ::garie::gl_table.BlendFuncSeparatei
+#undef glBufferStorage
+#define glBufferStorage ::garie::gl_table.BufferStorage
+#undef glBufferSubData
+#define glBufferSubData ::garie::gl_table.BufferSubData
+#undef glCheckFramebufferStatus
+#define glCheckFramebufferStatus ::garie::gl_table.CheckFramebufferStatus
+#undef glCheckNamedFramebufferStatus
+#define glCheckNamedFramebufferStatus ::garie::gl_table.CheckNamedFramebufferStatus
+#undef glClear
+#define glClear ::garie::gl_table.Clear
+#undef glClearColor
+#define glClearColor ::garie::gl_table.ClearColor
+#undef glClearDepthf
+#define glClearDepthf ::garie::gl_table.ClearDepthf
+#undef glClearStencil
+#define glClearStencil ::garie::gl_table.ClearStencil
+#undef glClientWaitSync
+#define glClientWaitSync ::garie::gl_table.ClientWaitSync
+#undef glColorMask
+#define glColorMask ::garie::gl_table.ColorMask
+#undef glColorMaski
+#define glColorMaski ::garie::gl_table.ColorMaski
+#undef glCompileShader
+#define glCompileShader ::garie::gl_table.CompileShader
+#undef glCreateBuffers
+#define glCreateBuffers ::garie::gl_table.CreateBuffers
+#undef glCreateFramebuffers
+#define glCreateFramebuffers ::garie::gl_table.CreateFramebuffers
+#undef glCreateProgram
+#define glCreateProgram ::garie::gl_table.CreateProgram
+#undef glCreateSamplers
+#define glCreateSamplers ::garie::gl_table.CreateSamplers
+#undef glCreateShader
+#define glCreateShader ::garie::gl_table.CreateShader
+#undef glCreateTextures
+#define glCreateTextures ::garie::gl_table.CreateTextures
+#undef glCreateVertexArrays
+#define glCreateVertexArrays ::garie::gl_table.CreateVertexArrays
+#undef glCullFace
+#define glCullFace ::garie::gl_table.CullFace
+#undef glDeleteBuffers
+#define glDeleteBuffers ::garie::gl_table.DeleteBuffers
+#undef glDeleteFramebuffers
+#define glDeleteFramebuffers ::garie::gl_table.DeleteFramebuffers
+#undef glDeleteProgram
+#define glDeleteProgram ::garie::gl_table.DeleteProgram
+#undef glDeleteQueries
+#define glDeleteQueries ::garie::gl_table.DeleteQueries
+#undef glDeleteSamplers
+#define glDeleteSamplers ::garie::gl_table.DeleteSamplers
+#undef glDeleteShader
+#define glDeleteShader ::garie::gl_table.DeleteShader
+#undef glDeleteSync
+#define glDeleteSync ::garie::gl_table.DeleteSync
+#undef glDeleteTextures
+#define glDeleteTextures ::garie::gl_table.DeleteTextures
+#undef glDeleteVertexArrays
+#define glDeleteVertexArrays ::garie::gl_table.DeleteVertexArrays
+#undef glDepthFunc
+#define glDepthFunc ::garie::gl_table.DepthFunc
+#undef glDepthMask
+#define glDepthMask ::garie::gl_table.DepthMask
+#undef glDepthRangef
+#define glDepthRangef ::garie::gl_table.DepthRangef
+#undef glDisable
+#define glDisable ::garie::gl_table.Disable
+#undef glDisablei
+#define glDisablei ::garie::gl_table.Disablei
+#undef glDispatchCompute
+#define glDispatchCompute ::garie::gl_table.DispatchCompute
+#undef glDrawArrays
+#define glDrawArrays ::garie::gl_table.DrawArrays
+#undef glDrawBuffers
+#define glDrawBuffers ::garie::gl_table.DrawBuffers
+#undef glDrawElements
+#define glDrawElements ::garie::gl_table.DrawElements
+#undef glDrawElementsIndirect
+#define glDrawElementsIndirect ::garie::gl_table.DrawElementsIndirect
+#undef glDrawElementsInstancedBaseVertexBaseInstance
+#define glDrawElementsInstancedBaseVertexBaseInstance ::garie::gl_table.DrawElementsInstancedBaseVertexBaseInstance
+#undef glEnable
+#define glEnable ::garie::gl_table.Enable
+#undef glEnableVertexArrayAttrib
+#define glEnableVertexArrayAttrib ::garie::gl_table.EnableVertexArrayAttrib
+#undef glEnableVertexAttribArray
+#define glEnableVertexAttribArray ::garie::gl_table.EnableVertexAttribArray
+#undef glEnablei
+#define glEnablei ::garie::gl_table.Enablei
+#undef glEndQuery
+#define glEndQuery ::garie::gl_table.EndQuery
+#undef glFenceSync
+#define glFenceSync ::garie::gl_table.FenceSync
+#undef glFlush
+#define glFlush ::garie::gl_table.Flush
+#undef glFramebufferTexture
+#define glFramebufferTexture ::garie::gl_table.FramebufferTexture
+#undef glFramebufferTexture2D
+#define glFramebufferTexture2D ::garie::gl_table.FramebufferTexture2D
+#undef glFramebufferTextureLayer
+#define glFramebufferTextureLayer ::garie::gl_table.FramebufferTextureLayer
+#undef glFrontFace
+#define glFrontFace ::garie::gl_table.FrontFace
+#undef glGenBuffers
+#define glGenBuffers ::garie::gl_table.GenBuffers
+#undef glGenFramebuffers
+#define glGenFramebuffers ::garie::gl_table.GenFramebuffers
+#undef glGenQueries
+#define glGenQueries ::garie::gl_table.GenQueries
+#undef glGenSamplers
+#define glGenSamplers ::garie::gl_table.GenSamplers
+#undef glGenTextures
+#define glGenTextures ::garie::gl_table.GenTextures
+#undef glGenVertexArrays
+#define glGenVertexArrays ::garie::gl_table.GenVertexArrays
+#undef glGenerateMipmap
+#define glGenerateMipmap ::garie::gl_table.GenerateMipmap
+#undef glGetIntegerv
+#define glGetIntegerv ::garie::gl_table.GetIntegerv
+#undef glGetProgramInfoLog
+#define glGetProgramInfoLog ::garie::gl_table.GetProgramInfoLog
+#undef glGetProgramiv
+#define glGetProgramiv ::garie::gl_table.GetProgramiv
+#undef glGetQueryObjectui64v
+#define glGetQueryObjectui64v ::garie::gl_table.GetQueryObjectui64v
+#undef glGetQueryObjectuiv
+#define glGetQueryObjectuiv ::garie::gl_table.GetQueryObjectuiv
+#undef glGetShaderInfoLog
+#define glGetShaderInfoLog ::garie::gl_table.GetShaderInfoLog
+#undef glGetShaderiv
+#define glGetShaderiv ::garie::gl_table.GetShaderiv
+#undef glGetString
+#define glGetString ::garie::gl_table.GetString
+#undef glLineWidth
+#define glLineWidth ::garie::gl_table.LineWidth
+#undef glLinkProgram
+#define glLinkProgram ::garie::gl_table.LinkProgram
+#undef glMapBufferRange
+#define glMapBufferRange ::garie::gl_table.MapBufferRange
+#undef glMapNamedBufferRange
+#define glMapNamedBufferRange ::garie::gl_table.MapNamedBufferRange
+#undef glMemoryBarrier
+#define glMemoryBarrier ::garie::gl_table.MemoryBarrier
+#undef glNamedBufferStorage
+#define glNamedBufferStorage ::garie::gl_table.NamedBufferStorage
+#undef glNamedBufferSubData
+#define glNamedBufferSubData ::garie::gl_table.NamedBufferSubData
+#undef glNamedFramebufferDrawBuffers
+#define glNamedFramebufferDrawBuffers ::garie::gl_table.NamedFramebufferDrawBuffers
+#undef glNamedFramebufferTexture
+#define glNamedFramebufferTexture ::garie::gl_table.NamedFramebufferTexture
+#undef glNamedFramebufferTextureLayer
+#define glNamedFramebufferTextureLayer ::garie::gl_table.NamedFramebufferTextureLayer
+#undef glPolygonMode
+#define glPolygonMode ::garie::gl_table.PolygonMode
+#undef glPolygonOffset
+#define glPolygonOffset ::garie::gl_table.PolygonOffset
+#undef glQueryCounter
+#define glQueryCounter ::garie::gl_table.QueryCounter
+#undef glSamplerParameterIiv
+#define glSamplerParameterIiv ::garie::gl_table.SamplerParameterIiv
+#undef glSamplerParameterIuiv
+#define glSamplerParameterIuiv ::garie::gl_table.SamplerParameterIuiv
+#undef glSamplerParameterf
+#define glSamplerParameterf ::garie::gl_table.SamplerParameterf
+#undef glSamplerParameterfv
+#define glSamplerParameterfv ::garie::gl_table.SamplerParameterfv
+#undef glSamplerParameteri
+#define glSamplerParameteri ::garie::gl_table.SamplerParameteri
+#undef glSamplerParameteriv
+#define glSamplerParameteriv ::garie::gl_table.SamplerParameteriv
+#undef glScissor
+#define glScissor ::garie::gl_table.Scissor
+#undef glScissorIndexedv
+#define glScissorIndexedv ::garie::gl_table.ScissorIndexedv
+#undef glShaderBinary
+#define glShaderBinary ::garie::gl_table.ShaderBinary
+#undef glShaderSource
+#define glShaderSource ::garie::gl_table.ShaderSource
+#undef glShaderStorageBlockBinding
+#define glShaderStorageBlockBinding ::garie::gl_table.ShaderStorageBlockBinding
+#undef glSpecializeShader
+#define glSpecializeShader ::garie::gl_table.SpecializeShader
+#undef glStencilFuncSeparate
+#define glStencilFuncSeparate ::garie::gl_table.StencilFuncSeparate
+#undef glStencilMaskSeparate
+#define glStencilMaskSeparate ::garie::gl_table.StencilMaskSeparate
+#undef glStencilOpSeparate
+#define glStencilOpSeparate ::garie::gl_table.StencilOpSeparate
+#undef glTexStorage2D
+#define glTexStorage2D ::garie::gl_table.TexStorage2D
+#undef glTexStorage2DMultisample
+#define glTexStorage2DMultisample ::garie::gl_table.TexStorage2DMultisample
+#undef glTexStorage3D
+#define glTexStorage3D ::garie::gl_table.TexStorage3D
+#undef glTexSubImage2D
+#define glTexSubImage2D ::garie::gl_table.TexSubImage2D
+#undef glTextureStorage2D
+#define glTextureStorage2D ::garie::gl_table.TextureStorage2D
+#undef glTextureStorage2DMultisample
+#define glTextureStorage2DMultisample ::garie::gl_table.TextureStorage2DMultisample
+#undef glTextureStorage3D
+#define glTextureStorage3D ::garie::gl_table.TextureStorage3D
+#undef glTextureSubImage2D
+#define glTextureSubImage2D ::garie::gl_table.TextureSubImage2D
+#undef glUniform1ui
+#define glUniform1ui ::garie::gl_table.Uniform1ui
+#undef glUniformBlockBinding
+#define glUniformBlockBinding ::garie::gl_table.UniformBlockBinding
+#undef glUniformMatrix4fv
+#define glUniformMatrix4fv ::garie::gl_table.UniformMatrix4fv
+#undef glUnmapBuffer
+#define glUnmapBuffer ::garie::gl_table.UnmapBuffer
+#undef glUnmapNamedBuffer
+#define glUnmapNamedBuffer ::garie::gl_table.UnmapNamedBuffer
+#undef glUseProgram
+#define glUseProgram ::garie::gl_table.UseProgram
+#undef glVertexArrayAttribBinding
+#define glVertexArrayAttribBinding ::garie::gl_table.VertexArrayAttribBinding
+#undef glVertexArrayAttribFormat
+#define glVertexArrayAttribFormat ::garie::gl_table.VertexArrayAttribFormat
+#undef glVertexArrayBindingDivisor
+#define glVertexArrayBindingDivisor ::garie::gl_table.VertexArrayBindingDivisor
+#undef glVertexArrayElementBuffer
+#define glVertexArrayElementBuffer ::garie::gl_table.VertexArrayElementBuffer
+#undef glVertexArrayVertexBuffer
+#define glVertexArrayVertexBuffer ::garie::gl_table.VertexArrayVertexBuffer
+#undef glVertexAttribDivisor
+#define glVertexAttribDivisor ::garie::gl_table.VertexAttribDivisor
+#undef glVertexAttribPointer
+#define glVertexAttribPointer ::garie::gl_table.VertexAttribPointer
+#undef glViewport
+#define glViewport ::garie::gl_table.Viewport
+#undef glViewportIndexedfv
+#define glViewportIndexedfv ::garie::gl_table.ViewportIndexedfv
+#endif
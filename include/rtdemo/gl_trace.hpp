@@ -0,0 +1,250 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "gl_dispatch.hpp"
+
+namespace garie {
+namespace detail {
+struct GlTraceAccess;
+}  // namespace detail
+
+/**
+ * @brief GLのトレースファイルの先頭
+ * 
+ * 後ろにレコードが並ぶ。レコードはuint16_tの番号で始まり、GlFunctionの番号なら関数の呼び出し、
+ * それ以外ならGlTraceOpの制御レコードを表す。
+ */
+struct GlTraceHeader {
+  char magic[8] = {'R', 'T', 'G', 'L', 'T', 'R', 'C', '\0'};  ///< ファイルの識別子
+  uint32_t version = 1;  ///< 形式のバージョン
+  uint32_t function_hash = 0;  ///< 記録したときの関数の並びのハッシュ。再生する側と一致しなければならない
+  uint32_t width = 0;  ///< バックバッファの幅
+  uint32_t height = 0;  ///< バックバッファの高さ
+};
+
+/**
+ * @brief 関数の呼び出し以外のレコード
+ */
+enum class GlTraceOp : uint16_t {
+  MEMORY = 0xfff0,  ///< マップしたバッファへの書き込み。バッファ名、マップ先からのオフセット、大きさ、データ
+  BEGIN_FRAMES = 0xfff1,  ///< ここまでが準備で、ここから計測するフレームが始まる
+  FRAME_END = 0xfff2,  ///< フレームの終わり。BEGIN_FRAMESからの経過時間[ns]
+  END = 0xffff,  ///< トレースの終わり
+};
+
+/**
+ * @brief 名前の種類。種類ごとに名前空間が異なる
+ */
+enum class GlNameType : uint32_t {
+  BUFFER,
+  FRAMEBUFFER,
+  PROGRAM,  ///< シェーダとプログラム。名前空間を共有する
+  QUERY,
+  SAMPLER,
+  TEXTURE,
+  VERTEX_ARRAY,
+  COUNT,
+};
+
+/**
+ * @brief GLの呼び出しをトレースファイルに記録する
+ * 
+ * GlDispatch::load()より前にopen()すると、GLの関数テーブルに記録する層を重ね、
+ * コンテキストを作ってからのすべての呼び出しを、バッファやテクスチャに渡したデータも含めて書き込む。
+ * begin_frames()からのフレームを計測の対象とし、指定した数のフレームが終わると記録をやめて閉じる。
+ * 
+ * マップしたバッファへの書き込みは、描画とディスパッチとアンマップの直前に記録する。
+ * 永続マップしていなければマップした範囲をすべて記録する。
+ * 永続マップしたバッファはmark_written()で知らされた範囲だけを前回と比べ、変わったところを記録する。
+ * 問い合わせ(glGet*など)は再生に不要なので記録しない。
+ * GLを呼び出すスレッドは1つである前提で、排他制御はしない。
+ */
+class GlCapture final {
+ public:
+  static GlCapture& get() noexcept {
+    static GlCapture self;
+    return self;
+  }
+
+  /**
+   * @brief トレースファイルを作り、記録を始める
+   * 
+   * @param path ファイルパス
+   * @param width バックバッファの幅
+   * @param height バックバッファの高さ
+   * @return true 成功した
+   * @return false ファイルを作れなかった
+   */
+  bool open(const std::filesystem::path& path, uint32_t width, uint32_t height);
+
+  /**
+   * @brief 記録中か
+   */
+  bool is_open() const noexcept {
+    return recording_;
+  }
+
+  /**
+   * @brief 関数テーブルに記録する層を重ねる
+   * 
+   * GlDispatch::load()が呼び出す。
+   * 
+   * @param table 重ねる先のテーブル。記録してから元の関数を呼び出すテーブルに書き換える
+   */
+  void wrap(GlTable& table);
+
+  /**
+   * @brief ここから計測するフレームとして記録する
+   * 
+   * @param frame_count 記録するフレーム数
+   */
+  void begin_frames(uint32_t frame_count);
+
+  /**
+   * @brief フレームの終わりを記録する
+   * 
+   * GlDispatch::end_frame()が呼び出す。
+   */
+  void end_frame();
+
+  /**
+   * @brief 永続マップしたバッファに書き込む範囲を知らせる
+   * 
+   * 次の描画の前に記録する。記録していなければ何もしない。
+   * 
+   * @param data 書き込む先頭。マップ先の中を指す
+   * @param size 大きさ[byte]
+   */
+  void mark_written(const void* data, size_t size) {
+    if (recording_) add_written_range(data, size);
+  }
+
+  /**
+   * @brief 記録を終えてファイルを閉じる
+   * 
+   * @return true 成功した
+   * @return false 書き込みに失敗した
+   */
+  bool close();
+
+ private:
+  friend struct detail::GlTraceAccess;
+
+  static constexpr size_t FLUSH_SIZE = 4 << 20;  ///< ファイルに書き出すまでに溜めるバイト数
+
+  /**
+   * @brief マップしているバッファ
+   */
+  struct Mapping {
+    GLuint buffer = 0;  ///< バッファ名
+    std::byte* data = nullptr;  ///< マップ先
+    size_t size = 0;  ///< マップした大きさ[byte]
+    std::vector<std::byte> shadow;  ///< 前回記録した内容。永続マップしたときだけ持つ
+    std::vector<std::pair<size_t, size_t>> written_ranges;  ///< 前回記録してから書き込まれた範囲の、先頭と終わりのオフセット
+  };
+
+  GlCapture() = default;
+
+  /**
+   * @brief 書き込まれた範囲を、それを含むマップに加える
+   */
+  void add_written_range(const void* data, size_t size);
+
+  std::ofstream ofs_;  ///< トレースファイル
+  std::filesystem::path path_;  ///< トレースファイルのパス
+  std::vector<std::byte> buffer_;  ///< 書き出していないレコード
+  size_t written_size_ = 0;  ///< 書き出したバイト数
+  bool recording_ = false;  ///< 記録中か
+  bool in_frames_ = false;  ///< 計測するフレームを記録中か
+  uint32_t remaining_frame_count_ = 0;  ///< 残りの記録するフレーム数
+  std::chrono::steady_clock::time_point begin_tp_;  ///< 計測するフレームを記録し始めた時刻
+  GlTable inner_table_;  ///< 記録してから呼び出す関数
+  std::unordered_map<GLenum, GLuint> bound_buffers_;  ///< ターゲットごとにバインドされたバッファ
+  std::unordered_map<GLsync, uint64_t> sync_ids_;  ///< フェンスに振った番号
+  uint64_t next_sync_id_ = 1;  ///< 次に振るフェンスの番号
+  std::vector<Mapping> mappings_;  ///< マップしているバッファ
+};
+
+/**
+ * @brief トレースファイルを再生する
+ * 
+ * GLの関数テーブルを読み込んでから使う。
+ * 再生で払い出される名前は記録と同じとは限らないので、種類ごとに記録した名前との対応を覚え、
+ * 引数の名前を払い出された名前に置き換えて呼び出す。記録にない名前が使われたら、再生を中断する。
+ */
+class GlReplayer final {
+ public:
+  /**
+   * @brief トレースファイルを読み込む
+   * 
+   * @param path ファイルパス
+   * @return true 成功した
+   * @return false 読み込めなかったか、形式が異なった
+   */
+  bool open(const std::filesystem::path& path);
+
+  uint32_t width() const noexcept {
+    return header_.width;
+  }
+
+  uint32_t height() const noexcept {
+    return header_.height;
+  }
+
+  /**
+   * @brief 計測するフレームの前までを再生する
+   * 
+   * @return true 成功した
+   * @return false 再生に失敗した
+   */
+  bool replay_setup();
+
+  /**
+   * @brief 次のフレームを再生する
+   * 
+   * @param timestamp 記録したときの、計測するフレームの始まりからフレームの終わりまでの時間[ns]
+   * @return true 1フレーム再生した
+   * @return false トレースが終わったか、再生に失敗した。failed()で区別する
+   */
+  bool replay_frame(uint64_t& timestamp);
+
+  /**
+   * @brief 再生に失敗したか
+   */
+  bool failed() const noexcept {
+    return failed_;
+  }
+
+ private:
+  friend struct detail::GlTraceAccess;
+
+  /**
+   * @brief 制御レコードか関数の呼び出しを1つ再生する
+   * 
+   * @return uint16_t 読んだレコードの番号。GlFunctionかGlTraceOpの値
+   */
+  uint16_t replay_record();
+
+  GlTraceHeader header_;  ///< ファイルの先頭
+  std::vector<std::byte> data_;  ///< レコード
+  size_t pos_ = 0;  ///< 次に読むレコードの位置
+  bool failed_ = false;  ///< 再生に失敗したか
+  bool ended_ = false;  ///< トレースの終わりまで再生したか
+  std::unordered_map<uint64_t, GLsync> syncs_;  ///< 記録したフェンスの番号と、再生したフェンス
+  std::unordered_map<GLuint, std::span<std::byte>> mapped_;  ///< 記録したバッファ名ごとの、マップした範囲
+  std::array<std::unordered_map<GLuint, GLuint>, static_cast<size_t>(GlNameType::COUNT)> name_maps_;  ///< 種類ごとの、記録した名前から払い出された名前へのマップ
+  const std::byte* expected_ = nullptr;  ///< 記録した名前や戻り値。呼び出した後に対応付ける
+  std::vector<GLuint> names_;  ///< 払い出された名前を受け取る領域と、置き換えた名前の配列
+  std::vector<const GLchar*> strings_;  ///< シェーダのソースを指すポインタ
+  std::vector<GLint> lengths_;  ///< シェーダのソースの長さ
+};
+}  // namespace garie
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include "garie.hpp"
+
+namespace rtdemo {
+/**
+ * @brief パスごとのGPU時間を計測するプロファイラ
+ * 
+ * スコープの開始と終了にGL_TIMESTAMPのクエリを発行する。
+ * 結果はFRAME_LATENCYフレーム遅れて読み出すので、読み出しでストールしない。
+ */
+class GpuProfiler final {
+ public:
+  /**
+   * @brief パスの計測結果
+   */
+  struct Pass {
+    const char* name = nullptr;  ///< パス名
+    uint32_t depth = 0;  ///< スコープの深さ
+    double time = 0.0;  ///< GPU時間[ms]
+    double average_time = 0.0;  ///< 平滑化したGPU時間[ms]
+  };
+
+  /**
+   * @brief 計測するスコープ
+   */
+  class Scope final {
+   public:
+    explicit Scope(const char* name) noexcept
+        : index_(GpuProfiler::get().begin(name)) {}
+
+    Scope(const Scope&) = delete;
+
+    ~Scope() noexcept {
+      GpuProfiler::get().end(index_);
+    }
+
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    size_t index_;  ///< イベント番号
+  };
+
+  /**
+   * @brief インスタンスを取得する
+   * 
+   * @return GpuProfiler&
+   */
+  static GpuProfiler& get() noexcept;
+
+  /**
+   * @brief クエリを破棄する
+   * 
+   * GLコンテキストを破棄する前に呼び出す。
+   */
+  void invalidate();
+
+  /**
+   * @brief フレームを開始する
+   * 
+   * FRAME_LATENCYフレーム前の結果が利用可能であれば読み出す。
+   */
+  void begin_frame();
+
+  /**
+   * @brief フレームを終了する
+   */
+  void end_frame();
+
+  /**
+   * @brief スコープを開始する
+   * 
+   * @param name パス名。フレームの結果を読み出すまで有効でなければならない。
+   * @return size_t イベント番号
+   */
+  size_t begin(const char* name);
+
+  /**
+   * @brief スコープを終了する
+   * 
+   * @param index beginが返したイベント番号
+   */
+  void end(size_t index);
+
+  /**
+   * @brief GUIを更新する
+   */
+  void update_gui();
+
+  /**
+   * @brief 最新の計測結果をJSONとして書き出す
+   * 
+   * @param path ファイルパス
+   * @return true 成功した
+   * @return false 失敗した
+   */
+  bool save(const std::filesystem::path& path) const;
+
+  /**
+   * @brief 最新の計測結果を取得する
+   * 
+   * @return const std::vector<Pass>& パスの計測結果
+   */
+  const std::vector<Pass>& passes() const noexcept {
+    return passes_;
+  }
+
+  /**
+   * @brief 現在のフレーム番号を取得する
+   */
+  uint64_t frame_index() const noexcept {
+    return frame_index_;
+  }
+
+  /**
+   * @brief passesが示すフレームの番号を取得する
+   */
+  uint64_t resolved_frame_index() const noexcept {
+    return resolved_frame_index_;
+  }
+
+  /**
+   * @brief 読み出しが間に合わずに捨てたフレーム数を取得する
+   */
+  uint64_t dropped_frame_count() const noexcept {
+    return dropped_frame_count_;
+  }
+
+  void set_enabled(bool enabled) noexcept {
+    enabled_ = enabled;
+  }
+
+  bool is_enabled() const noexcept {
+    return enabled_;
+  }
+
+ private:
+  static constexpr size_t FRAME_LATENCY = 4;  ///< 結果を読み出すまでのフレーム数
+  static constexpr size_t INVALID_INDEX = ~size_t(0);
+
+  /**
+   * @brief スコープの記録
+   */
+  struct Event {
+    const char* name;  ///< パス名
+    uint32_t depth;  ///< スコープの深さ
+    size_t begin_query;  ///< 開始時刻のクエリ番号
+    size_t end_query;  ///< 終了時刻のクエリ番号
+  };
+
+  /**
+   * @brief 1フレーム分の記録
+   */
+  struct Frame {
+    uint64_t index = 0;  ///< フレーム番号
+    bool pending = false;  ///< 結果を読み出していないか
+    std::vector<garie::Query> queries;  ///< タイムスタンプのクエリ
+    size_t query_count = 0;  ///< このフレームで使ったクエリの数
+    std::vector<Event> events;  ///< スコープの記録
+  };
+
+  /**
+   * @brief タイムスタンプを記録する
+   * 
+   * @return size_t クエリ番号
+   */
+  size_t timestamp(Frame& frame);
+
+  /**
+   * @brief フレームの結果を読み出す
+   */
+  void resolve(Frame& frame);
+
+  std::array<Frame, FRAME_LATENCY> frames_;
+  size_t current_ = 0;  ///< 記録中のフレーム
+  uint64_t frame_index_ = 0;  ///< 記録中のフレーム番号
+  uint64_t resolved_frame_index_ = 0;  ///< 最後に読み出したフレーム番号
+  uint64_t dropped_frame_count_ = 0;  ///< 捨てたフレーム数
+  uint32_t depth_ = 0;  ///< 現在のスコープの深さ
+  bool in_frame_ = false;  ///< フレームを記録中か
+  bool enabled_ = true;  ///< 計測するか
+  std::vector<Pass> passes_;  ///< 最新の計測結果
+};
+}  // namespace rtdemo
+
+#ifndef RT_PROFILE_CONCAT
+#define RT_PROFILE_CONCAT_IMPL(a, b) a##b
+#define RT_PROFILE_CONCAT(a, b) RT_PROFILE_CONCAT_IMPL(a, b)
+#endif
+
+/**
+ * @brief 現在のスコープのGPU時間を計測するマクロ
+ */
+#define RT_GPU_SCOPE(name) \
+  ::rtdemo::GpuProfiler::Scope RT_PROFILE_CONCAT(rt_gpu_scope_, __LINE__)(name)
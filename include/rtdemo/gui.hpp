@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
 #ifdef WIN32
 #include <Windows.h>
 #endif
@@ -36,6 +38,13 @@ class Gui final {
    */
   void new_frame();
 
+  /**
+   * @brief 最後のnew_frame()で入力を読んだ時刻を取得する
+   */
+  std::chrono::steady_clock::time_point input_time() const noexcept {
+    return input_tp_;
+  }
+
   /**
    * @brief 描画する
    */
@@ -79,14 +88,15 @@ class Gui final {
   GLFWwindow* window_ = nullptr;
   double time_ = 0.0;  ///< 前回のupdateを行った時刻
   bool mouse_pressed_[3] = {};  ///< マウスのボタンが押されているか
+  std::chrono::steady_clock::time_point input_tp_;  ///< 最後に入力を読んだ時刻
   garie::Program prog_;
-  garie::RasterizationState rs_;
-  garie::ColorBlendState cbs_;
-  garie::DepthStencilState dss_;
+  const garie::RasterizationState* rs_ = nullptr;  ///< 共有されたラスタライザーステート
+  const garie::ColorBlendState* cbs_ = nullptr;  ///< 共有されたブレンドステート
+  const garie::DepthStencilState* dss_ = nullptr;  ///< 共有されたデプスステンシルステート
   garie::VertexArray va_;
   garie::Buffer ib_;
   garie::Buffer vb_;
   garie::Texture font_tex_;
-  garie::Sampler font_ss_;
+  std::shared_ptr<const garie::Sampler> font_ss_;
 };
 }  // namespace rtdemo
@@ -28,6 +28,15 @@ public:
    */
   void terminate();
 
+  /**
+   * @brief 破棄時にキー入力を要求するかを設定する
+   * 
+   * @param enabled 要求するならtrue
+   */
+  void set_pause_on_terminate(bool enabled) noexcept {
+    pause_on_terminate_ = enabled;
+  }
+
   /**
    * @brief ログレベルを確認して、ログを出力する
    * 
@@ -44,6 +53,7 @@ public:
 
 private:
   spdlog::level::level_enum max_level_ = spdlog::level::trace;  ///< 出力されたログの中で最も大きなレベル
+  bool pause_on_terminate_ = true;  ///< 破棄時にキー入力を要求するか
   std::shared_ptr<spdlog::logger> logger_;
 };
 }  // namespace rtdemo
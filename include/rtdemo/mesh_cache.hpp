@@ -0,0 +1,224 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace rtdemo::util {
+/**
+ * @brief 読み込み専用でメモリにマップしたファイル
+ */
+class MappedFile final {
+ public:
+  MappedFile() = default;
+
+  MappedFile(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& other) noexcept;
+
+  ~MappedFile() noexcept;
+
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  /**
+   * @brief ファイルをマップする
+   * 
+   * @param path ファイルパス
+   * @return true 成功した
+   * @return false ファイルを開けなかったか、空だった
+   */
+  bool open(const std::filesystem::path& path);
+
+  /**
+   * @brief アンマップする
+   */
+  void close() noexcept;
+
+  /**
+   * @brief マップした内容
+   */
+  std::span<const std::byte> bytes() const noexcept {
+    return {data_, size_};
+  }
+
+ private:
+  const std::byte* data_ = nullptr;  ///< マップ先
+  size_t size_ = 0;  ///< ファイルの大きさ[byte]
+#ifdef _WIN32
+  void* mapping_ = nullptr;  ///< ファイルマッピングオブジェクトのハンドル
+#endif
+};
+
+/**
+ * @brief メッシュキャッシュの区画
+ */
+enum class MeshSection : uint32_t {
+  VERTICES,  ///< 頂点
+  INDICES,  ///< インデックス
+  COMMANDS,  ///< 間接描画コマンド
+  INDEX_TYPES,  ///< 描画コマンドごとのインデックスの型
+  RESOURCE_INDICES,  ///< メッシュごとのリソース番号
+  MATERIALS,  ///< マテリアル
+  BOUNDS,  ///< メッシュごとの境界ボックス
+  COUNT,
+};
+
+/**
+ * @brief メッシュキャッシュの区画の位置
+ */
+struct MeshSectionEntry {
+  uint64_t offset = 0;  ///< ファイルの先頭からのオフセット[byte]
+  uint64_t size = 0;  ///< 大きさ[byte]
+  uint32_t element_size = 0;  ///< 要素の大きさ[byte]。読み込む側の型と一致しなければならない
+  uint32_t _pad = 0;
+};
+
+/**
+ * @brief メッシュキャッシュの先頭
+ * 
+ * 後ろに区画の中身がSECTION_ALIGNMENTに揃えて並ぶ。
+ * 区画の中身はGLのバッファにそのまま転送できる形で、読み込むときに解析しない。
+ */
+struct MeshCacheHeader {
+  char magic[8] = {'R', 'T', 'M', 'E', 'S', 'H', '\0', '\0'};  ///< ファイルの識別子
+  uint32_t version = 4;  ///< 形式のバージョン
+  uint32_t import_flags = 0;  ///< 読み込むときにAssimpに渡したフラグ
+  uint64_t source_hash = 0;  ///< 元のファイルの内容のハッシュ値
+  uint64_t _pad = 0;
+  std::array<MeshSectionEntry, 16> sections{};  ///< MeshSectionごとの区画の位置。区画を増やしても大きさを変えないように余裕を持たせる
+};
+
+static_assert(static_cast<size_t>(MeshSection::COUNT) <= std::tuple_size_v<decltype(MeshCacheHeader::sections)>);
+
+/**
+ * @brief 元のファイルを読み込んで変換したメッシュを、そのままGLに転送できる形で保存したキャッシュ
+ * 
+ * 元のファイルの内容のハッシュ値と読み込みのフラグが一致するときだけ使う。
+ * ファイルから開いたときはマップした領域を、変換した直後はメモリ上の内容をそのまま返す。
+ * マテリアルを別のファイル(.mtlなど)から読み込む形式では、そのファイルの変更は検知しないので、キャッシュを消して作り直す。
+ */
+class MeshCache final {
+ public:
+  static constexpr size_t SECTION_ALIGNMENT = 16;  ///< 区画の先頭のアラインメント[byte]
+
+  /**
+   * @brief キャッシュファイルを開く
+   * 
+   * @param path キャッシュファイルのパス
+   * @param source_hash 元のファイルの内容のハッシュ値
+   * @param import_flags 読み込みのフラグ
+   * @return true 成功した
+   * @return false ファイルがないか、形式、ハッシュ値、フラグのいずれかが異なった
+   */
+  bool open(const std::filesystem::path& path, uint64_t source_hash, uint32_t import_flags);
+
+  /**
+   * @brief 区画の中身を返す
+   * 
+   * @tparam T 要素の型
+   * @return std::span<const T> 区画の中身。開いていないか、要素の大きさが異なれば空
+   */
+  template <typename T>
+  std::span<const T> section(MeshSection section) const noexcept {
+    const auto bytes = section_bytes(section, sizeof(T));
+    return {reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T)};
+  }
+
+  /**
+   * @brief 要素の型が実行時に決まる区画の中身を返す
+   * 
+   * @param element_size 要素の大きさ[byte]
+   * @return std::span<const std::byte> 区画の中身。開いていないか、要素の大きさが異なれば空
+   */
+  std::span<const std::byte> section_bytes(MeshSection section, size_t element_size) const noexcept {
+    const auto& entry = header().sections[static_cast<size_t>(section)];
+    if (bytes_.empty() || entry.element_size != element_size) return {};
+    return bytes_.subspan(entry.offset, entry.size);
+  }
+
+  /**
+   * @brief キャッシュの大きさ[byte]
+   */
+  size_t size() const noexcept {
+    return bytes_.size();
+  }
+
+ private:
+  friend class MeshCacheBuilder;
+
+  const MeshCacheHeader& header() const noexcept {
+    static const MeshCacheHeader empty;
+    return bytes_.empty() ? empty : *reinterpret_cast<const MeshCacheHeader*>(bytes_.data());
+  }
+
+  /**
+   * @brief 先頭と区画の位置が壊れていないかを確かめる
+   */
+  bool validate(uint64_t source_hash, uint32_t import_flags) const noexcept;
+
+  MappedFile file_;  ///< 開いたキャッシュファイル
+  std::vector<std::byte> memory_;  ///< 変換した直後のキャッシュの内容
+  std::span<const std::byte> bytes_;  ///< file_かmemory_の内容
+};
+
+/**
+ * @brief 変換したメッシュからキャッシュを作る
+ */
+class MeshCacheBuilder final {
+ public:
+  /**
+   * @brief 区画を追加する
+   * 
+   * @tparam T 要素の型。パディングも含めてそのまま保存する
+   * @param section 区画
+   * @param elements 中身
+   */
+  template <typename T>
+  MeshCacheBuilder& section(MeshSection section, std::span<const T> elements) {
+    add(section, elements.data(), elements.size_bytes(), sizeof(T));
+    return *this;
+  }
+
+  /**
+   * @brief 要素の型が実行時に決まる区画を追加する
+   * 
+   * @param section 区画
+   * @param bytes 中身
+   * @param element_size 要素の大きさ[byte]。読み込むときに照合する
+   */
+  MeshCacheBuilder& section_bytes(MeshSection section, std::span<const std::byte> bytes, size_t element_size) {
+    add(section, bytes.data(), bytes.size(), element_size);
+    return *this;
+  }
+
+  /**
+   * @brief キャッシュファイルに書き出し、作ったキャッシュを返す
+   * 
+   * 書き出しに失敗しても、キャッシュはメモリ上で使える。
+   * 
+   * @param path キャッシュファイルのパス。書き出し終えてから置き換えるので、途中で失敗しても壊れない
+   * @param source_hash 元のファイルの内容のハッシュ値
+   * @param import_flags 読み込みのフラグ
+   * @return MeshCache 作ったキャッシュ
+   */
+  MeshCache build(const std::filesystem::path& path, uint64_t source_hash, uint32_t import_flags);
+
+ private:
+  void add(MeshSection section, const void* data, size_t size, size_t element_size);
+
+  MeshCacheHeader header_;  ///< 先頭
+  std::vector<std::byte> body_;  ///< 区画の中身
+};
+
+/**
+ * @brief キャッシュの鍵にするハッシュ値を求める
+ * 
+ * 暗号学的な強さはなく、内容が変わったことを検知するためだけに使う。
+ */
+uint64_t hash_bytes(std::span<const std::byte> bytes) noexcept;
+}  // namespace rtdemo::util
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <GL/glew.h>
+
+namespace rtdemo::util {
+/**
+ * @brief 16ビットのインデックスで指せる頂点の数
+ */
+constexpr size_t MAX_SHORT_INDEX_VERTEX_COUNT = size_t(1) << 16;
+
+/**
+ * @brief インデックスの幅を決めたメッシュの一部
+ * 
+ * インデックスはvertices[0]を0とする番号で、index_typeの幅で表せる。
+ */
+struct IndexedChunk {
+  GLenum index_type = GL_UNSIGNED_SHORT;  ///< GL_UNSIGNED_SHORTかGL_UNSIGNED_INT
+  std::vector<uint32_t> vertices;  ///< 使う頂点の、元のメッシュでの番号
+  std::vector<uint32_t> indices;  ///< 三角形のリスト
+};
+
+/**
+ * @brief メッシュごとに最も狭いインデックスの幅を選ぶ
+ * 
+ * 16ビットで表せるメッシュはそのまま16ビットにする。
+ * 表せないメッシュは、16ビットで表せる塊に分けたときに複製する頂点の大きさと、
+ * 32ビットにしたときに増えるインデックスの大きさを比べ、小さい方を選ぶ。
+ * 塊に分けても描画コマンドが増えるだけなので、その分のコストは考えない。
+ * 
+ * @param indices 三角形のリスト。メッシュの先頭の頂点を0とする番号
+ * @param vertex_count メッシュの頂点数
+ * @param vertex_size 1頂点の大きさ[byte]
+ * @return std::vector<IndexedChunk> 描画する順に並べた塊
+ */
+std::vector<IndexedChunk> choose_index_width(std::span<const uint32_t> indices, size_t vertex_count,
+                                             size_t vertex_size);
+
+/**
+ * @brief インデックスの型の大きさ[byte]
+ */
+constexpr size_t index_type_size(GLenum index_type) noexcept {
+  return index_type == GL_UNSIGNED_INT ? sizeof(uint32_t) : sizeof(uint16_t);
+}
+}  // namespace rtdemo::util
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+namespace rtdemo::util {
+/**
+ * @brief 最適化と評価で想定する頂点キャッシュの大きさ
+ */
+constexpr size_t VERTEX_CACHE_SIZE = 16;
+
+/**
+ * @brief 頂点キャッシュの効率
+ */
+struct VertexCacheStats {
+  size_t triangle_count = 0;  ///< 三角形の数
+  size_t vertex_count = 0;  ///< 使われている頂点の数
+  size_t transform_count = 0;  ///< 頂点シェーダを実行する回数
+
+  /**
+   * @brief 三角形あたりの頂点シェーダの実行回数。0.5に近いほどよい
+   */
+  float acmr() const noexcept {
+    return triangle_count > 0 ? static_cast<float>(transform_count) / triangle_count : 0.f;
+  }
+
+  /**
+   * @brief 頂点あたりの頂点シェーダの実行回数。1に近いほどよい
+   */
+  float atvr() const noexcept {
+    return vertex_count > 0 ? static_cast<float>(transform_count) / vertex_count : 0.f;
+  }
+
+  VertexCacheStats& operator+=(const VertexCacheStats& other) noexcept {
+    triangle_count += other.triangle_count;
+    vertex_count += other.vertex_count;
+    transform_count += other.transform_count;
+    return *this;
+  }
+};
+
+/**
+ * @brief FIFOの頂点キャッシュを模して、インデックスの並びを評価する
+ * 
+ * @param indices 三角形のリスト
+ * @param vertex_count 頂点数
+ * @param cache_size キャッシュの大きさ
+ */
+VertexCacheStats analyze_vertex_cache(std::span<const uint32_t> indices, size_t vertex_count,
+                                      size_t cache_size = VERTEX_CACHE_SIZE);
+
+/**
+ * @brief 頂点キャッシュに載りやすいように三角形を並べ替える
+ * 
+ * Tipsifyで、キャッシュに残っている頂点を共有する三角形を続けて出す。
+ * 近くに続けられる三角形がなくなったところでクラスタを区切る。
+ * 
+ * @param indices 三角形のリスト。並べ替えた結果で上書きする
+ * @param vertex_count 頂点数
+ * @param cache_size キャッシュの大きさ
+ * @return std::vector<uint32_t> クラスタの先頭の三角形の番号
+ */
+std::vector<uint32_t> optimize_vertex_cache(std::span<uint32_t> indices, size_t vertex_count,
+                                            size_t cache_size = VERTEX_CACHE_SIZE);
+
+/**
+ * @brief オーバードローが減るようにクラスタを並べ替える
+ * 
+ * メッシュの外側を向いたクラスタほど手前に来やすいとみなし、先に描画する。
+ * クラスタの中の順番は変えないので、頂点キャッシュの効率はほぼ保たれる。
+ * 
+ * @param indices 三角形のリスト。並べ替えた結果で上書きする
+ * @param positions 頂点の位置
+ * @param clusters optimize_vertex_cacheが返したクラスタの先頭
+ */
+void optimize_overdraw(std::span<uint32_t> indices, std::span<const glm::vec3> positions,
+                       std::span<const uint32_t> clusters);
+
+/**
+ * @brief 頂点を初めて使われる順に並べ替える
+ * 
+ * 頂点の読み込みが連続するようにする。使われない頂点は除く。
+ * 
+ * @param indices 三角形のリスト。並べ替えた後の頂点の番号で上書きする
+ * @param vertex_count 頂点数
+ * @return std::vector<uint32_t> 並べ替えた後の頂点ごとの、元の頂点の番号
+ */
+std::vector<uint32_t> optimize_vertex_fetch(std::span<uint32_t> indices, size_t vertex_count);
+}  // namespace rtdemo::util
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <rtdemo/types.hpp>
+
+namespace rtdemo::util {
+/**
+ * @brief 頂点の形式
+ */
+enum class VertexFormat : uint32_t {
+  FLOAT,  ///< VertexP3N3。変換しない
+  P16N16,  ///< VertexP16N16。位置は境界ボックス内の16ビット、法線は16ビット×2の八面体
+  P16N8,  ///< VertexP16N8。位置は境界ボックス内の16ビット、法線は8ビット×2の八面体
+};
+
+/**
+ * @brief 頂点の形式の名前
+ */
+const char* vertex_format_name(VertexFormat format) noexcept;
+
+/**
+ * @brief 1頂点の大きさ[byte]
+ */
+size_t vertex_format_size(VertexFormat format) noexcept;
+
+/**
+ * @brief 単位ベクトルを八面体に写し、[-1,1]の2次元で表す
+ */
+glm::vec2 encode_octahedral(const glm::vec3& n) noexcept;
+
+/**
+ * @brief 頂点を量子化して書き込む
+ * 
+ * 位置はboundsの最小から最大を[0,1]に写してから量子化する。
+ * GLの正規化された整数の属性として読めば、VertexDecodeで元に戻せる。
+ * 
+ * @param format 頂点の形式
+ * @param vertices 変換する頂点
+ * @param bounds verticesを含む境界ボックス
+ * @param output 書き込む先。末尾に追加する
+ */
+void quantize_vertices(VertexFormat format, std::span<const VertexP3N3> vertices, const BoundingBox& bounds,
+                       std::vector<std::byte>& output);
+
+/**
+ * @brief 量子化した頂点をシェーダで元に戻すための情報
+ * 
+ * @param format 頂点の形式
+ * @param bounds 量子化に使った境界ボックス
+ */
+VertexDecode vertex_decode(VertexFormat format, const BoundingBox& bounds) noexcept;
+}  // namespace rtdemo::util
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "garie.hpp"
+#include "render_target_pool.hpp"
+
+namespace rtdemo {
+/**
+ * @brief パスが読み書きするリソースを宣言して、実行順序とバリアを決めるレンダグラフ
+ * 
+ * 毎フレーム、reset()してからパスを宣言し、execute()で実行する。
+ * execute()は次のことを行う。
+ * - 出力が使われないパスを実行しない
+ * - シェーダからの書き込みを読む直前に、必要なビットだけのglMemoryBarrierを発行する
+ * - 一時テクスチャ(バッファ)を最初に使うパスの前にRenderTargetPoolから借り、最後に使うパスの後で返す
+ * 
+ * 返したものは後のパスや他のテクニックのグラフが借りるので、生存期間が重ならない一時リソースは実体を共有する。
+ */
+class RenderGraph final {
+ public:
+  /**
+   * @brief リソースへのアクセス方法
+   */
+  enum class Access : uint32_t {
+    SAMPLED,  ///< テクスチャフェッチ
+    IMAGE_LOAD,  ///< イメージの読み込み
+    IMAGE_STORE,  ///< イメージへの書き込み(読み込みを含む)
+    STORAGE_READ,  ///< SSBOの読み込み
+    STORAGE_WRITE,  ///< SSBOへの書き込み(読み込みを含む)
+    UNIFORM,  ///< UBOの読み込み
+    ATTACHMENT_READ,  ///< 書き込まないアタッチメント(深度テストのみなど)
+    ATTACHMENT_WRITE,  ///< アタッチメントへの描画
+  };
+
+  /**
+   * @brief グラフ内のリソースを指すハンドル
+   */
+  struct Handle {
+    uint32_t index = UINT32_MAX;  ///< リソース番号
+
+    explicit operator bool() const noexcept {
+      return index != UINT32_MAX;
+    }
+  };
+
+  using TextureDesc = util::RenderTargetDesc;
+
+  /**
+   * @brief パスの宣言を続けるビルダークラス
+   */
+  class PassBuilder final {
+   public:
+    /**
+     * @brief リソースを読み込むことを宣言する
+     * 
+     * @param handle リソース
+     * @param access アクセス方法
+     * @return PassBuilder& 自身を返す
+     */
+    PassBuilder& read(Handle handle, Access access);
+
+    /**
+     * @brief リソースに書き込むことを宣言する
+     * 
+     * @param handle リソース
+     * @param access アクセス方法
+     * @return PassBuilder& 自身を返す
+     */
+    PassBuilder& write(Handle handle, Access access);
+
+    /**
+     * @brief カラーアタッチメントに描画することを宣言する
+     * 
+     * @param index アタッチメント番号
+     * @param handle テクスチャ
+     * @return PassBuilder& 自身を返す
+     */
+    PassBuilder& color(GLuint index, Handle handle);
+
+    /**
+     * @brief 深度(ステンシル)アタッチメントを使うことを宣言する
+     * 
+     * @param handle テクスチャ
+     * @param write 深度に書き込むか
+     * @return PassBuilder& 自身を返す
+     */
+    PassBuilder& depth(Handle handle, bool write = true);
+
+    /**
+     * @brief バックバッファへの描画など、グラフの外から見える結果を持つことを宣言する
+     * 
+     * @return PassBuilder& 自身を返す
+     */
+    PassBuilder& side_effect() noexcept;
+
+   private:
+    friend class RenderGraph;
+
+    PassBuilder(RenderGraph& graph, size_t pass_index) noexcept
+        : graph_(graph), pass_index_(pass_index) {}
+
+    RenderGraph& graph_;  ///< 宣言先のグラフ
+    size_t pass_index_;  ///< 宣言中のパス
+  };
+
+  using ExecuteFunc = std::function<void(const RenderGraph&)>;
+
+  /**
+   * @brief 宣言したパスとリソースを破棄する
+   */
+  void reset();
+
+  /**
+   * @brief 外部で生成したテクスチャを登録する
+   * 
+   * @param name リソース名
+   * @param texture テクスチャ
+   * @return Handle ハンドル
+   */
+  Handle import_texture(const char* name, const garie::Texture& texture);
+
+  /**
+   * @brief 外部で生成したバッファを登録する
+   * 
+   * @param name リソース名
+   * @param buffer バッファ
+   * @return Handle ハンドル
+   */
+  Handle import_buffer(const char* name, const garie::Buffer& buffer);
+
+  /**
+   * @brief このフレームだけで使うテクスチャを宣言する
+   * 
+   * 実体はexecute()の間だけRenderTargetPoolから借りる。
+   * 
+   * @param name リソース名
+   * @param desc 仕様
+   * @return Handle ハンドル
+   */
+  Handle create_texture(const char* name, const TextureDesc& desc);
+
+  /**
+   * @brief このフレームだけで使うバッファを宣言する
+   * 
+   * @param name リソース名
+   * @param size 大きさ[byte]
+   * @return Handle ハンドル
+   */
+  Handle create_buffer(const char* name, size_t size);
+
+  /**
+   * @brief パスを追加する
+   * 
+   * アタッチメントを宣言したパスでは、executeを呼び出す前にフレームバッファをバインドする。
+   * 
+   * @param name パス名。GPU時間の計測にも使うので、文字列リテラルを渡す。
+   * @param execute GLコマンドを発行する関数
+   * @return PassBuilder 読み書きするリソースを宣言するビルダー
+   */
+  PassBuilder add_pass(const char* name, ExecuteFunc execute);
+
+  /**
+   * @brief 宣言したパスを実行する
+   */
+  void execute();
+
+  /**
+   * @brief 実体のテクスチャを取得する
+   */
+  const garie::Texture& texture(Handle handle) const noexcept;
+
+  /**
+   * @brief 実体のバッファを取得する
+   */
+  const garie::Buffer& buffer(Handle handle) const noexcept;
+
+  /**
+   * @brief 宣言した一時リソースのGPUメモリの見積もり
+   * 
+   * 宣言した仕様から求めるので、次にreset()するまで、実行した後も同じ値を返す。
+   * 
+   * @return size_t 使用量[byte]
+   */
+  size_t memory_usage() const noexcept;
+
+  /**
+   * @brief 現在のウィンドウにGUIを描画する
+   */
+  void update_gui() const;
+
+ private:
+  /**
+   * @brief アクセスの記録
+   */
+  struct Use {
+    uint32_t resource;  ///< リソース番号
+    Access access;  ///< アクセス方法
+  };
+
+  /**
+   * @brief アタッチメント
+   */
+  struct Attachment {
+    GLenum point;  ///< GL_COLOR_ATTACHMENTiなど
+    uint32_t resource;  ///< リソース番号
+  };
+
+  /**
+   * @brief パス
+   */
+  struct Pass {
+    const char* name = nullptr;  ///< パス名
+    ExecuteFunc execute;  ///< GLコマンドを発行する関数
+    std::vector<Use> reads;  ///< 読み込むリソース
+    std::vector<Use> writes;  ///< 書き込むリソース
+    std::vector<Attachment> attachments;  ///< アタッチメント
+    bool side_effect = false;  ///< グラフの外から見える結果を持つか
+    bool culled = false;  ///< 実行しないか
+    GLbitfield barrier = 0;  ///< 実行前に発行するバリア
+  };
+
+  /**
+   * @brief グラフ内のリソース
+   */
+  struct Resource {
+    const char* name = nullptr;  ///< リソース名
+    bool is_texture = true;  ///< テクスチャか
+    bool is_transient = false;  ///< このフレームだけで使うか
+    TextureDesc texture_desc;  ///< 一時テクスチャの仕様
+    size_t buffer_size = 0;  ///< 一時バッファの大きさ[byte]
+    const garie::Texture* texture = nullptr;  ///< 実体のテクスチャ
+    const garie::Buffer* buffer = nullptr;  ///< 実体のバッファ
+    size_t first_pass = SIZE_MAX;  ///< 最初に使うパス。使うパスがなければSIZE_MAX
+    size_t last_pass = SIZE_MAX;  ///< 最後に使うパス。使うパスがなければSIZE_MAX
+  };
+
+  /**
+   * @brief 出力が使われないパスを除く
+   */
+  void cull();
+
+  /**
+   * @brief 実行するパスの範囲から一時リソースの生存期間を求める
+   */
+  void compute_lifetimes();
+
+  /**
+   * @brief パスごとのバリアを決める
+   */
+  void place_barriers();
+
+  /**
+   * @brief パスの前に、そこから使い始める一時リソースを借りる
+   */
+  void acquire_transients(size_t pass_index);
+
+  /**
+   * @brief パスの後に、そこで使い終わる一時リソースを返す
+   */
+  void release_transients(size_t pass_index);
+
+  std::vector<Pass> passes_;  ///< 宣言されたパス
+  std::vector<Resource> resources_;  ///< 宣言されたリソース
+  size_t culled_pass_count_ = 0;  ///< 前回除いたパスの数
+  size_t barrier_count_ = 0;  ///< 前回発行したバリアの数
+  size_t transient_count_ = 0;  ///< 前回借りた一時リソースの数
+};
+}  // namespace rtdemo
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "garie.hpp"
+
+namespace rtdemo::util {
+/**
+ * @brief プールから借りるテクスチャの仕様
+ */
+struct RenderTargetDesc {
+  GLenum target = GL_TEXTURE_2D;  ///< GL_TEXTURE_2DかGL_TEXTURE_3D
+  GLenum internal_format = GL_RGBA8;  ///< 内部フォーマット
+  uint32_t width = 1;  ///< 幅
+  uint32_t height = 1;  ///< 高さ
+  uint32_t depth = 1;  ///< 奥行き(3Dテクスチャのみ)
+  uint32_t samples = 0;  ///< サンプル数。0でなければGL_TEXTURE_2D_MULTISAMPLEとして生成する
+
+  bool operator==(const RenderTargetDesc& rhs) const noexcept {
+    return target == rhs.target && internal_format == rhs.internal_format &&
+        width == rhs.width && height == rhs.height && depth == rhs.depth && samples == rhs.samples;
+  }
+};
+
+/**
+ * @brief フレームの中で一時的に使うテクスチャとバッファを使い回すプール
+ * 
+ * 返却されたテクスチャは破棄せずに残し、同じ仕様の要求に貸し出す。
+ * テクニックを切り替えたり、restoreとinvalidateを繰り返したりしても、GLオブジェクトを作り直さない。
+ * しばらく貸し出していないものはend_frame()で破棄する。
+ * 
+ * ResourceTrackerには、貸し出している間は借りたときのScopeのタグに、返却されている間は"render target pool"に数える。
+ */
+class RenderTargetPool final {
+ public:
+  /**
+   * @brief フレームバッファのアタッチメント
+   */
+  using Attachment = std::pair<GLenum, GLuint>;
+
+  /**
+   * @brief インスタンスを取得する
+   * 
+   * @return RenderTargetPool&
+   */
+  static RenderTargetPool& get() noexcept;
+
+  /**
+   * @brief すべてのテクスチャとバッファとフレームバッファを破棄する
+   * 
+   * GLコンテキストを破棄する前に呼び出す。
+   */
+  void clear();
+
+  /**
+   * @brief テクスチャを借りる
+   * 
+   * @param desc 仕様
+   * @return const garie::Texture& 返却するまで使えるテクスチャ
+   */
+  const garie::Texture& acquire_texture(const RenderTargetDesc& desc);
+
+  /**
+   * @brief テクスチャを返却する
+   * 
+   * @param texture acquire_textureで借りたテクスチャ
+   */
+  void release_texture(const garie::Texture& texture);
+
+  /**
+   * @brief SSBOとして使うバッファを借りる
+   * 
+   * @param size 大きさ[byte]
+   * @return const garie::Buffer& 返却するまで使えるバッファ
+   */
+  const garie::Buffer& acquire_buffer(size_t size);
+
+  /**
+   * @brief バッファを返却する
+   * 
+   * @param buffer acquire_bufferで借りたバッファ
+   */
+  void release_buffer(const garie::Buffer& buffer);
+
+  /**
+   * @brief アタッチメントの組み合わせに合うフレームバッファを探し、なければ作る
+   * 
+   * @param attachments アタッチメントポイントとテクスチャIDの組。順番はglDrawBuffersの順になる。
+   * @return const garie::Framebuffer& フレームバッファ
+   */
+  const garie::Framebuffer& framebuffer(const std::vector<Attachment>& attachments);
+
+  /**
+   * @brief フレームの終わりに、しばらく使っていないものを破棄する
+   */
+  void end_frame();
+
+  /**
+   * @brief 残しているGPUメモリの合計を取得する
+   */
+  size_t memory_usage() const noexcept {
+    return memory_usage_;
+  }
+
+  /**
+   * @brief 現在のウィンドウにGUIを描画する
+   */
+  void update_gui() const;
+
+ private:
+  static constexpr uint64_t KEEP_FRAME_COUNT = 120;  ///< 返却されてから破棄するまでのフレーム数
+
+  /**
+   * @brief 残しているテクスチャかバッファ
+   */
+  struct Entry {
+    bool is_texture = true;  ///< テクスチャか
+    RenderTargetDesc desc;  ///< テクスチャの仕様
+    size_t size = 0;  ///< GPUメモリの使用量[byte]
+    garie::Texture texture;  ///< テクスチャ
+    garie::Buffer buffer;  ///< バッファ
+    bool in_use = false;  ///< 貸し出し中か
+    uint64_t released_frame = 0;  ///< 返却されたフレーム
+  };
+
+  /**
+   * @brief 作ったフレームバッファ
+   */
+  struct CachedFramebuffer {
+    std::vector<Attachment> attachments;  ///< アタッチメント
+    garie::Framebuffer framebuffer;  ///< フレームバッファ
+  };
+
+  RenderTargetPool() = default;
+
+  /**
+   * @brief 貸し出した大きさを、ResourceTrackerで借り手のタグに数える
+   */
+  static void track_acquire(const Entry& entry);
+
+  /**
+   * @brief 返却された大きさを、ResourceTrackerでプールのタグに戻す
+   */
+  static void track_release(const Entry& entry) noexcept;
+
+  /**
+   * @brief テクスチャを参照しているフレームバッファを破棄する
+   */
+  void erase_framebuffers(GLuint texture_id);
+
+  std::vector<std::unique_ptr<Entry>> entries_;  ///< 残しているテクスチャとバッファ。参照を返すので要素を動かさない
+  std::vector<std::unique_ptr<CachedFramebuffer>> framebuffers_;  ///< 作ったフレームバッファ
+  uint64_t frame_index_ = 0;  ///< end_frame()を呼び出した回数
+  size_t memory_usage_ = 0;  ///< 残しているGPUメモリの合計[byte]
+  size_t created_count_ = 0;  ///< 生成した回数
+  size_t reused_count_ = 0;  ///< 使い回した回数
+};
+}  // namespace rtdemo::util
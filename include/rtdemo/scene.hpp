@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include "application.hpp"
+#include "frame_packet.hpp"
 
 namespace rtdemo {
 /**
@@ -72,6 +74,10 @@ enum class ApplyType {
 enum class DrawType {
   /**
    * @brief 不透明オブジェクトを描画する
+   * 
+   * SSBO = {
+   *   7: 描画コマンドごとの頂点を元に戻すための情報(VertexDecode)
+   * }
    */
   OPAQUE,
 
@@ -95,6 +101,21 @@ class Scene {
  public:
   virtual ~Scene() noexcept {}
 
+  /**
+   * @brief GLを使わない読み込みを済ませる
+   * 
+   * ローダースレッドから呼び出されるので、GLを呼び出してはならない。
+   * 呼び出さずにrestoreしたときは、restoreが読み込む。
+   * 
+   * @param progress 進捗(0から1)を書き込む
+   * @return true 成功した
+   * @return false 失敗した
+   */
+  virtual bool load(std::atomic<float>& progress) {
+    progress = 1.f;
+    return true;
+  }
+
   /**
    * @brief リソースを用意する
    * 
@@ -112,9 +133,21 @@ class Scene {
   virtual bool invalidate() = 0;
 
   /**
-   * @brief シーンの状態を更新する
+   * @brief シーンの状態を更新してパケットに書き込む
+   * 
+   * ワーカースレッドから呼び出されるので、GLを呼び出してはならない。
+   * 前のフレームのapplyやdrawと並行して動くので、それらが書き換える状態にも触れてはならない。
+   * 
+   * @param packet 書き込むパケット
+   */
+  virtual void update(FramePacket& packet) = 0;
+
+  /**
+   * @brief パケットの内容をGPUに転送する
+   * 
+   * @param packet updateで書き込んだパケット
    */
-  virtual void update() = 0;
+  virtual void upload(const FramePacket& packet) = 0;
 
   /**
    * @brief GUIを更新する
@@ -141,12 +174,19 @@ class Scene {
  * 
  * ソースファイルでrtdemo::scene下に記述すると、プログラム起動時にT型のシーンを登録してくれる。
  */
-#define RT_MANAGED_SCENE(T) \
+#define RT_MANAGED_SCENE(T) RT_MANAGED_SCENE_NAMED(T, T)
+
+/**
+ * @brief 名前とコンストラクタの引数を指定してstaticなシーンを定義するマクロ
+ * 
+ * 同じ型のシーンを設定を変えて複数登録するときに使う。
+ */
+#define RT_MANAGED_SCENE_NAMED(NAME, T, ...) \
   namespace { \
-    static struct ManagedScene_##T { \
-      ManagedScene_##T() { \
-        ::rtdemo::Application::get().insert_scene(#T, std::make_shared<T>()); \
+    static struct ManagedScene_##NAME { \
+      ManagedScene_##NAME() { \
+        ::rtdemo::Application::get().insert_scene(#NAME, std::make_shared<T>(__VA_ARGS__)); \
       } \
-    } managed_scene_##T##_; \
+    } managed_scene_##NAME##_; \
   }
 }  // namespace rtdemo
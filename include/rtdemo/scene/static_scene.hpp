@@ -1,24 +1,48 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <glm/glm.hpp>
 #include <rtdemo/types.hpp>
 #include <rtdemo/garie.hpp>
+#include <rtdemo/upload_ring.hpp>
+#include <rtdemo/mesh_cache.hpp>
+#include <rtdemo/mesh_quantize.hpp>
 #include <rtdemo/scene.hpp>
 
 namespace rtdemo::scene {
 /**
  * @brief 静的なシーン
+ * 
+ * 頂点の形式と、メッシュをまとめる大きさはシーンごとに決め、読み込むときに変換する。
+ * まとめたメッシュの頂点数は、16ビットのインデックスで引ける数を超えないようにする。
  */
 class StaticScene final : public Scene {
  public:
+  static constexpr uint32_t DEFAULT_MAX_BATCH_TRIANGLE_COUNT = 1 << 16;  ///< まとめたメッシュの三角形の数の既定の上限
+
+  /**
+   * @brief コンストラクタ
+   * 
+   * @param vertex_format 頂点の形式
+   * @param max_batch_triangle_count 同じマテリアルのメッシュをまとめるときの三角形の数の上限。0ならまとめない
+   */
+  explicit StaticScene(util::VertexFormat vertex_format = util::VertexFormat::FLOAT,
+                       uint32_t max_batch_triangle_count = DEFAULT_MAX_BATCH_TRIANGLE_COUNT) noexcept
+      : vertex_format_(vertex_format), max_batch_triangle_count_(max_batch_triangle_count) {}
+
   ~StaticScene() noexcept override {}
 
+  bool load(std::atomic<float>& progress) override;
+
   bool restore() override;
 
   bool invalidate() override;
 
-  void update() override;
+  void update(FramePacket& packet) override;
+
+  void upload(const FramePacket& packet) override;
 
   void update_gui() override;
 
@@ -51,6 +75,42 @@ class StaticScene final : public Scene {
     float _pad[3];
   };
 
+  /**
+   * @brief loadで読み込み、restoreでGLリソースにするデータ
+   * 
+   * メッシュとマテリアルはメッシュキャッシュに置き、restoreでそのままバッファに転送する。
+   */
+  struct LoadedData {
+    util::MeshCache mesh_cache;
+    std::vector<PointLight> lights;
+    std::vector<ShadowCaster> shadow_casters;
+  };
+
+  /**
+   * @brief シーンを読み込むときにAssimpに渡すフラグ
+   */
+  static const uint32_t IMPORT_FLAGS;
+
+  /**
+   * @brief Assimpでシーンを読み込み、メッシュキャッシュを作る
+   * 
+   * @param scene_path シーンのファイルパス
+   * @param cache_path メッシュキャッシュを書き出すパス
+   * @param source_hash シーンのファイルの内容のハッシュ値
+   * @param vertex_format 頂点の形式
+   * @param max_batch_triangle_count メッシュをまとめるときの三角形の数の上限
+   * @param progress 進捗
+   * @param mesh_cache 作ったメッシュキャッシュを書き込む先
+   * @return true 成功した
+   * @return false 失敗した
+   */
+  static bool import(const char* scene_path, const std::filesystem::path& cache_path, uint64_t source_hash,
+                     util::VertexFormat vertex_format, uint32_t max_batch_triangle_count,
+                     std::atomic<float>& progress, util::MeshCache& mesh_cache);
+
+  const util::VertexFormat vertex_format_;  ///< 頂点の形式
+  const uint32_t max_batch_triangle_count_;  ///< メッシュをまとめるときの三角形の数の上限。描画の数とカリングの細かさの兼ね合いで決める
+
   float camera_center_ = 0.f;  ///< カメラの中心
   float camera_distance_ = 0.f;  ///< カメラの距離
   float camera_yaw_ = 0.f;  ///< カメラのY軸回転角度
@@ -58,23 +118,33 @@ class StaticScene final : public Scene {
   float lens_depth_ = 100.f;  ///< ファー面の距離
   DrawMode draw_mode_ = DrawMode::DRAW;  ///< 描画モード
 
+  /**
+   * @brief バッファヒープから割り当てた範囲を返す
+   */
+  void free_views();
+
   garie::VertexArray vao_;
-  garie::Buffer vbo_;
-  garie::Buffer ibo_;
-  garie::Buffer camera_ubo_;
-  garie::Buffer constant_ubo_;
-  garie::Buffer resource_index_ssbo_;
-  garie::Buffer material_ssbo_;
-  garie::Buffer light_ssbo_;
-  garie::Buffer shadow_ssbo_;
+  garie::BufferView vertex_view_;  ///< 頂点
+  garie::BufferView index_view_;  ///< インデックス
+  garie::BufferView vertex_decode_view_;  ///< 描画コマンドごとの頂点を元に戻すための情報
+  garie::BufferView resource_index_view_;  ///< メッシュごとのリソース番号
+  garie::BufferView material_view_;  ///< マテリアル
   PointLight light_{
     glm::vec3(0.f, 3.f, 0.f),
     7.f,
     glm::vec3(1.f, 1.f, 1.f),
     1.f,
   };
-  size_t light_count_ = 0;
-  garie::Buffer dio_;  ///< indirect描画コマンドのバッファ
-  std::vector<Command> commands_;
+  std::vector<PointLight> lights_;  ///< 読み込んだライト
+  std::vector<ShadowCaster> shadow_casters_;  ///< 読み込んだシャドウ
+  BoundingBox bounds_{};  ///< シーン全体の境界ボックス
+  util::UploadRing::Allocation camera_range_;  ///< このフレームのカメラ情報
+  util::UploadRing::Allocation constant_range_;  ///< このフレームの定数
+  util::UploadRing::Allocation light_range_;  ///< このフレームのライト
+  util::UploadRing::Allocation shadow_range_;  ///< このフレームのシャドウ
+  garie::BufferView command_view_;  ///< indirect描画コマンド
+  std::vector<Command> commands_;  ///< 描画コマンド。最初のインデックスはバッファの先頭から数える
+  std::vector<GLenum> index_types_;  ///< 描画コマンドごとのインデックスの型
+  std::unique_ptr<LoadedData> loaded_;  ///< restoreを待っているデータ
 };
 }  // namespace rtdemo::scene
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <rtdemo/garie.hpp>
+#include <rtdemo/upload_ring.hpp>
+#include <rtdemo/render_graph.hpp>
 #include <rtdemo/technique.hpp>
 
 namespace rtdemo::tech {
@@ -16,12 +19,18 @@ class DeferredShading final : public Technique {
 
   bool invalidate() override;
 
-  void update() override;
+  void update(FramePacket& packet) override;
+
+  void upload(const FramePacket& packet) override;
 
   void update_gui() override;
 
   void apply(Scene& scene) override;
 
+  size_t memory_usage() const noexcept override {
+    return memory_usage_ + graph_.memory_usage();
+  }
+
  private:
   /**
    * @brief モード
@@ -40,20 +49,18 @@ class DeferredShading final : public Technique {
   struct Constant {
     Mode mode;
     float _pad[3];
+    float uv_scale[2];  ///< 描画した範囲が占めるテクスチャ座標の割合
+    float _pad1[2];
   };
 
   garie::Program p0_prog_;  ///< Gパスのプログラム
   garie::Program p1_prog_;  ///< Lパスのプログラム
-  garie::Buffer constant_ub_;  ///< 定数用バッファ
-  garie::Texture ds_tex_;  ///< 深度ステンシル
-  garie::Texture g0_tex_;  ///< Gバッファ（1枚目）
-  garie::Texture g1_tex_;  ///< Gバッファ（2枚目）
-  garie::Texture g2_tex_;  ///< Gバッファ（3枚目）
-  garie::Texture g3_tex_;  ///< Gバッファ（4枚目）
-  garie::Framebuffer fb_;
-  garie::Viewport viewport_;
-  garie::Sampler ss_;
+  util::UploadRing::Allocation constant_range_;  ///< このフレームの定数
+  RenderGraph graph_;  ///< 深度ステンシルとGバッファを一時テクスチャとして扱うレンダグラフ
+  garie::Viewport viewport_;  ///< 内部解像度で描画するビューポート
+  std::shared_ptr<const garie::Sampler> ss_;
   Mode mode_ = Mode::DEFAULT;
+  size_t memory_usage_ = 0;  ///< GPUメモリの使用量の見積もり[byte]
   std::string log_;  // シェーダのエラーログ
 };
 }  // namespace rtdemo::tech
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <rtdemo/garie.hpp>
+#include <rtdemo/upload_ring.hpp>
 #include <rtdemo/technique.hpp>
 
 namespace rtdemo::tech {
@@ -16,12 +17,18 @@ class ForwardShading final : public Technique {
 
   bool invalidate() override;
 
-  void update() override;
+  void update(FramePacket& packet) override;
+
+  void upload(const FramePacket& packet) override;
 
   void update_gui() override;
 
   void apply(Scene& scene) override;
 
+  size_t memory_usage() const noexcept override {
+    return memory_usage_;
+  }
+
  private:
   /**
    * @brief モード
@@ -38,11 +45,13 @@ class ForwardShading final : public Technique {
 
   struct Constant {
     Mode mode;
+    float _pad[3];  ///< cbufferは16byte単位なので、バインドする範囲を合わせる
   };
 
   garie::Program prog_;
-  garie::Buffer constant_ub_;
+  util::UploadRing::Allocation constant_range_;  ///< このフレームの定数
   Mode mode_ = Mode::DEFAULT;
+  size_t memory_usage_ = 0;  ///< GPUメモリの使用量の見積もり[byte]
   std::string log_;  // シェーダのエラーログ
 };
 }  // namespace rtdemo::tech
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <rtdemo/garie.hpp>
+#include <rtdemo/upload_ring.hpp>
+#include <rtdemo/render_graph.hpp>
 #include <rtdemo/technique.hpp>
 
 namespace rtdemo::tech {
@@ -16,13 +19,22 @@ class ShadowMapping final : public Technique {
 
   bool invalidate() override;
 
-  void update() override;
+  void update(FramePacket& packet) override;
+
+  void upload(const FramePacket& packet) override;
 
   void update_gui() override;
 
   void apply(Scene& scene) override;
 
+  size_t memory_usage() const noexcept override {
+    return memory_usage_ + graph_.memory_usage();
+  }
+
  private:
+  static constexpr uint32_t SHADOW_MAP_WIDTH = 1024;  ///< シャドウマップの幅
+  static constexpr uint32_t SHADOW_MAP_HEIGHT = 1024;  ///< シャドウマップの高さ
+
   /**
    * @brief モード
    */
@@ -39,12 +51,12 @@ class ShadowMapping final : public Technique {
 
   garie::Program p0_prog_;  ///< シャドウパスのプログラム
   garie::Program p1_prog_;  ///< シェーディングパスのプログラム
-  garie::Buffer constant_ub_;
-  garie::Texture depth_tex_;  ///< シャドウマップのテクスチャ
-  garie::Framebuffer p0_fbo_;  ///< シャドウパスのフレームバッファ
+  util::UploadRing::Allocation constant_range_;  ///< このフレームの定数
+  RenderGraph graph_;  ///< シャドウマップを一時テクスチャとして扱うレンダグラフ
   garie::Viewport p0_viewport_;  ///< シャドウパスのビューポート
-  garie::Sampler ss_;  ///< サンプラ
+  std::shared_ptr<const garie::Sampler> ss_;  ///< サンプラ
   Constant constant_;
+  size_t memory_usage_ = 0;  ///< GPUメモリの使用量の見積もり[byte]
   std::string log_;  // シェーダのエラーログ
 };
 }  // namespace rtdemo::tech
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <rtdemo/garie.hpp>
+#include <rtdemo/upload_ring.hpp>
+#include <rtdemo/render_graph.hpp>
 #include <rtdemo/technique.hpp>
 
 namespace rtdemo::tech {
@@ -16,12 +19,18 @@ class TiledForwardShading final : public Technique {
 
   bool invalidate() override;
 
-  void update() override;
+  void update(FramePacket& packet) override;
+
+  void upload(const FramePacket& packet) override;
 
   void update_gui() override;
 
   void apply(Scene& scene) override;
 
+  size_t memory_usage() const noexcept override {
+    return memory_usage_ + graph_.memory_usage();
+  }
+
 private:
   static constexpr size_t TILE_WIDTH = 32;
   static constexpr size_t TILE_HEIGHT = 32;
@@ -70,19 +79,15 @@ private:
   garie::Program p1_prog_;
   garie::Program p2_prog_;
   garie::Program p3_prog_;
-  garie::Texture depth_tex_;
-  garie::Texture rt0_tex_;
-  garie::Framebuffer p0_fbo_;
-  garie::Framebuffer p2_fbo_;
-  garie::Viewport viewport_;
-  garie::Buffer constant_ubo_;
-  garie::Buffer tiles_ssbo_;
-  garie::Buffer light_indices_ssbo_;
-  garie::Buffer light_index_count_ssbo_;
-  garie::Buffer print_ssbo_;
+  RenderGraph graph_;  ///< レンダターゲットとタイルごとのバッファを一時リソースとして扱うレンダグラフ
+  garie::Viewport viewport_;  ///< 内部解像度で描画するビューポート
+  std::shared_ptr<const garie::Sampler> p3_ss_;  ///< 内部解像度の結果を拡大するためのサンプラ
+  util::UploadRing::Allocation constant_range_;  ///< このフレームの定数
   Mode mode_ = Mode::DEFAULT;
   uint32_t tiled_screen_width_ = 0;
   uint32_t tiled_screen_height_ = 0;
+  uint32_t dispatch_tile_count_[2] = {};  ///< 内部解像度を占めるタイルの数
+  size_t memory_usage_ = 0;  ///< GPUメモリの使用量の見積もり[byte]
   std::string log_;  ///< シェーダのエラーログ
 };
 }  // namespace rtdemo::tech
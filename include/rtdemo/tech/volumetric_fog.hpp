@@ -1,7 +1,10 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <rtdemo/garie.hpp>
+#include <rtdemo/upload_ring.hpp>
+#include <rtdemo/render_graph.hpp>
 #include <rtdemo/technique.hpp>
 
 namespace rtdemo::tech {
@@ -16,13 +19,22 @@ class VolumetricFog final : public Technique {
 
   bool invalidate() override;
 
-  void update() override;
+  void update(FramePacket& packet) override;
+
+  void upload(const FramePacket& packet) override;
 
   void update_gui() override;
 
   void apply(Scene& scene) override;
 
+  size_t memory_usage() const noexcept override {
+    return memory_usage_ + graph_.memory_usage();
+  }
+
 private:
+  static constexpr uint32_t SHADOW_WIDTH = 1024;  ///< シャドウマップの幅
+  static constexpr uint32_t SHADOW_HEIGHT = 1024;  ///< シャドウマップの高さ
+
   /**
    * @brief モード
    */
@@ -77,16 +89,14 @@ private:
   garie::Program p0_prog_;  // ボリュームのボクセル化
   garie::Program p1_prog_;  // ボリューメトリックライティングの計算
   garie::Program p2_prog_;  // レンダリング
-  garie::Texture shadow_tex_;  // シャドウマップ
-  garie::Texture vbuffer_tex_;  // ボリュームの特性を格納する3Dテクスチャ
-  garie::Texture lighting_tex_;  // 視点から見たのボリューメトリックライティングの結果を格納する3Dテクスチャ
-  garie::Framebuffer shadow_fb_;  // シャドウマッピング用
+  RenderGraph graph_;  // シャドウマップとVバッファを一時テクスチャとして扱うレンダグラフ
   garie::Viewport shadow_vp_;  // シャドウマッピング用
-  garie::Sampler lighting_ss_;  // 3Dテクスチャをサンプルするためのサンプラ
-  garie::Sampler shadow_ss_;  // シャドウマップをサンプルするためのサンプラ
-  garie::Buffer constant_ub_;  // 定数用バッファ
+  std::shared_ptr<const garie::Sampler> lighting_ss_;  // 3Dテクスチャをサンプルするためのサンプラ
+  std::shared_ptr<const garie::Sampler> shadow_ss_;  // シャドウマップをサンプルするためのサンプラ
+  util::UploadRing::Allocation constant_range_;  ///< このフレームの定数
   Constant constant_;  // 定数の値
   float absorption_coeff_ = 0.f;
+  size_t memory_usage_ = 0;  ///< GPUメモリの使用量の見積もり[byte]
   std::string log_;  ///< シェーダのエラーログ
 };
 }  // namespace rtdemo::tech
@@ -28,9 +28,20 @@ class Technique {
   virtual bool invalidate() = 0;
 
   /**
-   * @brief 状態を更新する
+   * @brief 状態を更新してパケットに書き込む
+   * 
+   * Scene::updateのあとにワーカースレッドから呼び出されるので、GLを呼び出してはならない。
+   * 
+   * @param packet 書き込むパケット
+   */
+  virtual void update(FramePacket& packet) = 0;
+
+  /**
+   * @brief パケットの内容をGPUに転送する
+   * 
+   * @param packet updateで書き込んだパケット
    */
-  virtual void update() = 0;
+  virtual void upload(const FramePacket& packet) = 0;
 
   /**
    * @brief GUIを更新する
@@ -43,6 +54,15 @@ class Technique {
    * @param scene 描画するシーン
    */
   virtual void apply(Scene& scene) = 0;
+
+  /**
+   * @brief restoreで確保したGPUメモリの量を見積もる
+   * 
+   * @return size_t 使用量[byte]
+   */
+  virtual size_t memory_usage() const noexcept {
+    return 0;
+  }
 };
 
 /**
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <list>
+#include <string>
+#include <cstddef>
+
+namespace rtdemo {
+class Technique;
+
+/**
+ * @brief 最近使ったテクニックのリソースを破棄せずに残しておくキャッシュ
+ * 
+ * 切り替えたときにinvalidateせず、GPUメモリの予算を超えた分だけ
+ * 最も長く使っていないテクニックからinvalidateする。
+ */
+class TechniqueCache final {
+ public:
+  /**
+   * @brief テクニックを使えるようにする
+   * 
+   * 残っていなければrestoreし、予算を超えた分を破棄する。
+   * 
+   * @param name テクニック名
+   * @param technique テクニック
+   * @param restored restoreしたかを書き込む先
+   * @return true 成功した
+   * @return false 失敗した
+   */
+  bool acquire(const std::string& name, Technique& technique, bool* restored = nullptr);
+
+  /**
+   * @brief すべてのテクニックを破棄する
+   */
+  void clear();
+
+  /**
+   * @brief GPUメモリの予算を設定する
+   * 
+   * 使用中のテクニックは予算を超えても破棄しない。
+   * 
+   * @param budget 予算[byte]
+   */
+  void set_budget(size_t budget);
+
+  size_t budget() const noexcept {
+    return budget_;
+  }
+
+  /**
+   * @brief 残しているテクニックのGPUメモリの合計を取得する
+   */
+  size_t memory_usage() const noexcept;
+
+  /**
+   * @brief 現在のウィンドウにGUIを描画する
+   */
+  void update_gui();
+
+ private:
+  /**
+   * @brief 残しているテクニック
+   */
+  struct Entry {
+    std::string name;  ///< テクニック名
+    Technique* technique;  ///< テクニック
+  };
+
+  /**
+   * @brief 予算を超えた分を破棄する
+   */
+  void evict();
+
+  std::list<Entry> entries_;  ///< 最近使った順に並べたテクニック
+  size_t budget_ = 256 << 20;  ///< GPUメモリの予算[byte]
+  size_t hit_count_ = 0;  ///< 残っていたテクニックに切り替えた回数
+  size_t miss_count_ = 0;  ///< restoreした回数
+};
+}  // namespace rtdemo
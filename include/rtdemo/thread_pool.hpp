@@ -0,0 +1,83 @@
+#pragma once
+
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+namespace rtdemo {
+/**
+ * @brief 固定数のスレッドでタスクを実行するプール
+ * 
+ * 起動していない間に投入したタスクは、投入したスレッドでその場で実行する。
+ */
+class ThreadPool final {
+ public:
+  ThreadPool() = default;
+
+  ThreadPool(const ThreadPool&) = delete;
+
+  ~ThreadPool() noexcept {
+    stop();
+  }
+
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * @brief スレッドを起動する
+   * 
+   * @param thread_count スレッド数
+   * @param name CPUプロファイラに表示するスレッド名
+   * @return true 成功した
+   * @return false 失敗した
+   */
+  bool start(size_t thread_count, const std::string& name);
+
+  /**
+   * @brief 残りのタスクを実行してからスレッドを停止する
+   */
+  void stop();
+
+  /**
+   * @brief タスクを投入する
+   * 
+   * @param f 実行する関数
+   * @return std::future 関数の戻り値
+   */
+  template <typename F>
+  auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+    using Result = std::invoke_result_t<std::decay_t<F>>;
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+    auto future = task->get_future();
+    push([task] { (*task)(); });
+    return future;
+  }
+
+  size_t thread_count() const noexcept {
+    return threads_.size();
+  }
+
+ private:
+  /**
+   * @brief タスクをキューに追加する
+   */
+  void push(std::function<void()> task);
+
+  /**
+   * @brief スレッドの処理
+   */
+  void run(std::string name);
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;  ///< 以下のメンバを保護する
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;  ///< 実行を待っているタスク
+  bool quit_ = false;  ///< スレッドを終了するか
+};
+}  // namespace rtdemo
@@ -21,6 +21,38 @@ struct VertexP3N3 {
   glm::vec3 normal;  ///< 法線
 };
 
+/**
+ * @brief 16ビットの位置と16ビット×2の八面体の法線を持つ頂点
+ * 
+ * 位置は境界ボックス内の正規化された符号なし整数、法線は正規化された符号付き整数。
+ */
+struct VertexP16N16 {
+  uint16_t position[3];  ///< 位置
+  uint16_t _position;  ///< パッディング
+  int16_t normal[2];  ///< 八面体に写した法線
+};
+
+/**
+ * @brief 16ビットの位置と8ビット×2の八面体の法線を持つ頂点
+ * 
+ */
+struct VertexP16N8 {
+  uint16_t position[3];  ///< 位置
+  int8_t normal[2];  ///< 八面体に写した法線
+};
+
+/**
+ * @brief 量子化した頂点を元に戻すための情報
+ * 
+ * 描画コマンドごとに1つ持つ。
+ */
+struct VertexDecode {
+  glm::vec3 position_offset;  ///< 位置に足す値
+  uint32_t normal_encoding;  ///< 0:そのまま、1:八面体
+  glm::vec3 position_scale;  ///< 位置に掛ける値
+  float _position_scale;  ///< パッディング
+};
+
 /**
  * @brief カメラ
  * 
@@ -69,6 +101,17 @@ struct PointLight {
   float intensity;  ///< 強度
 };
 
+/**
+ * @brief 軸に平行な境界ボックス
+ * 
+ */
+struct BoundingBox {
+  glm::vec3 min;  ///< 最小の座標
+  float _min;  ///< パッディング
+  glm::vec3 max;  ///< 最大の座標
+  float _max;  ///< パッディング
+};
+
 /**
  * @brief シャドウキャスタ
  * 
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include "garie.hpp"
+#include "frame_limiter.hpp"
+
+namespace rtdemo::util {
+/**
+ * @brief 毎フレーム書き換える定数やSSBOのデータを置く、永続マップしたリングバッファ
+ * 
+ * バッファをMAX_FRAME_COUNT個の領域に分け、そのうち先頭のframe_count()個をフレームごとに順番に使う。
+ * 領域を使い終わったフレームの終わりにフェンスを置き、次にその領域を使う前にGPUが読み終わるのを待つ。
+ * 使う領域の数はFrameLimiterの上限に合わせ、リングの待ちが上限より先にCPUを止めないようにする。
+ * 書き込んだデータはglBindBufferRangeでバインドするので、マップとアンマップやバッファの再確保は起きない。
+ * GLの呼び出しを記録しているときは、割り当てた範囲をGlCapture::mark_written()で知らせる。
+ */
+class UploadRing final {
+ public:
+  static constexpr uint32_t MAX_FRAME_COUNT = FrameLimiter::MAX_FRAMES_IN_FLIGHT_LIMIT + 1;  ///< 確保する領域の数
+
+  /**
+   * @brief 1フレーム分の割り当て
+   * 
+   * 範囲はbind()でバインドする。
+   */
+  struct Allocation : garie::BufferView {
+    void* data = nullptr;  ///< 書き込み先
+  };
+
+  /**
+   * @brief インスタンスを取得する
+   * 
+   * @return UploadRing&
+   */
+  static UploadRing& get() noexcept;
+
+  /**
+   * @brief バッファを確保してマップする
+   * 
+   * @param frame_size 1フレームで割り当てられる大きさ[byte]
+   * @return true 成功した
+   * @return false 失敗した
+   */
+  bool init(size_t frame_size);
+
+  /**
+   * @brief バッファとフェンスを破棄する
+   * 
+   * GLコンテキストを破棄する前に呼び出す。
+   */
+  void clear();
+
+  /**
+   * @brief 現在のフレームの領域から割り当てる
+   * 
+   * 割り当ては次のend_frame()までに書き込み、そのフレームの描画で使う。
+   * 
+   * @param target GL_UNIFORM_BUFFERかGL_SHADER_STORAGE_BUFFER。オフセットのアラインメントを決める。
+   * @param size 大きさ[byte]
+   * @return Allocation 割り当て。領域が足りなければ空
+   */
+  Allocation allocate(GLenum target, size_t size);
+
+  /**
+   * @brief 現在の領域にフェンスを置き、次の領域をGPUが読み終わるまで待つ
+   */
+  void end_frame();
+
+  /**
+   * @brief GPUに積まれるフレームの数に合わせて、使う領域の数を決める
+   * 
+   * CPUが書き込む領域の分だけ多く使う。バッファは確保し直さないので、毎フレーム呼び出してよい。
+   * 
+   * @param count FrameLimiterの上限。0であれば確保したすべての領域を使う
+   */
+  void set_frames_in_flight(uint32_t count) noexcept;
+
+  /**
+   * @brief 使う領域の数
+   */
+  uint32_t frame_count() const noexcept {
+    return frame_count_;
+  }
+
+  /**
+   * @brief 現在のウィンドウにGUIを描画する
+   */
+  void update_gui() const;
+
+ private:
+  /**
+   * @brief フレームごとの領域
+   */
+  struct Region {
+    GLsync fence = nullptr;  ///< この領域を最後に使ったフレームの終わり
+    size_t used = 0;  ///< 割り当てた大きさ[byte]
+  };
+
+  UploadRing() = default;
+
+  garie::Buffer buffer_;  ///< リングバッファ
+  uint8_t* mapped_ = nullptr;  ///< マップしたバッファの先頭
+  size_t frame_size_ = 0;  ///< 1フレームの領域の大きさ[byte]
+  GLint uniform_alignment_ = 256;  ///< GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+  GLint storage_alignment_ = 256;  ///< GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+  std::array<Region, MAX_FRAME_COUNT> regions_;  ///< フレームごとの領域
+  uint32_t frame_count_ = FrameLimiter::DEFAULT_MAX_FRAMES_IN_FLIGHT + 1;  ///< 使う領域の数
+  uint32_t current_ = 0;  ///< 現在のフレームの領域
+  size_t last_used_ = 0;  ///< 前のフレームで割り当てた大きさ[byte]
+  double last_wait_time_ = 0.0;  ///< 前のフレームで領域を待った時間[ms]
+  bool overflowed_ = false;  ///< 現在のフレームで割り当てに失敗したか
+};
+}  // namespace rtdemo::util
@@ -130,6 +130,13 @@ const garie::VertexArray& screen_triangle_vao();
  */
 void draw_screen_quad();
 
+/**
+ * @brief screen_quad_vao()とscreen_triangle_vao()が生成したオブジェクトを破棄する
+ * 
+ * GLコンテキストを破棄する前に呼び出す。次に取得したときに作り直す。
+ */
+void clear_screen_vaos();
+
 /**
  * @brief 既定値のステート
  * 
@@ -226,4 +233,17 @@ garie::Viewport screen_viewport();
  * @return Scissor 
  */
 garie::Scissor screen_scissor();
+
+/**
+ * @brief テクスチャのGPUメモリの使用量を見積もる
+ * 
+ * ミップマップや圧縮フォーマットは考慮しない。
+ * 
+ * @param internal_format 内部フォーマット
+ * @param width 幅
+ * @param height 高さ
+ * @param depth 奥行き
+ * @return size_t 使用量[byte]
+ */
+size_t texture_memory_size(GLenum internal_format, size_t width, size_t height, size_t depth = 1);
 }  // namespace rtdemo::util
@@ -6,9 +6,20 @@
 #include <gsl/gsl>
 #include <GLFW/glfw3.h>
 #include <GL/glew.h>
+#ifdef RT_USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 #include <imgui.h>
 #include <rtdemo/logging.hpp>
 #include <rtdemo/gui.hpp>
+#include <rtdemo/cpu_profiler.hpp>
+#include <rtdemo/frame_stats.hpp>
+#include <rtdemo/gpu_profiler.hpp>
+#include <rtdemo/render_target_pool.hpp>
+#include <rtdemo/upload_ring.hpp>
+#include <rtdemo/buffer_heap.hpp>
+#include <rtdemo/gl_trace.hpp>
 #include <rtdemo/scene.hpp>
 #include <rtdemo/technique.hpp>
 #include <rtdemo/util.hpp>
@@ -20,6 +31,10 @@ Application& Application::get() noexcept {
 }
 
 bool Application::init(size_t screen_width, size_t screen_height) {
+  current_scene_ = scene_map_.end();
+  current_technique_ = technique_map_.end();
+  loading_scene_ = scene_map_.end();
+
   // 初期化に失敗した場合にterminateを呼ぶようにする
   bool succeeded = false;
   auto _ = gsl::finally([&, this] {
@@ -56,6 +71,11 @@ bool Application::init(size_t screen_width, size_t screen_height) {
     RT_ERROR("GLEWの初期化に失敗した");
     return false;
   }
+  if (!garie::GlDispatch::get().load()) return false;
+  RT_DEBUG("ウィンドウで初期化した (renderer:{})", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+
+  // 毎フレーム書き換えるデータを置くリングバッファを確保する
+  if (!util::UploadRing::get().init(UPLOAD_RING_FRAME_SIZE)) return false;
 
   // GUIを初期化する
   if (!Gui::get().init(window_)) {
@@ -81,35 +101,238 @@ bool Application::init(size_t screen_width, size_t screen_height) {
   glfwGetFramebufferSize(window_, &w, &h);
   screen_width_ = static_cast<uint32_t>(w);
   screen_height_ = static_cast<uint32_t>(h);
+
+  // シーンを更新するワーカースレッドを起動する
+  if (!frame_pipeline_.start()) return false;
+
+  // シーンを読み込むスレッドを起動する
+  if (!loader_pool_.start(LOADER_THREAD_COUNT, "Loader")) return false;
+
+  succeeded = true;  // 初期化に成功した
+  return true;
+}
+
+bool Application::init_headless(size_t screen_width, size_t screen_height) {
   current_scene_ = scene_map_.end();
   current_technique_ = technique_map_.end();
+  loading_scene_ = scene_map_.end();
+  headless_ = true;
+
+  // 初期化に失敗した場合にterminateを呼ぶようにする
+  bool succeeded = false;
+  auto _ = gsl::finally([&, this] {
+    if (!succeeded) terminate();
+  });
+
+  // 何もしないバックエンドはドライバを呼び出さないので、コンテキストを作らない
+  if (garie::GlDispatch::get().backend() != garie::GlDispatch::Backend::NOOP) {
+    if (!create_egl_context(screen_width, screen_height)) return false;
+  }
+  if (!garie::GlDispatch::get().load()) return false;
+  RT_DEBUG("オフスクリーンで初期化した (renderer:{})", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+
+  // 毎フレーム書き換えるデータを置くリングバッファを確保する
+  if (!util::UploadRing::get().init(UPLOAD_RING_FRAME_SIZE)) return false;
+
+  screen_width_ = static_cast<uint32_t>(screen_width);
+  screen_height_ = static_cast<uint32_t>(screen_height);
+
+  // シーンを更新するワーカースレッドを起動する
+  if (!frame_pipeline_.start()) return false;
 
   succeeded = true;  // 初期化に成功した
   return true;
 }
 
+bool Application::create_egl_context(size_t screen_width, size_t screen_height) {
+#ifdef RT_USE_EGL
+  // surfacelessプラットフォームのディスプレイを取得する
+  EGLDisplay display = EGL_NO_DISPLAY;
+  const auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+      eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  if (get_platform_display) {
+    display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+  }
+  if (display == EGL_NO_DISPLAY) {
+    RT_WARN("surfacelessプラットフォームが利用できないため、既定のディスプレイを使う");
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+  if (display == EGL_NO_DISPLAY) {
+    RT_ERROR("EGLディスプレイの取得に失敗した");
+    return false;
+  }
+
+  // EGLを初期化する
+  EGLint major = 0;
+  EGLint minor = 0;
+  if (!eglInitialize(display, &major, &minor)) {
+    RT_ERROR("EGLの初期化に失敗した (error:{:#x})", eglGetError());
+    return false;
+  }
+  egl_display_ = display;
+  if (!eglBindAPI(EGL_OPENGL_API)) {
+    RT_ERROR("OpenGL APIのバインドに失敗した (error:{:#x})", eglGetError());
+    return false;
+  }
+
+  // pbufferを生成できるコンフィグを選ぶ
+  const EGLint config_attribs[] = {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_RED_SIZE, 8,
+      EGL_GREEN_SIZE, 8,
+      EGL_BLUE_SIZE, 8,
+      EGL_ALPHA_SIZE, 8,
+      EGL_DEPTH_SIZE, 24,
+      EGL_STENCIL_SIZE, 8,
+      EGL_NONE,
+  };
+  EGLConfig config = nullptr;
+  EGLint config_count = 0;
+  if (!eglChooseConfig(display, config_attribs, &config, 1, &config_count) || config_count == 0) {
+    RT_ERROR("EGLコンフィグの選択に失敗した (error:{:#x})", eglGetError());
+    return false;
+  }
+
+  // コンテキストを生成する
+  const EGLint context_attribs[] = {
+      EGL_CONTEXT_MAJOR_VERSION, 4,
+      EGL_CONTEXT_MINOR_VERSION, 5,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+#ifndef NDEBUG
+      EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+#endif
+      EGL_NONE,
+  };
+  EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+  if (context == EGL_NO_CONTEXT) {
+    RT_ERROR("EGLコンテキストの生成に失敗した (error:{:#x})", eglGetError());
+    return false;
+  }
+  egl_context_ = context;
+
+  // バックバッファの代わりとなるpbufferを生成する
+  const EGLint surface_attribs[] = {
+      EGL_WIDTH, static_cast<EGLint>(screen_width),
+      EGL_HEIGHT, static_cast<EGLint>(screen_height),
+      EGL_NONE,
+  };
+  EGLSurface surface = eglCreatePbufferSurface(display, config, surface_attribs);
+  if (surface == EGL_NO_SURFACE) {
+    RT_ERROR("pbufferの生成に失敗した (error:{:#x})", eglGetError());
+    return false;
+  }
+  egl_surface_ = surface;
+
+  if (!eglMakeCurrent(display, surface, surface, context)) {
+    RT_ERROR("EGLコンテキストのバインドに失敗した (error:{:#x})", eglGetError());
+    return false;
+  }
+
+  // GLEWを初期化する
+  // GLXを持たない環境ではGLX拡張の初期化に失敗するが、GLの関数は読み込まれている
+  glewExperimental = GL_TRUE;
+  const GLenum glew_result = glewInit();
+  if (glew_result != GLEW_OK && glew_result != GLEW_ERROR_NO_GLX_DISPLAY) {
+    RT_ERROR("GLEWの初期化に失敗した (error:{})", glew_result);
+    return false;
+  }
+
+  RT_DEBUG("EGLコンテキストを生成した (EGL:{}.{})", major, minor);
+  return true;
+#else
+  static_cast<void>(screen_width);
+  static_cast<void>(screen_height);
+  RT_ERROR("EGLを無効にしてビルドされているため、オフスクリーンで初期化できない");
+  return false;
+#endif
+}
+
 void Application::terminate() {
-  Gui::get().terminate();
-  glfwTerminate();
+  // シーンを参照しているワーカースレッドを止める
+  frame_pipeline_.stop();
+  wait_loading();
+  loader_pool_.stop();
+
+  // コンテキストが有効なうちにリソースを破棄する
+  select_scene(scene_map_.end());
+  select_technique(technique_map_.end());
+  GpuProfiler::get().invalidate();
+  util::RenderTargetPool::get().clear();
+  util::UploadRing::get().clear();
+  util::BufferHeap::get().clear();
+  util::clear_screen_vaos();
+  frame_limiter_.clear();
+  if (!headless_) Gui::get().terminate();
+
+  // ここで残っているオブジェクトは、どこからも破棄されていない
+  const auto& resource_tracker = garie::ResourceTracker::get();
+  if (resource_tracker.count() > 0) {
+    RT_WARN("破棄されていないGLオブジェクトがある (count:{}, size:{}KiB)",
+            resource_tracker.count(), resource_tracker.totals().size >> 10);
+    for (const auto& record : resource_tracker.records()) {
+      RT_WARN("  {} {} (id:{}, size:{}, site:{}:{})", record.tag, garie::ResourceTracker::type_name(record.type),
+              record.id, record.size, record.site.file_name(), record.site.line());
+    }
+  }
+
+  // 破棄を待っているオブジェクトと、まとめて生成したまま使わなかった名前を破棄する
+  garie::DeletionQueue::get().flush();
+  garie::NamePool::clear_all();
+  garie::StateCache::get().invalidate();
+
+  // 記録中のトレースがあれば閉じる
+  garie::GlCapture::get().close();
+
+  if (headless_) {
+#ifdef RT_USE_EGL
+    if (egl_display_) {
+      eglMakeCurrent(egl_display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+      if (egl_surface_) eglDestroySurface(egl_display_, egl_surface_);
+      if (egl_context_) eglDestroyContext(egl_display_, egl_context_);
+      eglTerminate(egl_display_);
+    }
+#endif
+    egl_display_ = nullptr;
+    egl_context_ = nullptr;
+    egl_surface_ = nullptr;
+    headless_ = false;
+  } else {
+    glfwTerminate();
+  }
   window_ = nullptr;
   screen_width_ = 0;
   screen_height_ = 0;
   current_scene_ = scene_map_.end();
   current_technique_ = technique_map_.end();
+  loading_scene_ = scene_map_.end();
 }
 
 bool Application::update() {
+  RT_CPU_SCOPE("Application::update");
+
   // ウィンドウが閉じていれば、更新できない
   if (glfwWindowShouldClose(window_)) return false;
 
   // OSのイベントを処理する
   glfwPollEvents();
 
+  // ワーカースレッドが前のフレームで始めた更新を待つ
+  // ここからrender()までは、シーンとテクニックの状態を書き換えてよい
+  frame_pipeline_.wait();
+
+  // 読み込みが終わったシーンに切り替える
+  update_loading();
+
   // GUI開始
   Gui::get().new_frame();
+  frame_limiter_.set_input_time(Gui::get().input_time());
 
   // シーン名の一覧を表示するコンボボックスを描画する
-  {
+  // 読み込み中は、読み込みが終わるまで今のシーンを描画し続ける
+  if (loading_scene_ != scene_map_.end()) {
+    ImGui::ProgressBar(loading_progress_.load(), ImVec2(-1.f, 0.f), loading_scene_->first.c_str());
+  } else {
     const char* preview_value = "-----";  // コンボボックスが閉じているときに表示する文字列
     if (current_scene_ != scene_map_.end()) {
       preview_value = current_scene_->first.c_str();
@@ -120,14 +343,8 @@ bool Application::update() {
       for (auto iter = scene_map_.begin(); iter != last; ++iter) {
         const bool selected = iter == current_scene_;
         if (ImGui::Selectable(iter->first.c_str(), &selected)) {
-          // 要素が選択されれば、シーンを切り替える
-          if (current_scene_ != scene_map_.end() && current_scene_->second) {
-            current_scene_->second->invalidate();
-          }
-          current_scene_ = iter;
-          if (current_scene_->second) {
-            current_scene_->second->restore();
-          }
+          // 要素が選択されれば、シーンを読み込み始める
+          request_scene(iter);
         }
         if (selected) {
           // コンボボックスを開いたとき、すでに選択されている要素にフォーカスする
@@ -150,14 +367,8 @@ bool Application::update() {
       for (auto iter = technique_map_.begin(); iter != last; ++iter) {
         const bool selected = iter == current_technique_;
         if (ImGui::Selectable(iter->first.c_str(), &selected)) {
-          // 要素が選択されれば、シーンを切り替える
-          if (current_technique_ != technique_map_.end() && current_technique_->second) {
-            current_technique_->second->invalidate();
-          }
-          current_technique_ = iter;
-          if (current_technique_->second) {
-            current_technique_->second->restore();
-          }
+          // 要素が選択されれば、テクニックを切り替える
+          select_technique(iter);
         }
         if (selected) {
           // コンボボックスを開いたとき、すでに選択されている要素にフォーカスする
@@ -168,69 +379,302 @@ bool Application::update() {
     }
   }
 
-  // FPSを計算して表示する
+  // フレーム時間を計測して表示する
   {
-    using namespace std::chrono_literals;
-
-    using Seconds = std::chrono::duration<double>;
     using Milliseconds = std::chrono::duration<double, std::milli>;
-    using Nanoseconds = std::chrono::duration<double, std::nano>;
-    using Clock = std::chrono::high_resolution_clock;
-
-    // 経過時間を計測する
-    static Nanoseconds elapsed_time;  // 経過時間
-    static auto last_tp = Clock::now();  // 前回計測したときの時間
-    auto now_tp = Clock::now();
-    elapsed_time = std::chrono::duration_cast<Nanoseconds>(now_tp - last_tp);
-    last_tp = now_tp;
-
-    // 平均FPSを計算する
-    static auto checkpoint_tp = Clock::now() + 1s;  // この時刻を超えたら平均を計算する
-    static Nanoseconds sum_elapsed_time;  // 経過時間の合計
-    static size_t elapsed_time_count = 0;  // 合計した経過時間の数
-    static Nanoseconds ave_elapsed_time;  // 平均経過時間
-    static double ave_fps = 0.0;  // 平均FPS
-    sum_elapsed_time += elapsed_time;
-    elapsed_time_count++;
-    if (now_tp >= checkpoint_tp) {
-      ave_elapsed_time = sum_elapsed_time / elapsed_time_count;
-      ave_fps = 1.0 / std::chrono::duration_cast<Seconds>(ave_elapsed_time).count();
-      sum_elapsed_time = {};
-      elapsed_time_count = 0;
-      checkpoint_tp = now_tp + 1s;
+    const auto now_tp = std::chrono::steady_clock::now();
+    if (last_frame_tp_ != std::chrono::steady_clock::time_point{}) {
+      frame_stats_.add(std::chrono::duration_cast<Milliseconds>(now_tp - last_frame_tp_).count());
+    }
+    last_frame_tp_ = now_tp;
+    frame_stats_.update_gui();
+
+    // 更新をワーカースレッドで行うか
+    bool threaded = frame_pipeline_.is_running();
+    if (ImGui::Checkbox("threaded update", &threaded)) {
+      if (threaded) {
+        frame_pipeline_.start();
+      } else {
+        frame_pipeline_.stop();
+      }
+    }
+    ImGui::Text("update wait:%5.3lf[ms]", frame_pipeline_.last_wait_time());
+
+    // 残しているテクニックと一時テクスチャ
+    technique_cache_.update_gui();
+    util::RenderTargetPool::get().update_gui();
+    util::UploadRing::get().update_gui();
+    util::BufferHeap::get().update_gui();
+
+    // 状態キャッシュが省いたGLの呼び出し
+    const auto& state_cache = garie::StateCache::get();
+    ImGui::Text("gl state calls:%zu (skipped:%zu)", state_cache.last_emitted_count(), state_cache.last_skipped_count());
+    const auto& sampler_cache = garie::SamplerCache::get();
+    ImGui::Text("shared samplers:%zu (created:%zu, hits:%zu), states:%zu/%zu/%zu",
+                sampler_cache.size(), sampler_cache.created_count(), sampler_cache.hit_count(),
+                garie::StateObjectCache<garie::RasterizationState>::get().size(),
+                garie::StateObjectCache<garie::ColorBlendState>::get().size(),
+                garie::StateObjectCache<garie::DepthStencilState>::get().size());
+
+    // GPUが使い終わるのを待っているGLオブジェクト
+    const auto& deletion_queue = garie::DeletionQueue::get();
+    ImGui::Text("pending deletes:%zu (retired:%zu)", deletion_queue.pending_count(), deletion_queue.last_retired_count());
+
+    // 生きているGLオブジェクトの、持ち主と種類ごとの合計
+    const auto& resource_tracker = garie::ResourceTracker::get();
+    const auto resource_totals = resource_tracker.totals();
+    if (ImGui::TreeNode("gl resources", "gl resources:%zu (%zuKiB)", resource_totals.count, resource_totals.size >> 10)) {
+      for (const auto& [tag, totals] : resource_tracker.totals_by_tag()) {
+        ImGui::Text("%.*s:%zu (%zuKiB)", static_cast<int>(tag.size()), tag.data(), totals.count, totals.size >> 10);
+      }
+      const auto type_totals = resource_tracker.totals_by_type();
+      for (size_t i = 0; i < type_totals.size(); ++i) {
+        if (type_totals[i].count == 0) continue;
+        ImGui::Text("  %s:%zu (%zuKiB)", garie::ResourceTracker::type_name(static_cast<garie::ResourceType>(i)),
+                    type_totals[i].count, type_totals[i].size >> 10);
+      }
+      ImGui::TreePop();
+    }
+
+    // 前のフレームで呼び出したGLの関数
+    const auto& gl_dispatch = garie::GlDispatch::get();
+    if (gl_dispatch.is_counting()) {
+      ImGui::Text("gl calls:%llu", static_cast<unsigned long long>(gl_dispatch.last_call_count()));
+      for (const auto& [name, count] : gl_dispatch.last_top_calls(GUI_TOP_GL_CALL_COUNT)) {
+        ImGui::Text("  %s:%llu", name, static_cast<unsigned long long>(count));
+      }
     }
 
-    ImGui::Text("Ave. Time:%5.3lf[ms]", std::chrono::duration_cast<Milliseconds>(ave_elapsed_time));
-    ImGui::Text("Ave. FPS :%5.3lf[fps]", ave_fps);
+    // 内部解像度
+    dynamic_resolution_.update_gui();
+
+    // 積まれているフレームと入力の遅延
+    frame_limiter_.update_gui();
   }
 
-  // 状態を更新する
+  // パスごとのGPU時間を表示する
+  GpuProfiler::get().update_gui();
+
+  // CPU時間の記録を操作する
+  CpuProfiler::get().update_gui();
+
+  // GUIを更新する
   if (current_scene_ != scene_map_.end() &&
       current_technique_ != technique_map_.end() &&
       current_scene_->second &&
       current_technique_->second) {
     current_scene_->second->update_gui();
     current_technique_->second->update_gui();
+  }
+
+  // 状態を更新して描画する
+  render();
+
+  // GUIを描画する
+  Gui::get().render();
+
+  // レンダリング結果をウィンドウに表示する
+  present();
+
+  return true;
+}
+
+void Application::render() {
+  GpuProfiler::get().begin_frame();
+  if (current_scene_ != scene_map_.end() &&
+      current_technique_ != technique_map_.end() &&
+      current_scene_->second &&
+      current_technique_->second) {
+    Scene& scene = *current_scene_->second;
+    Technique& technique = *current_technique_->second;
+
+    // 新しいGPU時間が読み出されていれば、内部解像度を選び直す
+    auto& profiler = GpuProfiler::get();
+    if (profiler.resolved_frame_index() != last_resolved_frame_index_) {
+      last_resolved_frame_index_ = profiler.resolved_frame_index();
+      double gpu_time = 0.0;
+      for (const auto& pass : profiler.passes()) {
+        if (pass.depth == 0) gpu_time += pass.time;
+      }
+      dynamic_resolution_.update(gpu_time);
+    }
 
-    current_scene_->second->update();
-    current_technique_->second->update();
+    // このフレームのパケットを受け取り、次のフレームの更新を始める
+    const FrameSize size = frame_size();
+    const FramePacket& packet = frame_pipeline_.acquire(scene, technique, size);
+    frame_pipeline_.kick(scene, technique, size);
 
-    current_technique_->second->apply(*current_scene_->second);
+    {
+      RT_CPU_SCOPE("Scene::upload");
+      scene.upload(packet);
+    }
+    {
+      RT_CPU_SCOPE("Technique::upload");
+      technique.upload(packet);
+    }
+
+    RT_CPU_SCOPE("Technique::apply");
+    RT_GPU_SCOPE(current_technique_->first.c_str());
+    // プールから借りる一時テクスチャをテクニックの持ち物として数える
+    garie::ResourceTracker::Scope scope(technique_tag_);
+    technique.apply(scene);
   } else {
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     util::screen_viewport().apply();
     util::clear({0.f, 0.f, 0.f, 0.f}, 1.f);
   }
+  GpuProfiler::get().end_frame();
 
-  // GUIを描画する
-  Gui::get().render();
+  // しばらく使っていない一時テクスチャを破棄する
+  util::RenderTargetPool::get().end_frame();
+}
 
-  // レンダリング結果をウィンドウに表示する
-  glfwSwapBuffers(window_);
+void Application::present() {
+  RT_CPU_SCOPE("Application::present");
+
+  // このフレームのGLの呼び出しがすべて済んだので、フレームの区切りを付ける
+  util::UploadRing::get().set_frames_in_flight(frame_limiter_.max_frames_in_flight());
+  util::UploadRing::get().end_frame();
+  garie::StateCache::get().end_frame();
+  garie::DeletionQueue::get().end_frame();
+  garie::GlDispatch::get().end_frame();
+
+  if (headless_) {
+    // pbufferはスワップできないので、コマンドの発行だけを行う
+    glFlush();
+  } else {
+    glfwSwapBuffers(window_);
+  }
+
+  // 古いフレームがGPUで終わるまで待ち、CPUが先に進みすぎないようにする
+  frame_limiter_.end_frame();
+}
+
+bool Application::select_scene(const std::string& name) {
+  auto iter = scene_map_.find(name);
+  if (iter == scene_map_.end()) {
+    RT_ERROR("シーンが見つからない (name:{})", name);
+    return false;
+  }
+  wait_loading();
+  return select_scene(iter);
+}
+
+bool Application::select_technique(const std::string& name) {
+  auto iter = technique_map_.find(name);
+  if (iter == technique_map_.end()) {
+    RT_ERROR("テクニックが見つからない (name:{})", name);
+    return false;
+  }
+  return select_technique(iter);
+}
+
+bool Application::select_scene(SceneMap::const_iterator iter) {
+  // 古いシーンで作ったパケットは使えない
+  frame_pipeline_.reset();
+
+  if (current_scene_ != scene_map_.end() && current_scene_->second) {
+    RT_CPU_SCOPE("Scene::invalidate");
+    current_scene_->second->invalidate();
+  }
+  current_scene_ = iter;
+  if (current_scene_ != scene_map_.end() && current_scene_->second) {
+    RT_CPU_SCOPE("Scene::restore");
+    garie::ResourceTracker::Scope scope("scene:" + current_scene_->first);
+    return current_scene_->second->restore();
+  }
+  return true;
+}
+
+bool Application::request_scene(SceneMap::const_iterator iter) {
+  if (iter == current_scene_ || loading_scene_ != scene_map_.end()) return false;
+  if (iter == scene_map_.end() || !iter->second) return select_scene(iter);
+
+  // CPUで行える読み込みをローダースレッドに任せる
+  loading_scene_ = iter;
+  loading_progress_ = 0.f;
+  loading_future_ = loader_pool_.submit([this, scene = iter->second] {
+    return scene->load(loading_progress_);
+  });
+  RT_DEBUG("シーンの読み込みを開始した (name:{})", iter->first);
+  return true;
+}
 
+void Application::update_loading() {
+  if (loading_scene_ == scene_map_.end()) return;
+  if (loading_future_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+  const auto iter = loading_scene_;
+  loading_scene_ = scene_map_.end();
+  if (!loading_future_.get()) {
+    RT_ERROR("シーンの読み込みに失敗した (name:{})", iter->first);
+    iter->second->invalidate();
+    return;
+  }
+
+  // 読み込んだデータをGPUに転送するだけなので、restoreはすぐに終わる
+  select_scene(iter);
+}
+
+void Application::wait_loading() {
+  if (loading_scene_ == scene_map_.end()) return;
+  loading_future_.wait();
+  update_loading();
+}
+
+bool Application::select_technique(TechniqueMap::const_iterator iter) {
+  // 古いテクニックで作ったパケットは使えない
+  frame_pipeline_.reset();
+
+  // 古いテクニックのGPU時間で選んだ内部解像度は当てにならない
+  dynamic_resolution_.reset();
+
+  // 古いテクニックのリソースはキャッシュに残す
+  current_technique_ = iter;
+  technique_tag_.clear();
+  if (current_technique_ == technique_map_.end()) {
+    // 選択を解除したときは、残しているリソースもすべて破棄する
+    technique_cache_.clear();
+    return true;
+  }
+  if (!current_technique_->second) return true;
+  technique_tag_ = "technique:" + current_technique_->first;
+  bool restored = false;
+  if (!technique_cache_.acquire(current_technique_->first, *current_technique_->second, &restored)) {
+    return false;
+  }
+
+  // 初めての描画でドライバがシェーダをコンパイルしないように、一度描画しておく
+  if (restored) warm_up();
   return true;
 }
 
+void Application::warm_up() {
+  if (current_scene_ == scene_map_.end() || !current_scene_->second) return;
+  RT_CPU_SCOPE("Application::warm_up");
+
+  // 結果は次のフレームで上書きされる
+  Scene& scene = *current_scene_->second;
+  Technique& technique = *current_technique_->second;
+  const FramePacket& packet = frame_pipeline_.acquire(scene, technique, frame_size());
+  scene.upload(packet);
+  technique.upload(packet);
+  {
+    garie::ResourceTracker::Scope scope(technique_tag_);
+    technique.apply(scene);
+  }
+  frame_pipeline_.reset();
+}
+
+FrameSize Application::frame_size() const noexcept {
+  FrameSize size{};
+  size.screen_width = screen_width_;
+  size.screen_height = screen_height_;
+  size.render_width = dynamic_resolution_.scale(screen_width_);
+  size.render_height = dynamic_resolution_.scale(screen_height_);
+  return size;
+}
+
 bool Application::insert_scene(std::string name, std::shared_ptr<Scene> scene) {
   auto iter = scene_map_.find(name);
   if (iter != scene_map_.end()) return false;  // 同名への上書きはできない
@@ -0,0 +1,210 @@
+#include <rtdemo/benchmark.hpp>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <GL/glew.h>
+#include <rtdemo/logging.hpp>
+#include <rtdemo/application.hpp>
+#include <rtdemo/garie.hpp>
+#include <rtdemo/gl_trace.hpp>
+#include <rtdemo/gpu_profiler.hpp>
+#include <rtdemo/cpu_profiler.hpp>
+
+namespace rtdemo {
+namespace {
+using Milliseconds = std::chrono::duration<double, std::milli>;
+using Clock = std::chrono::high_resolution_clock;
+
+/**
+ * @brief JSONの文字列としてエスケープする
+ */
+std::string escape_json(const std::string& str) {
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (const char c : str) {
+    switch (c) {
+      case '"': escaped += "\\\""; break;
+      case '\\': escaped += "\\\\"; break;
+      case '\n': escaped += "\\n"; break;
+      default: escaped += c; break;
+    }
+  }
+  return escaped;
+}
+
+/**
+ * @brief 統計値をJSONのオブジェクトとして書式化する
+ */
+std::string format_summary(const FrameStats::Summary& summary) {
+  return fmt::format(
+      "{{\"mean\": {:.6f}, \"min\": {:.6f}, \"p50\": {:.6f}, \"p95\": {:.6f}, \"p99\": {:.6f}, \"max\": {:.6f}, \"hitches\": {}}}",
+      summary.mean, summary.min, summary.p50, summary.p95, summary.p99, summary.max, summary.hitch_count);
+}
+}  // namespace
+
+bool Benchmark::run() {
+  auto& app = Application::get();
+
+  // 計測する組み合わせを用意する
+  if (!app.select_scene(desc_.scene_name)) {
+    RT_ERROR("シーンの用意に失敗した (name:{})", desc_.scene_name);
+    return false;
+  }
+  if (!app.select_technique(desc_.technique_name)) {
+    RT_ERROR("テクニックの用意に失敗した (name:{})", desc_.technique_name);
+    return false;
+  }
+
+  // GPU時間を計測するクエリを用意する
+  // 読み戻しでストールしないように、数フレーム遅れて結果を取得する
+  std::array<garie::Query, QUERY_COUNT> queries;
+  {
+    garie::ResourceTracker::Scope scope("benchmark");
+    for (auto& query : queries) query.gen();
+  }
+
+  const size_t total_frame_count = desc_.warmup_frame_count + desc_.frame_count;
+  records_.assign(desc_.frame_count, FrameRecord{});
+  pass_records_.clear();
+
+  // パスごとの結果を集計する
+  auto& profiler = GpuProfiler::get();
+  const uint64_t first_profiled_frame = profiler.frame_index() + desc_.warmup_frame_count;
+  uint64_t last_resolved_frame = profiler.resolved_frame_index();
+  const auto accumulate_passes = [&, this] {
+    if (profiler.resolved_frame_index() == last_resolved_frame) return;
+    last_resolved_frame = profiler.resolved_frame_index();
+    if (last_resolved_frame < first_profiled_frame) return;
+    for (const auto& pass : profiler.passes()) {
+      auto iter = std::find_if(pass_records_.begin(), pass_records_.end(), [&](const PassRecord& record) {
+        return record.name == pass.name && record.depth == pass.depth;
+      });
+      if (iter == pass_records_.end()) {
+        iter = pass_records_.insert(pass_records_.end(), PassRecord{pass.name, pass.depth});
+      }
+      iter->sum_time += pass.time;
+      iter->count++;
+    }
+  };
+  const auto resolve = [&, this](size_t frame) {
+    const GLuint64 elapsed = queries[frame % QUERY_COUNT].result();
+    if (frame >= desc_.warmup_frame_count) {
+      records_[frame - desc_.warmup_frame_count].gpu_time = elapsed * 1e-6;
+    }
+  };
+
+  for (size_t frame = 0; frame < total_frame_count; ++frame) {
+    // 再利用するクエリの結果を読み出す
+    if (frame >= QUERY_COUNT) resolve(frame - QUERY_COUNT);
+
+    // 計測するフレームからCPUトレースを記録する
+    if (frame == desc_.warmup_frame_count && !desc_.trace_path.empty()) {
+      CpuProfiler::get().start_capture();
+    }
+
+    // 計測するフレームからGLの呼び出しを再生の対象にする
+    if (frame == desc_.warmup_frame_count && garie::GlCapture::get().is_open()) {
+      const size_t capture_frame_count = desc_.capture_frame_count > 0 ?
+          std::min(desc_.capture_frame_count, desc_.frame_count) : desc_.frame_count;
+      garie::GlCapture::get().begin_frames(static_cast<uint32_t>(capture_frame_count));
+    }
+    RT_CPU_SCOPE("Benchmark::frame");
+
+    const auto begin_tp = Clock::now();
+    const auto& query = queries[frame % QUERY_COUNT];
+    query.begin(GL_TIME_ELAPSED);
+    app.render();
+    query.end(GL_TIME_ELAPSED);
+    app.present();
+    const auto end_tp = Clock::now();
+
+    if (frame >= desc_.warmup_frame_count) {
+      auto& record = records_[frame - desc_.warmup_frame_count];
+      record.cpu_time = std::chrono::duration_cast<Milliseconds>(end_tp - begin_tp).count();
+      record.gl_call_count = garie::GlDispatch::get().last_call_count();
+    }
+    accumulate_passes();
+  }
+
+  // CPUトレースを書き出す
+  if (!desc_.trace_path.empty()) {
+    CpuProfiler::get().stop_capture();
+    if (!CpuProfiler::get().save(desc_.trace_path)) return false;
+  }
+
+  // 残りのクエリの結果を読み出す
+  const size_t first_pending = total_frame_count > QUERY_COUNT ? total_frame_count - QUERY_COUNT : 0;
+  for (size_t frame = first_pending; frame < total_frame_count; ++frame) {
+    resolve(frame);
+  }
+
+  // 統計を計算する
+  cpu_stats_.reset();
+  gpu_stats_.reset();
+  cpu_stats_.set_budget(desc_.frame_budget);
+  gpu_stats_.set_budget(desc_.frame_budget);
+  for (const auto& record : records_) {
+    cpu_stats_.add(record.cpu_time);
+    gpu_stats_.add(record.gpu_time);
+  }
+
+  RT_DEBUG("ベンチマークが完了した (scene:{}, technique:{}, frames:{})",
+           desc_.scene_name, desc_.technique_name, desc_.frame_count);
+  return true;
+}
+
+bool Benchmark::save() const {
+  std::ofstream ofs(desc_.output_path, std::ios::out | std::ios::trunc);
+  if (!ofs) {
+    RT_ERROR("ファイルのオープンに失敗した (path:{})", desc_.output_path.string());
+    return false;
+  }
+
+  const auto renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+  const auto& gl_dispatch = garie::GlDispatch::get();
+  uint64_t gl_call_sum = 0;
+  for (const auto& record : records_) gl_call_sum += record.gl_call_count;
+
+  ofs << "{\n";
+  ofs << fmt::format("  \"scene\": \"{}\",\n", escape_json(desc_.scene_name));
+  ofs << fmt::format("  \"technique\": \"{}\",\n", escape_json(desc_.technique_name));
+  ofs << fmt::format("  \"width\": {},\n", desc_.screen_width);
+  ofs << fmt::format("  \"height\": {},\n", desc_.screen_height);
+  ofs << fmt::format("  \"warmup_frames\": {},\n", desc_.warmup_frame_count);
+  ofs << fmt::format("  \"renderer\": \"{}\",\n", escape_json(renderer ? renderer : ""));
+  ofs << fmt::format("  \"gl_backend\": \"{}\",\n", garie::GlDispatch::backend_name(gl_dispatch.backend()));
+  ofs << fmt::format("  \"gl_call_counting\": {},\n", gl_dispatch.is_counting());
+  ofs << "  \"summary\": {\n";
+  ofs << fmt::format("    \"budget_ms\": {:.6f},\n", desc_.frame_budget);
+  ofs << fmt::format("    \"cpu_ms\": {},\n", format_summary(cpu_stats_.summary()));
+  ofs << fmt::format("    \"gpu_ms\": {},\n", format_summary(gpu_stats_.summary()));
+  ofs << fmt::format("    \"gl_calls\": {:.1f}\n",
+                     records_.empty() ? 0.0 : static_cast<double>(gl_call_sum) / records_.size());
+  ofs << "  },\n";
+  ofs << "  \"passes\": [\n";
+  for (size_t i = 0; i < pass_records_.size(); ++i) {
+    const auto& record = pass_records_[i];
+    ofs << fmt::format("    {{\"name\": \"{}\", \"depth\": {}, \"gpu_ms\": {:.6f}, \"frames\": {}}}{}\n",
+                       escape_json(record.name), record.depth,
+                       record.count > 0 ? record.sum_time / record.count : 0.0, record.count,
+                       i + 1 < pass_records_.size() ? "," : "");
+  }
+  ofs << "  ],\n";
+  ofs << "  \"frames\": [\n";
+  for (size_t i = 0; i < records_.size(); ++i) {
+    const auto& record = records_[i];
+    ofs << fmt::format("    {{\"index\": {}, \"cpu_ms\": {:.6f}, \"gpu_ms\": {:.6f}, \"gl_calls\": {}}}{}\n",
+                       i, record.cpu_time, record.gpu_time, record.gl_call_count,
+                       i + 1 < records_.size() ? "," : "");
+  }
+  ofs << "  ]\n";
+  ofs << "}\n";
+
+  if (!ofs) {
+    RT_ERROR("ファイルへの書き込みに失敗した (path:{})", desc_.output_path.string());
+    return false;
+  }
+  return true;
+}
+}  // namespace rtdemo
@@ -0,0 +1,150 @@
+#include <rtdemo/buffer_heap.hpp>
+#include <algorithm>
+#include <iterator>
+#include <imgui.h>
+#include <rtdemo/logging.hpp>
+
+namespace rtdemo::util {
+namespace {
+size_t align_up(size_t value, size_t alignment) noexcept {
+  return (value + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+BufferHeap& BufferHeap::get() noexcept {
+  static BufferHeap self;
+  return self;
+}
+
+void BufferHeap::clear() {
+  pages_.clear();
+  memory_usage_ = 0;
+}
+
+garie::BufferView BufferHeap::allocate(GLenum target, size_t size, const void* data) {
+  if (size == 0) return garie::BufferView();
+
+  if (uniform_alignment_ == 0) {
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment_);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_alignment_);
+  }
+  size_t alignment = MIN_ALIGNMENT;
+  if (target == GL_UNIFORM_BUFFER) alignment = std::max(alignment, static_cast<size_t>(uniform_alignment_));
+  if (target == GL_SHADER_STORAGE_BUFFER) alignment = std::max(alignment, static_cast<size_t>(storage_alignment_));
+
+  // 返した範囲が細かく割れないように、大きさもアラインメントの最小値に切り上げる
+  const size_t block_size = align_up(size, MIN_ALIGNMENT);
+  Page* page = nullptr;
+  size_t offset = SIZE_MAX;
+  for (auto& candidate : pages_) {
+    offset = allocate_range(*candidate, block_size, alignment);
+    if (offset != SIZE_MAX) {
+      page = candidate.get();
+      break;
+    }
+  }
+  if (!page) {
+    page = &add_page(std::max(PAGE_SIZE, block_size));
+    offset = allocate_range(*page, block_size, alignment);
+  }
+
+  if (data) page->buffer.sub_data(static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+  garie::ResourceTracker::get().add_allocation(garie::ResourceType::BUFFER, page->buffer.id(), offset, block_size);
+  return garie::BufferView{&page->buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size)};
+}
+
+void BufferHeap::free(const garie::BufferView& view) {
+  if (!view) return;
+
+  auto iter = std::find_if(pages_.begin(), pages_.end(), [&](const std::unique_ptr<Page>& page) {
+    return &page->buffer == view.buffer;
+  });
+  if (iter == pages_.end()) {
+    RT_WARN("ヒープのものではない範囲を返そうとした (id:{})", view.buffer->id());
+    return;
+  }
+  Page& page = **iter;
+  garie::ResourceTracker::get().remove_allocation(garie::ResourceType::BUFFER, page.buffer.id(), static_cast<size_t>(view.offset));
+  free_range(page, static_cast<size_t>(view.offset), align_up(static_cast<size_t>(view.size), MIN_ALIGNMENT));
+
+  // 専用に確保したページは、空になったらすぐに破棄する
+  if (page.block_count == 0 && page.size > PAGE_SIZE) {
+    memory_usage_ -= page.size;
+    pages_.erase(iter);
+  }
+}
+
+void BufferHeap::update_gui() const {
+  size_t used = 0;
+  size_t block_count = 0;
+  size_t free_range_count = 0;
+  for (const auto& page : pages_) {
+    used += page->used;
+    block_count += page->block_count;
+    free_range_count += page->free_ranges.size();
+  }
+  ImGui::Text("buffer heap:%zu/%zuKiB, pages:%zu, blocks:%zu, free ranges:%zu",
+              used >> 10, memory_usage_ >> 10, pages_.size(), block_count, free_range_count);
+}
+
+BufferHeap::Page& BufferHeap::add_page(size_t size) {
+  // ページは複数のシーンで共有するので、ページ自体はシーンの持ち物として数えない。
+  // 割り当てた範囲はallocate()を呼び出したときのタグに数え、ここには空き範囲だけが残る
+  garie::ResourceTracker::Scope scope("buffer heap");
+  auto page = std::make_unique<Page>();
+  page->size = size;
+  page->buffer.gen();
+  page->buffer.storage(static_cast<GLsizeiptr>(size), nullptr, GL_DYNAMIC_STORAGE_BIT);
+  page->free_ranges.emplace(0, size);
+  memory_usage_ += size;
+  RT_DEBUG("バッファヒープのページを確保した (size:{})", size);
+  return *pages_.emplace_back(std::move(page));
+}
+
+size_t BufferHeap::allocate_range(Page& page, size_t size, size_t alignment) {
+  // 入りきる空き範囲のうち、最も小さいものから切り出す
+  auto best = page.free_ranges.end();
+  for (auto iter = page.free_ranges.begin(); iter != page.free_ranges.end(); ++iter) {
+    const auto [begin, range_size] = *iter;
+    const size_t aligned = align_up(begin, alignment);
+    if (aligned + size > begin + range_size) continue;
+    if (best == page.free_ranges.end() || range_size < best->second) best = iter;
+  }
+  if (best == page.free_ranges.end()) return SIZE_MAX;
+
+  const auto [begin, range_size] = *best;
+  const size_t offset = align_up(begin, alignment);
+  const size_t end = begin + range_size;
+  page.free_ranges.erase(best);
+  if (offset > begin) page.free_ranges.emplace(begin, offset - begin);
+  if (offset + size < end) page.free_ranges.emplace(offset + size, end - (offset + size));
+  page.used += size;
+  page.block_count++;
+  return offset;
+}
+
+void BufferHeap::free_range(Page& page, size_t offset, size_t size) {
+  auto [iter, inserted] = page.free_ranges.emplace(offset, size);
+  if (!inserted) {
+    RT_WARN("返した範囲をもう一度返そうとした (offset:{})", offset);
+    return;
+  }
+  page.used -= size;
+  page.block_count--;
+
+  // 後ろの空き範囲と結合する
+  auto next = std::next(iter);
+  if (next != page.free_ranges.end() && iter->first + iter->second == next->first) {
+    iter->second += next->second;
+    page.free_ranges.erase(next);
+  }
+  // 前の空き範囲と結合する
+  if (iter != page.free_ranges.begin()) {
+    auto prev = std::prev(iter);
+    if (prev->first + prev->second == iter->first) {
+      prev->second += iter->second;
+      page.free_ranges.erase(iter);
+    }
+  }
+}
+}  // namespace rtdemo::util
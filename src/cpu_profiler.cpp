@@ -0,0 +1,127 @@
+#include <rtdemo/cpu_profiler.hpp>
+#include <chrono>
+#include <fstream>
+#include <imgui.h>
+#include <rtdemo/logging.hpp>
+
+namespace rtdemo {
+namespace {
+using Clock = std::chrono::steady_clock;
+
+const Clock::time_point epoch_ = Clock::now();  // 経過時間の基準となる時刻
+}  // namespace
+
+CpuProfiler& CpuProfiler::get() noexcept {
+  static CpuProfiler self;
+  return self;
+}
+
+int64_t CpuProfiler::now() noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch_).count();
+}
+
+void CpuProfiler::set_thread_name(std::string name) {
+  ThreadBuffer& buffer = thread_buffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  buffer.name = std::move(name);
+}
+
+void CpuProfiler::start_capture() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& buffer : thread_buffers_) {
+      std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+      buffer->events.clear();
+    }
+  }
+  capturing_.store(true, std::memory_order_relaxed);
+}
+
+void CpuProfiler::stop_capture() {
+  capturing_.store(false, std::memory_order_relaxed);
+}
+
+void CpuProfiler::record(const char* name, int64_t begin, int64_t end) {
+  if (!is_capturing()) return;
+
+  // 他のスレッドと競合するのは書き出すときだけなので、ロックはほぼ待たない
+  ThreadBuffer& buffer = thread_buffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  if (buffer.events.size() >= MAX_EVENT_COUNT) return;
+  buffer.events.push_back(Event{name, begin, end});
+}
+
+size_t CpuProfiler::event_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t count = 0;
+  for (const auto& buffer : thread_buffers_) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    count += buffer->events.size();
+  }
+  return count;
+}
+
+bool CpuProfiler::save(const std::filesystem::path& path) const {
+  std::ofstream ofs(path, std::ios::out | std::ios::trunc);
+  if (!ofs) {
+    RT_ERROR("ファイルのオープンに失敗した (path:{})", path.string());
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  ofs << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  bool first = true;
+  for (const auto& buffer : thread_buffers_) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+
+    // スレッド名のメタデータ
+    if (!buffer->name.empty()) {
+      ofs << fmt::format(
+          "{}{{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": {}, \"args\": {{\"name\": \"{}\"}}}}",
+          first ? "" : ",\n", buffer->id, buffer->name);
+      first = false;
+    }
+
+    // 完了イベント
+    for (const auto& event : buffer->events) {
+      ofs << fmt::format(
+          "{}{{\"name\": \"{}\", \"cat\": \"cpu\", \"ph\": \"X\", \"pid\": 1, \"tid\": {}, \"ts\": {:.3f}, \"dur\": {:.3f}}}",
+          first ? "" : ",\n", event.name, buffer->id, event.begin * 1e-3,
+          (event.end - event.begin) * 1e-3);
+      first = false;
+    }
+  }
+  ofs << "\n]}\n";
+
+  if (!ofs) {
+    RT_ERROR("ファイルへの書き込みに失敗した (path:{})", path.string());
+    return false;
+  }
+  return true;
+}
+
+void CpuProfiler::update_gui() {
+  ImGui::Begin("CPU Profiler");
+  if (is_capturing()) {
+    if (ImGui::Button("stop & save")) {
+      stop_capture();
+      save(output_path_);
+    }
+  } else {
+    if (ImGui::Button("capture")) start_capture();
+  }
+  ImGui::Text("events:%zu", event_count());
+  ImGui::End();
+}
+
+CpuProfiler::ThreadBuffer& CpuProfiler::thread_buffer() {
+  thread_local std::shared_ptr<ThreadBuffer> buffer = [this] {
+    auto buffer = std::make_shared<ThreadBuffer>();
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer->id = static_cast<uint32_t>(thread_buffers_.size() + 1);
+    thread_buffers_.push_back(buffer);
+    return buffer;
+  }();
+  return *buffer;
+}
+}  // namespace rtdemo
@@ -0,0 +1,49 @@
+#include <rtdemo/dynamic_resolution.hpp>
+#include <cmath>
+#include <algorithm>
+#include <imgui.h>
+
+namespace rtdemo {
+void DynamicResolution::update(double gpu_time) {
+  if (gpu_time <= 0.0) return;
+  average_time_ = average_time_ > 0.0 ? average_time_ + (gpu_time - average_time_) * SMOOTHING : gpu_time;
+  if (!enabled_) {
+    scale_ = max_scale_;
+    return;
+  }
+
+  // GPU時間はピクセル数、つまり倍率の2乗に比例するとみなす
+  const double ratio = target_time_ * HEADROOM / average_time_;
+  const float desired = std::clamp(static_cast<float>(scale_ * std::sqrt(ratio)), min_scale_, max_scale_);
+
+  // 揺れないように、差が小さければ変えず、大きくても少しずつ変える
+  const float diff = desired - scale_;
+  if (std::abs(diff) < DEAD_ZONE) return;
+  scale_ = std::clamp(scale_ + std::clamp(diff, -MAX_STEP, MAX_STEP), min_scale_, max_scale_);
+}
+
+void DynamicResolution::reset() {
+  average_time_ = 0.0;
+  scale_ = max_scale_;
+}
+
+uint32_t DynamicResolution::scale(uint32_t size) const noexcept {
+  // 最小値の1が最大値を超えないように、大きさのないものはそのまま返す
+  if (size == 0) return 0;
+  const float scale = enabled_ ? scale_ : max_scale_;
+  return std::clamp<uint32_t>(static_cast<uint32_t>(std::lround(size * scale)), 1, size);
+}
+
+void DynamicResolution::update_gui() {
+  ImGui::Checkbox("dynamic resolution", &enabled_);
+  float target_time = static_cast<float>(target_time_);
+  if (ImGui::SliderFloat("gpu target[ms]", &target_time, 1.f, 100.f)) target_time_ = target_time;
+  ImGui::Text("scale:%4.2f (gpu:%5.2lf[ms])", enabled_ ? scale_ : max_scale_, average_time_);
+}
+
+void DynamicResolution::set_scale_range(float min_scale, float max_scale) noexcept {
+  max_scale_ = std::clamp(max_scale, 0.f, 1.f);
+  min_scale_ = std::clamp(min_scale, 0.f, max_scale_);
+  scale_ = std::clamp(scale_, min_scale_, max_scale_);
+}
+}  // namespace rtdemo
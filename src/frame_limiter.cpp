@@ -0,0 +1,65 @@
+#include <rtdemo/frame_limiter.hpp>
+#include <algorithm>
+#include <imgui.h>
+#include <rtdemo/logging.hpp>
+
+namespace rtdemo {
+namespace {
+using Milliseconds = std::chrono::duration<double, std::milli>;
+}  // namespace
+
+void FrameLimiter::end_frame() {
+  // 入力を読んでいなければ(ベンチマークなど)、フレームの始まりから計測する
+  const auto end_tp = std::chrono::steady_clock::now();
+  const TimePoint input_tp = has_input_ ? input_tp_ : (last_end_tp_ != TimePoint{} ? last_end_tp_ : end_tp);
+  has_input_ = false;
+  frames_.push_back(Frame{glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), input_tp});
+
+  // すでに終わったフレームを取り除く
+  while (!frames_.empty() && glClientWaitSync(frames_.front().fence, 0, 0) != GL_TIMEOUT_EXPIRED) {
+    retire(frames_.front(), std::chrono::steady_clock::now());
+    frames_.pop_front();
+  }
+
+  // 上限に達していれば、古いフレームが終わるまで待つ
+  const auto wait_begin_tp = std::chrono::steady_clock::now();
+  while (max_frames_in_flight_ > 0 && frames_.size() >= max_frames_in_flight_) {
+    const Frame& frame = frames_.front();
+    GLenum result = glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000);
+    while (result == GL_TIMEOUT_EXPIRED) {
+      result = glClientWaitSync(frame.fence, 0, 1'000'000);
+    }
+    if (result == GL_WAIT_FAILED) RT_WARN("フレームのフェンスを待てなかった");
+    retire(frame, std::chrono::steady_clock::now());
+    frames_.pop_front();
+  }
+  last_end_tp_ = std::chrono::steady_clock::now();
+  last_wait_time_ = std::chrono::duration_cast<Milliseconds>(last_end_tp_ - wait_begin_tp).count();
+  average_wait_time_ += (last_wait_time_ - average_wait_time_) * SMOOTHING;
+}
+
+void FrameLimiter::clear() {
+  for (const auto& frame : frames_) glDeleteSync(frame.fence);
+  frames_.clear();
+  has_input_ = false;
+  last_end_tp_ = TimePoint{};
+}
+
+void FrameLimiter::update_gui() {
+  int count = static_cast<int>(max_frames_in_flight_);
+  if (ImGui::SliderInt("frames in flight", &count, 0, MAX_FRAMES_IN_FLIGHT_LIMIT, count == 0 ? "unlimited (ring:8)" : "%d")) {
+    set_max_frames_in_flight(static_cast<uint32_t>(count));
+  }
+  ImGui::Text("queued:%zu, wait:%5.3lf[ms], latency:%5.2lf[ms]", frames_.size(), average_wait_time_, average_latency_);
+}
+
+void FrameLimiter::set_max_frames_in_flight(uint32_t count) noexcept {
+  max_frames_in_flight_ = std::min(count, MAX_FRAMES_IN_FLIGHT_LIMIT);
+}
+
+void FrameLimiter::retire(const Frame& frame, TimePoint now) {
+  glDeleteSync(frame.fence);
+  last_latency_ = std::chrono::duration_cast<Milliseconds>(now - frame.input_tp).count();
+  average_latency_ = average_latency_ > 0.0 ? average_latency_ + (last_latency_ - average_latency_) * SMOOTHING : last_latency_;
+}
+}  // namespace rtdemo
@@ -0,0 +1,141 @@
+#include <rtdemo/frame_pipeline.hpp>
+#include <chrono>
+#include <system_error>
+#include <rtdemo/logging.hpp>
+#include <rtdemo/cpu_profiler.hpp>
+#include <rtdemo/scene.hpp>
+#include <rtdemo/technique.hpp>
+
+namespace rtdemo {
+bool FramePipeline::start() {
+  if (is_running()) return true;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = false;
+    busy_ = false;
+    ready_ = false;
+  }
+  try {
+    thread_ = std::thread([this] { run(); });
+  } catch (const std::system_error& e) {
+    RT_ERROR("ワーカースレッドの起動に失敗した (what:{})", e.what());
+    return false;
+  }
+  return true;
+}
+
+void FramePipeline::stop() {
+  if (!is_running()) return;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+
+  // 止めたときに作成を始めていないパケットは捨て、wait()とreset()が待ち続けないようにする
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    busy_ = false;
+    ready_ = false;
+  }
+  cv_.notify_all();
+}
+
+void FramePipeline::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return !busy_; });
+}
+
+void FramePipeline::reset() {
+  wait();
+  std::lock_guard<std::mutex> lock(mutex_);
+  ready_ = false;
+}
+
+const FramePacket& FramePipeline::acquire(Scene& scene, Technique& technique, const FrameSize& size) {
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+  const auto begin_tp = std::chrono::steady_clock::now();
+  {
+    RT_CPU_SCOPE("FramePipeline::wait");
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !busy_; });
+
+    // kickで作成したパケットを使う
+    if (ready_ && scene_ == &scene && technique_ == &technique) {
+      ready_ = false;
+      current_ = (current_ + 1) % PACKET_COUNT;
+      last_wait_time_ = std::chrono::duration_cast<Milliseconds>(std::chrono::steady_clock::now() - begin_tp).count();
+      return packets_[current_];
+    }
+    ready_ = false;
+  }
+  last_wait_time_ = std::chrono::duration_cast<Milliseconds>(std::chrono::steady_clock::now() - begin_tp).count();
+
+  // 作成済みのパケットがなければ、この場で作成する
+  FramePacket& packet = packets_[current_];
+  packet.frame_index = frame_index_++;
+  packet.set_size(size);
+  build(packet, scene, technique);
+  return packet;
+}
+
+void FramePipeline::kick(Scene& scene, Technique& technique, const FrameSize& size) {
+  if (!is_running()) return;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (busy_) {
+      RT_WARN("ワーカースレッドが作成中のパケットがある");
+      return;
+    }
+
+    // 描画中でないパケットに書き込む
+    FramePacket& packet = packets_[(current_ + 1) % PACKET_COUNT];
+    packet.frame_index = frame_index_++;
+    packet.set_size(size);
+    scene_ = &scene;
+    technique_ = &technique;
+    busy_ = true;
+    ready_ = false;
+  }
+  cv_.notify_all();
+}
+
+void FramePipeline::run() {
+  CpuProfiler::get().set_thread_name("Simulation");
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] { return quit_ || (busy_ && !ready_); });
+    if (quit_) break;
+
+    // 作成中はロックを外す
+    // busy_が立っている間は、GLのスレッドがこのパケットとシーンの状態に触れない
+    FramePacket& packet = packets_[(current_ + 1) % PACKET_COUNT];
+    Scene* scene = scene_;
+    Technique* technique = technique_;
+    lock.unlock();
+    build(packet, *scene, *technique);
+    lock.lock();
+
+    busy_ = false;
+    ready_ = true;
+    cv_.notify_all();
+  }
+}
+
+void FramePipeline::build(FramePacket& packet, Scene& scene, Technique& technique) {
+  packet.clear();
+  {
+    RT_CPU_SCOPE("Scene::update");
+    scene.update(packet);
+  }
+  {
+    RT_CPU_SCOPE("Technique::update");
+    technique.update(packet);
+  }
+}
+}  // namespace rtdemo
@@ -0,0 +1,132 @@
+#include <rtdemo/frame_stats.hpp>
+#include <cmath>
+#include <algorithm>
+#include <imgui.h>
+
+namespace rtdemo {
+void FrameStats::add(double time) {
+  // 全体の統計
+  buckets_[bucket_index(time)]++;
+  min_ = count_ == 0 ? time : std::min(min_, time);
+  max_ = count_ == 0 ? time : std::max(max_, time);
+  sum_ += time;
+
+  // ヒッチを記録する
+  if (time > budget_) {
+    hitches_[hitch_count_ % HITCH_HISTORY_SIZE] = Hitch{count_, static_cast<float>(time)};
+    hitch_count_++;
+  }
+  count_++;
+
+  // 直近のフレーム
+  history_[history_head_] = static_cast<float>(time);
+  history_head_ = (history_head_ + 1) % HISTORY_SIZE;
+  history_count_ = std::min(history_count_ + 1, HISTORY_SIZE);
+}
+
+void FrameStats::reset() {
+  buckets_.fill(0);
+  count_ = 0;
+  sum_ = 0.0;
+  min_ = 0.0;
+  max_ = 0.0;
+  hitch_count_ = 0;
+  history_.fill(0.f);
+  history_head_ = 0;
+  history_count_ = 0;
+  hitches_.fill(Hitch{});
+}
+
+FrameStats::Summary FrameStats::summary() const {
+  Summary summary;
+  summary.count = static_cast<size_t>(count_);
+  if (count_ == 0) return summary;
+  summary.mean = sum_ / count_;
+  summary.min = min_;
+  summary.p50 = percentile(0.50);
+  summary.p95 = percentile(0.95);
+  summary.p99 = percentile(0.99);
+  summary.max = max_;
+  summary.hitch_count = static_cast<size_t>(hitch_count_);
+  return summary;
+}
+
+FrameStats::Summary FrameStats::recent_summary() const {
+  Summary summary;
+  summary.count = history_count_;
+  if (history_count_ == 0) return summary;
+
+  // 直近のフレームは数が少ないので、ソートして正確に求める
+  std::array<float, HISTORY_SIZE> sorted;
+  std::copy_n(history_.begin(), history_count_, sorted.begin());
+  std::sort(sorted.begin(), sorted.begin() + history_count_);
+  const auto at = [&](double p) {
+    const size_t rank = static_cast<size_t>(std::ceil(p * history_count_));
+    return static_cast<double>(sorted[std::clamp<size_t>(rank, 1, history_count_) - 1]);
+  };
+
+  double sum = 0.0;
+  for (size_t i = 0; i < history_count_; ++i) {
+    sum += sorted[i];
+    if (sorted[i] > budget_) summary.hitch_count++;
+  }
+  summary.mean = sum / history_count_;
+  summary.min = sorted[0];
+  summary.p50 = at(0.50);
+  summary.p95 = at(0.95);
+  summary.p99 = at(0.99);
+  summary.max = sorted[history_count_ - 1];
+  return summary;
+}
+
+double FrameStats::percentile(double p) const {
+  if (count_ == 0) return 0.0;
+
+  const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * count_)));
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+    cumulative += buckets_[i];
+    if (cumulative >= rank) return std::clamp(bucket_value(i), min_, max_);
+  }
+  return max_;
+}
+
+void FrameStats::update_gui() {
+  const Summary recent = recent_summary();
+  ImGui::Text("Ave. Time:%5.3lf[ms]", recent.mean);
+  ImGui::Text("Ave. FPS :%5.3lf[fps]", recent.mean > 0.0 ? 1000.0 / recent.mean : 0.0);
+  ImGui::Text("p50/p95/p99/max:%5.2lf/%5.2lf/%5.2lf/%5.2lf[ms]", recent.p50, recent.p95, recent.p99, recent.max);
+  ImGui::PlotLines("frame time", history_.data(), static_cast<int>(history_count_),
+                   static_cast<int>(history_offset()), nullptr, 0.f,
+                   static_cast<float>(std::max(budget_ * 2.0, recent.max)));
+
+  // ヒッチ
+  float budget = static_cast<float>(budget_);
+  if (ImGui::SliderFloat("budget[ms]", &budget, 1.f, 100.f)) budget_ = budget;
+  ImGui::Text("hitches:%llu (recent:%zu)", static_cast<unsigned long long>(hitch_count_), recent.hitch_count);
+  if (hitch_count_ > 0) {
+    const Hitch& last = hitches_[(hitch_count_ - 1) % HITCH_HISTORY_SIZE];
+    ImGui::Text("last hitch:frame %llu, %5.2f[ms]", static_cast<unsigned long long>(last.frame_index), last.time);
+  }
+  if (ImGui::Button("reset stats")) reset();
+}
+
+size_t FrameStats::bucket_index(double time) noexcept {
+  if (!(time > std::ldexp(1.0, MIN_EXPONENT))) return 0;
+
+  // time = m * 2^e (0.5 <= m < 1)
+  int e = 0;
+  const double m = std::frexp(time, &e);
+  const int exponent = e - 1;
+  if (exponent >= MAX_EXPONENT) return BUCKET_COUNT - 1;
+
+  const size_t sub = static_cast<size_t>((2.0 * m - 1.0) * SUB_BUCKET_COUNT);
+  return (exponent - MIN_EXPONENT) * SUB_BUCKET_COUNT + std::min(sub, SUB_BUCKET_COUNT - 1);
+}
+
+double FrameStats::bucket_value(size_t index) noexcept {
+  const int exponent = static_cast<int>(index / SUB_BUCKET_COUNT) + MIN_EXPONENT;
+  const double sub = static_cast<double>(index % SUB_BUCKET_COUNT);
+  return std::ldexp(1.0 + (sub + 0.5) / SUB_BUCKET_COUNT, exponent);
+}
+}  // namespace rtdemo
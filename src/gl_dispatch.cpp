@@ -0,0 +1,273 @@
+#define GARIE_GL_DISPATCH_NO_REDIRECT
+#include <rtdemo/gl_dispatch.hpp>
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include <unordered_map>
+#include <rtdemo/gl_trace.hpp>
+#include <rtdemo/logging.hpp>
+
+namespace garie {
+namespace {
+constexpr size_t FUNCTION_COUNT = static_cast<size_t>(GlFunction::COUNT);  ///< 関数の数
+
+/**
+ * @brief 関数名
+ */
+constexpr std::array<const char*, FUNCTION_COUNT> function_names = {
+#define GARIE_GL_NAME_ENTRY(ret, name, params, args) "gl" #name,
+  GARIE_GL_FUNCTIONS(GARIE_GL_NAME_ENTRY)
+#undef GARIE_GL_NAME_ENTRY
+};
+
+std::array<uint64_t, FUNCTION_COUNT> call_counts{};  ///< 現在のフレームで呼び出した回数
+std::array<uint64_t, FUNCTION_COUNT> last_call_counts{};  ///< 前のフレームで呼び出した回数
+GlTable inner_table;  ///< 回数を数える層から呼び出す関数
+
+/**
+ * @brief 回数を数えてから内側の関数を呼び出す
+ */
+#define GARIE_GL_COUNTING_ENTRY(ret, name, params, args) \
+  ret GLAPIENTRY counting_##name params { \
+    call_counts[static_cast<size_t>(GlFunction::name)]++; \
+    return inner_table.name args; \
+  }
+GARIE_GL_FUNCTIONS(GARIE_GL_COUNTING_ENTRY)
+#undef GARIE_GL_COUNTING_ENTRY
+
+/**
+ * @brief 何もせずに既定値を返す関数
+ */
+template <typename F>
+struct Noop;
+
+template <typename R, typename... Args>
+struct Noop<R(GLAPIENTRY*)(Args...)> {
+  static R GLAPIENTRY call(Args...) {
+    if constexpr (!std::is_void_v<R>) return R{};
+  }
+};
+
+/**
+ * @brief NOOPバックエンドが払い出したオブジェクトとマップ
+ */
+struct NoopState {
+  GLuint next_name = 1;  ///< 次に払い出す名前
+  std::unordered_map<GLenum, GLuint> bound_buffers;  ///< ターゲットごとにバインドされたバッファ
+  std::unordered_map<GLuint, std::vector<std::byte>> mapped;  ///< バッファごとのマップ先
+};
+NoopState noop_state;
+
+void GLAPIENTRY noop_gen(GLsizei n, GLuint* names) {
+  for (GLsizei i = 0; i < n; ++i) names[i] = noop_state.next_name++;
+}
+
+void GLAPIENTRY noop_create_textures(GLenum, GLsizei n, GLuint* names) {
+  noop_gen(n, names);
+}
+
+GLuint GLAPIENTRY noop_create_shader(GLenum) {
+  return noop_state.next_name++;
+}
+
+GLuint GLAPIENTRY noop_create_program() {
+  return noop_state.next_name++;
+}
+
+void GLAPIENTRY noop_bind_buffer(GLenum target, GLuint buffer) {
+  noop_state.bound_buffers[target] = buffer;
+}
+
+void GLAPIENTRY noop_delete_buffers(GLsizei n, const GLuint* buffers) {
+  for (GLsizei i = 0; i < n; ++i) noop_state.mapped.erase(buffers[i]);
+}
+
+void* GLAPIENTRY noop_map_named_buffer_range(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield) {
+  // 書き込みを受け止めるだけのホストメモリを返す
+  auto& memory = noop_state.mapped[buffer];
+  const size_t end = static_cast<size_t>(offset + length);
+  if (memory.size() < end) memory.resize(end);
+  return memory.data() + offset;
+}
+
+void* GLAPIENTRY noop_map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+  return noop_map_named_buffer_range(noop_state.bound_buffers[target], offset, length, access);
+}
+
+GLboolean GLAPIENTRY noop_unmap_buffer(GLenum) {
+  return GL_TRUE;
+}
+
+GLboolean GLAPIENTRY noop_unmap_named_buffer(GLuint) {
+  return GL_TRUE;
+}
+
+GLsync GLAPIENTRY noop_fence_sync(GLenum, GLbitfield) {
+  static int dummy;
+  return reinterpret_cast<GLsync>(&dummy);
+}
+
+GLenum GLAPIENTRY noop_client_wait_sync(GLsync, GLbitfield, GLuint64) {
+  return GL_ALREADY_SIGNALED;
+}
+
+GLenum GLAPIENTRY noop_check_framebuffer_status(GLenum) {
+  return GL_FRAMEBUFFER_COMPLETE;
+}
+
+GLenum GLAPIENTRY noop_check_named_framebuffer_status(GLuint, GLenum) {
+  return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void GLAPIENTRY noop_get_object_iv(GLuint, GLenum pname, GLint* params) {
+  // コンパイルとリンクは成功したことにし、ログは空にする
+  *params = pname == GL_INFO_LOG_LENGTH ? 0 : GL_TRUE;
+}
+
+void GLAPIENTRY noop_get_info_log(GLuint, GLsizei buf_size, GLsizei* length, GLchar* info_log) {
+  if (length) *length = 0;
+  if (info_log && buf_size > 0) info_log[0] = '\0';
+}
+
+void GLAPIENTRY noop_get_integerv(GLenum, GLint* data) {
+  // アラインメントの問い合わせに、どのドライバでも満たす値を返す
+  *data = 256;
+}
+
+void GLAPIENTRY noop_get_query_object_uiv(GLuint, GLenum, GLuint* params) {
+  *params = GL_TRUE;
+}
+
+void GLAPIENTRY noop_get_query_object_ui64v(GLuint, GLenum, GLuint64* params) {
+  *params = 0;
+}
+
+const GLubyte* GLAPIENTRY noop_get_string(GLenum) {
+  return reinterpret_cast<const GLubyte*>("garie noop");
+}
+
+/**
+ * @brief ドライバの関数を読み込む
+ * 
+ * @return const char* 見つからなかった関数の名前。すべてあればnullptr
+ */
+const char* load_real(GlTable& table) {
+  const char* missing = nullptr;
+#define GARIE_GL_REAL_ENTRY(ret, name, params, args) \
+  table.name = gl##name; \
+  if (!table.name && !missing) missing = "gl" #name;
+  GARIE_GL_FUNCTIONS(GARIE_GL_REAL_ENTRY)
+#undef GARIE_GL_REAL_ENTRY
+  return missing;
+}
+
+/**
+ * @brief 何もしない関数を読み込む
+ */
+void load_noop(GlTable& table) {
+#define GARIE_GL_NOOP_ENTRY(ret, name, params, args) table.name = Noop<decltype(table.name)>::call;
+  GARIE_GL_FUNCTIONS(GARIE_GL_NOOP_ENTRY)
+#undef GARIE_GL_NOOP_ENTRY
+
+  table.GenBuffers = noop_gen;
+  table.GenFramebuffers = noop_gen;
+  table.GenQueries = noop_gen;
+  table.GenSamplers = noop_gen;
+  table.GenTextures = noop_gen;
+  table.GenVertexArrays = noop_gen;
+  table.CreateBuffers = noop_gen;
+  table.CreateFramebuffers = noop_gen;
+  table.CreateSamplers = noop_gen;
+  table.CreateVertexArrays = noop_gen;
+  table.CreateTextures = noop_create_textures;
+  table.CreateShader = noop_create_shader;
+  table.CreateProgram = noop_create_program;
+  table.BindBuffer = noop_bind_buffer;
+  table.DeleteBuffers = noop_delete_buffers;
+  table.MapBufferRange = noop_map_buffer_range;
+  table.MapNamedBufferRange = noop_map_named_buffer_range;
+  table.UnmapBuffer = noop_unmap_buffer;
+  table.UnmapNamedBuffer = noop_unmap_named_buffer;
+  table.FenceSync = noop_fence_sync;
+  table.ClientWaitSync = noop_client_wait_sync;
+  table.CheckFramebufferStatus = noop_check_framebuffer_status;
+  table.CheckNamedFramebufferStatus = noop_check_named_framebuffer_status;
+  table.GetShaderiv = noop_get_object_iv;
+  table.GetProgramiv = noop_get_object_iv;
+  table.GetShaderInfoLog = noop_get_info_log;
+  table.GetProgramInfoLog = noop_get_info_log;
+  table.GetIntegerv = noop_get_integerv;
+  table.GetQueryObjectuiv = noop_get_query_object_uiv;
+  table.GetQueryObjectui64v = noop_get_query_object_ui64v;
+  table.GetString = noop_get_string;
+}
+}  // namespace
+
+bool GlDispatch::load() {
+  GlTable table;
+  missing_function_ = nullptr;
+  if (backend_ == Backend::NOOP) {
+    noop_state = NoopState{};
+    load_noop(table);
+  } else {
+    missing_function_ = load_real(table);
+    if (missing_function_) {
+      RT_ERROR("GLの関数が見つからない ({})", missing_function_);
+      return false;
+    }
+  }
+
+  // 記録する層は数える層の内側に重ね、数える層の呼び出しを記録しないようにする
+  if (GlCapture::get().is_open()) GlCapture::get().wrap(table);
+
+  if (counting_) {
+    inner_table = table;
+#define GARIE_GL_COUNTING_LOAD_ENTRY(ret, name, params, args) table.name = counting_##name;
+    GARIE_GL_FUNCTIONS(GARIE_GL_COUNTING_LOAD_ENTRY)
+#undef GARIE_GL_COUNTING_LOAD_ENTRY
+  }
+  call_counts.fill(0);
+  last_call_counts.fill(0);
+  last_call_count_ = 0;
+  gl_table = table;
+  RT_DEBUG("GLの呼び出し先: {}{}", backend_name(backend_), counting_ ? " (counting)" : "");
+  return true;
+}
+
+void GlDispatch::end_frame() {
+  GlCapture::get().end_frame();
+  if (!counting_) return;
+  last_call_counts = call_counts;
+  call_counts.fill(0);
+  last_call_count_ = 0;
+  for (uint64_t count : last_call_counts) last_call_count_ += count;
+}
+
+std::vector<std::pair<const char*, uint64_t>> GlDispatch::last_top_calls(size_t count) const {
+  std::vector<std::pair<const char*, uint64_t>> calls;
+  for (size_t i = 0; i < FUNCTION_COUNT; ++i) {
+    if (last_call_counts[i] > 0) calls.emplace_back(function_names[i], last_call_counts[i]);
+  }
+  count = std::min(count, calls.size());
+  std::partial_sort(calls.begin(), calls.begin() + count, calls.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.second > rhs.second;
+  });
+  calls.resize(count);
+  return calls;
+}
+
+const char* GlDispatch::function_name(GlFunction function) noexcept {
+  const auto index = static_cast<size_t>(function);
+  return index < FUNCTION_COUNT ? function_names[index] : "unknown";
+}
+
+const char* GlDispatch::backend_name(Backend backend) noexcept {
+  switch (backend) {
+    case Backend::REAL:
+      return "real";
+    case Backend::NOOP:
+      return "noop";
+  }
+  return "unknown";
+}
+}  // namespace garie
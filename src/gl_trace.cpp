@@ -0,0 +1,1171 @@
+#define GARIE_GL_DISPATCH_NO_REDIRECT
+#include <rtdemo/gl_trace.hpp>
+#include <algorithm>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <cstring>
+#include <rtdemo/logging.hpp>
+
+// 引数リストの先頭にカンマを付ける。引数のない関数ではカンマも付けない
+#define GARIE_GL_TRACE_ARGS(...) __VA_OPT__(,) __VA_ARGS__
+
+namespace garie {
+namespace {
+constexpr size_t PAYLOAD_ALIGNMENT = 8;  ///< 関数に渡すデータのアラインメント
+constexpr size_t MEMORY_CHUNK_SIZE = 256;  ///< マップしたバッファの差分を取る単位[byte]
+
+/**
+ * @brief 戻り値のない関数の戻り値
+ */
+struct Void {};
+
+/**
+ * @brief 関数の並びのハッシュ(FNV-1a)
+ */
+uint32_t function_hash() noexcept {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < static_cast<size_t>(GlFunction::COUNT); ++i) {
+    const std::string_view name = GlDispatch::function_name(static_cast<GlFunction>(i));
+    for (char c : name) hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    hash = (hash ^ 0u) * 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * @brief 状態を変えない問い合わせか
+ */
+constexpr bool is_query(GlFunction function) noexcept {
+  switch (function) {
+    case GlFunction::CheckFramebufferStatus:
+    case GlFunction::CheckNamedFramebufferStatus:
+    case GlFunction::GetIntegerv:
+    case GlFunction::GetProgramInfoLog:
+    case GlFunction::GetProgramiv:
+    case GlFunction::GetQueryObjectui64v:
+    case GlFunction::GetQueryObjectuiv:
+    case GlFunction::GetShaderInfoLog:
+    case GlFunction::GetShaderiv:
+    case GlFunction::GetString:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief マップしたバッファの内容をGPUが読むかもしれない関数か
+ */
+constexpr bool reads_mapped_memory(GlFunction function) noexcept {
+  switch (function) {
+    case GlFunction::DispatchCompute:
+    case GlFunction::DrawArrays:
+    case GlFunction::DrawElements:
+    case GlFunction::DrawElementsIndirect:
+    case GlFunction::DrawElementsInstancedBaseVertexBaseInstance:
+    case GlFunction::Flush:
+    case GlFunction::UnmapBuffer:
+    case GlFunction::UnmapNamedBuffer:
+      return true;
+    default:
+      return false;
+  }
+}
+
+constexpr GlNameType NOT_NAME = GlNameType::COUNT;  ///< 名前ではない引数
+
+/**
+ * @brief 関数の引数が名前なら、その種類
+ * 
+ * 名前の配列を受け取る関数は、Codecで置き換える。
+ * 
+ * @param function 関数
+ * @param index 引数の番号
+ * @return GlNameType 名前の種類。名前でなければNOT_NAME
+ */
+constexpr GlNameType name_type(GlFunction function, size_t index) noexcept {
+  const auto at = [index](size_t name_index, GlNameType type) {
+    return index == name_index ? type : NOT_NAME;
+  };
+  switch (function) {
+    case GlFunction::AttachShader:
+      return index <= 1 ? GlNameType::PROGRAM : NOT_NAME;
+    case GlFunction::BeginQuery:
+      return at(1, GlNameType::QUERY);
+    case GlFunction::BindBuffer:
+      return at(1, GlNameType::BUFFER);
+    case GlFunction::BindBufferBase:
+    case GlFunction::BindBufferRange:
+      return at(2, GlNameType::BUFFER);
+    case GlFunction::BindFramebuffer:
+      return at(1, GlNameType::FRAMEBUFFER);
+    case GlFunction::BindImageTexture:
+      return at(1, GlNameType::TEXTURE);
+    case GlFunction::BindSampler:
+      return at(1, GlNameType::SAMPLER);
+    case GlFunction::BindTexture:
+      return at(1, GlNameType::TEXTURE);
+    case GlFunction::BindVertexArray:
+      return at(0, GlNameType::VERTEX_ARRAY);
+    case GlFunction::CompileShader:
+    case GlFunction::DeleteProgram:
+    case GlFunction::DeleteShader:
+    case GlFunction::LinkProgram:
+    case GlFunction::ShaderSource:
+    case GlFunction::ShaderStorageBlockBinding:
+    case GlFunction::SpecializeShader:
+    case GlFunction::UniformBlockBinding:
+    case GlFunction::UseProgram:
+      return at(0, GlNameType::PROGRAM);
+    case GlFunction::EnableVertexArrayAttrib:
+    case GlFunction::VertexArrayAttribBinding:
+    case GlFunction::VertexArrayAttribFormat:
+    case GlFunction::VertexArrayBindingDivisor:
+      return at(0, GlNameType::VERTEX_ARRAY);
+    case GlFunction::FramebufferTexture:
+    case GlFunction::FramebufferTextureLayer:
+      return at(2, GlNameType::TEXTURE);
+    case GlFunction::FramebufferTexture2D:
+      return at(3, GlNameType::TEXTURE);
+    case GlFunction::MapNamedBufferRange:
+    case GlFunction::NamedBufferStorage:
+    case GlFunction::NamedBufferSubData:
+    case GlFunction::UnmapNamedBuffer:
+      return at(0, GlNameType::BUFFER);
+    case GlFunction::NamedFramebufferDrawBuffers:
+      return at(0, GlNameType::FRAMEBUFFER);
+    case GlFunction::NamedFramebufferTexture:
+    case GlFunction::NamedFramebufferTextureLayer:
+      return index == 0 ? GlNameType::FRAMEBUFFER : at(2, GlNameType::TEXTURE);
+    case GlFunction::QueryCounter:
+      return at(0, GlNameType::QUERY);
+    case GlFunction::SamplerParameterIiv:
+    case GlFunction::SamplerParameterIuiv:
+    case GlFunction::SamplerParameterf:
+    case GlFunction::SamplerParameterfv:
+    case GlFunction::SamplerParameteri:
+    case GlFunction::SamplerParameteriv:
+      return at(0, GlNameType::SAMPLER);
+    case GlFunction::TextureStorage2D:
+    case GlFunction::TextureStorage2DMultisample:
+    case GlFunction::TextureStorage3D:
+    case GlFunction::TextureSubImage2D:
+      return at(0, GlNameType::TEXTURE);
+    case GlFunction::VertexArrayElementBuffer:
+      return index == 0 ? GlNameType::VERTEX_ARRAY : at(1, GlNameType::BUFFER);
+    case GlFunction::VertexArrayVertexBuffer:
+      return index == 0 ? GlNameType::VERTEX_ARRAY : at(2, GlNameType::BUFFER);
+    default:
+      return NOT_NAME;
+  }
+}
+
+/**
+ * @brief glTexSubImage2Dなどに渡すピクセルの大きさ[byte]
+ */
+size_t pixel_size(GLenum format, GLenum type) noexcept {
+  switch (type) {
+    case GL_UNSIGNED_INT_24_8:
+    case GL_UNSIGNED_INT_10F_11F_11F_REV:
+    case GL_UNSIGNED_INT_5_9_9_9_REV:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_8_8_8_8:
+    case GL_UNSIGNED_INT_8_8_8_8_REV:
+      return 4;
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+      return 2;
+    default:
+      break;
+  }
+
+  size_t component_size = 1;
+  switch (type) {
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT:
+      component_size = 2;
+      break;
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+      component_size = 4;
+      break;
+    default:
+      break;
+  }
+
+  switch (format) {
+    case GL_RG:
+    case GL_RG_INTEGER:
+      return component_size * 2;
+    case GL_RGB:
+    case GL_BGR:
+    case GL_RGB_INTEGER:
+      return component_size * 3;
+    case GL_RGBA:
+    case GL_BGRA:
+    case GL_RGBA_INTEGER:
+      return component_size * 4;
+    default:
+      return component_size;
+  }
+}
+
+/**
+ * @brief glTexSubImage2Dなどが読むピクセルデータの大きさ[byte]
+ * 
+ * GL_UNPACK_ALIGNMENTは既定値の4とする。
+ */
+size_t image_size(GLsizei width, GLsizei height, GLenum format, GLenum type) noexcept {
+  if (width <= 0 || height <= 0) return 0;
+  const size_t row_size = static_cast<size_t>(width) * pixel_size(format, type);
+  const size_t row_stride = (row_size + 3) & ~size_t{3};
+  return row_stride * (height - 1) + row_size;
+}
+}  // namespace
+
+namespace detail {
+/**
+ * @brief GlCaptureとGlReplayerの読み書き
+ */
+struct GlTraceAccess {
+  static void write_bytes(GlCapture& capture, const void* data, size_t size) {
+    const auto bytes = static_cast<const std::byte*>(data);
+    capture.buffer_.insert(capture.buffer_.end(), bytes, bytes + size);
+  }
+
+  template <typename T>
+  static void write(GlCapture& capture, const T& value) {
+    write_bytes(capture, &value, sizeof(T));
+  }
+
+  /**
+   * @brief 関数に渡すデータを、大きさを付けて書き込む
+   */
+  static void write_payload(GlCapture& capture, const void* data, size_t size) {
+    if (!data) size = 0;
+    write<uint64_t>(capture, size);
+    const size_t offset = capture.written_size_ + capture.buffer_.size();
+    const size_t padding = (PAYLOAD_ALIGNMENT - offset % PAYLOAD_ALIGNMENT) % PAYLOAD_ALIGNMENT;
+    capture.buffer_.resize(capture.buffer_.size() + padding);
+    write_bytes(capture, data, size);
+  }
+
+  template <typename T>
+  static void write_arg(GlCapture& capture, T value) {
+    if constexpr (std::is_same_v<T, GLsync>) {
+      auto iter = capture.sync_ids_.find(value);
+      write<uint64_t>(capture, iter != capture.sync_ids_.end() ? iter->second : 0);
+    } else if constexpr (std::is_pointer_v<T>) {
+      // バッファ内のオフセットとして使われるポインタがあるので、値をそのまま残す
+      write<uint64_t>(capture, reinterpret_cast<uintptr_t>(value));
+    } else {
+      write(capture, value);
+    }
+  }
+
+  static const std::byte* read_bytes(GlReplayer& replayer, size_t size) {
+    if (replayer.failed_ || replayer.pos_ + size > replayer.data_.size()) {
+      if (!replayer.failed_) RT_ERROR("トレースが途中で終わっている (pos:{})", replayer.pos_);
+      replayer.failed_ = true;
+      return nullptr;
+    }
+    const std::byte* data = replayer.data_.data() + replayer.pos_;
+    replayer.pos_ += size;
+    return data;
+  }
+
+  template <typename T>
+  static T read(GlReplayer& replayer) {
+    T value{};
+    if (const std::byte* data = read_bytes(replayer, sizeof(T))) std::memcpy(&value, data, sizeof(T));
+    return value;
+  }
+
+  /**
+   * @brief 関数に渡すデータを読み込む
+   * 
+   * @return const std::byte* データの先頭。大きさが0ならnullptr
+   */
+  static const std::byte* read_payload(GlReplayer& replayer, size_t* size = nullptr) {
+    const auto payload_size = static_cast<size_t>(read<uint64_t>(replayer));
+    const size_t padding = (PAYLOAD_ALIGNMENT - replayer.pos_ % PAYLOAD_ALIGNMENT) % PAYLOAD_ALIGNMENT;
+    if (!read_bytes(replayer, padding)) return nullptr;
+    if (size) *size = payload_size;
+    return payload_size > 0 ? read_bytes(replayer, payload_size) : nullptr;
+  }
+
+  template <typename T>
+  static T read_arg(GlReplayer& replayer) {
+    const auto value = read<std::conditional_t<std::is_pointer_v<T>, uint64_t, T>>(replayer);
+    if constexpr (std::is_same_v<T, GLsync>) {
+      auto iter = replayer.syncs_.find(value);
+      return iter != replayer.syncs_.end() ? iter->second : nullptr;
+    } else if constexpr (std::is_pointer_v<T>) {
+      return reinterpret_cast<T>(static_cast<uintptr_t>(value));
+    } else {
+      return value;
+    }
+  }
+
+  /**
+   * @brief マップ先への書き込みを記録する
+   */
+  static void write_memory(GlCapture& capture, const GlCapture::Mapping& mapping, size_t begin, size_t end) {
+    write<uint16_t>(capture, static_cast<uint16_t>(GlTraceOp::MEMORY));
+    write<GLuint>(capture, mapping.buffer);
+    write<uint64_t>(capture, begin);
+    write_payload(capture, mapping.data + begin, end - begin);
+  }
+
+  /**
+   * @brief マップしたバッファの、前回から書き込まれた範囲を記録する
+   * 
+   * 永続マップしたバッファは、書き込まれた範囲のうち前回と変わったチャンクだけを記録する。
+   */
+  static void flush_mapped(GlCapture& capture) {
+    for (auto& mapping : capture.mappings_) {
+      for (const auto& [begin, end] : mapping.written_ranges) {
+        if (mapping.shadow.empty()) {
+          write_memory(capture, mapping, begin, end);
+          continue;
+        }
+
+        size_t offset = begin;
+        while (offset < end) {
+          // 書き換えられたチャンクが続く範囲をまとめる
+          const auto changed = [&](size_t chunk) {
+            const size_t length = std::min(MEMORY_CHUNK_SIZE, end - chunk);
+            return std::memcmp(mapping.data + chunk, mapping.shadow.data() + chunk, length) != 0;
+          };
+          if (!changed(offset)) {
+            offset += MEMORY_CHUNK_SIZE;
+            continue;
+          }
+          size_t changed_end = offset;
+          while (changed_end < end && changed(changed_end)) changed_end += MEMORY_CHUNK_SIZE;
+          changed_end = std::min(changed_end, end);
+
+          write_memory(capture, mapping, offset, changed_end);
+          std::memcpy(mapping.shadow.data() + offset, mapping.data + offset, changed_end - offset);
+          offset = changed_end;
+        }
+      }
+      mapping.written_ranges.clear();
+    }
+  }
+
+  /**
+   * @brief 溜まったレコードをファイルに書き出す
+   */
+  static void flush(GlCapture& capture) {
+    capture.ofs_.write(reinterpret_cast<const char*>(capture.buffer_.data()),
+                       static_cast<std::streamsize>(capture.buffer_.size()));
+    capture.written_size_ += capture.buffer_.size();
+    capture.buffer_.clear();
+  }
+
+  template <GlFunction F, typename R, typename... A>
+  static R record(R (GLAPIENTRY* GlTable::* member)(A...), std::type_identity_t<A>... args);
+
+  template <GlFunction F, typename R, typename... A>
+  static void replay(GlReplayer& replayer, R (GLAPIENTRY* function)(A...));
+
+  /**
+   * @brief 名前の引数を置き換える
+   */
+  template <GlNameType TYPE, typename T>
+  static void translate_arg(GlReplayer& replayer, T& value) {
+    if constexpr (TYPE != NOT_NAME) value = translate(replayer, TYPE, value);
+  }
+
+  /**
+   * @brief マップを始める
+   * 
+   * 永続マップでなければ、アンマップするまでにマップした範囲がすべて書き込まれるものとする。
+   */
+  static void map(GlCapture& capture, GLuint buffer, void* data, GLsizeiptr length, GLbitfield access) {
+    if (!data) return;
+    auto& mapping = capture.mappings_.emplace_back();
+    mapping.buffer = buffer;
+    mapping.data = static_cast<std::byte*>(data);
+    mapping.size = static_cast<size_t>(length);
+    if (access & GL_MAP_PERSISTENT_BIT) {
+      mapping.shadow.assign(mapping.data, mapping.data + length);
+    } else {
+      mapping.written_ranges.emplace_back(0, mapping.size);
+    }
+  }
+
+  /**
+   * @brief マップを終える
+   */
+  static void unmap(GlCapture& capture, GLuint buffer) {
+    std::erase_if(capture.mappings_, [&](const GlCapture::Mapping& mapping) {
+      return mapping.buffer == buffer;
+    });
+  }
+
+  static GLuint bound_buffer(GlCapture& capture, GLenum target) {
+    return capture.bound_buffers_[target];
+  }
+
+  static void bind_buffer(GlCapture& capture, GLenum target, GLuint buffer) {
+    capture.bound_buffers_[target] = buffer;
+  }
+
+  static uint64_t add_sync(GlCapture& capture, GLsync sync) {
+    const uint64_t id = capture.next_sync_id_++;
+    capture.sync_ids_[sync] = id;
+    return id;
+  }
+
+  static void erase_sync(GlCapture& capture, GLsync sync) {
+    capture.sync_ids_.erase(sync);
+  }
+
+  static const std::byte*& expected(GlReplayer& replayer) {
+    return replayer.expected_;
+  }
+
+  static std::vector<GLuint>& names(GlReplayer& replayer) {
+    return replayer.names_;
+  }
+
+  static std::unordered_map<GLuint, GLuint>& name_map(GlReplayer& replayer, GlNameType type) {
+    return replayer.name_maps_[static_cast<size_t>(type)];
+  }
+
+  /**
+   * @brief 記録した名前を、再生で払い出された名前に置き換える
+   * 
+   * 0はどの種類でも0のままにする。記録にない名前であれば再生を中断する。
+   */
+  static GLuint translate(GlReplayer& replayer, GlNameType type, GLuint name) {
+    if (name == 0) return 0;
+    const auto& map = name_map(replayer, type);
+    auto iter = map.find(name);
+    if (iter != map.end()) return iter->second;
+    if (!replayer.failed_) {
+      RT_ERROR("記録にない名前が使われた (type:{}, name:{}, pos:{})", static_cast<uint32_t>(type), name, replayer.pos_);
+    }
+    replayer.failed_ = true;
+    return 0;
+  }
+
+  static std::vector<const GLchar*>& strings(GlReplayer& replayer) {
+    return replayer.strings_;
+  }
+
+  static std::vector<GLint>& lengths(GlReplayer& replayer) {
+    return replayer.lengths_;
+  }
+
+  static std::unordered_map<uint64_t, GLsync>& syncs(GlReplayer& replayer) {
+    return replayer.syncs_;
+  }
+
+  static std::unordered_map<GLuint, std::span<std::byte>>& mapped(GlReplayer& replayer) {
+    return replayer.mapped_;
+  }
+};
+}  // namespace detail
+
+namespace {
+using Access = detail::GlTraceAccess;
+
+/**
+ * @brief 引数が指すデータと戻り値の読み書き
+ * 
+ * 既定では何もしない。ポインタを受け取る関数とオブジェクトを払い出す関数は特殊化する。
+ * - write:記録するときに、呼び出した後で、引数の後ろにデータを書き込む
+ * - read:再生するときに、呼び出す前に、データを読み込んでポインタの引数をそこに向ける
+ * - check:再生するときに、呼び出した後で、払い出されたものを記録と対応付ける
+ * 
+ * 名前の引数はname_type()に従ってreadの後で置き換える。
+ */
+template <GlFunction F>
+struct Codec {
+  template <typename R, typename Tuple>
+  static void write(GlCapture&, const R&, const Tuple&) {}
+
+  template <typename Tuple>
+  static void read(GlReplayer&, Tuple&) {}
+
+  template <typename R, typename Tuple>
+  static bool check(GlReplayer&, const R&, const Tuple&) {
+    return true;
+  }
+};
+
+using DefaultCodec = Codec<GlFunction::COUNT>;
+
+/**
+ * @brief 要素数の引数を持つ配列
+ */
+template <size_t POINTER_INDEX, size_t COUNT_INDEX, typename T, size_t STRIDE = 1>
+struct ArrayCodec : DefaultCodec {
+  template <typename R, typename Tuple>
+  static void write(GlCapture& capture, const R&, const Tuple& args) {
+    const auto count = static_cast<size_t>(std::get<COUNT_INDEX>(args));
+    Access::write_payload(capture, std::get<POINTER_INDEX>(args), count * STRIDE * sizeof(T));
+  }
+
+  template <typename Tuple>
+  static void read(GlReplayer& replayer, Tuple& args) {
+    std::get<POINTER_INDEX>(args) = reinterpret_cast<const T*>(Access::read_payload(replayer));
+  }
+};
+
+/**
+ * @brief 要素数の決まった配列
+ */
+template <size_t POINTER_INDEX, typename T, size_t COUNT>
+struct FixedArrayCodec : DefaultCodec {
+  template <typename R, typename Tuple>
+  static void write(GlCapture& capture, const R&, const Tuple& args) {
+    Access::write_payload(capture, std::get<POINTER_INDEX>(args), COUNT * sizeof(T));
+  }
+
+  template <typename Tuple>
+  static void read(GlReplayer& replayer, Tuple& args) {
+    std::get<POINTER_INDEX>(args) = reinterpret_cast<const T*>(Access::read_payload(replayer));
+  }
+};
+
+/**
+ * @brief 大きさ[byte]の引数を持つデータ
+ */
+template <size_t POINTER_INDEX, size_t SIZE_INDEX>
+struct BytesCodec : DefaultCodec {
+  template <typename R, typename Tuple>
+  static void write(GlCapture& capture, const R&, const Tuple& args) {
+    Access::write_payload(capture, std::get<POINTER_INDEX>(args), static_cast<size_t>(std::get<SIZE_INDEX>(args)));
+  }
+
+  template <typename Tuple>
+  static void read(GlReplayer& replayer, Tuple& args) {
+    std::get<POINTER_INDEX>(args) = Access::read_payload(replayer);
+  }
+};
+
+/**
+ * @brief glSamplerParameter*v
+ */
+template <typename T>
+struct SamplerParameterCodec : DefaultCodec {
+  template <typename R, typename Tuple>
+  static void write(GlCapture& capture, const R&, const Tuple& args) {
+    const size_t count = std::get<1>(args) == GL_TEXTURE_BORDER_COLOR ? 4 : 1;
+    Access::write_payload(capture, std::get<2>(args), count * sizeof(T));
+  }
+
+  template <typename Tuple>
+  static void read(GlReplayer& replayer, Tuple& args) {
+    std::get<2>(args) = reinterpret_cast<const T*>(Access::read_payload(replayer));
+  }
+};
+
+/**
+ * @brief glTexSubImage2DとglTextureSubImage2D
+ * 
+ * ピクセルアンパックバッファは使わない前提で、pixelsが指すデータを書き込む。
+ */
+struct SubImageCodec : DefaultCodec {
+  template <typename R, typename Tuple>
+  static void write(GlCapture& capture, const R&, const Tuple& args) {
+    const size_t size = image_size(std::get<4>(args), std::get<5>(args), std::get<6>(args), std::get<7>(args));
+    Access::write_payload(capture, std::get<8>(args), size);
+  }
+
+  template <typename Tuple>
+  static void read(GlReplayer& replayer, Tuple& args) {
+    std::get<8>(args) = Access::read_payload(replayer);
+  }
+};
+
+/**
+ * @brief 名前の配列
+ * 
+ * 再生するときは払い出された名前に置き換えて渡す。DELETESなら、呼び出した後で対応を消す。
+ */
+template <size_t POINTER_INDEX, size_t COUNT_INDEX, GlNameType TYPE, bool DELETES>
+struct NamesCodec : DefaultCodec {
+  template <typename R, typename Tuple>
+  static void write(GlCapture& capture, const R&, const Tuple& args) {
+    const auto count = static_cast<size_t>(std::get<COUNT_INDEX>(args));
+    Access::write_payload(capture, std::get<POINTER_INDEX>(args), count * sizeof(GLuint));
+  }
+
+  template <typename Tuple>
+  static void read(GlReplayer& replayer, Tuple& args) {
+    const std::byte* recorded = Access::read_payload(replayer);
+    Access::expected(replayer) = recorded;
+    auto& names = Access::names(replayer);
+    names.assign(recorded ? static_cast<size_t>(std::get<COUNT_INDEX>(args)) : 0, 0);
+    for (size_t i = 0; i < names.size(); ++i) {
+      GLuint name = 0;
+      std::memcpy(&name, recorded + i * sizeof(GLuint), sizeof(GLuint));
+      names[i] = Access::translate(replayer, TYPE, name);
+    }
+    std::get<POINTER_INDEX>(args) = recorded ? names.data() : nullptr;
+  }
+
+  template <typename R, typename Tuple>
+  static bool check(GlReplayer& replayer, const R&, const Tuple&) {
+    if constexpr (DELETES) {
+      auto& map = Access::name_map(replayer, TYPE);
+      const std::byte* recorded = Access::expected(replayer);
+      for (size_t i = 0; i < Access::names(replayer).size(); ++i) {
+        GLuint name = 0;
+        std::memcpy(&name, recorded + i * sizeof(GLuint), sizeof(GLuint));
+        map.erase(name);
+      }
+    }
+    return true;
+  }
+};
+
+/**
+ * @brief 名前を払い出すglGen*とglCreate*
+ */
+template <size_t COUNT_INDEX, size_t NAMES_INDEX, GlNameType TYPE>
+struct GenCodec : DefaultCodec {
+  template <typename R, typename Tuple>
+  static void write(GlCapture& capture, const R&, const Tuple& args) {
+    const auto count = static_cast<size_t>(std::get<COUNT_INDEX>(args));
+    Access::write_payload(capture, std::get<NAMES_INDEX>(args), count * sizeof(GLuint));
+  }
+
+  template <typename Tuple>
+  static void read(GlReplayer& replayer, Tuple& args) {
+    Access::expected(replayer) = Access::read_payload(replayer);
+    auto& names = Access::names(replayer);
+    names.assign(static_cast<size_t>(std::get<COUNT_INDEX>(args)), 0);
+    std::get<NAMES_INDEX>(args) = names.data();
+  }
+
+  template <typename R, typename Tuple>
+  static bool check(GlReplayer& replayer, const R&, const Tuple&) {
+    const auto& names = Access::names(replayer);
+    const std::byte* recorded = Access::expected(replayer);
+    if (!recorded) return true;
+    auto& map = Access::name_map(replayer, TYPE);
+    for (size_t i = 0; i < names.size(); ++i) {
+      GLuint name = 0;
+      std::memcpy(&name, recorded + i * sizeof(GLuint), sizeof(GLuint));
+      map[name] = names[i];
+    }
+    return true;
+  }
+};
+
+/**
+ * @brief 名前を返すglCreateShaderとglCreateProgram
+ */
+struct CreateCodec : DefaultCodec {
+  template <typename Tuple>
+  static void write(GlCapture& capture, GLuint result, const Tuple&) {
+    Access::write<GLuint>(capture, result);
+  }
+
+  template <typename Tuple>
+  static void read(GlReplayer& replayer, Tuple&) {
+    Access::expected(replayer) = Access::read_bytes(replayer, sizeof(GLuint));
+  }
+
+  template <typename Tuple>
+  static bool check(GlReplayer& replayer, GLuint result, const Tuple&) {
+    GLuint name = 0;
+    std::memcpy(&name, Access::expected(replayer), sizeof(GLuint));
+    if (!result) {
+      RT_ERROR("シェーダかプログラムの生成に失敗した (name:{})", name);
+      return false;
+    }
+    Access::name_map(replayer, GlNameType::PROGRAM)[name] = result;
+    return true;
+  }
+};
+
+/**
+ * @brief glDeleteShaderとglDeleteProgram
+ * 
+ * 引数は置き換えた後の名前なので、払い出された名前から対応を探して消す。
+ */
+struct DeleteProgramCodec : DefaultCodec {
+  template <typename Tuple>
+  static bool check(GlReplayer& replayer, Void, const Tuple& args) {
+    std::erase_if(Access::name_map(replayer, GlNameType::PROGRAM), [&](const auto& pair) {
+      return pair.second == std::get<0>(args);
+    });
+    return true;
+  }
+};
+
+/**
+ * @brief glMapBufferRangeとglMapNamedBufferRange
+ * 
+ * マップしたバッファの名前を書き込み、再生するときはそのバッファのマップ先を覚える。
+ */
+template <bool NAMED>
+struct MapCodec : DefaultCodec {
+  template <typename Tuple>
+  static void write(GlCapture& capture, void* result, const Tuple& args) {
+    const GLuint buffer = NAMED ? static_cast<GLuint>(std::get<0>(args)) : Access::bound_buffer(capture, std::get<0>(args));
+    Access::write<GLuint>(capture, buffer);
+    Access::map(capture, buffer, result, std::get<2>(args), std::get<3>(args));
+  }
+
+  template <typename Tuple>
+  static void read(GlReplayer& replayer, Tuple&) {
+    Access::expected(replayer) = Access::read_bytes(replayer, sizeof(GLuint));
+  }
+
+  template <typename Tuple>
+  static bool check(GlReplayer& replayer, void* result, const Tuple& args) {
+    GLuint buffer = 0;
+    std::memcpy(&buffer, Access::expected(replayer), sizeof(GLuint));
+    if (!result) {
+      RT_ERROR("バッファのマップに失敗した (buffer:{})", buffer);
+      return false;
+    }
+    Access::mapped(replayer)[buffer] = std::span(static_cast<std::byte*>(result), static_cast<size_t>(std::get<2>(args)));
+    return true;
+  }
+};
+
+/**
+ * @brief glUnmapBufferとglUnmapNamedBuffer
+ */
+template <bool NAMED>
+struct UnmapCodec : DefaultCodec {
+  template <typename Tuple>
+  static void write(GlCapture& capture, GLboolean, const Tuple& args) {
+    const GLuint buffer = NAMED ? static_cast<GLuint>(std::get<0>(args)) : Access::bound_buffer(capture, std::get<0>(args));
+    Access::write<GLuint>(capture, buffer);
+    Access::unmap(capture, buffer);
+  }
+
+  template <typename Tuple>
+  static void read(GlReplayer& replayer, Tuple&) {
+    Access::expected(replayer) = Access::read_bytes(replayer, sizeof(GLuint));
+  }
+
+  template <typename Tuple>
+  static bool check(GlReplayer& replayer, GLboolean, const Tuple&) {
+    GLuint buffer = 0;
+    std::memcpy(&buffer, Access::expected(replayer), sizeof(GLuint));
+    Access::mapped(replayer).erase(buffer);
+    return true;
+  }
+};
+
+template <> struct Codec<GlFunction::BufferStorage> : BytesCodec<2, 1> {};
+template <> struct Codec<GlFunction::BufferSubData> : BytesCodec<3, 2> {};
+template <> struct Codec<GlFunction::NamedBufferStorage> : BytesCodec<2, 1> {};
+template <> struct Codec<GlFunction::NamedBufferSubData> : BytesCodec<3, 2> {};
+template <> struct Codec<GlFunction::DeleteBuffers> : NamesCodec<1, 0, GlNameType::BUFFER, true> {};
+template <> struct Codec<GlFunction::DeleteFramebuffers> : NamesCodec<1, 0, GlNameType::FRAMEBUFFER, true> {};
+template <> struct Codec<GlFunction::DeleteQueries> : NamesCodec<1, 0, GlNameType::QUERY, true> {};
+template <> struct Codec<GlFunction::DeleteSamplers> : NamesCodec<1, 0, GlNameType::SAMPLER, true> {};
+template <> struct Codec<GlFunction::DeleteTextures> : NamesCodec<1, 0, GlNameType::TEXTURE, true> {};
+template <> struct Codec<GlFunction::DeleteVertexArrays> : NamesCodec<1, 0, GlNameType::VERTEX_ARRAY, true> {};
+template <> struct Codec<GlFunction::DeleteProgram> : DeleteProgramCodec {};
+template <> struct Codec<GlFunction::DeleteShader> : DeleteProgramCodec {};
+template <> struct Codec<GlFunction::DrawBuffers> : ArrayCodec<1, 0, GLenum> {};
+template <> struct Codec<GlFunction::NamedFramebufferDrawBuffers> : ArrayCodec<2, 1, GLenum> {};
+template <> struct Codec<GlFunction::UniformMatrix4fv> : ArrayCodec<3, 1, GLfloat, 16> {};
+template <> struct Codec<GlFunction::ScissorIndexedv> : FixedArrayCodec<1, GLint, 4> {};
+template <> struct Codec<GlFunction::ViewportIndexedfv> : FixedArrayCodec<1, GLfloat, 4> {};
+template <> struct Codec<GlFunction::SamplerParameterfv> : SamplerParameterCodec<GLfloat> {};
+template <> struct Codec<GlFunction::SamplerParameteriv> : SamplerParameterCodec<GLint> {};
+template <> struct Codec<GlFunction::SamplerParameterIiv> : SamplerParameterCodec<GLint> {};
+template <> struct Codec<GlFunction::SamplerParameterIuiv> : SamplerParameterCodec<GLuint> {};
+template <> struct Codec<GlFunction::TexSubImage2D> : SubImageCodec {};
+template <> struct Codec<GlFunction::TextureSubImage2D> : SubImageCodec {};
+template <> struct Codec<GlFunction::GenBuffers> : GenCodec<0, 1, GlNameType::BUFFER> {};
+template <> struct Codec<GlFunction::GenFramebuffers> : GenCodec<0, 1, GlNameType::FRAMEBUFFER> {};
+template <> struct Codec<GlFunction::GenQueries> : GenCodec<0, 1, GlNameType::QUERY> {};
+template <> struct Codec<GlFunction::GenSamplers> : GenCodec<0, 1, GlNameType::SAMPLER> {};
+template <> struct Codec<GlFunction::GenTextures> : GenCodec<0, 1, GlNameType::TEXTURE> {};
+template <> struct Codec<GlFunction::GenVertexArrays> : GenCodec<0, 1, GlNameType::VERTEX_ARRAY> {};
+template <> struct Codec<GlFunction::CreateBuffers> : GenCodec<0, 1, GlNameType::BUFFER> {};
+template <> struct Codec<GlFunction::CreateFramebuffers> : GenCodec<0, 1, GlNameType::FRAMEBUFFER> {};
+template <> struct Codec<GlFunction::CreateSamplers> : GenCodec<0, 1, GlNameType::SAMPLER> {};
+template <> struct Codec<GlFunction::CreateVertexArrays> : GenCodec<0, 1, GlNameType::VERTEX_ARRAY> {};
+template <> struct Codec<GlFunction::CreateTextures> : GenCodec<1, 2, GlNameType::TEXTURE> {};
+template <> struct Codec<GlFunction::CreateShader> : CreateCodec {};
+template <> struct Codec<GlFunction::CreateProgram> : CreateCodec {};
+template <> struct Codec<GlFunction::MapBufferRange> : MapCodec<false> {};
+template <> struct Codec<GlFunction::MapNamedBufferRange> : MapCodec<true> {};
+template <> struct Codec<GlFunction::UnmapBuffer> : UnmapCodec<false> {};
+template <> struct Codec<GlFunction::UnmapNamedBuffer> : UnmapCodec<true> {};
+
+template <>
+struct Codec<GlFunction::BindBuffer> : DefaultCodec {
+  template <typename Tuple>
+  static void write(GlCapture& capture, Void, const Tuple& args) {
+    Access::bind_buffer(capture, std::get<0>(args), std::get<1>(args));
+  }
+};
+
+template <>
+struct Codec<GlFunction::FenceSync> : DefaultCodec {
+  template <typename Tuple>
+  static void write(GlCapture& capture, GLsync result, const Tuple&) {
+    Access::write<uint64_t>(capture, Access::add_sync(capture, result));
+  }
+
+  template <typename Tuple>
+  static void read(GlReplayer& replayer, Tuple&) {
+    Access::expected(replayer) = Access::read_bytes(replayer, sizeof(uint64_t));
+  }
+
+  template <typename Tuple>
+  static bool check(GlReplayer& replayer, GLsync result, const Tuple&) {
+    uint64_t id = 0;
+    std::memcpy(&id, Access::expected(replayer), sizeof(uint64_t));
+    Access::syncs(replayer)[id] = result;
+    return true;
+  }
+};
+
+template <>
+struct Codec<GlFunction::DeleteSync> : DefaultCodec {
+  template <typename Tuple>
+  static void write(GlCapture& capture, Void, const Tuple& args) {
+    Access::erase_sync(capture, std::get<0>(args));
+  }
+
+  template <typename Tuple>
+  static bool check(GlReplayer& replayer, Void, const Tuple& args) {
+    std::erase_if(Access::syncs(replayer), [&](const auto& pair) {
+      return pair.second == std::get<0>(args);
+    });
+    return true;
+  }
+};
+
+template <>
+struct Codec<GlFunction::ShaderSource> : DefaultCodec {
+  template <typename Tuple>
+  static void write(GlCapture& capture, Void, const Tuple& args) {
+    const auto [shader, count, strings, lengths] = args;
+    for (GLsizei i = 0; i < count; ++i) {
+      const size_t length = lengths && lengths[i] >= 0 ? static_cast<size_t>(lengths[i]) : std::strlen(strings[i]);
+      Access::write_payload(capture, strings[i], length);
+    }
+  }
+
+  template <typename Tuple>
+  static void read(GlReplayer& replayer, Tuple& args) {
+    auto& strings = Access::strings(replayer);
+    auto& lengths = Access::lengths(replayer);
+    strings.clear();
+    lengths.clear();
+    for (GLsizei i = 0; i < std::get<1>(args); ++i) {
+      size_t size = 0;
+      strings.push_back(reinterpret_cast<const GLchar*>(Access::read_payload(replayer, &size)));
+      lengths.push_back(static_cast<GLint>(size));
+    }
+    std::get<2>(args) = strings.data();
+    std::get<3>(args) = lengths.data();
+  }
+};
+
+template <>
+struct Codec<GlFunction::ShaderBinary> : DefaultCodec {
+  template <typename Tuple>
+  static void write(GlCapture& capture, Void, const Tuple& args) {
+    Access::write_payload(capture, std::get<1>(args), static_cast<size_t>(std::get<0>(args)) * sizeof(GLuint));
+    Access::write_payload(capture, std::get<3>(args), static_cast<size_t>(std::get<4>(args)));
+  }
+
+  template <typename Tuple>
+  static void read(GlReplayer& replayer, Tuple& args) {
+    NamesCodec<1, 0, GlNameType::PROGRAM, false>::read(replayer, args);
+    std::get<3>(args) = Access::read_payload(replayer);
+  }
+};
+
+template <>
+struct Codec<GlFunction::SpecializeShader> : DefaultCodec {
+  template <typename Tuple>
+  static void write(GlCapture& capture, Void, const Tuple& args) {
+    const auto [shader, entry_point, count, indices, values] = args;
+    Access::write_payload(capture, entry_point, entry_point ? std::strlen(entry_point) + 1 : 0);
+    Access::write_payload(capture, indices, count * sizeof(GLuint));
+    Access::write_payload(capture, values, count * sizeof(GLuint));
+  }
+
+  template <typename Tuple>
+  static void read(GlReplayer& replayer, Tuple& args) {
+    std::get<1>(args) = reinterpret_cast<const GLchar*>(Access::read_payload(replayer));
+    std::get<3>(args) = reinterpret_cast<const GLuint*>(Access::read_payload(replayer));
+    std::get<4>(args) = reinterpret_cast<const GLuint*>(Access::read_payload(replayer));
+  }
+};
+
+/**
+ * @brief 記録してから元の関数を呼び出す
+ */
+#define GARIE_GL_CAPTURE_ENTRY(ret, name, params, args) \
+  ret GLAPIENTRY capture_##name params { \
+    return Access::record<GlFunction::name>(&GlTable::name GARIE_GL_TRACE_ARGS args); \
+  }
+GARIE_GL_FUNCTIONS(GARIE_GL_CAPTURE_ENTRY)
+#undef GARIE_GL_CAPTURE_ENTRY
+}  // namespace
+
+template <GlFunction F, typename R, typename... A>
+R detail::GlTraceAccess::record(R (GLAPIENTRY* GlTable::* member)(A...), std::type_identity_t<A>... args) {
+  GlCapture& capture = GlCapture::get();
+  const auto function = capture.inner_table_.*member;
+  if (!capture.recording_ || is_query(F)) return function(args...);
+
+  // GPUが読む前に、マップしたバッファへの書き込みを記録する
+  if constexpr (reads_mapped_memory(F)) flush_mapped(capture);
+
+  const std::tuple<A...> values(args...);
+  write<uint16_t>(capture, static_cast<uint16_t>(F));
+  std::apply([&](auto... value) {
+    (write_arg(capture, value), ...);
+  }, values);
+
+  if constexpr (std::is_void_v<R>) {
+    function(args...);
+    Codec<F>::write(capture, Void{}, values);
+    if (capture.buffer_.size() >= GlCapture::FLUSH_SIZE) flush(capture);
+  } else {
+    R result = function(args...);
+    Codec<F>::write(capture, result, values);
+    if (capture.buffer_.size() >= GlCapture::FLUSH_SIZE) flush(capture);
+    return result;
+  }
+}
+
+template <GlFunction F, typename R, typename... A>
+void detail::GlTraceAccess::replay(GlReplayer& replayer, R (GLAPIENTRY* function)(A...)) {
+  // 波括弧の初期化子は先頭から順に評価される
+  std::tuple<A...> values{read_arg<A>(replayer)...};
+  Codec<F>::read(replayer, values);
+  [&]<size_t... I>(std::index_sequence<I...>) {
+    ((translate_arg<name_type(F, I)>(replayer, std::get<I>(values))), ...);
+  }(std::index_sequence_for<A...>{});
+  if (replayer.failed_) return;
+
+  bool succeeded = false;
+  if constexpr (std::is_void_v<R>) {
+    std::apply(function, values);
+    succeeded = Codec<F>::check(replayer, Void{}, values);
+  } else {
+    const R result = std::apply(function, values);
+    succeeded = Codec<F>::check(replayer, result, values);
+  }
+  if (!succeeded) {
+    RT_ERROR("再生に失敗した (function:{}, pos:{})", GlDispatch::function_name(F), replayer.pos_);
+    replayer.failed_ = true;
+  }
+}
+
+bool GlCapture::open(const std::filesystem::path& path, uint32_t width, uint32_t height) {
+  close();
+  ofs_.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!ofs_) {
+    RT_ERROR("ファイルのオープンに失敗した (path:{})", path.string());
+    return false;
+  }
+
+  GlTraceHeader header;
+  header.function_hash = function_hash();
+  header.width = width;
+  header.height = height;
+  ofs_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  path_ = path;
+  buffer_.clear();
+  written_size_ = 0;
+  recording_ = true;
+  in_frames_ = false;
+  remaining_frame_count_ = 0;
+  bound_buffers_.clear();
+  sync_ids_.clear();
+  next_sync_id_ = 1;
+  mappings_.clear();
+  return true;
+}
+
+void GlCapture::add_written_range(const void* data, size_t size) {
+  const auto address = reinterpret_cast<uintptr_t>(data);
+  for (auto& mapping : mappings_) {
+    const auto mapped = reinterpret_cast<uintptr_t>(mapping.data);
+    if (address < mapped || address >= mapped + mapping.size) continue;
+    const size_t begin = address - mapped;
+    const size_t end = std::min(begin + size, mapping.size);
+
+    // リングバッファは前から順に割り当てるので、重なるか続いていれば前の範囲に含める
+    auto& ranges = mapping.written_ranges;
+    if (!ranges.empty() && ranges.back().first <= begin && begin <= ranges.back().second) {
+      ranges.back().second = std::max(ranges.back().second, end);
+    } else {
+      ranges.emplace_back(begin, end);
+    }
+    return;
+  }
+}
+
+void GlCapture::wrap(GlTable& table) {
+  inner_table_ = table;
+#define GARIE_GL_CAPTURE_LOAD_ENTRY(ret, name, params, args) table.name = capture_##name;
+  GARIE_GL_FUNCTIONS(GARIE_GL_CAPTURE_LOAD_ENTRY)
+#undef GARIE_GL_CAPTURE_LOAD_ENTRY
+}
+
+void GlCapture::begin_frames(uint32_t frame_count) {
+  if (!recording_) return;
+  detail::GlTraceAccess::write<uint16_t>(*this, static_cast<uint16_t>(GlTraceOp::BEGIN_FRAMES));
+  in_frames_ = true;
+  remaining_frame_count_ = frame_count;
+  begin_tp_ = std::chrono::steady_clock::now();
+  if (remaining_frame_count_ == 0) close();
+}
+
+void GlCapture::end_frame() {
+  if (!recording_ || !in_frames_) return;
+  const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin_tp_);
+  detail::GlTraceAccess::write<uint16_t>(*this, static_cast<uint16_t>(GlTraceOp::FRAME_END));
+  detail::GlTraceAccess::write<uint64_t>(*this, static_cast<uint64_t>(elapsed.count()));
+  if (--remaining_frame_count_ == 0) close();
+}
+
+bool GlCapture::close() {
+  if (!recording_) return true;
+  detail::GlTraceAccess::write<uint16_t>(*this, static_cast<uint16_t>(GlTraceOp::END));
+  detail::GlTraceAccess::flush(*this);
+  recording_ = false;
+  in_frames_ = false;
+  mappings_.clear();
+  ofs_.close();
+  if (!ofs_) {
+    RT_ERROR("ファイルへの書き込みに失敗した (path:{})", path_.string());
+    return false;
+  }
+  RT_DEBUG("GLの呼び出しを記録した (path:{}, size:{}KiB)", path_.string(), written_size_ >> 10);
+  return true;
+}
+
+bool GlReplayer::open(const std::filesystem::path& path) {
+  std::ifstream ifs(path, std::ios::in | std::ios::binary);
+  if (!ifs) {
+    RT_ERROR("ファイルのオープンに失敗した (path:{})", path.string());
+    return false;
+  }
+  if (!ifs.read(reinterpret_cast<char*>(&header_), sizeof(header_))) {
+    RT_ERROR("トレースファイルではない (path:{})", path.string());
+    return false;
+  }
+  const GlTraceHeader expected;
+  if (std::memcmp(header_.magic, expected.magic, sizeof(expected.magic)) != 0 || header_.version != expected.version) {
+    RT_ERROR("トレースファイルではないか、形式が異なる (path:{})", path.string());
+    return false;
+  }
+  if (header_.function_hash != function_hash()) {
+    RT_ERROR("記録したときとGLの関数の並びが異なる (path:{})", path.string());
+    return false;
+  }
+
+  ifs.seekg(0, std::ios::end);
+  const auto end = static_cast<size_t>(ifs.tellg());
+  ifs.seekg(sizeof(header_), std::ios::beg);
+  data_.resize(end - sizeof(header_));
+  if (!ifs.read(reinterpret_cast<char*>(data_.data()), static_cast<std::streamsize>(data_.size()))) {
+    RT_ERROR("ファイルの読み込みに失敗した (path:{})", path.string());
+    return false;
+  }
+
+  pos_ = 0;
+  failed_ = false;
+  ended_ = false;
+  syncs_.clear();
+  mapped_.clear();
+  for (auto& map : name_maps_) map.clear();
+  RT_DEBUG("トレースファイルを読み込んだ (path:{}, size:{}x{}, {}KiB)", path.string(), header_.width, header_.height, data_.size() >> 10);
+  return true;
+}
+
+bool GlReplayer::replay_setup() {
+  while (!failed_ && !ended_) {
+    const uint16_t op = replay_record();
+    if (op == static_cast<uint16_t>(GlTraceOp::BEGIN_FRAMES)) return true;
+    if (op == static_cast<uint16_t>(GlTraceOp::END)) ended_ = true;
+  }
+  return !failed_;
+}
+
+bool GlReplayer::replay_frame(uint64_t& timestamp) {
+  while (!failed_ && !ended_) {
+    const uint16_t op = replay_record();
+    if (op == static_cast<uint16_t>(GlTraceOp::FRAME_END)) {
+      timestamp = detail::GlTraceAccess::read<uint64_t>(*this);
+      return !failed_;
+    }
+    if (op == static_cast<uint16_t>(GlTraceOp::END)) ended_ = true;
+  }
+  return false;
+}
+
+uint16_t GlReplayer::replay_record() {
+  using Access = detail::GlTraceAccess;
+  const auto op = Access::read<uint16_t>(*this);
+  if (failed_) return op;
+
+  if (op < static_cast<uint16_t>(GlFunction::COUNT)) {
+    switch (static_cast<GlFunction>(op)) {
+#define GARIE_GL_REPLAY_ENTRY(ret, name, params, args) \
+      case GlFunction::name: \
+        Access::replay<GlFunction::name>(*this, gl_table.name); \
+        break;
+      GARIE_GL_FUNCTIONS(GARIE_GL_REPLAY_ENTRY)
+#undef GARIE_GL_REPLAY_ENTRY
+      default:
+        break;
+    }
+    return op;
+  }
+
+  switch (static_cast<GlTraceOp>(op)) {
+    case GlTraceOp::MEMORY: {
+      const auto buffer = Access::read<GLuint>(*this);
+      const auto offset = static_cast<size_t>(Access::read<uint64_t>(*this));
+      size_t size = 0;
+      const std::byte* data = Access::read_payload(*this, &size);
+      auto iter = mapped_.find(buffer);
+      if (iter == mapped_.end()) {
+        RT_ERROR("マップしていないバッファへの書き込み (buffer:{}, pos:{})", buffer, pos_);
+        failed_ = true;
+      } else if (offset > iter->second.size() || size > iter->second.size() - offset) {
+        // 壊れたトレースでマップ先の外に書き込まないようにする
+        RT_ERROR("マップした範囲の外への書き込み (buffer:{}, offset:{}, size:{}, mapped:{}, pos:{})",
+                 buffer, offset, size, iter->second.size(), pos_);
+        failed_ = true;
+      } else if (data) {
+        std::memcpy(iter->second.data() + offset, data, size);
+      }
+      break;
+    }
+    case GlTraceOp::BEGIN_FRAMES:
+    case GlTraceOp::FRAME_END:
+    case GlTraceOp::END:
+      break;
+    default:
+      RT_ERROR("不明なレコード (op:{:#x}, pos:{})", op, pos_);
+      failed_ = true;
+      break;
+  }
+  return op;
+}
+}  // namespace garie
@@ -0,0 +1,171 @@
+#include <rtdemo/gpu_profiler.hpp>
+#include <fstream>
+#include <imgui.h>
+#include <rtdemo/logging.hpp>
+
+namespace rtdemo {
+namespace {
+constexpr double AVERAGE_WEIGHT = 0.05;  // 平滑化で新しい値にかける重み
+}  // namespace
+
+GpuProfiler& GpuProfiler::get() noexcept {
+  static GpuProfiler self;
+  return self;
+}
+
+void GpuProfiler::invalidate() {
+  for (auto& frame : frames_) {
+    frame = Frame{};
+  }
+  passes_.clear();
+  depth_ = 0;
+  in_frame_ = false;
+}
+
+void GpuProfiler::begin_frame() {
+  if (!enabled_) return;
+
+  // 使い回すフレームの結果を読み出す
+  Frame& frame = frames_[current_];
+  resolve(frame);
+
+  frame.index = frame_index_;
+  frame.query_count = 0;
+  frame.events.clear();
+  depth_ = 0;
+  in_frame_ = true;
+}
+
+void GpuProfiler::end_frame() {
+  if (!in_frame_) return;
+
+  Frame& frame = frames_[current_];
+  frame.pending = !frame.events.empty();
+  in_frame_ = false;
+
+  current_ = (current_ + 1) % FRAME_LATENCY;
+  frame_index_++;
+}
+
+size_t GpuProfiler::begin(const char* name) {
+  if (!in_frame_) return INVALID_INDEX;
+
+  Frame& frame = frames_[current_];
+  const size_t index = frame.events.size();
+  frame.events.push_back(Event{
+      name,
+      depth_,
+      timestamp(frame),
+      INVALID_INDEX,
+  });
+  depth_++;
+  return index;
+}
+
+void GpuProfiler::end(size_t index) {
+  if (!in_frame_ || index == INVALID_INDEX) return;
+
+  Frame& frame = frames_[current_];
+  if (index >= frame.events.size()) return;
+  frame.events[index].end_query = timestamp(frame);
+  depth_--;
+}
+
+size_t GpuProfiler::timestamp(Frame& frame) {
+  // 足りなければクエリを追加する
+  if (frame.query_count >= frame.queries.size()) {
+    garie::ResourceTracker::Scope scope("gpu profiler");
+    garie::Query query;
+    query.gen();
+    frame.queries.push_back(std::move(query));
+  }
+  const size_t index = frame.query_count++;
+  frame.queries[index].timestamp();
+  return index;
+}
+
+void GpuProfiler::resolve(Frame& frame) {
+  if (!frame.pending) return;
+  frame.pending = false;
+
+  // 最後に発行したクエリが完了していれば、それ以前のクエリも完了している
+  if (!frame.queries[frame.query_count - 1].available()) {
+    dropped_frame_count_++;
+    return;
+  }
+
+  // 前回と同じパスの並びであれば平滑化する
+  bool same_layout = passes_.size() == frame.events.size();
+  for (size_t i = 0; same_layout && i < frame.events.size(); ++i) {
+    same_layout = passes_[i].name == frame.events[i].name;
+  }
+  if (!same_layout) passes_.assign(frame.events.size(), Pass{});
+
+  for (size_t i = 0; i < frame.events.size(); ++i) {
+    const Event& event = frame.events[i];
+    Pass& pass = passes_[i];
+    double time = 0.0;
+    if (event.end_query != INVALID_INDEX) {
+      const GLuint64 begin_ns = frame.queries[event.begin_query].result();
+      const GLuint64 end_ns = frame.queries[event.end_query].result();
+      time = end_ns > begin_ns ? (end_ns - begin_ns) * 1e-6 : 0.0;
+    }
+    pass.name = event.name;
+    pass.depth = event.depth;
+    pass.time = time;
+    pass.average_time = same_layout ? pass.average_time + (time - pass.average_time) * AVERAGE_WEIGHT : time;
+  }
+  resolved_frame_index_ = frame.index;
+}
+
+void GpuProfiler::update_gui() {
+  ImGui::Begin("GPU Profiler");
+  ImGui::Checkbox("enabled", &enabled_);
+  ImGui::SameLine();
+  if (ImGui::Button("export")) save("gpu_profile.json");
+  ImGui::Text("frame:%llu dropped:%llu",
+              static_cast<unsigned long long>(resolved_frame_index_),
+              static_cast<unsigned long long>(dropped_frame_count_));
+  ImGui::Separator();
+  ImGui::Columns(3, "passes");
+  ImGui::Text("pass");
+  ImGui::NextColumn();
+  ImGui::Text("time[ms]");
+  ImGui::NextColumn();
+  ImGui::Text("ave.[ms]");
+  ImGui::NextColumn();
+  ImGui::Separator();
+  for (const auto& pass : passes_) {
+    ImGui::Text("%*s%s", static_cast<int>(pass.depth * 2), "", pass.name);
+    ImGui::NextColumn();
+    ImGui::Text("%7.3f", pass.time);
+    ImGui::NextColumn();
+    ImGui::Text("%7.3f", pass.average_time);
+    ImGui::NextColumn();
+  }
+  ImGui::Columns(1);
+  ImGui::End();
+}
+
+bool GpuProfiler::save(const std::filesystem::path& path) const {
+  std::ofstream ofs(path, std::ios::out | std::ios::trunc);
+  if (!ofs) {
+    RT_ERROR("ファイルのオープンに失敗した (path:{})", path.string());
+    return false;
+  }
+
+  ofs << "{\n";
+  ofs << fmt::format("  \"frame\": {},\n", resolved_frame_index_);
+  ofs << "  \"passes\": [\n";
+  for (size_t i = 0; i < passes_.size(); ++i) {
+    const auto& pass = passes_[i];
+    ofs << fmt::format(
+        "    {{\"name\": \"{}\", \"depth\": {}, \"gpu_ms\": {:.6f}, \"average_gpu_ms\": {:.6f}}}{}\n",
+        pass.name, pass.depth, pass.time, pass.average_time,
+        i + 1 < passes_.size() ? "," : "");
+  }
+  ofs << "  ]\n";
+  ofs << "}\n";
+  return static_cast<bool>(ofs);
+}
+}  // namespace rtdemo
@@ -8,6 +8,7 @@
 #include <GLFW/glfw3native.h>
 #include <imgui.h>
 #include <rtdemo/logging.hpp>
+#include <rtdemo/cpu_profiler.hpp>
 
 namespace rtdemo {
 namespace {
@@ -26,6 +27,7 @@ bool Gui::init(GLFWwindow* window) {
   auto _ = gsl::finally([&, this] {
     if (!succeeded) terminate();
   });
+  garie::ResourceTracker::Scope scope("gui");
 
   // コンテキストを生成する
   IMGUI_CHECKVERSION();
@@ -135,25 +137,22 @@ bool Gui::init(GLFWwindow* window) {
 
   // ステートを生成する
   rs_ =
-      garie::RasterizationStateBuilder().cull_mode(GL_NONE).build();
+      &garie::RasterizationStateBuilder().cull_mode(GL_NONE).build_shared();
   cbs_ =
-      garie::ColorBlendStateBuilder()
+      &garie::ColorBlendStateBuilder()
           .enable(0, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_FUNC_ADD,
                   GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_FUNC_ADD,
                   {GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE})
-          .build();
-  dss_ = garie::DepthStencilStateBuilder().build();
+          .build_shared();
+  dss_ = &garie::DepthStencilStateBuilder().build_shared();
 
   // インデックスバッファを生成する
   ib_.gen();
-  ib_.bind(GL_ELEMENT_ARRAY_BUFFER);
-  glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, INDEX_BUFFER_SIZE, nullptr,
-                  GL_MAP_WRITE_BIT);
+  ib_.storage(INDEX_BUFFER_SIZE, nullptr, GL_MAP_WRITE_BIT);
 
   // 頂点バッファを生成する
   vb_.gen();
-  vb_.bind(GL_ARRAY_BUFFER);
-  glBufferStorage(GL_ARRAY_BUFFER, VERTEX_BUFFER_SIZE, nullptr, GL_MAP_WRITE_BIT);
+  vb_.storage(VERTEX_BUFFER_SIZE, nullptr, GL_MAP_WRITE_BIT);
 
   // VAOを生成する
   va_ = garie::VertexArrayBuilder()
@@ -174,11 +173,9 @@ bool Gui::init(GLFWwindow* window) {
   io.Fonts->AddFontFromFileTTF("assets/fonts/migu-1m-regular.ttf", 14.f,
                                nullptr, io.Fonts->GetGlyphRangesJapanese());
   io.Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
-  font_tex_.gen();
-  font_tex_.bind(GL_TEXTURE_2D);
-  glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, width, height);
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED,
-                  GL_UNSIGNED_BYTE, pixels);
+  font_tex_.gen(GL_TEXTURE_2D);
+  font_tex_.storage_2d(1, GL_R8, width, height);
+  font_tex_.sub_image_2d(0, 0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE, pixels);
   // glGenerateMipmap(GL_TEXTURE_2D);
   io.Fonts->TexID = reinterpret_cast<void*>(static_cast<intptr_t>(font_tex_.id()));
   io.Fonts->ClearTexData();
@@ -187,7 +184,7 @@ bool Gui::init(GLFWwindow* window) {
   font_ss_ = garie::SamplerBuilder()
                                .min_filter(GL_NEAREST)
                                .mag_filter(GL_NEAREST)
-                               .build();
+                               .build_shared();
 
   // 後始末
   window_ = window;
@@ -209,6 +206,8 @@ void Gui::terminate() {
 }
 
 void Gui::new_frame() {
+  RT_CPU_SCOPE("Gui::new_frame");
+
   ImGuiIO& io = ImGui::GetIO();
 
   // ディスプレイサイズを設定する
@@ -229,6 +228,7 @@ void Gui::new_frame() {
   time_ = current_time;
 
   // マウスカーソルの位置を更新する
+  input_tp_ = std::chrono::steady_clock::now();
   const ImVec2 mouse_pos = io.MousePos;
   io.MousePos = ImVec2(-FLT_MAX, -FLT_MAX);
   if (glfwGetWindowAttrib(window_, GLFW_FOCUSED)) {
@@ -253,6 +253,8 @@ void Gui::new_frame() {
 }
 
 void Gui::render() {
+  RT_CPU_SCOPE("Gui::render");
+
   ImGui::Render();
 
   ImDrawData* draw_data = ImGui::GetDrawData();
@@ -267,18 +269,18 @@ void Gui::render() {
 
   // パイプラインをバインドする
   prog_.use();
-  rs_.apply();
-  cbs_.apply();
-  dss_.apply();
+  rs_->apply();
+  cbs_->apply();
+  dss_->apply();
 
   // 動的ステートを設定する
-  glEnable(GL_SCISSOR_TEST);
+  garie::StateCache::get().enable(GL_SCISSOR_TEST, true);
   glViewport(0, 0, fb_width, fb_height);
 
   // リソースをバインドする
   va_.bind();
   font_tex_.active(0, GL_TEXTURE_2D);
-  font_ss_.bind(0);
+  font_ss_->bind(0);
 
   // スケーリング行列をアップロードする
   const float ortho_projection[16] = {
@@ -308,23 +310,20 @@ void Gui::render() {
     
     // インデックスデータを書き込む
     // TODO:一度のMapですべてのデータをコピーする
-    ib_.bind(GL_ELEMENT_ARRAY_BUFFER);
-    void* ib_data = 
-        glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0,
-                         cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx),
-                         GL_MAP_WRITE_BIT);
+    void* ib_data =
+        ib_.map(0, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx),
+                GL_MAP_WRITE_BIT);
     memcpy(ib_data, cmd_list->IdxBuffer.Data,
            cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
-    glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+    ib_.unmap();
 
     // 頂点データを書き込む
-    vb_.bind(GL_ARRAY_BUFFER);
-    void* vb_data = glMapBufferRange(
-        GL_ARRAY_BUFFER, 0, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert),
+    void* vb_data = vb_.map(
+        0, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert),
         GL_MAP_WRITE_BIT);
     memcpy(vb_data, cmd_list->VtxBuffer.Data,
            cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
-    glUnmapBuffer(GL_ARRAY_BUFFER);
+    vb_.unmap();
 
     // 描画する
     for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++) {
@@ -345,7 +344,7 @@ void Gui::render() {
   }
 
   // ステートを戻す
-  glDisable(GL_SCISSOR_TEST);
+  garie::StateCache::get().enable(GL_SCISSOR_TEST, false);
 }
 
 void Gui::on_mouse_button(int button, int action, int mods) {
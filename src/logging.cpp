@@ -25,7 +25,7 @@ bool Logger::init(spdlog::level::level_enum level) {
 
 void Logger::terminate() {
   // ログを確認するためにコンソールへのキー入力を要求する
-  if (max_level_ >= spdlog::level::warn) {
+  if (pause_on_terminate_ && max_level_ >= spdlog::level::warn) {
 #ifdef WIN32
     system("PAUSE");
 #else
@@ -1,18 +1,223 @@
+#include <string>
+#include <string_view>
+#include <cstdlib>
 #include <rtdemo/logging.hpp>
 #include <rtdemo/application.hpp>
+#include <rtdemo/benchmark.hpp>
+#include <rtdemo/gl_trace.hpp>
+#include <rtdemo/util.hpp>
 
 using namespace rtdemo;
 
-int main() {
+namespace {
+constexpr uint64_t MAX_SCREEN_SIZE = 16384;  ///< バックバッファの幅と高さの上限
+
+/**
+ * @brief コマンドライン引数で指定できる設定
+ */
+struct Options {
+  bool benchmark = false;  ///< ベンチマークモードで動作するか
+  BenchmarkDesc benchmark_desc;  ///< ベンチマークの設定
+  uint32_t max_frames_in_flight = FrameLimiter::DEFAULT_MAX_FRAMES_IN_FLIGHT;  ///< GPUに積むフレーム数の上限
+  garie::GlDispatch::Backend gl_backend = garie::GlDispatch::Backend::REAL;  ///< GLの呼び出し先
+  bool count_gl_calls = false;  ///< GLの呼び出し回数を数えるか
+};
+
+void print_usage(const char* program) {
+  fmt::print(
+      "usage: {} [options]\n"
+      "  --benchmark          GUIを使わずにオフスクリーンで計測する\n"
+      "  --scene NAME         計測するシーン名\n"
+      "  --technique NAME     計測するテクニック名\n"
+      "  --width N            バックバッファの幅(1-16384) (既定値:1280)\n"
+      "  --height N           バックバッファの高さ(1-16384) (既定値:720)\n"
+      "  --frames N           計測するフレーム数 (既定値:300)\n"
+      "  --warmup N           計測前に捨てるフレーム数 (既定値:10)\n"
+      "  --budget MS          ヒッチとみなすフレーム時間 (既定値:16.667)\n"
+      "  --output PATH        結果を書き出すJSONファイル (既定値:benchmark.json)\n"
+      "  --trace PATH         CPUトレースを書き出すJSONファイル\n"
+      "  --frames-in-flight N GPUに積むフレーム数の上限(0-8)。0ならリングバッファの領域数の8まで積む (既定値:2)\n"
+      "  --gl-backend NAME    GLの呼び出し先。real/noop。noopはベンチマークでのみ使える (既定値:real)\n"
+      "  --count-gl-calls     GLの呼び出し回数を関数ごとに数える\n"
+      "  --capture PATH       GLの呼び出しを記録するトレースファイル。gl_replayで再生できる\n"
+      "  --capture-frames N   記録する計測フレーム数。0ならすべて (既定値:0)\n"
+      "  --shader-dir PATH    シェーダファイルを探すディレクトリ\n",
+      program);
+}
+
+/**
+ * @brief コマンドライン引数を解析する
+ * 
+ * @return true 成功した
+ * @return false 失敗した
+ */
+bool parse_options(int argc, char** argv, Options& options) {
+  auto& desc = options.benchmark_desc;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const auto value = [&]() -> const char* {
+      if (i + 1 >= argc) {
+        RT_ERROR("引数の値がない (option:{})", arg);
+        return nullptr;
+      }
+      return argv[++i];
+    };
+    const auto number = [&](auto& dst) {
+      const char* str = value();
+      if (!str) return false;
+      try {
+        dst = static_cast<std::remove_reference_t<decltype(dst)>>(std::stoull(str));
+      } catch (const std::exception&) {
+        RT_ERROR("引数の値が数値ではない (option:{}, value:{})", arg, str);
+        return false;
+      }
+      return true;
+    };
+    const auto screen_size = [&](uint32_t& dst) {
+      // 負の値はstoullで大きな値になるので、上限で弾く
+      uint64_t size = 0;
+      if (!number(size)) return false;
+      if (size == 0 || size > MAX_SCREEN_SIZE) {
+        RT_ERROR("バックバッファの大きさが範囲外 (option:{}, value:{}, max:{})", arg, argv[i], MAX_SCREEN_SIZE);
+        return false;
+      }
+      dst = static_cast<uint32_t>(size);
+      return true;
+    };
+
+    if (arg == "--benchmark") {
+      options.benchmark = true;
+    } else if (arg == "--scene") {
+      const char* str = value();
+      if (!str) return false;
+      desc.scene_name = str;
+    } else if (arg == "--technique") {
+      const char* str = value();
+      if (!str) return false;
+      desc.technique_name = str;
+    } else if (arg == "--width") {
+      if (!screen_size(desc.screen_width)) return false;
+    } else if (arg == "--height") {
+      if (!screen_size(desc.screen_height)) return false;
+    } else if (arg == "--frames") {
+      if (!number(desc.frame_count)) return false;
+    } else if (arg == "--warmup") {
+      if (!number(desc.warmup_frame_count)) return false;
+    } else if (arg == "--budget") {
+      const char* str = value();
+      if (!str) return false;
+      try {
+        desc.frame_budget = std::stod(str);
+      } catch (const std::exception&) {
+        RT_ERROR("引数の値が数値ではない (option:{}, value:{})", arg, str);
+        return false;
+      }
+    } else if (arg == "--output") {
+      const char* str = value();
+      if (!str) return false;
+      desc.output_path = str;
+    } else if (arg == "--trace") {
+      const char* str = value();
+      if (!str) return false;
+      desc.trace_path = str;
+    } else if (arg == "--frames-in-flight") {
+      if (!number(options.max_frames_in_flight)) return false;
+    } else if (arg == "--gl-backend") {
+      const char* str = value();
+      if (!str) return false;
+      const std::string_view name = str;
+      if (name == "real") {
+        options.gl_backend = garie::GlDispatch::Backend::REAL;
+      } else if (name == "noop") {
+        options.gl_backend = garie::GlDispatch::Backend::NOOP;
+      } else {
+        RT_ERROR("不明なGLの呼び出し先 (value:{})", name);
+        return false;
+      }
+    } else if (arg == "--count-gl-calls") {
+      options.count_gl_calls = true;
+    } else if (arg == "--capture") {
+      const char* str = value();
+      if (!str) return false;
+      desc.capture_path = str;
+    } else if (arg == "--capture-frames") {
+      if (!number(desc.capture_frame_count)) return false;
+    } else if (arg == "--shader-dir") {
+      const char* str = value();
+      if (!str) return false;
+      util::set_shader_search_path(str);
+    } else {
+      RT_ERROR("不明な引数 (arg:{})", arg);
+      return false;
+    }
+  }
+
+  if (options.benchmark && (desc.scene_name.empty() || desc.technique_name.empty())) {
+    RT_ERROR("ベンチマークにはシーン名とテクニック名が必要");
+    return false;
+  }
+  if (!options.benchmark && !desc.capture_path.empty()) {
+    // 準備からのすべての呼び出しを記録するので、終わりの決まったベンチマークでのみ記録する
+    RT_ERROR("GLの呼び出しはベンチマークでのみ記録できる");
+    return false;
+  }
+  if (!options.benchmark && options.gl_backend == garie::GlDispatch::Backend::NOOP) {
+    // GUIはGLの呼び出し先を経由せずに描画するので、ウィンドウでは使えない
+    RT_ERROR("何もしないGLの呼び出し先はベンチマークでのみ使える");
+    return false;
+  }
+  return true;
+}
+
+int run_benchmark(const Options& options) {
+  const auto& desc = options.benchmark_desc;
+  garie::GlDispatch::get().select(options.gl_backend, options.count_gl_calls);
+  if (!desc.capture_path.empty() && !garie::GlCapture::get().open(desc.capture_path, desc.screen_width, desc.screen_height)) {
+    return EXIT_FAILURE;
+  }
+  if (!Application::get().init_headless(desc.screen_width, desc.screen_height)) {
+    // 書き出していないレコードと終わりのレコードを残して閉じる
+    garie::GlCapture::get().close();
+    return EXIT_FAILURE;
+  }
+  Application::get().frame_limiter().set_max_frames_in_flight(options.max_frames_in_flight);
+
+  Benchmark benchmark(desc);
+  const bool succeeded = benchmark.run() && benchmark.save();
+
+  Application::get().terminate();
+  return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
   // 初期化
   if (!Logger::get().init(spdlog::level::trace)) return EXIT_FAILURE;
-  if (!Application::get().init(1280, 720)) return EXIT_FAILURE;
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    print_usage(argv[0]);
+    Logger::get().set_pause_on_terminate(false);
+    Logger::get().terminate();
+    return EXIT_FAILURE;
+  }
 
-  // メインループ
-  while (Application::get().update()) {
-    std::this_thread::yield();
+  // ベンチマークモードでは入力を待たない
+  if (options.benchmark) {
+    Logger::get().set_pause_on_terminate(false);
+    const int result = run_benchmark(options);
+    Logger::get().terminate();
+    return result;
   }
 
+  const auto& desc = options.benchmark_desc;
+  garie::GlDispatch::get().select(options.gl_backend, options.count_gl_calls);
+  if (!Application::get().init(desc.screen_width, desc.screen_height)) return EXIT_FAILURE;
+  Application::get().frame_limiter().set_max_frames_in_flight(options.max_frames_in_flight);
+
+  // メインループ
+  // シーンの更新はワーカースレッドで行い、待ちはFramePipelineが条件変数で行う
+  while (Application::get().update()) {}
+
   // 破棄
   Application::get().terminate();
   Logger::get().terminate();
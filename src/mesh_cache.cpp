@@ -0,0 +1,195 @@
+#include <rtdemo/mesh_cache.hpp>
+#include <fstream>
+#include <system_error>
+#include <utility>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <rtdemo/logging.hpp>
+
+namespace rtdemo::util {
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0))
+#ifdef _WIN32
+      , mapping_(std::exchange(other.mapping_, nullptr))
+#endif
+{
+}
+
+MappedFile::~MappedFile() noexcept {
+  close();
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    close();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+#ifdef _WIN32
+    mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+  }
+  return *this;
+}
+
+bool MappedFile::open(const std::filesystem::path& path) {
+  close();
+#ifdef _WIN32
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+  // マッピングオブジェクトがファイルを参照し続けるので、ファイルのハンドルはすぐに閉じてよい
+  HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (!mapping) return false;
+  void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!data) {
+    CloseHandle(mapping);
+    return false;
+  }
+  mapping_ = mapping;
+  data_ = static_cast<const std::byte*>(data);
+  size_ = static_cast<size_t>(size.QuadPart);
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+  // マップした領域はファイルを閉じても残る
+  void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) return false;
+  // すぐに全体を読むので、先読みさせる
+  madvise(data, static_cast<size_t>(st.st_size), MADV_WILLNEED);
+  data_ = static_cast<const std::byte*>(data);
+  size_ = static_cast<size_t>(st.st_size);
+#endif
+  return true;
+}
+
+void MappedFile::close() noexcept {
+  if (!data_) return;
+#ifdef _WIN32
+  UnmapViewOfFile(data_);
+  CloseHandle(mapping_);
+  mapping_ = nullptr;
+#else
+  munmap(const_cast<std::byte*>(data_), size_);
+#endif
+  data_ = nullptr;
+  size_ = 0;
+}
+
+bool MeshCache::open(const std::filesystem::path& path, uint64_t source_hash, uint32_t import_flags) {
+  memory_.clear();
+  bytes_ = {};
+  if (!file_.open(path)) return false;
+  bytes_ = file_.bytes();
+  if (!validate(source_hash, import_flags)) {
+    file_.close();
+    bytes_ = {};
+    return false;
+  }
+  return true;
+}
+
+bool MeshCache::validate(uint64_t source_hash, uint32_t import_flags) const noexcept {
+  const MeshCacheHeader expected;
+  if (bytes_.size() < sizeof(MeshCacheHeader)) return false;
+  const auto& header = this->header();
+  if (std::memcmp(header.magic, expected.magic, sizeof(expected.magic)) != 0 || header.version != expected.version) {
+    RT_DEBUG("メッシュキャッシュの形式が異なる (version:{})", header.version);
+    return false;
+  }
+  if (header.source_hash != source_hash || header.import_flags != import_flags) {
+    RT_DEBUG("メッシュキャッシュが古い (hash:{:#x}, flags:{:#x})", header.source_hash, header.import_flags);
+    return false;
+  }
+  for (const auto& entry : header.sections) {
+    if (entry.size == 0) continue;
+    if (entry.element_size == 0 || entry.size % entry.element_size != 0 || entry.offset % SECTION_ALIGNMENT != 0 ||
+        entry.offset > bytes_.size() || entry.size > bytes_.size() - entry.offset) {
+      RT_WARN("メッシュキャッシュが壊れている (offset:{}, size:{}, file size:{})", entry.offset, entry.size, bytes_.size());
+      return false;
+    }
+  }
+  return true;
+}
+
+void MeshCacheBuilder::add(MeshSection section, const void* data, size_t size, size_t element_size) {
+  // 区画の先頭を揃える
+  body_.resize((body_.size() + MeshCache::SECTION_ALIGNMENT - 1) / MeshCache::SECTION_ALIGNMENT * MeshCache::SECTION_ALIGNMENT);
+  auto& entry = header_.sections[static_cast<size_t>(section)];
+  entry.offset = sizeof(MeshCacheHeader) + body_.size();
+  entry.size = size;
+  entry.element_size = static_cast<uint32_t>(element_size);
+  const auto bytes = static_cast<const std::byte*>(data);
+  body_.insert(body_.end(), bytes, bytes + size);
+}
+
+MeshCache MeshCacheBuilder::build(const std::filesystem::path& path, uint64_t source_hash, uint32_t import_flags) {
+  static_assert(sizeof(MeshCacheHeader) % MeshCache::SECTION_ALIGNMENT == 0);
+  header_.source_hash = source_hash;
+  header_.import_flags = import_flags;
+
+  MeshCache cache;
+  cache.memory_.resize(sizeof(MeshCacheHeader) + body_.size());
+  std::memcpy(cache.memory_.data(), &header_, sizeof(MeshCacheHeader));
+  std::memcpy(cache.memory_.data() + sizeof(MeshCacheHeader), body_.data(), body_.size());
+  cache.bytes_ = cache.memory_;
+  body_.clear();
+  body_.shrink_to_fit();
+
+  // 一時ファイルに書き出してから置き換える
+  auto temp_path = path;
+  temp_path += ".tmp";
+  {
+    std::ofstream ofs(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char*>(cache.memory_.data()), static_cast<std::streamsize>(cache.memory_.size()));
+    if (!ofs) {
+      RT_WARN("メッシュキャッシュを書き出せなかった (path:{})", temp_path.string());
+      return cache;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(temp_path, path, ec);
+  if (ec) {
+    RT_WARN("メッシュキャッシュを置き換えられなかった (path:{}, error:{})", path.string(), ec.message());
+    std::filesystem::remove(temp_path, ec);
+    return cache;
+  }
+  RT_DEBUG("メッシュキャッシュを書き出した (path:{}, size:{}KiB)", path.string(), cache.memory_.size() >> 10);
+  return cache;
+}
+
+uint64_t hash_bytes(std::span<const std::byte> bytes) noexcept {
+  // 8バイトずつ混ぜる
+  constexpr uint64_t PRIME = 0x100000001b3;
+  uint64_t hash = 0xcbf29ce484222325;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= bytes.size(); i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes.data() + i, sizeof(word));
+    hash = (hash ^ word) * PRIME;
+    hash ^= hash >> 29;
+  }
+  for (; i < bytes.size(); ++i) hash = (hash ^ static_cast<uint64_t>(bytes[i])) * PRIME;
+  hash ^= bytes.size();
+  return hash;
+}
+}  // namespace rtdemo::util
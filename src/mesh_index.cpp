@@ -0,0 +1,75 @@
+#include <rtdemo/mesh_index.hpp>
+#include <algorithm>
+#include <numeric>
+#include <rtdemo/logging.hpp>
+
+namespace rtdemo::util {
+namespace {
+/**
+ * @brief すべての頂点を使う1つの塊にする
+ */
+IndexedChunk whole_chunk(GLenum index_type, std::span<const uint32_t> indices, size_t vertex_count) {
+  IndexedChunk chunk;
+  chunk.index_type = index_type;
+  chunk.vertices.resize(vertex_count);
+  std::iota(chunk.vertices.begin(), chunk.vertices.end(), 0u);
+  chunk.indices.assign(indices.begin(), indices.end());
+  return chunk;
+}
+}  // namespace
+
+std::vector<IndexedChunk> choose_index_width(std::span<const uint32_t> indices, size_t vertex_count,
+                                             size_t vertex_size) {
+  std::vector<IndexedChunk> chunks;
+  if (vertex_count <= MAX_SHORT_INDEX_VERTEX_COUNT) {
+    chunks.push_back(whole_chunk(GL_UNSIGNED_SHORT, indices, vertex_count));
+    return chunks;
+  }
+
+  // 三角形を順に詰め、頂点が入りきらなくなったら次の塊にする
+  // 塊ごとに表を消さずに済むように、何番目の塊で割り当てたかを覚えておく
+  constexpr uint32_t UNASSIGNED = UINT32_MAX;
+  std::vector<uint32_t> local_indices(vertex_count, UNASSIGNED);
+  std::vector<uint32_t> chunk_ids(vertex_count, UNASSIGNED);
+  size_t copied_vertex_count = 0;
+  chunks.emplace_back();
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    uint32_t chunk_id = static_cast<uint32_t>(chunks.size() - 1);
+    size_t new_vertex_count = 0;
+    for (size_t k = 0; k < 3; ++k) {
+      if (chunk_ids[indices[i + k]] != chunk_id) new_vertex_count++;
+    }
+    if (chunks.back().vertices.size() + new_vertex_count > MAX_SHORT_INDEX_VERTEX_COUNT) {
+      copied_vertex_count += chunks.back().vertices.size();
+      chunks.emplace_back();
+      chunk_id++;
+    }
+
+    auto& chunk = chunks.back();
+    for (size_t k = 0; k < 3; ++k) {
+      const uint32_t index = indices[i + k];
+      if (chunk_ids[index] != chunk_id) {
+        chunk_ids[index] = chunk_id;
+        local_indices[index] = static_cast<uint32_t>(chunk.vertices.size());
+        chunk.vertices.push_back(index);
+      }
+      chunk.indices.push_back(local_indices[index]);
+    }
+  }
+  copied_vertex_count += chunks.back().vertices.size();
+
+  // 複製する頂点と、32ビットにしたときに増えるインデックスの大きさを比べる
+  // 使われない頂点は塊に入らないので、元の頂点数より少なくなることもある
+  const size_t duplicated_vertex_count = copied_vertex_count - std::min(copied_vertex_count, vertex_count);
+  const size_t split_cost = duplicated_vertex_count * vertex_size;
+  const size_t wide_cost = indices.size() * (sizeof(uint32_t) - sizeof(uint16_t));
+  if (split_cost < wide_cost) {
+    RT_DEBUG("メッシュを16ビットのインデックスで分割した (vertices:{}, chunks:{}, duplicated:{})",
+             vertex_count, chunks.size(), duplicated_vertex_count);
+    return chunks;
+  }
+  chunks.clear();
+  chunks.push_back(whole_chunk(GL_UNSIGNED_INT, indices, vertex_count));
+  return chunks;
+}
+}  // namespace rtdemo::util
@@ -0,0 +1,174 @@
+#include <rtdemo/mesh_optimize.hpp>
+#include <algorithm>
+#include <numeric>
+
+namespace rtdemo::util {
+VertexCacheStats analyze_vertex_cache(std::span<const uint32_t> indices, size_t vertex_count, size_t cache_size) {
+  VertexCacheStats stats;
+  stats.triangle_count = indices.size() / 3;
+
+  // FIFOなので、頂点を変換したときの通し番号が新しいものからcache_size個がキャッシュに残る
+  constexpr size_t NEVER = SIZE_MAX;
+  std::vector<size_t> transformed_at(vertex_count, NEVER);
+  for (const uint32_t index : indices) {
+    if (transformed_at[index] == NEVER) stats.vertex_count++;
+    if (transformed_at[index] != NEVER && stats.transform_count - transformed_at[index] < cache_size) continue;
+    transformed_at[index] = stats.transform_count++;
+  }
+  return stats;
+}
+
+std::vector<uint32_t> optimize_vertex_cache(std::span<uint32_t> indices, size_t vertex_count, size_t cache_size) {
+  std::vector<uint32_t> clusters;
+  const size_t triangle_count = indices.size() / 3;
+  if (triangle_count == 0) return clusters;
+
+  // 頂点ごとに、まだ出していない三角形の数と、その一覧を作る
+  std::vector<uint32_t> offsets(vertex_count + 1, 0);
+  for (size_t i = 0; i < triangle_count * 3; ++i) offsets[indices[i] + 1]++;
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  std::vector<uint32_t> live_counts(vertex_count);
+  for (size_t v = 0; v < vertex_count; ++v) live_counts[v] = offsets[v + 1] - offsets[v];
+  std::vector<uint32_t> adjacency(triangle_count * 3);
+  std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t t = 0; t < triangle_count; ++t) {
+    for (size_t k = 0; k < 3; ++k) adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+  }
+
+  // Tipsify
+  // 扇の中心にする頂点を決め、その頂点を使う三角形をすべて出してから、次の中心をキャッシュに残っている頂点から選ぶ
+  std::vector<uint32_t> cache_times(vertex_count, 0);
+  std::vector<bool> emitted(triangle_count, false);
+  std::vector<uint32_t> dead_ends;
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> output;
+  output.reserve(triangle_count * 3);
+  uint32_t time = static_cast<uint32_t>(cache_size) + 1;
+  size_t cursor = 0;
+  bool new_cluster = true;
+  int64_t fan = indices[0];
+  while (fan >= 0) {
+    candidates.clear();
+    for (uint32_t a = offsets[fan]; a < offsets[fan + 1]; ++a) {
+      const uint32_t t = adjacency[a];
+      if (emitted[t]) continue;
+      if (new_cluster) {
+        clusters.push_back(static_cast<uint32_t>(output.size() / 3));
+        new_cluster = false;
+      }
+      for (size_t k = 0; k < 3; ++k) {
+        const uint32_t v = indices[t * 3 + k];
+        output.push_back(v);
+        dead_ends.push_back(v);
+        candidates.push_back(v);
+        live_counts[v]--;
+        if (time - cache_times[v] > cache_size) cache_times[v] = time++;
+      }
+      emitted[t] = true;
+    }
+
+    // 扇を出してもキャッシュに残る頂点のうち、最も古いものを選ぶ
+    int64_t next = -1;
+    int64_t best_priority = -1;
+    for (const uint32_t v : candidates) {
+      if (live_counts[v] == 0) continue;
+      int64_t priority = 0;
+      if (time - cache_times[v] + 2 * live_counts[v] <= cache_size) priority = time - cache_times[v];
+      if (priority > best_priority) {
+        best_priority = priority;
+        next = v;
+      }
+    }
+    if (next >= 0) {
+      fan = next;
+      continue;
+    }
+
+    // 行き止まりになったら、最近出した頂点か、まだ三角形が残っている頂点から続ける
+    new_cluster = true;
+    while (!dead_ends.empty() && next < 0) {
+      const uint32_t v = dead_ends.back();
+      dead_ends.pop_back();
+      if (live_counts[v] > 0) next = v;
+    }
+    for (; cursor < vertex_count && next < 0; ++cursor) {
+      if (live_counts[cursor] > 0) next = static_cast<int64_t>(cursor);
+    }
+    fan = next;
+  }
+
+  std::copy(output.begin(), output.end(), indices.begin());
+  return clusters;
+}
+
+void optimize_overdraw(std::span<uint32_t> indices, std::span<const glm::vec3> positions,
+                       std::span<const uint32_t> clusters) {
+  const size_t triangle_count = indices.size() / 3;
+  if (clusters.size() < 2) return;
+
+  // クラスタごとに、面積で重み付けした中心と法線を求める
+  struct Cluster {
+    uint32_t first;  ///< 先頭の三角形
+    uint32_t count;  ///< 三角形の数
+    glm::vec3 centroid;  ///< 面積で重み付けした中心
+    glm::vec3 normal;  ///< 面積で重み付けした法線
+    float area;  ///< 面積の2倍
+    float sort_key;  ///< 大きいほど先に描画する
+  };
+  std::vector<Cluster> cluster_infos(clusters.size());
+  glm::vec3 mesh_centroid(0.f);
+  float mesh_area = 0.f;
+  for (size_t c = 0; c < clusters.size(); ++c) {
+    auto& cluster = cluster_infos[c];
+    cluster.first = clusters[c];
+    cluster.count = static_cast<uint32_t>((c + 1 < clusters.size() ? clusters[c + 1] : triangle_count) - clusters[c]);
+    cluster.centroid = glm::vec3(0.f);
+    cluster.normal = glm::vec3(0.f);
+    cluster.area = 0.f;
+    for (size_t t = cluster.first; t < cluster.first + cluster.count; ++t) {
+      const glm::vec3& p0 = positions[indices[t * 3 + 0]];
+      const glm::vec3& p1 = positions[indices[t * 3 + 1]];
+      const glm::vec3& p2 = positions[indices[t * 3 + 2]];
+      const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+      const float area = glm::length(normal);
+      cluster.centroid += (p0 + p1 + p2) * (area / 3.f);
+      cluster.normal += normal;
+      cluster.area += area;
+    }
+    mesh_centroid += cluster.centroid;
+    mesh_area += cluster.area;
+    if (cluster.area > 0.f) cluster.centroid /= cluster.area;
+  }
+  if (mesh_area > 0.f) mesh_centroid /= mesh_area;
+
+  // 中心から外側を向いているクラスタほど、他のクラスタを隠しやすい
+  for (auto& cluster : cluster_infos) {
+    const float length = glm::length(cluster.normal);
+    cluster.sort_key = length > 0.f ? glm::dot(cluster.centroid - mesh_centroid, cluster.normal / length) : 0.f;
+  }
+  std::stable_sort(cluster_infos.begin(), cluster_infos.end(),
+                   [](const Cluster& a, const Cluster& b) { return a.sort_key > b.sort_key; });
+
+  std::vector<uint32_t> output;
+  output.reserve(triangle_count * 3);
+  for (const auto& cluster : cluster_infos) {
+    output.insert(output.end(), indices.begin() + cluster.first * 3,
+                  indices.begin() + (cluster.first + cluster.count) * 3);
+  }
+  std::copy(output.begin(), output.end(), indices.begin());
+}
+
+std::vector<uint32_t> optimize_vertex_fetch(std::span<uint32_t> indices, size_t vertex_count) {
+  constexpr uint32_t UNUSED = UINT32_MAX;
+  std::vector<uint32_t> remap(vertex_count, UNUSED);
+  std::vector<uint32_t> order;
+  for (auto& index : indices) {
+    if (remap[index] == UNUSED) {
+      remap[index] = static_cast<uint32_t>(order.size());
+      order.push_back(index);
+    }
+    index = remap[index];
+  }
+  return order;
+}
+}  // namespace rtdemo::util
@@ -0,0 +1,114 @@
+#include <rtdemo/mesh_quantize.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace rtdemo::util {
+namespace {
+/**
+ * @brief [0,1]を正規化された符号なし整数にする
+ */
+template <typename T>
+T quantize_unorm(float v) noexcept {
+  constexpr float MAX = static_cast<float>(std::numeric_limits<T>::max());
+  return static_cast<T>(std::lround(std::clamp(v, 0.f, 1.f) * MAX));
+}
+
+/**
+ * @brief [-1,1]を正規化された符号付き整数にする
+ * 
+ * GLは最小値を-1として読むので、-MAXから+MAXまでを使う。
+ */
+template <typename T>
+T quantize_snorm(float v) noexcept {
+  constexpr float MAX = static_cast<float>(std::numeric_limits<T>::max());
+  return static_cast<T>(std::lround(std::clamp(v, -1.f, 1.f) * MAX));
+}
+
+/**
+ * @brief 位置を境界ボックス内の[0,1]に写す
+ */
+glm::vec3 normalize_position(const glm::vec3& p, const BoundingBox& bounds) noexcept {
+  const glm::vec3 extent = bounds.max - bounds.min;
+  return glm::vec3(
+      extent.x > 0.f ? (p.x - bounds.min.x) / extent.x : 0.f,
+      extent.y > 0.f ? (p.y - bounds.min.y) / extent.y : 0.f,
+      extent.z > 0.f ? (p.z - bounds.min.z) / extent.z : 0.f);
+}
+
+/**
+ * @brief 頂点をT型にして書き込む
+ */
+template <typename T>
+void write_vertex(const T& vertex, std::vector<std::byte>& output) {
+  const auto bytes = reinterpret_cast<const std::byte*>(&vertex);
+  output.insert(output.end(), bytes, bytes + sizeof(T));
+}
+}  // namespace
+
+const char* vertex_format_name(VertexFormat format) noexcept {
+  switch (format) {
+    case VertexFormat::FLOAT: return "float";
+    case VertexFormat::P16N16: return "p16n16";
+    case VertexFormat::P16N8: return "p16n8";
+  }
+  return "unknown";
+}
+
+size_t vertex_format_size(VertexFormat format) noexcept {
+  switch (format) {
+    case VertexFormat::FLOAT: return sizeof(VertexP3N3);
+    case VertexFormat::P16N16: return sizeof(VertexP16N16);
+    case VertexFormat::P16N8: return sizeof(VertexP16N8);
+  }
+  return 0;
+}
+
+glm::vec2 encode_octahedral(const glm::vec3& n) noexcept {
+  const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+  if (l1 <= 0.f) return glm::vec2(0.f);
+  glm::vec2 e(n.x / l1, n.y / l1);
+  // 下半分は対角線で折り返す
+  if (n.z < 0.f) {
+    e = glm::vec2((1.f - std::abs(e.y)) * (e.x >= 0.f ? 1.f : -1.f),
+                  (1.f - std::abs(e.x)) * (e.y >= 0.f ? 1.f : -1.f));
+  }
+  return e;
+}
+
+void quantize_vertices(VertexFormat format, std::span<const VertexP3N3> vertices, const BoundingBox& bounds,
+                       std::vector<std::byte>& output) {
+  output.reserve(output.size() + vertices.size() * vertex_format_size(format));
+  for (const auto& vertex : vertices) {
+    switch (format) {
+      case VertexFormat::FLOAT: {
+        write_vertex(vertex, output);
+        break;
+      }
+      case VertexFormat::P16N16: {
+        const glm::vec3 p = normalize_position(vertex.position, bounds);
+        const glm::vec2 n = encode_octahedral(vertex.normal);
+        write_vertex(VertexP16N16{
+            {quantize_unorm<uint16_t>(p.x), quantize_unorm<uint16_t>(p.y), quantize_unorm<uint16_t>(p.z)}, 0,
+            {quantize_snorm<int16_t>(n.x), quantize_snorm<int16_t>(n.y)},
+        }, output);
+        break;
+      }
+      case VertexFormat::P16N8: {
+        const glm::vec3 p = normalize_position(vertex.position, bounds);
+        const glm::vec2 n = encode_octahedral(vertex.normal);
+        write_vertex(VertexP16N8{
+            {quantize_unorm<uint16_t>(p.x), quantize_unorm<uint16_t>(p.y), quantize_unorm<uint16_t>(p.z)},
+            {quantize_snorm<int8_t>(n.x), quantize_snorm<int8_t>(n.y)},
+        }, output);
+        break;
+      }
+    }
+  }
+}
+
+VertexDecode vertex_decode(VertexFormat format, const BoundingBox& bounds) noexcept {
+  if (format == VertexFormat::FLOAT) return VertexDecode{glm::vec3(0.f), 0, glm::vec3(1.f), 0.f};
+  return VertexDecode{bounds.min, 1, bounds.max - bounds.min, 0.f};
+}
+}  // namespace rtdemo::util
@@ -0,0 +1,300 @@
+#include <rtdemo/render_graph.hpp>
+#include <algorithm>
+#include <imgui.h>
+#include <rtdemo/gpu_profiler.hpp>
+#include <rtdemo/logging.hpp>
+#include <rtdemo/util.hpp>
+
+namespace rtdemo {
+namespace {
+/**
+ * @brief シェーダから書き込むため、読む前にバリアが必要なアクセスか
+ */
+bool is_incoherent_write(RenderGraph::Access access) noexcept {
+  return access == RenderGraph::Access::IMAGE_STORE || access == RenderGraph::Access::STORAGE_WRITE;
+}
+
+/**
+ * @brief シェーダから書き込んだ結果をアクセス方法から見えるようにするバリアのビット
+ */
+GLbitfield barrier_bit(RenderGraph::Access access) noexcept {
+  switch (access) {
+    case RenderGraph::Access::SAMPLED:
+      return GL_TEXTURE_FETCH_BARRIER_BIT;
+    case RenderGraph::Access::IMAGE_LOAD:
+    case RenderGraph::Access::IMAGE_STORE:
+      return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+    case RenderGraph::Access::STORAGE_READ:
+    case RenderGraph::Access::STORAGE_WRITE:
+      return GL_SHADER_STORAGE_BARRIER_BIT;
+    case RenderGraph::Access::UNIFORM:
+      return GL_UNIFORM_BARRIER_BIT;
+    case RenderGraph::Access::ATTACHMENT_READ:
+    case RenderGraph::Access::ATTACHMENT_WRITE:
+      return GL_FRAMEBUFFER_BARRIER_BIT;
+  }
+  return GL_ALL_BARRIER_BITS;
+}
+
+/**
+ * @brief ステンシルを含む深度フォーマットか
+ */
+bool has_stencil(GLenum internal_format) noexcept {
+  return internal_format == GL_DEPTH24_STENCIL8 || internal_format == GL_DEPTH32F_STENCIL8;
+}
+}  // namespace
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(Handle handle, Access access) {
+  graph_.passes_[pass_index_].reads.push_back(Use{handle.index, access});
+  return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(Handle handle, Access access) {
+  graph_.passes_[pass_index_].writes.push_back(Use{handle.index, access});
+  return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::color(GLuint index, Handle handle) {
+  Pass& pass = graph_.passes_[pass_index_];
+  pass.writes.push_back(Use{handle.index, Access::ATTACHMENT_WRITE});
+  pass.attachments.push_back(Attachment{GL_COLOR_ATTACHMENT0 + index, handle.index});
+  return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::depth(Handle handle, bool write) {
+  Pass& pass = graph_.passes_[pass_index_];
+  const Resource& resource = graph_.resources_[handle.index];
+  if (write) {
+    pass.writes.push_back(Use{handle.index, Access::ATTACHMENT_WRITE});
+  } else {
+    pass.reads.push_back(Use{handle.index, Access::ATTACHMENT_READ});
+  }
+  const GLenum point = resource.is_transient && has_stencil(resource.texture_desc.internal_format) ?
+      GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+  pass.attachments.push_back(Attachment{point, handle.index});
+  return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::side_effect() noexcept {
+  graph_.passes_[pass_index_].side_effect = true;
+  return *this;
+}
+
+void RenderGraph::reset() {
+  passes_.clear();
+  resources_.clear();
+}
+
+RenderGraph::Handle RenderGraph::import_texture(const char* name, const garie::Texture& texture) {
+  Resource& resource = resources_.emplace_back();
+  resource.name = name;
+  resource.is_texture = true;
+  resource.texture = &texture;
+  return Handle{static_cast<uint32_t>(resources_.size() - 1)};
+}
+
+RenderGraph::Handle RenderGraph::import_buffer(const char* name, const garie::Buffer& buffer) {
+  Resource& resource = resources_.emplace_back();
+  resource.name = name;
+  resource.is_texture = false;
+  resource.buffer = &buffer;
+  return Handle{static_cast<uint32_t>(resources_.size() - 1)};
+}
+
+RenderGraph::Handle RenderGraph::create_texture(const char* name, const TextureDesc& desc) {
+  Resource& resource = resources_.emplace_back();
+  resource.name = name;
+  resource.is_texture = true;
+  resource.is_transient = true;
+  resource.texture_desc = desc;
+  return Handle{static_cast<uint32_t>(resources_.size() - 1)};
+}
+
+RenderGraph::Handle RenderGraph::create_buffer(const char* name, size_t size) {
+  Resource& resource = resources_.emplace_back();
+  resource.name = name;
+  resource.is_texture = false;
+  resource.is_transient = true;
+  resource.buffer_size = size;
+  return Handle{static_cast<uint32_t>(resources_.size() - 1)};
+}
+
+RenderGraph::PassBuilder RenderGraph::add_pass(const char* name, ExecuteFunc execute) {
+  Pass& pass = passes_.emplace_back();
+  pass.name = name;
+  pass.execute = std::move(execute);
+  return PassBuilder(*this, passes_.size() - 1);
+}
+
+void RenderGraph::execute() {
+  cull();
+  compute_lifetimes();
+  place_barriers();
+
+  barrier_count_ = 0;
+  transient_count_ = 0;
+  std::vector<util::RenderTargetPool::Attachment> attachments;
+  for (size_t i = 0; i < passes_.size(); ++i) {
+    const Pass& pass = passes_[i];
+    if (pass.culled) continue;
+
+    acquire_transients(i);
+    if (pass.barrier) {
+      glMemoryBarrier(pass.barrier);
+      barrier_count_++;
+    }
+    if (!pass.attachments.empty()) {
+      attachments.clear();
+      for (const auto& attachment : pass.attachments) {
+        const garie::Texture* attached = resources_[attachment.resource].texture;
+        if (!attached) {
+          RT_WARN("実体のないテクスチャをアタッチしようとした (pass:{}, resource:{})",
+                  pass.name, resources_[attachment.resource].name);
+          continue;
+        }
+        attachments.emplace_back(attachment.point, attached->id());
+      }
+      util::RenderTargetPool::get().framebuffer(attachments).bind(GL_DRAW_FRAMEBUFFER);
+    }
+
+    {
+      RT_GPU_SCOPE(pass.name);
+      pass.execute(*this);
+    }
+    release_transients(i);
+  }
+}
+
+const garie::Texture& RenderGraph::texture(Handle handle) const noexcept {
+  return *resources_[handle.index].texture;
+}
+
+const garie::Buffer& RenderGraph::buffer(Handle handle) const noexcept {
+  return *resources_[handle.index].buffer;
+}
+
+size_t RenderGraph::memory_usage() const noexcept {
+  size_t usage = 0;
+  for (const auto& resource : resources_) {
+    if (!resource.is_transient) continue;
+    if (!resource.is_texture) {
+      usage += resource.buffer_size;
+      continue;
+    }
+    const TextureDesc& desc = resource.texture_desc;
+    const size_t size = util::texture_memory_size(desc.internal_format, desc.width, desc.height, desc.depth);
+    usage += desc.samples > 0 ? size * desc.samples : size;
+  }
+  return usage;
+}
+
+void RenderGraph::update_gui() const {
+  ImGui::Text("passes:%zu (culled:%zu), barriers:%zu, transient:%zu",
+              passes_.size(), culled_pass_count_, barrier_count_, transient_count_);
+}
+
+void RenderGraph::cull() {
+  // 後ろのパスから、読まれるリソースに書き込むパスだけを残していく
+  std::vector<bool> needed(resources_.size(), false);
+  culled_pass_count_ = 0;
+  for (auto iter = passes_.rbegin(); iter != passes_.rend(); ++iter) {
+    Pass& pass = *iter;
+    pass.culled = !pass.side_effect && std::none_of(pass.writes.begin(), pass.writes.end(), [&](const Use& use) {
+      return needed[use.resource];
+    });
+    if (pass.culled) {
+      culled_pass_count_++;
+      continue;
+    }
+    for (const auto& use : pass.reads) needed[use.resource] = true;
+  }
+}
+
+void RenderGraph::compute_lifetimes() {
+  for (auto& resource : resources_) {
+    resource.first_pass = SIZE_MAX;
+    resource.last_pass = SIZE_MAX;
+  }
+  for (size_t i = 0; i < passes_.size(); ++i) {
+    const Pass& pass = passes_[i];
+    if (pass.culled) continue;
+    const auto extend = [&](const Use& use) {
+      Resource& resource = resources_[use.resource];
+      resource.first_pass = std::min(resource.first_pass, i);
+      resource.last_pass = resource.last_pass == SIZE_MAX ? i : std::max(resource.last_pass, i);
+    };
+    std::for_each(pass.reads.begin(), pass.reads.end(), extend);
+    std::for_each(pass.writes.begin(), pass.writes.end(), extend);
+  }
+  // 除かれたパスだけが使うリソースは、first_passもlast_passもSIZE_MAXのままなので、借りも返しもしない
+}
+
+void RenderGraph::acquire_transients(size_t pass_index) {
+  auto& pool = util::RenderTargetPool::get();
+  for (auto& resource : resources_) {
+    if (!resource.is_transient || resource.first_pass != pass_index) continue;
+    if (resource.is_texture) {
+      if (resource.texture) {
+        RT_WARN("返していない一時テクスチャを借りようとした (name:{})", resource.name);
+        pool.release_texture(*resource.texture);
+      }
+      resource.texture = &pool.acquire_texture(resource.texture_desc);
+    } else {
+      if (resource.buffer) {
+        RT_WARN("返していない一時バッファを借りようとした (name:{})", resource.name);
+        pool.release_buffer(*resource.buffer);
+      }
+      resource.buffer = &pool.acquire_buffer(resource.buffer_size);
+    }
+    transient_count_++;
+  }
+}
+
+void RenderGraph::release_transients(size_t pass_index) {
+  auto& pool = util::RenderTargetPool::get();
+  for (auto& resource : resources_) {
+    if (!resource.is_transient || resource.last_pass != pass_index) continue;
+    if (resource.is_texture) {
+      if (resource.texture) pool.release_texture(*resource.texture);
+      resource.texture = nullptr;
+    } else {
+      if (resource.buffer) pool.release_buffer(*resource.buffer);
+      resource.buffer = nullptr;
+    }
+  }
+}
+
+void RenderGraph::place_barriers() {
+  // glMemoryBarrierはすべてのリソースに効くので、発行済みのビットをリソースごとに覚えておく
+  struct State {
+    bool dirty = false;  // シェーダから書き込んでから、まだ見えていないアクセスがあるか
+    GLbitfield visible = 0;  // 書き込みが見えるようになったアクセス
+  };
+  std::vector<State> states(resources_.size());
+
+  for (auto& pass : passes_) {
+    pass.barrier = 0;
+    if (pass.culled) continue;
+
+    const auto require = [&](const Use& use) {
+      const State& state = states[use.resource];
+      const GLbitfield bit = barrier_bit(use.access);
+      if (state.dirty && !(state.visible & bit)) pass.barrier |= bit;
+    };
+    std::for_each(pass.reads.begin(), pass.reads.end(), require);
+    std::for_each(pass.writes.begin(), pass.writes.end(), require);
+
+    if (pass.barrier) {
+      for (auto& state : states) {
+        if (state.dirty) state.visible |= pass.barrier;
+      }
+    }
+
+    for (const auto& use : pass.writes) {
+      State& state = states[use.resource];
+      state.dirty = is_incoherent_write(use.access);
+      state.visible = 0;
+    }
+  }
+}
+}  // namespace rtdemo
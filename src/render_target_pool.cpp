@@ -0,0 +1,179 @@
+#include <rtdemo/render_target_pool.hpp>
+#include <algorithm>
+#include <imgui.h>
+#include <rtdemo/logging.hpp>
+#include <rtdemo/util.hpp>
+
+namespace rtdemo::util {
+RenderTargetPool& RenderTargetPool::get() noexcept {
+  static RenderTargetPool self;
+  return self;
+}
+
+void RenderTargetPool::clear() {
+  framebuffers_.clear();
+  entries_.clear();
+  memory_usage_ = 0;
+}
+
+const garie::Texture& RenderTargetPool::acquire_texture(const RenderTargetDesc& desc) {
+  auto iter = std::find_if(entries_.begin(), entries_.end(), [&](const std::unique_ptr<Entry>& entry) {
+    return !entry->in_use && entry->is_texture && entry->desc == desc;
+  });
+  if (iter != entries_.end()) {
+    (*iter)->in_use = true;
+    reused_count_++;
+    track_acquire(**iter);
+    return (*iter)->texture;
+  }
+
+  auto entry = std::make_unique<Entry>();
+  entry->is_texture = true;
+  entry->desc = desc;
+  entry->in_use = true;
+  {
+    // GLオブジェクトはプールの持ち物にし、貸し出している間は借り手のタグに数える
+    garie::ResourceTracker::Scope scope("render target pool");
+    if (desc.samples > 0) {
+      entry->texture.gen(GL_TEXTURE_2D_MULTISAMPLE);
+      entry->texture.storage_2d_multisample(desc.samples, desc.internal_format, desc.width, desc.height);
+      entry->size = texture_memory_size(desc.internal_format, desc.width, desc.height) * desc.samples;
+    } else {
+      entry->texture.gen(desc.target);
+      if (desc.target == GL_TEXTURE_3D) {
+        entry->texture.storage_3d(1, desc.internal_format, desc.width, desc.height, desc.depth);
+      } else {
+        entry->texture.storage_2d(1, desc.internal_format, desc.width, desc.height);
+      }
+      entry->size = texture_memory_size(desc.internal_format, desc.width, desc.height, desc.depth);
+    }
+  }
+  memory_usage_ += entry->size;
+  created_count_++;
+  RT_DEBUG("テクスチャを生成した (format:{:#x}, size:{}x{}x{}, samples:{})",
+           desc.internal_format, desc.width, desc.height, desc.depth, desc.samples);
+  track_acquire(*entry);
+  return entries_.emplace_back(std::move(entry))->texture;
+}
+
+void RenderTargetPool::release_texture(const garie::Texture& texture) {
+  for (auto& entry : entries_) {
+    if (&entry->texture == &texture) {
+      entry->in_use = false;
+      entry->released_frame = frame_index_;
+      track_release(*entry);
+      return;
+    }
+  }
+  RT_WARN("プールのものではないテクスチャを返却しようとした (id:{})", texture.id());
+}
+
+const garie::Buffer& RenderTargetPool::acquire_buffer(size_t size) {
+  auto iter = std::find_if(entries_.begin(), entries_.end(), [&](const std::unique_ptr<Entry>& entry) {
+    return !entry->in_use && !entry->is_texture && entry->size == size;
+  });
+  if (iter != entries_.end()) {
+    (*iter)->in_use = true;
+    reused_count_++;
+    track_acquire(**iter);
+    return (*iter)->buffer;
+  }
+
+  auto entry = std::make_unique<Entry>();
+  entry->is_texture = false;
+  entry->size = size;
+  entry->in_use = true;
+  {
+    garie::ResourceTracker::Scope scope("render target pool");
+    entry->buffer.gen();
+    entry->buffer.storage(size, nullptr, 0);
+  }
+  memory_usage_ += size;
+  created_count_++;
+  RT_DEBUG("バッファを生成した (size:{})", size);
+  track_acquire(*entry);
+  return entries_.emplace_back(std::move(entry))->buffer;
+}
+
+void RenderTargetPool::release_buffer(const garie::Buffer& buffer) {
+  for (auto& entry : entries_) {
+    if (&entry->buffer == &buffer) {
+      entry->in_use = false;
+      entry->released_frame = frame_index_;
+      track_release(*entry);
+      return;
+    }
+  }
+  RT_WARN("プールのものではないバッファを返却しようとした (id:{})", buffer.id());
+}
+
+const garie::Framebuffer& RenderTargetPool::framebuffer(const std::vector<Attachment>& attachments) {
+  auto iter = std::find_if(framebuffers_.begin(), framebuffers_.end(), [&](const std::unique_ptr<CachedFramebuffer>& cached) {
+    return cached->attachments == attachments;
+  });
+  if (iter != framebuffers_.end()) return (*iter)->framebuffer;
+
+  // garie::Textureを経由せずにIDで取り付ける
+  garie::ResourceTracker::Scope scope("render target pool");
+  garie::FramebufferBuilder builder;
+  for (const auto& [point, texture_id] : attachments) builder.attachment(point, texture_id);
+  GLenum status = GL_NONE;
+  garie::Framebuffer framebuffer = builder.build(&status);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    RT_WARN("フレームバッファが不完全");
+  }
+
+  auto cached = std::make_unique<CachedFramebuffer>();
+  cached->attachments = attachments;
+  cached->framebuffer = std::move(framebuffer);
+  return framebuffers_.emplace_back(std::move(cached))->framebuffer;
+}
+
+void RenderTargetPool::end_frame() {
+  frame_index_++;
+
+  // しばらく返却されたままのものを破棄する
+  auto iter = std::remove_if(entries_.begin(), entries_.end(), [this](const std::unique_ptr<Entry>& entry) {
+    if (entry->in_use || frame_index_ - entry->released_frame < KEEP_FRAME_COUNT) return false;
+    if (entry->is_texture) erase_framebuffers(entry->texture.id());
+    memory_usage_ -= entry->size;
+    return true;
+  });
+  entries_.erase(iter, entries_.end());
+}
+
+void RenderTargetPool::update_gui() const {
+  const size_t in_use_count = std::count_if(entries_.begin(), entries_.end(), [](const std::unique_ptr<Entry>& entry) {
+    return entry->in_use;
+  });
+  ImGui::Text("render targets:%zu (in use:%zu, %zuKiB), fbo:%zu", entries_.size(), in_use_count, memory_usage_ >> 10, framebuffers_.size());
+  ImGui::Text("created:%zu, reused:%zu", created_count_, reused_count_);
+}
+
+void RenderTargetPool::track_acquire(const Entry& entry) {
+  auto& tracker = garie::ResourceTracker::get();
+  if (entry.is_texture) {
+    tracker.add_allocation(garie::ResourceType::TEXTURE, entry.texture.id(), 0, entry.size);
+  } else {
+    tracker.add_allocation(garie::ResourceType::BUFFER, entry.buffer.id(), 0, entry.size);
+  }
+}
+
+void RenderTargetPool::track_release(const Entry& entry) noexcept {
+  auto& tracker = garie::ResourceTracker::get();
+  if (entry.is_texture) {
+    tracker.remove_allocation(garie::ResourceType::TEXTURE, entry.texture.id(), 0);
+  } else {
+    tracker.remove_allocation(garie::ResourceType::BUFFER, entry.buffer.id(), 0);
+  }
+}
+
+void RenderTargetPool::erase_framebuffers(GLuint texture_id) {
+  auto iter = std::remove_if(framebuffers_.begin(), framebuffers_.end(), [&](const std::unique_ptr<CachedFramebuffer>& cached) {
+    return std::any_of(cached->attachments.begin(), cached->attachments.end(), [&](const Attachment& attachment) {
+      return attachment.second == texture_id;
+    });
+  });
+  framebuffers_.erase(iter, framebuffers_.end());
+}
+}  // namespace rtdemo::util
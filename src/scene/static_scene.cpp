@@ -1,67 +1,270 @@
 #include <rtdemo/scene/static_scene.hpp>
 #include <vector>
 #include <random>
+#include <algorithm>
+#include <filesystem>
+#include <cfloat>
+#include <cstring>
 #include <glm/ext.hpp>
 #include <assimp/Importer.hpp>
+#include <assimp/ProgressHandler.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <imgui.h>
 #include <rtdemo/types.hpp>
 #include <rtdemo/util.hpp>
+#include <rtdemo/upload_ring.hpp>
+#include <rtdemo/buffer_heap.hpp>
+#include <rtdemo/mesh_cache.hpp>
+#include <rtdemo/mesh_index.hpp>
+#include <rtdemo/mesh_quantize.hpp>
+#include <rtdemo/mesh_optimize.hpp>
+#include <rtdemo/cpu_profiler.hpp>
+#include <rtdemo/logging.hpp>
 
 namespace rtdemo::scene {
+namespace {
+/**
+ * @brief Assimpの読み込みの進捗を書き込む
+ */
+class ImportProgressHandler final : public Assimp::ProgressHandler {
+ public:
+  ImportProgressHandler(std::atomic<float>& progress, float begin, float end) noexcept
+      : progress_(progress), begin_(begin), end_(end) {}
+
+  bool Update(float percentage) override {
+    if (percentage >= 0.f) progress_ = begin_ + (end_ - begin_) * std::min(percentage, 1.f);
+    return true;  // 中断しない
+  }
+
+ private:
+  std::atomic<float>& progress_;
+  float begin_;  ///< 読み込み開始時の進捗
+  float end_;  ///< 読み込み完了時の進捗
+};
+
+/**
+ * @brief 同じマテリアルのメッシュを、三角形の数が上限を超えない範囲でまとめる
+ * 
+ * マテリアルが同じなので、まとめた後も描画コマンドごとにマテリアルを引ける。
+ * 16ビットのインデックスで引けるメッシュをまとめて32ビットにしないように、
+ * 頂点数がMAX_SHORT_INDEX_VERTEX_COUNTを超えるときもまとまりを分ける。
+ * 上限より大きいメッシュは分けずに1つにする。
+ * 
+ * @param scene シーン
+ * @param max_triangle_count 三角形の数の上限。0ならまとめない
+ * @return std::vector<std::vector<uint32_t>> まとめたメッシュの番号
+ */
+std::vector<std::vector<uint32_t>> batch_meshes(const aiScene* scene, uint32_t max_triangle_count) {
+  constexpr size_t NO_BATCH = SIZE_MAX;
+  std::vector<std::vector<uint32_t>> batches;
+  std::vector<size_t> triangle_counts;  // まとめたメッシュごとの三角形の数
+  std::vector<size_t> vertex_counts;  // まとめたメッシュごとの頂点数
+  std::vector<size_t> open_batches(scene->mNumMaterials, NO_BATCH);  // マテリアルごとの、まだ追加できるまとまり
+  for (uint32_t mesh_i = 0; mesh_i < scene->mNumMeshes; ++mesh_i) {
+    const aiMesh* mesh = scene->mMeshes[mesh_i];
+    if (mesh->mMaterialIndex >= open_batches.size()) open_batches.resize(mesh->mMaterialIndex + 1, NO_BATCH);
+    auto& open_batch = open_batches[mesh->mMaterialIndex];
+    if (max_triangle_count == 0 || open_batch == NO_BATCH ||
+        triangle_counts[open_batch] + mesh->mNumFaces > max_triangle_count ||
+        vertex_counts[open_batch] + mesh->mNumVertices > util::MAX_SHORT_INDEX_VERTEX_COUNT) {
+      open_batch = batches.size();
+      batches.emplace_back();
+      triangle_counts.push_back(0);
+      vertex_counts.push_back(0);
+    }
+    batches[open_batch].push_back(mesh_i);
+    triangle_counts[open_batch] += mesh->mNumFaces;
+    vertex_counts[open_batch] += mesh->mNumVertices;
+  }
+  return batches;
+}
+}  // namespace
+
 RT_MANAGED_SCENE(StaticScene);
+RT_MANAGED_SCENE_NAMED(StaticSceneP16N16, StaticScene, util::VertexFormat::P16N16);
+RT_MANAGED_SCENE_NAMED(StaticSceneP16N8, StaticScene, util::VertexFormat::P16N8);
+RT_MANAGED_SCENE_NAMED(StaticSceneUnbatched, StaticScene, util::VertexFormat::FLOAT, 0);
+
+const uint32_t StaticScene::IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_GenNormals;
+
+bool StaticScene::load(std::atomic<float>& progress) {
+  RT_CPU_SCOPE("StaticScene::load");
+  progress = 0.f;
 
-bool StaticScene::restore() {
   // シーンを読み込む
   // const char* scene_path = "assets/scenes/cornellbox/CornellBox-Original.obj";
   const char* scene_path = "assets/scenes/test/untitled.obj";
-  Assimp::Importer importer;
-  const aiScene* scene =
-      importer.ReadFile(scene_path, aiProcess_Triangulate | aiProcess_GenNormals);
+  auto data = std::make_unique<LoadedData>();
 
-  // 描画に必要なデータをコピーする
-  size_t total_vertex_count = 0;
-  size_t total_index_count = 0;
-  std::vector<ResourceIndex> resource_indices;
-  std::vector<Command> commands;
-  resource_indices.reserve(scene->mNumMeshes);
-  commands.reserve(scene->mNumMeshes);
-  for (size_t i = 0; i < scene->mNumMeshes; ++i) {
-    const aiMesh* mesh = scene->mMeshes[i];
-    resource_indices.push_back(ResourceIndex{
-        mesh->mMaterialIndex,
-    });
-    commands.push_back(Command{
-        static_cast<GLuint>(mesh->mNumFaces * 3), 1,
-        static_cast<GLuint>(total_index_count),
-        static_cast<GLuint>(total_vertex_count), 0,
+  // 内容が変わっていなければ、前に変換したメッシュキャッシュをマップするだけで済ませる
+  uint64_t source_hash = 0;
+  {
+    RT_CPU_SCOPE("StaticScene::load hash");
+    util::MappedFile source;
+    if (!source.open(scene_path)) {
+      RT_ERROR("シーンを開けない (path:{})", scene_path);
+      return false;
+    }
+    source_hash = util::hash_bytes(source.bytes());
+  }
+  // 頂点の形式とまとめる大きさごとに別のキャッシュにする
+  std::filesystem::path cache_path = scene_path;
+  cache_path += fmt::format(".{}.b{}.rtmesh", util::vertex_format_name(vertex_format_), max_batch_triangle_count_);
+  if (data->mesh_cache.open(cache_path, source_hash, IMPORT_FLAGS)) {
+    RT_DEBUG("メッシュキャッシュを開いた (path:{}, size:{}KiB)", cache_path.string(), data->mesh_cache.size() >> 10);
+  } else if (!import(scene_path, cache_path, source_hash, vertex_format_, max_batch_triangle_count_, progress,
+                     data->mesh_cache)) {
+    return false;
+  }
+
+  // ライトのデータをコピーする
+  // TODO:シーンから実際のライトデータをコピーする
+  auto& lights = data->lights;
+  lights.reserve(10);
+  std::mt19937_64 engine;
+  std::uniform_real_distribution<float> dist;
+  std::uniform_real_distribution<float> dist10(-10.f, 10.f);
+  for (size_t i = 0; i < lights.capacity(); ++i) {
+    lights.push_back(PointLight{
+      {dist10(engine), dist10(engine), dist10(engine)},
+      3.f + dist(engine) * 7.f,
+      {dist(engine), dist(engine), dist(engine)},
+      5.f,
     });
-    total_index_count += mesh->mNumFaces * 3;
-    total_vertex_count += mesh->mNumVertices;
   }
 
+  // シャドウキャスタのデータをコピーする
+  auto& shadow_casters = data->shadow_casters;
+  shadow_casters.reserve(2);
+  shadow_casters.push_back(ShadowCaster{
+    glm::perspective(glm::radians(90.f), 1.f, 0.01f, 100.f) * glm::lookAt(glm::vec3(0.f, 5.f, 0.f), glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, -1.f)),
+  });
+
+  loaded_ = std::move(data);
+  progress = 1.f;
+  return true;
+}
+
+bool StaticScene::import(const char* scene_path, const std::filesystem::path& cache_path, uint64_t source_hash,
+                         util::VertexFormat vertex_format, uint32_t max_batch_triangle_count,
+                         std::atomic<float>& progress, util::MeshCache& mesh_cache) {
+  RT_CPU_SCOPE("StaticScene::import");
+  Assimp::Importer importer;
+  importer.SetProgressHandler(new ImportProgressHandler(progress, 0.f, 0.8f));  // importerが破棄する
+  const aiScene* scene = nullptr;
+  {
+    RT_CPU_SCOPE("Assimp::Importer::ReadFile");
+    scene = importer.ReadFile(scene_path, IMPORT_FLAGS);
+  }
+  if (!scene) {
+    RT_ERROR("シーンの読み込みに失敗した (path:{}, error:{})", scene_path, importer.GetErrorString());
+    return false;
+  }
+  progress = 0.8f;
+
   // メッシュのデータをコピーする
-  std::vector<VertexP3N3> vertices;
-  std::vector<uint16_t> indices;
-  vertices.reserve(total_vertex_count);
-  indices.reserve(total_index_count);
-  for (size_t mesh_i = 0; mesh_i < scene->mNumMeshes; ++mesh_i) {
-    const aiMesh* mesh = scene->mMeshes[mesh_i];
-    for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
-      const auto& p = mesh->mVertices[i];
-      const auto& n = mesh->mNormals[i];
-      vertices.push_back(VertexP3N3{
-          {p.x, p.y, p.z}, {n.x, n.y, n.z},
-      });
+  // 同じマテリアルのメッシュは1つにまとめて描画の数を減らす
+  // まとめたメッシュごとにインデックスの幅を選び、必要なら分割するので、描画コマンドはまとめた数より多くなることがある
+  // 頂点は描画コマンドごとの境界ボックスを使って、指定した形式に変換する
+  const size_t vertex_size = util::vertex_format_size(vertex_format);
+  std::vector<std::byte> vertices;
+  std::vector<VertexP3N3> chunk_vertices;
+  size_t vertex_count = 0;
+  std::vector<uint16_t> short_indices;
+  std::vector<uint32_t> int_indices;
+  std::vector<ResourceIndex> resource_indices;
+  std::vector<Command> commands;
+  std::vector<uint32_t> index_types;
+  std::vector<BoundingBox> bounds;
+  std::vector<uint32_t> batch_indices;
+  std::vector<glm::vec3> batch_positions;
+  std::vector<glm::vec3> batch_normals;
+  util::VertexCacheStats stats_before;
+  util::VertexCacheStats stats_after;
+  const auto batches = batch_meshes(scene, max_batch_triangle_count);
+  for (size_t batch_i = 0; batch_i < batches.size(); ++batch_i) {
+    // まとめるメッシュの頂点とインデックスを並べる
+    const auto& batch = batches[batch_i];
+    batch_indices.clear();
+    batch_positions.clear();
+    batch_normals.clear();
+    for (const uint32_t mesh_i : batch) {
+      const aiMesh* mesh = scene->mMeshes[mesh_i];
+      const auto base_index = static_cast<uint32_t>(batch_positions.size());
+      for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
+        // 三角形にならなかった点や線は描画しない
+        const auto& face = mesh->mFaces[i];
+        if (face.mNumIndices != 3) continue;
+        for (unsigned int k = 0; k < 3; ++k) batch_indices.push_back(base_index + face.mIndices[k]);
+      }
+      for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
+        const auto& p = mesh->mVertices[i];
+        const auto& n = mesh->mNormals[i];
+        batch_positions.emplace_back(p.x, p.y, p.z);
+        batch_normals.emplace_back(n.x, n.y, n.z);
+      }
     }
-    for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
-      const auto& face = mesh->mFaces[i];
-      indices.push_back(static_cast<uint16_t>(face.mIndices[0]));
-      indices.push_back(static_cast<uint16_t>(face.mIndices[1]));
-      indices.push_back(static_cast<uint16_t>(face.mIndices[2]));
+    const uint32_t material_index = scene->mMeshes[batch.front()]->mMaterialIndex;
+
+    // 頂点キャッシュ、オーバードロー、頂点の読み込みの順に並べ替える
+    // 以降の頂点の番号は、vertex_orderで元の頂点の番号に戻す
+    stats_before += util::analyze_vertex_cache(batch_indices, batch_positions.size());
+    const auto clusters = util::optimize_vertex_cache(batch_indices, batch_positions.size());
+    util::optimize_overdraw(batch_indices, batch_positions, clusters);
+    const auto vertex_order = util::optimize_vertex_fetch(batch_indices, batch_positions.size());
+    stats_after += util::analyze_vertex_cache(batch_indices, vertex_order.size());
+
+    for (const auto& chunk : util::choose_index_width(batch_indices, vertex_order.size(), vertex_size)) {
+      // 三角形のないメッシュは描画しない
+      if (chunk.indices.empty()) continue;
+      BoundingBox box{glm::vec3(FLT_MAX), 0.f, glm::vec3(-FLT_MAX), 0.f};
+      const size_t base_vertex = vertex_count;
+      chunk_vertices.clear();
+      for (const uint32_t local_i : chunk.vertices) {
+        const uint32_t i = vertex_order[local_i];
+        chunk_vertices.push_back(VertexP3N3{batch_positions[i], batch_normals[i]});
+        box.min = glm::min(box.min, chunk_vertices.back().position);
+        box.max = glm::max(box.max, chunk_vertices.back().position);
+      }
+      util::quantize_vertices(vertex_format, chunk_vertices, box, vertices);
+      vertex_count += chunk_vertices.size();
+
+      // 32ビットのインデックスの位置は、16ビットのインデックスをすべて並べてから決める
+      size_t first_index = 0;
+      if (chunk.index_type == GL_UNSIGNED_SHORT) {
+        first_index = short_indices.size();
+        short_indices.insert(short_indices.end(), chunk.indices.begin(), chunk.indices.end());
+      } else {
+        first_index = int_indices.size();
+        int_indices.insert(int_indices.end(), chunk.indices.begin(), chunk.indices.end());
+      }
+      commands.push_back(Command{
+          static_cast<GLuint>(chunk.indices.size()), 1,
+          static_cast<GLuint>(first_index),
+          static_cast<GLuint>(base_vertex), 0,
+      });
+      resource_indices.push_back(ResourceIndex{
+          material_index,
+      });
+      index_types.push_back(chunk.index_type);
+      bounds.push_back(box);
     }
+    progress = 0.8f + 0.2f * static_cast<float>(batch_i + 1) / batches.size();
+  }
+  RT_DEBUG("同じマテリアルのメッシュをまとめた (meshes:{}, batches:{}, draws:{}, max triangles:{})",
+           scene->mNumMeshes, batches.size(), commands.size(), max_batch_triangle_count);
+
+  // 32ビットのインデックスは、16ビットのインデックスの後ろに4バイトに揃えて並べる
+  if (short_indices.size() % 2 != 0) short_indices.push_back(0);
+  const GLuint int_index_offset = static_cast<GLuint>(short_indices.size() / 2);
+  for (size_t i = 0; i < commands.size(); ++i) {
+    if (index_types[i] == GL_UNSIGNED_INT) commands[i].index_first += int_index_offset;
   }
+  const size_t short_index_size = short_indices.size() * sizeof(uint16_t);
+  std::vector<std::byte> indices(short_index_size + int_indices.size() * sizeof(uint32_t));
+  std::memcpy(indices.data(), short_indices.data(), short_index_size);
+  std::memcpy(indices.data() + short_index_size, int_indices.data(), int_indices.size() * sizeof(uint32_t));
 
   // マテリアルのデータをコピーする
   std::vector<Material> materials;
@@ -86,94 +289,122 @@ bool StaticScene::restore() {
     });
   }
 
-  // ライトのデータをコピーする
-  // TODO:シーンから実際のライトデータをコピーする
-  std::vector<PointLight> lights;
-  lights.reserve(10);
-  std::mt19937_64 engine;
-  std::uniform_real_distribution<float> dist;
-  std::uniform_real_distribution<float> dist10(-10.f, 10.f);
-  for (size_t i = 0; i < lights.capacity(); ++i) {
-    lights.push_back(PointLight{
-      {dist10(engine), dist10(engine), dist10(engine)},
-      3.f + dist(engine) * 7.f,
-      {dist(engine), dist(engine), dist(engine)},
-      5.f,
-    });
-  }
+  RT_DEBUG("メッシュを最適化した (triangles:{}, ACMR:{:.3f}->{:.3f}, ATVR:{:.3f}->{:.3f})",
+           stats_after.triangle_count, stats_before.acmr(), stats_after.acmr(), stats_before.atvr(), stats_after.atvr());
+  RT_DEBUG("頂点を変換した (format:{}, vertices:{}, size:{}KiB, float size:{}KiB)",
+           util::vertex_format_name(vertex_format), vertex_count, vertices.size() >> 10,
+           (vertex_count * sizeof(VertexP3N3)) >> 10);
 
-  // シャドウキャスタのデータをコピーする
-  std::vector<ShadowCaster> shadow_casters;
-  shadow_casters.reserve(2);
-  shadow_casters.push_back(ShadowCaster{
-    glm::perspective(glm::radians(90.f), 1.f, 0.01f, 100.f) * glm::lookAt(glm::vec3(0.f, 5.f, 0.f), glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, -1.f)),
-  });
+  // 次からはAssimpを通さずに読み込めるように、キャッシュを書き出す
+  RT_CPU_SCOPE("StaticScene::import write cache");
+  mesh_cache = util::MeshCacheBuilder()
+      .section_bytes(util::MeshSection::VERTICES, vertices, vertex_size)
+      .section<std::byte>(util::MeshSection::INDICES, indices)
+      .section<Command>(util::MeshSection::COMMANDS, commands)
+      .section<uint32_t>(util::MeshSection::INDEX_TYPES, index_types)
+      .section<ResourceIndex>(util::MeshSection::RESOURCE_INDICES, resource_indices)
+      .section<Material>(util::MeshSection::MATERIALS, materials)
+      .section<BoundingBox>(util::MeshSection::BOUNDS, bounds)
+      .build(cache_path, source_hash, IMPORT_FLAGS);
+  return true;
+}
+
+bool StaticScene::restore() {
+  RT_CPU_SCOPE("StaticScene::restore");
+
+  // loadを済ませていなければ、ここで読み込む
+  if (!loaded_) {
+    std::atomic<float> progress{0.f};
+    if (!load(progress)) return false;
+  }
+  const auto data = std::move(loaded_);
+  const auto& mesh_cache = data->mesh_cache;
+  const size_t vertex_size = util::vertex_format_size(vertex_format_);
+  const auto vertices = mesh_cache.section_bytes(util::MeshSection::VERTICES, vertex_size);
+  const auto indices = mesh_cache.section<std::byte>(util::MeshSection::INDICES);
+  const auto resource_indices = mesh_cache.section<ResourceIndex>(util::MeshSection::RESOURCE_INDICES);
+  const auto materials = mesh_cache.section<Material>(util::MeshSection::MATERIALS);
+  const auto commands = mesh_cache.section<Command>(util::MeshSection::COMMANDS);
+  const auto index_types = mesh_cache.section<uint32_t>(util::MeshSection::INDEX_TYPES);
+  const auto bounds = mesh_cache.section<BoundingBox>(util::MeshSection::BOUNDS);
+  auto& lights = data->lights;
+  auto& shadow_casters = data->shadow_casters;
 
   // GLリソースを生成する
-  garie::Buffer vbo;
-  vbo.gen();
-  vbo.bind(GL_ARRAY_BUFFER);
-  glBufferStorage(GL_ARRAY_BUFFER, vertices.size() * sizeof(VertexP3N3),
-                  vertices.data(), 0);
-
-  garie::Buffer ibo;
-  ibo.gen();
-  ibo.bind(GL_ELEMENT_ARRAY_BUFFER);
-  glBufferStorage(GL_ELEMENT_ARRAY_BUFFER,
-                  indices.size() * sizeof(uint16_t), indices.data(), 0);
-
-  garie::VertexArray vao = garie::VertexArrayBuilder()
-      .index_buffer(ibo)
-      .vertex_buffer(vbo)
-      .attribute(0, 3, GL_FLOAT, GL_FALSE,
-                 sizeof(VertexP3N3), offsetof(VertexP3N3, position), 0)
-      .attribute(1, 3, GL_FLOAT, GL_FALSE,
-                 sizeof(VertexP3N3), offsetof(VertexP3N3, normal), 0)
-      .build();
-
-  garie::Buffer camera_ubo;
-  camera_ubo.gen();
-  camera_ubo.bind(GL_UNIFORM_BUFFER);
-  glBufferStorage(
-      GL_UNIFORM_BUFFER, sizeof(Camera), nullptr, GL_MAP_WRITE_BIT);
-
-  garie::Buffer constant_ubo;
-  constant_ubo.gen();
-  constant_ubo.bind(GL_UNIFORM_BUFFER);
-  glBufferStorage(
-      GL_UNIFORM_BUFFER, sizeof(Constant), nullptr, GL_MAP_WRITE_BIT);
-
-  garie::Buffer resource_index_ssbo;
-  resource_index_ssbo.gen();
-  resource_index_ssbo.bind(GL_SHADER_STORAGE_BUFFER);
-  glBufferStorage(GL_SHADER_STORAGE_BUFFER,
-                  resource_indices.size() * sizeof(ResourceIndex),
-                  resource_indices.data(), 0);
-
-  garie::Buffer material_ssbo;
-  material_ssbo.gen();
-  material_ssbo.bind(GL_SHADER_STORAGE_BUFFER);
-  glBufferStorage(GL_SHADER_STORAGE_BUFFER,
-                  materials.size() * sizeof(Material), materials.data(),
-                  0);
-
-  garie::Buffer light_ssbo;
-  light_ssbo.gen();
-  light_ssbo.bind(GL_SHADER_STORAGE_BUFFER);
-  glBufferStorage(GL_SHADER_STORAGE_BUFFER,
-                  lights.size() * sizeof(PointLight), lights.data(), GL_MAP_WRITE_BIT);
-
-  garie::Buffer shadow_ssbo;
-  shadow_ssbo.gen();
-  shadow_ssbo.bind(GL_SHADER_STORAGE_BUFFER);
-  glBufferStorage(GL_SHADER_STORAGE_BUFFER,
-                  shadow_casters.size() * sizeof(ShadowCaster), shadow_casters.data(), GL_MAP_WRITE_BIT);
-
-  garie::Buffer dio;
-  dio.gen();
-  dio.bind(GL_DRAW_INDIRECT_BUFFER);
-  glBufferStorage(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(Command),
-                  commands.data(), 0);
+  // メッシュキャッシュの内容をそのまま転送する
+  RT_CPU_SCOPE("StaticScene::restore upload");
+  // バッファはヒープから切り出すので、他のシーンとバッファを共有する
+  if (vertices.empty() || indices.empty() || commands.empty()) {
+    RT_ERROR("シーンにメッシュがない");
+    return false;
+  }
+  if (index_types.size() != commands.size() || resource_indices.size() != commands.size() ||
+      bounds.size() != commands.size()) {
+    RT_ERROR("描画コマンドの数が合わない (commands:{}, index types:{}, resource indices:{}, bounds:{})",
+             commands.size(), index_types.size(), resource_indices.size(), bounds.size());
+    return false;
+  }
+  auto& heap = util::BufferHeap::get();
+  free_views();
+  vertex_view_ = heap.allocate(GL_ARRAY_BUFFER, vertices.size_bytes(), vertices.data());
+  index_view_ = heap.allocate(GL_ELEMENT_ARRAY_BUFFER, indices.size_bytes(), indices.data());
+
+  // 量子化した形式は正規化された整数として読み、シェーダでVertexDecodeを使って元に戻す
+  garie::VertexArrayBuilder vao_builder;
+  vao_builder
+      .index_buffer(*index_view_.buffer)
+      .vertex_buffer(*vertex_view_.buffer);
+  switch (vertex_format_) {
+    case util::VertexFormat::FLOAT: {
+      vao_builder
+          .attribute(0, 3, GL_FLOAT, GL_FALSE,
+                     sizeof(VertexP3N3), vertex_view_.offset + offsetof(VertexP3N3, position), 0)
+          .attribute(1, 3, GL_FLOAT, GL_FALSE,
+                     sizeof(VertexP3N3), vertex_view_.offset + offsetof(VertexP3N3, normal), 0);
+      break;
+    }
+    case util::VertexFormat::P16N16: {
+      vao_builder
+          .attribute(0, 3, GL_UNSIGNED_SHORT, GL_TRUE,
+                     sizeof(VertexP16N16), vertex_view_.offset + offsetof(VertexP16N16, position), 0)
+          .attribute(1, 2, GL_SHORT, GL_TRUE,
+                     sizeof(VertexP16N16), vertex_view_.offset + offsetof(VertexP16N16, normal), 0);
+      break;
+    }
+    case util::VertexFormat::P16N8: {
+      vao_builder
+          .attribute(0, 3, GL_UNSIGNED_SHORT, GL_TRUE,
+                     sizeof(VertexP16N8), vertex_view_.offset + offsetof(VertexP16N8, position), 0)
+          .attribute(1, 2, GL_BYTE, GL_TRUE,
+                     sizeof(VertexP16N8), vertex_view_.offset + offsetof(VertexP16N8, normal), 0);
+      break;
+    }
+  }
+  garie::VertexArray vao = vao_builder.build();
+
+  resource_index_view_ = heap.allocate(GL_SHADER_STORAGE_BUFFER, resource_indices.size_bytes(), resource_indices.data());
+  material_view_ = heap.allocate(GL_SHADER_STORAGE_BUFFER, materials.size_bytes(), materials.data());
+
+  // 最初のインデックスを、インデックスを置いた範囲ではなくバッファの先頭から数える
+  // ヒープのアラインメントは4バイト以上なので、どちらの幅でも割り切れる
+  commands_.assign(commands.begin(), commands.end());
+  index_types_.assign(index_types.begin(), index_types.end());
+  for (size_t i = 0; i < commands_.size(); ++i) {
+    commands_[i].index_first += static_cast<GLuint>(index_view_.offset / util::index_type_size(index_types_[i]));
+  }
+  command_view_ = heap.allocate(GL_DRAW_INDIRECT_BUFFER, commands_.size() * sizeof(Command), commands_.data());
+
+  // メッシュごとの境界ボックスをまとめ、頂点を元に戻すための情報を作る
+  bounds_ = BoundingBox{glm::vec3(FLT_MAX), 0.f, glm::vec3(-FLT_MAX), 0.f};
+  std::vector<VertexDecode> vertex_decodes;
+  vertex_decodes.reserve(bounds.size());
+  for (const auto& box : bounds) {
+    bounds_.min = glm::min(bounds_.min, box.min);
+    bounds_.max = glm::max(bounds_.max, box.max);
+    vertex_decodes.push_back(util::vertex_decode(vertex_format_, box));
+  }
+  vertex_decode_view_ = heap.allocate(GL_SHADER_STORAGE_BUFFER, vertex_decodes.size() * sizeof(VertexDecode),
+                                      vertex_decodes.data());
 
   // 後始末
   camera_center_ = 0.f;
@@ -183,40 +414,51 @@ bool StaticScene::restore() {
   draw_mode_ = DrawMode::DRAW;
 
   vao_ = std::move(vao);
-  vbo_ = std::move(vbo);
-  ibo_ = std::move(ibo);
-  camera_ubo_ = std::move(camera_ubo);
-  constant_ubo_ = std::move(constant_ubo);
-  resource_index_ssbo_ = std::move(resource_index_ssbo);
-  material_ssbo_ = std::move(material_ssbo);
-  light_ssbo_ = std::move(light_ssbo);
-  shadow_ssbo_ = std::move(shadow_ssbo);
-  light_count_ = lights.size();
-  dio_ = std::move(dio);
-  commands_ = std::move(commands);
+  lights_ = std::move(lights);
+  shadow_casters_ = std::move(shadow_casters);
   return true;
 }
 
 bool StaticScene::invalidate() {
+  loaded_.reset();
   vao_ = garie::VertexArray();
-  vbo_ = garie::Buffer();
-  ibo_ = garie::Buffer();
-  camera_ubo_ = garie::Buffer();
-  constant_ubo_ = garie::Buffer();
-  resource_index_ssbo_ = garie::Buffer();
-  material_ssbo_ = garie::Buffer();
-  light_ssbo_ = garie::Buffer();
-  shadow_ssbo_ = garie::Buffer();
-  light_count_ = 0;
-  dio_ = garie::Buffer();
+  free_views();
+  lights_.clear();
+  shadow_casters_.clear();
+  camera_range_ = {};
+  constant_range_ = {};
+  light_range_ = {};
+  shadow_range_ = {};
   commands_.clear();
+  index_types_.clear();
   return true;
 }
 
-void StaticScene::update() {
+void StaticScene::free_views() {
+  auto& heap = util::BufferHeap::get();
+  heap.free(vertex_view_);
+  heap.free(index_view_);
+  heap.free(vertex_decode_view_);
+  heap.free(resource_index_view_);
+  heap.free(material_view_);
+  heap.free(command_view_);
+  vertex_view_ = {};
+  index_view_ = {};
+  vertex_decode_view_ = {};
+  resource_index_view_ = {};
+  material_view_ = {};
+  command_view_ = {};
+}
+
+void StaticScene::update(FramePacket& packet) {
+  RT_CPU_SCOPE("StaticScene::update");
+
+  const float screen_width = static_cast<float>(packet.screen_width);
+  const float screen_height = static_cast<float>(packet.screen_height);
+
   // 射影行列を計算する
   const glm::mat4 proj =
-      glm::perspective(glm::radians(45.f), 1280.f / 720.f, 0.01f, lens_depth_);
+      glm::perspective(glm::radians(45.f), screen_width / screen_height, 0.01f, lens_depth_);
 
   // ビュー行列を計算する
   const glm::mat3 rot = glm::yawPitchRoll(camera_yaw_, camera_pitch_, 0.f);
@@ -226,59 +468,59 @@ void StaticScene::update() {
   const glm::mat4 view = glm::lookAt(eye, glm::vec3(0.f, camera_center_, 0.f), up);
   const glm::mat4 view_proj = proj * view;
 
+  // カメラ情報
+  Camera& camera = packet.camera;
+  camera.view_proj = view_proj;
+  camera.view = view;
+  camera.proj = proj;
+  camera.view_proj_inv = glm::inverse(view_proj);
+  camera.view_inv = glm::inverse(view);
+  camera.proj_inv = glm::inverse(proj);
+  camera.range = glm::vec4(screen_width, screen_height, 0.01f, lens_depth_);
+  camera.position_w = eye;
+
+  // ライト情報
+  packet.lights.push_back(light_);
+
+  // シャドウ情報
+  // const glm::mat4 proj = glm::perspective(glm::radians(90.f), 1.f, 0.01f, 100.f);
+  // const glm::mat4 view = glm::lookAt(light_.position_w, glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, -1.f));
+  const glm::mat4 shadow_proj = glm::ortho(-25.f, 25.f, -25.f, 25.f, 0.01f, 1000.f);
+  const glm::mat4 shadow_view = glm::lookAt(light_.position_w, glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, -1.f));
+  packet.shadow_casters.push_back(ShadowCaster{shadow_proj * shadow_view});
+}
+
+void StaticScene::upload(const FramePacket& packet) {
+  RT_CPU_SCOPE("StaticScene::upload");
+
+  auto& ring = util::UploadRing::get();
+
   // カメラ情報を更新する
-  camera_ubo_.bind(GL_UNIFORM_BUFFER);
-  Camera* camera =
-  reinterpret_cast<Camera*>(glMapBufferRange(
-      GL_UNIFORM_BUFFER, 0, sizeof(Camera),
-      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
-  if (camera) {
-    camera->view_proj = view_proj;
-    camera->view = view;
-    camera->proj = proj;
-    camera->view_proj_inv = glm::inverse(view_proj);
-    camera->view_inv = glm::inverse(view);
-    camera->proj_inv = glm::inverse(proj);
-    camera->range = glm::vec4(1280.f, 720.f, 0.01f, lens_depth_);
-    camera->position_w = eye;
-    glUnmapBuffer(GL_UNIFORM_BUFFER);
-  }
+  camera_range_ = ring.allocate(GL_UNIFORM_BUFFER, sizeof(Camera));
+  if (camera_range_) *static_cast<Camera*>(camera_range_.data) = packet.camera;
 
   // ライト情報を更新する
-  light_ssbo_.bind(GL_SHADER_STORAGE_BUFFER);
-  PointLight* lights =
-  reinterpret_cast<PointLight*>(glMapBufferRange(
-      GL_SHADER_STORAGE_BUFFER, 0, sizeof(PointLight),
-      GL_MAP_WRITE_BIT));
-  if (lights) {
-    lights[0] = light_;
-    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+  // ライトの数はrestoreで決まるので、入りきらないライトは捨て、足りない分は読み込んだライトを使う
+  // 大きさが0の範囲はバインドできないので、少なくとも1つ分を割り当てる
+  light_range_ = ring.allocate(GL_SHADER_STORAGE_BUFFER, sizeof(PointLight) * std::max<size_t>(lights_.size(), 1));
+  if (light_range_) {
+    auto lights = static_cast<PointLight*>(light_range_.data);
+    std::copy(lights_.begin(), lights_.end(), lights);
+    std::copy_n(packet.lights.begin(), std::min(packet.lights.size(), lights_.size()), lights);
   }
 
   // シャドウ情報を更新する
-  shadow_ssbo_.bind(GL_SHADER_STORAGE_BUFFER);
-  auto shadow_casters =
-  reinterpret_cast<ShadowCaster*>(glMapBufferRange(
-      GL_SHADER_STORAGE_BUFFER, 0, sizeof(ShadowCaster),
-      GL_MAP_WRITE_BIT));
-  if (shadow_casters) {
-    // const glm::mat4 proj = glm::perspective(glm::radians(90.f), 1.f, 0.01f, 100.f);
-    // const glm::mat4 view = glm::lookAt(light_.position_w, glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, -1.f));
-    const glm::mat4 proj = glm::ortho(-25.f, 25.f, -25.f, 25.f, 0.01f, 1000.f);
-    const glm::mat4 view = glm::lookAt(light_.position_w, glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, -1.f));
-    shadow_casters[0].view_proj = proj * view;
-    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+  shadow_range_ = ring.allocate(GL_SHADER_STORAGE_BUFFER, sizeof(ShadowCaster) * std::max<size_t>(shadow_casters_.size(), 1));
+  if (shadow_range_) {
+    auto shadow_casters = static_cast<ShadowCaster*>(shadow_range_.data);
+    std::copy(shadow_casters_.begin(), shadow_casters_.end(), shadow_casters);
+    if (!packet.shadow_casters.empty() && !shadow_casters_.empty()) shadow_casters[0] = packet.shadow_casters[0];
   }
 
   // 定数情報を更新する
-  constant_ubo_.bind(GL_UNIFORM_BUFFER);
-  Constant* constant =
-  reinterpret_cast<Constant*>(glMapBufferRange(
-      GL_UNIFORM_BUFFER, 0, sizeof(Constant),
-      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
-  if (constant) {
-    constant->light_count = static_cast<uint32_t>(light_count_);
-    glUnmapBuffer(GL_UNIFORM_BUFFER);
+  constant_range_ = ring.allocate(GL_UNIFORM_BUFFER, sizeof(Constant));
+  if (constant_range_) {
+    *static_cast<Constant*>(constant_range_.data) = Constant{static_cast<uint32_t>(lights_.size()), {}};
   }
 }
 
@@ -295,45 +537,50 @@ void StaticScene::update_gui() {
   ImGui::SliderFloat("intensity", &light_.intensity, 0.f, 10.f);
   ImGui::Combo("draw mode", reinterpret_cast<int*>(&draw_mode_),
                "DRAW\0DRAW_INDIRECT\0\0");
+  ImGui::Text("vertex format:%s (%zu bytes/vertex)",
+              util::vertex_format_name(vertex_format_), util::vertex_format_size(vertex_format_));
+  ImGui::Text("draws:%zu (max batch triangles:%u)", commands_.size(), max_batch_triangle_count_);
+  ImGui::Text("bounds:(%.2f, %.2f, %.2f)-(%.2f, %.2f, %.2f)",
+              bounds_.min.x, bounds_.min.y, bounds_.min.z, bounds_.max.x, bounds_.max.y, bounds_.max.z);
   ImGui::End();
 }
 
 void StaticScene::apply(ApplyType type) {
   switch (type) {
     case ApplyType::SHADE: {
-      camera_ubo_.bind_base(GL_UNIFORM_BUFFER, 0);
-      constant_ubo_.bind_base(GL_UNIFORM_BUFFER, 7);
+      camera_range_.bind(GL_UNIFORM_BUFFER, 0);
+      constant_range_.bind(GL_UNIFORM_BUFFER, 7);
       
-      resource_index_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 0);
-      material_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 1);
-      light_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 2);
-      shadow_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 3);
+      resource_index_view_.bind(GL_SHADER_STORAGE_BUFFER, 0);
+      material_view_.bind(GL_SHADER_STORAGE_BUFFER, 1);
+      light_range_.bind(GL_SHADER_STORAGE_BUFFER, 2);
+      shadow_range_.bind(GL_SHADER_STORAGE_BUFFER, 3);
       break;
     }
     case ApplyType::NO_SHADE: {
-      camera_ubo_.bind_base(GL_UNIFORM_BUFFER, 0);
-      constant_ubo_.bind_base(GL_UNIFORM_BUFFER, 7);
+      camera_range_.bind(GL_UNIFORM_BUFFER, 0);
+      constant_range_.bind(GL_UNIFORM_BUFFER, 7);
       break;
     }
     case ApplyType::LIGHT: {
-      camera_ubo_.bind_base(GL_UNIFORM_BUFFER, 0);
-      constant_ubo_.bind_base(GL_UNIFORM_BUFFER, 7);
+      camera_range_.bind(GL_UNIFORM_BUFFER, 0);
+      constant_range_.bind(GL_UNIFORM_BUFFER, 7);
       
-      light_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 0);
+      light_range_.bind(GL_SHADER_STORAGE_BUFFER, 0);
       break;
     }
     case ApplyType::SHADOW: {
-      constant_ubo_.bind_base(GL_UNIFORM_BUFFER, 7);
+      constant_range_.bind(GL_UNIFORM_BUFFER, 7);
 
-      shadow_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 0);
+      shadow_range_.bind(GL_SHADER_STORAGE_BUFFER, 0);
       break;
     }
     case ApplyType::LIGHT_SHADOW: {
-      camera_ubo_.bind_base(GL_UNIFORM_BUFFER, 0);
-      constant_ubo_.bind_base(GL_UNIFORM_BUFFER, 7);
+      camera_range_.bind(GL_UNIFORM_BUFFER, 0);
+      constant_range_.bind(GL_UNIFORM_BUFFER, 7);
       
-      light_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 0);
-      shadow_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 1);
+      light_range_.bind(GL_SHADER_STORAGE_BUFFER, 0);
+      shadow_range_.bind(GL_SHADER_STORAGE_BUFFER, 1);
       break;
     }
   }
@@ -343,25 +590,26 @@ void StaticScene::draw(DrawType type) {
   switch (type) {
     case DrawType::OPAQUE: {
       vao_.bind();
+      vertex_decode_view_.bind(GL_SHADER_STORAGE_BUFFER, 7);
       switch (draw_mode_) {
         case DrawMode::DRAW: {
           for (size_t i = 0; i < commands_.size(); ++i) {
             const auto& command = commands_[i];
             glUniform1ui(0, static_cast<GLuint>(i));
             glDrawElementsInstancedBaseVertexBaseInstance(
-                GL_TRIANGLES, command.index_count, GL_UNSIGNED_SHORT,
-                (const GLvoid*)(command.index_first * sizeof(uint16_t)),
+                GL_TRIANGLES, command.index_count, index_types_[i],
+                (const GLvoid*)(command.index_first * util::index_type_size(index_types_[i])),
                 command.instance_count, command.base_vertex, command.base_instance);
           }
           break;
         }
         case DrawMode::DRAW_INDIRECT: {
-          dio_.bind(GL_DRAW_INDIRECT_BUFFER);
+          command_view_.buffer->bind(GL_DRAW_INDIRECT_BUFFER);
           for (size_t i = 0; i < commands_.size(); ++i) {
             const auto& command = commands_[i];
             glUniform1ui(0, static_cast<GLuint>(i));
-            glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT,
-                                  (const void*)(i * sizeof(Command)));
+            glDrawElementsIndirect(GL_TRIANGLES, index_types_[i],
+                                  (const void*)(command_view_.offset + i * sizeof(Command)));
           }
           glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
           break;
@@ -375,7 +623,7 @@ void StaticScene::draw(DrawType type) {
     }
     case DrawType::LIGHT_VOLUME: {
       util::screen_quad_vao().bind();
-      for (size_t i = 0; i < light_count_; ++i) {
+      for (size_t i = 0; i < lights_.size(); ++i) {
         glUniform1ui(0, static_cast<GLuint>(i));
         util::draw_screen_quad();
       }
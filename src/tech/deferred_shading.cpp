@@ -2,7 +2,9 @@
 #include <gsl/gsl>
 #include <imgui.h>
 #include <rtdemo/logging.hpp>
+#include <rtdemo/gpu_profiler.hpp>
 #include <rtdemo/util.hpp>
+#include <rtdemo/upload_ring.hpp>
 
 namespace rtdemo::tech {
 RT_MANAGED_TECHNIQUE(DeferredShading);
@@ -42,47 +44,19 @@ bool DeferredShading::restore() {
   p1_prog_ = util::link_program(p1_vert, p1_frag, &log_);
   if (!p1_prog_) return false;
 
-  // リソースを生成する
-  constant_ub_.gen();
-  constant_ub_.bind(GL_UNIFORM_BUFFER);
-  glBufferStorage(GL_UNIFORM_BUFFER, 1024, nullptr, GL_MAP_WRITE_BIT);
-
+  // Gバッファはレンダグラフの一時テクスチャにする
   const uint32_t screen_width = Application::get().screen_width();
   const uint32_t screen_height = Application::get().screen_height();
-  ds_tex_.gen();
-  ds_tex_.bind(GL_TEXTURE_2D);
-  glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH24_STENCIL8, screen_width, screen_height);
-
-  g0_tex_.gen();
-  g0_tex_.bind(GL_TEXTURE_2D);
-  glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, screen_width, screen_height);
-
-  g1_tex_.gen();
-  g1_tex_.bind(GL_TEXTURE_2D);
-  glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, screen_width, screen_height);
-
-  g2_tex_.gen();
-  g2_tex_.bind(GL_TEXTURE_2D);
-  glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, screen_width, screen_height);
-
-  g3_tex_.gen();
-  g3_tex_.bind(GL_TEXTURE_2D);
-  glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, screen_width, screen_height);
-
-  fb_ = garie::FramebufferBuilder()
-      .depthstencil_texture(ds_tex_)
-      .color_texture(0, g0_tex_)
-      .color_texture(1, g1_tex_)
-      .color_texture(2, g2_tex_)
-      .color_texture(3, g3_tex_)
-      .build();
-
   viewport_ = garie::Viewport(0.f, 0.f, static_cast<float>(screen_width), static_cast<float>(screen_height));
 
   ss_ = garie::SamplerBuilder()
         .min_filter(GL_NEAREST)
         .mag_filter(GL_NEAREST)
-        .build();
+        .build_shared();
+
+  // GPUメモリの使用量を見積もる
+  // Gバッファはプールから借り、定数はリングバッファに書き込むので、自身では持たない
+  memory_usage_ = 0;
 
   log_ = "成功";
 
@@ -91,41 +65,57 @@ bool DeferredShading::restore() {
 }
 
 bool DeferredShading::invalidate() {
+  memory_usage_ = 0;
   p0_prog_.del();
   p1_prog_.del();
-  constant_ub_.del();
-  ds_tex_.del();
-  g0_tex_.del();
-  g1_tex_.del();
-  g2_tex_.del();
-  g3_tex_.del();
-  fb_.del();
-  ss_.del();
+  ss_.reset();
+  graph_.reset();
   log_ = "利用不可";
   return true;
 }
 
-void DeferredShading::update() {
-  constant_ub_.bind(GL_UNIFORM_BUFFER);
-  auto constant = reinterpret_cast<Constant*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, sizeof(Mode), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
-  if (constant) {
-    constant->mode = mode_;
-    glUnmapBuffer(GL_UNIFORM_BUFFER);
-  }
+void DeferredShading::update(FramePacket& packet) {
+  Constant constant{};
+  constant.mode = mode_;
+  constant.uv_scale[0] = static_cast<float>(packet.render_width) / static_cast<float>(packet.screen_width);
+  constant.uv_scale[1] = static_cast<float>(packet.render_height) / static_cast<float>(packet.screen_height);
+  packet.set_technique_constant(constant);
+}
+
+void DeferredShading::upload(const FramePacket& packet) {
+  constant_range_ = util::UploadRing::get().allocate(GL_UNIFORM_BUFFER, sizeof(Constant));
+  if (constant_range_) *static_cast<Constant*>(constant_range_.data) = packet.get_technique_constant<Constant>();
+
+  // Gバッファは画面の大きさで確保したまま、左下の内部解像度の範囲だけに描画する
+  viewport_ = garie::Viewport(0.f, 0.f, static_cast<float>(packet.render_width), static_cast<float>(packet.render_height));
 }
 
 void DeferredShading::update_gui() {
   ImGui::Begin("DeferredShading");
   ImGui::Combo("mode", reinterpret_cast<int*>(&mode_), "Default\0Depth\0Normal\0Ambient\0Diffuse\0Specular\0SpecularPower\0Reconstructed position\0");
+  graph_.update_gui();
   ImGui::TextWrapped("%s", log_.c_str());
   ImGui::End();
 }
 
 void DeferredShading::apply(Scene& scene) {
+  graph_.reset();
+
+  RenderGraph::TextureDesc gbuffer_desc;
+  gbuffer_desc.width = Application::get().screen_width();
+  gbuffer_desc.height = Application::get().screen_height();
+  RenderGraph::TextureDesc ds_desc = gbuffer_desc;
+  ds_desc.internal_format = GL_DEPTH24_STENCIL8;
+  const auto ds = graph_.create_texture("ds", ds_desc);
+  const RenderGraph::Handle g[4] = {
+    graph_.create_texture("g0", gbuffer_desc),
+    graph_.create_texture("g1", gbuffer_desc),
+    graph_.create_texture("g2", gbuffer_desc),
+    graph_.create_texture("g3", gbuffer_desc),
+  };
+
   // パス0
-  {
-    // Gバッファをレンダターゲットにバインドする
-    fb_.bind(GL_DRAW_FRAMEBUFFER);
+  graph_.add_pass("G-Buffer", [this, &scene](const RenderGraph&) {
     viewport_.apply();
 
     // レンダターゲットをクリアする
@@ -138,15 +128,20 @@ void DeferredShading::apply(Scene& scene) {
     util::depth_test_dss().apply();
 
     // リソースをバインドする
-    constant_ub_.bind_base(GL_UNIFORM_BUFFER, 15);
+    constant_range_.bind(GL_UNIFORM_BUFFER, 15);
 
     // シーンを描画する
     scene.apply(ApplyType::SHADE);
     scene.draw(DrawType::OPAQUE);
-  }
+  })
+      .depth(ds)
+      .color(0, g[0])
+      .color(1, g[1])
+      .color(2, g[2])
+      .color(3, g[3]);
 
   // パス1
-  {
+  graph_.add_pass("Lighting", [this, &scene, ds, g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3]](const RenderGraph& graph) {
     // MRTを解除する
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
     util::screen_viewport().apply();
@@ -161,17 +156,17 @@ void DeferredShading::apply(Scene& scene) {
     util::default_dss().apply();
 
     // リソースをバインドする
-    constant_ub_.bind_base(GL_UNIFORM_BUFFER, 15);
-    ds_tex_.active(8, GL_TEXTURE_2D);
-    ss_.bind(8);
-    g0_tex_.active(9, GL_TEXTURE_2D);
-    ss_.bind(9);
-    g1_tex_.active(10, GL_TEXTURE_2D);
-    ss_.bind(10);
-    g2_tex_.active(11, GL_TEXTURE_2D);
-    ss_.bind(11);
-    g3_tex_.active(12, GL_TEXTURE_2D);
-    ss_.bind(12);
+    constant_range_.bind(GL_UNIFORM_BUFFER, 15);
+    graph.texture(ds).active(8, GL_TEXTURE_2D);
+    ss_->bind(8);
+    graph.texture(g0).active(9, GL_TEXTURE_2D);
+    ss_->bind(9);
+    graph.texture(g1).active(10, GL_TEXTURE_2D);
+    ss_->bind(10);
+    graph.texture(g2).active(11, GL_TEXTURE_2D);
+    ss_->bind(11);
+    graph.texture(g3).active(12, GL_TEXTURE_2D);
+    ss_->bind(12);
 
     // ライトボリュームを描画する
     if (mode_ == Mode::DEFAULT) {
@@ -183,6 +178,14 @@ void DeferredShading::apply(Scene& scene) {
       util::screen_quad_vao().bind();
       util::draw_screen_quad();
     }
-  }
+  })
+      .read(ds, RenderGraph::Access::SAMPLED)
+      .read(g[0], RenderGraph::Access::SAMPLED)
+      .read(g[1], RenderGraph::Access::SAMPLED)
+      .read(g[2], RenderGraph::Access::SAMPLED)
+      .read(g[3], RenderGraph::Access::SAMPLED)
+      .side_effect();
+
+  graph_.execute();
 }
 }  // namespace rtrdemo::tech
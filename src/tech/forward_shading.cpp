@@ -2,7 +2,9 @@
 #include <gsl/gsl>
 #include <imgui.h>
 #include <rtdemo/logging.hpp>
+#include <rtdemo/gpu_profiler.hpp>
 #include <rtdemo/util.hpp>
+#include <rtdemo/upload_ring.hpp>
 
 namespace rtdemo::tech {
 RT_MANAGED_TECHNIQUE(ForwardShading);
@@ -27,10 +29,9 @@ bool ForwardShading::restore() {
   prog_ = util::link_program(vert, frag, &log_);
   if (!prog_) return false;
 
-  // リソースを生成する
-  constant_ub_.gen();
-  constant_ub_.bind(GL_UNIFORM_BUFFER);
-  glBufferStorage(GL_UNIFORM_BUFFER, 1024, nullptr, GL_MAP_WRITE_BIT);
+  // GPUメモリの使用量を見積もる
+  // 定数はリングバッファに書き込むので、GPUメモリを持たない
+  memory_usage_ = 0;
 
   log_ = "成功";
 
@@ -39,19 +40,21 @@ bool ForwardShading::restore() {
 }
 
 bool ForwardShading::invalidate() {
+  memory_usage_ = 0;
   prog_.del();
-  constant_ub_.del();
   log_ = "利用不可";
   return true;
 }
 
-void ForwardShading::update() {
-  constant_ub_.bind(GL_UNIFORM_BUFFER);
-  auto constant = reinterpret_cast<Constant*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, sizeof(Mode), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
-  if (constant) {
-    constant->mode = mode_;
-    glUnmapBuffer(GL_UNIFORM_BUFFER);
-  }
+void ForwardShading::update(FramePacket& packet) {
+  Constant constant{};
+  constant.mode = mode_;
+  packet.set_technique_constant(constant);
+}
+
+void ForwardShading::upload(const FramePacket& packet) {
+  constant_range_ = util::UploadRing::get().allocate(GL_UNIFORM_BUFFER, sizeof(Constant));
+  if (constant_range_) *static_cast<Constant*>(constant_range_.data) = packet.get_technique_constant<Constant>();
 }
 
 void ForwardShading::update_gui() {
@@ -62,6 +65,8 @@ void ForwardShading::update_gui() {
 }
 
 void ForwardShading::apply(Scene& scene) {
+  RT_GPU_SCOPE("Shading");
+
   // バックバッファをレンダターゲットにセットする
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
   util::screen_viewport().apply();
@@ -76,7 +81,7 @@ void ForwardShading::apply(Scene& scene) {
   util::depth_test_dss().apply();
 
   // リソースをバインドする
-  constant_ub_.bind_base(GL_UNIFORM_BUFFER, 15);
+  constant_range_.bind(GL_UNIFORM_BUFFER, 15);
 
   // シーンを描画する
   scene.apply(ApplyType::SHADE);
@@ -2,7 +2,9 @@
 #include <gsl/gsl>
 #include <imgui.h>
 #include <rtdemo/logging.hpp>
+#include <rtdemo/gpu_profiler.hpp>
 #include <rtdemo/util.hpp>
+#include <rtdemo/upload_ring.hpp>
 
 namespace rtdemo::tech {
 RT_MANAGED_TECHNIQUE(ShadowMapping);
@@ -39,20 +41,8 @@ bool ShadowMapping::restore() {
   if (!p1_prog_) return false;
 
   // リソースを生成する
-  constant_ub_.gen();
-  constant_ub_.bind(GL_UNIFORM_BUFFER);
-  glBufferStorage(GL_UNIFORM_BUFFER, sizeof(Constant), nullptr, GL_MAP_WRITE_BIT);
-
-  const GLuint shadow_map_width = 1024;
-  const GLuint shadow_map_height = 1024;
-  depth_tex_.gen();
-  depth_tex_.bind(GL_TEXTURE_2D);
-  glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT16, shadow_map_width, shadow_map_height);
-
-  p0_fbo_ =
-      garie::FramebufferBuilder().depth_texture(depth_tex_).build();
-
-  p0_viewport_ = garie::Viewport(0.f, 0.f, shadow_map_width, shadow_map_height);
+  // シャドウマップはレンダグラフの一時テクスチャにする
+  p0_viewport_ = garie::Viewport(0.f, 0.f, SHADOW_MAP_WIDTH, SHADOW_MAP_HEIGHT);
 
   const float border_color[4] = {1.f, 1.f, 1.f, 1.f};
   ss_ = garie::SamplerBuilder()
@@ -61,7 +51,11 @@ bool ShadowMapping::restore() {
       .wrap_s(GL_CLAMP_TO_BORDER)
       .wrap_t(GL_CLAMP_TO_BORDER)
       .border_color(border_color)
-      .build();
+      .build_shared();
+
+  // GPUメモリの使用量を見積もる
+  // 定数はリングバッファに置くので、持っているのはサンプラだけ
+  memory_usage_ = 0;
 
   log_ = "成功";
 
@@ -70,39 +64,45 @@ bool ShadowMapping::restore() {
 }
 
 bool ShadowMapping::invalidate() {
-  ss_.del();
-  p0_fbo_.del();
-  depth_tex_.del();
-  constant_ub_.del();
+  memory_usage_ = 0;
+  ss_.reset();
+  graph_.reset();
   p0_prog_.del();
   p1_prog_.del();
   log_ = "利用不可";
   return true;
 }
 
-void ShadowMapping::update() {
-  constant_ub_.bind(GL_UNIFORM_BUFFER);
-  auto constant = reinterpret_cast<Constant*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, sizeof(Constant), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
-  if (constant) {
-    *constant = constant_;
-    glUnmapBuffer(GL_UNIFORM_BUFFER);
-  }
+void ShadowMapping::update(FramePacket& packet) {
+  packet.set_technique_constant(constant_);
+}
+
+void ShadowMapping::upload(const FramePacket& packet) {
+  constant_range_ = util::UploadRing::get().allocate(GL_UNIFORM_BUFFER, sizeof(Constant));
+  if (constant_range_) *static_cast<Constant*>(constant_range_.data) = packet.get_technique_constant<Constant>();
 }
 
 void ShadowMapping::update_gui() {
   ImGui::Begin("ShadowMapping");
   ImGui::Combo("debug view", reinterpret_cast<int*>(&constant_.mode),
                "Default\0SHADOWED\0");
+  graph_.update_gui();
   // ImGui::DragFloat("Bias * 100", &shadow_bias_, 0.01f, -1.f, 1.f);
   ImGui::TextWrapped("%s", log_.c_str());
   ImGui::End();
 }
 
 void ShadowMapping::apply(Scene& scene) {
+  graph_.reset();
+
+  RenderGraph::TextureDesc shadow_desc;
+  shadow_desc.internal_format = GL_DEPTH_COMPONENT16;
+  shadow_desc.width = SHADOW_MAP_WIDTH;
+  shadow_desc.height = SHADOW_MAP_HEIGHT;
+  const auto shadow = graph_.create_texture("shadow", shadow_desc);
+
   // パス0:シャドウ
-  {
-    // 深度バッファのみのFBOをバインドする
-    p0_fbo_.bind(GL_DRAW_FRAMEBUFFER);
+  graph_.add_pass("Shadow", [this, &scene](const RenderGraph&) {
     p0_viewport_.apply();
 
     // 深度バッファをクリアする
@@ -116,15 +116,15 @@ void ShadowMapping::apply(Scene& scene) {
     util::depth_test_dss().apply();
 
     // リソースをバインドする
-    constant_ub_.bind_base(GL_UNIFORM_BUFFER, 15);
+    constant_range_.bind(GL_UNIFORM_BUFFER, 15);
 
     // シーンを描画する
     scene.apply(ApplyType::SHADOW);
     scene.draw(DrawType::OPAQUE);
-  }
+  }).depth(shadow);
 
   // パス1:シェーディング
-  {
+  graph_.add_pass("Shading", [this, &scene, shadow](const RenderGraph& graph) {
     // バックバッファをターゲットにする
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
     util::screen_viewport().apply();
@@ -139,13 +139,17 @@ void ShadowMapping::apply(Scene& scene) {
     util::depth_test_dss().apply();
 
     // リソースをバインドする
-    constant_ub_.bind_base(GL_UNIFORM_BUFFER, 15);
-    depth_tex_.active(8, GL_TEXTURE_2D);
-    ss_.bind(8);
+    constant_range_.bind(GL_UNIFORM_BUFFER, 15);
+    graph.texture(shadow).active(8, GL_TEXTURE_2D);
+    ss_->bind(8);
 
     // シーンを描画する
     scene.apply(ApplyType::SHADE);
     scene.draw(DrawType::OPAQUE);
-  }
+  })
+      .read(shadow, RenderGraph::Access::SAMPLED)
+      .side_effect();
+
+  graph_.execute();
 }
 }  // namespace rtdemo::tech
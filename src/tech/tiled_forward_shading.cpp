@@ -3,7 +3,9 @@
 #include <gsl/gsl>
 #include <glm/glm.hpp>
 #include <rtdemo/logging.hpp>
+#include <rtdemo/gpu_profiler.hpp>
 #include <rtdemo/util.hpp>
+#include <rtdemo/upload_ring.hpp>
 
 namespace rtdemo::tech {
 RT_MANAGED_TECHNIQUE(TiledForwardShading);
@@ -62,47 +64,21 @@ bool TiledForwardShading::restore() {
   const uint32_t screen_height = Application::get().screen_height();
   tiled_screen_width_ = (screen_width + TILE_WIDTH - 1) / TILE_WIDTH;
   tiled_screen_height_ = (screen_height + TILE_HEIGHT - 1) / TILE_HEIGHT;
-  const uint32_t tiled_screen_size = tiled_screen_width_ * tiled_screen_height_;
 
   // リソースを生成する
-  depth_tex_.gen();
-  depth_tex_.bind(GL_TEXTURE_2D);
-  glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH24_STENCIL8, screen_width, screen_height);
-
-  rt0_tex_.gen();
-  rt0_tex_.bind(GL_TEXTURE_2D);
-  glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, screen_width, screen_height);
-
-  p0_fbo_ = garie::FramebufferBuilder()
-      .depth_texture(depth_tex_)
-      .build();
-
-  p2_fbo_ = garie::FramebufferBuilder()
-      .depth_texture(depth_tex_)
-      .color_texture(0, rt0_tex_)
-      .build();
-
+  // レンダターゲットとタイルごとのバッファはレンダグラフの一時リソースにする
   viewport_ = garie::Viewport(0.f, 0.f, static_cast<float>(screen_width), static_cast<float>(screen_height));
 
-  constant_ubo_.gen();
-  constant_ubo_.bind(GL_UNIFORM_BUFFER);
-  glBufferStorage(GL_UNIFORM_BUFFER, sizeof(Constant), nullptr, GL_MAP_WRITE_BIT);
-
-  tiles_ssbo_.gen();
-  tiles_ssbo_.bind(GL_SHADER_STORAGE_BUFFER);
-  glBufferStorage(GL_SHADER_STORAGE_BUFFER, tiled_screen_size * sizeof(Tile), nullptr, 0);
-
-  light_indices_ssbo_.gen();
-  light_indices_ssbo_.bind(GL_SHADER_STORAGE_BUFFER);
-  glBufferStorage(GL_SHADER_STORAGE_BUFFER, MAX_LIGHT_COUNT * tiled_screen_size * sizeof(uint32_t), nullptr, 0);
-
-  light_index_count_ssbo_.gen();
-  light_index_count_ssbo_.bind(GL_SHADER_STORAGE_BUFFER);
-  glBufferStorage(GL_SHADER_STORAGE_BUFFER, sizeof(uint32_t), nullptr, 0);
+  p3_ss_ = garie::SamplerBuilder()
+      .min_filter(GL_LINEAR)
+      .mag_filter(GL_LINEAR)
+      .wrap_s(GL_CLAMP_TO_EDGE)
+      .wrap_t(GL_CLAMP_TO_EDGE)
+      .build_shared();
 
-  print_ssbo_.gen();
-  print_ssbo_.bind(GL_SHADER_STORAGE_BUFFER);
-  glBufferStorage(GL_SHADER_STORAGE_BUFFER, tiled_screen_size * sizeof(Print), nullptr, 0);
+  // GPUメモリの使用量を見積もる
+  // タイルごとのバッファはプールから借り、定数はリングバッファに書き込む
+  memory_usage_ = 0;
 
   log_ = "成功";
 
@@ -111,50 +87,65 @@ bool TiledForwardShading::restore() {
 }
 
 bool TiledForwardShading::invalidate() {
+  memory_usage_ = 0;
   p0_prog_.del();
   p1_prog_.del();
   p2_prog_.del();
   p3_prog_.del();
-  depth_tex_.del();
-  rt0_tex_.del();
-  p0_fbo_.del();
-  p2_fbo_.del();
-  constant_ubo_.del();
-  tiles_ssbo_.del();
-  light_indices_ssbo_.del();
-  light_index_count_ssbo_.del();
-  print_ssbo_.del();
+  p3_ss_.reset();
+  graph_.reset();
   log_ = "利用不可";
   return true;
 }
 
-void TiledForwardShading::update() {
-  auto& app = Application::get();
-
-  constant_ubo_.bind(GL_UNIFORM_BUFFER);
-  auto constant = reinterpret_cast<Constant*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, sizeof(Constant), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
-  if (constant) {
-    constant->tile_count[0] = (app.screen_width() + TILE_WIDTH - 1) / TILE_WIDTH;
-    constant->tile_count[1] = (app.screen_height() + TILE_HEIGHT - 1) / TILE_HEIGHT;
-    constant->pixel_count[0] = app.screen_width();
-    constant->pixel_count[1] = app.screen_height();
-    constant->mode = mode_;
-    glUnmapBuffer(GL_UNIFORM_BUFFER);
-  }
+void TiledForwardShading::update(FramePacket& packet) {
+  Constant constant{};
+  constant.tile_count[0] = (packet.render_width + TILE_WIDTH - 1) / TILE_WIDTH;
+  constant.tile_count[1] = (packet.render_height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+  constant.pixel_count[0] = packet.render_width;
+  constant.pixel_count[1] = packet.render_height;
+  constant.mode = mode_;
+  packet.set_technique_constant(constant);
+}
+
+void TiledForwardShading::upload(const FramePacket& packet) {
+  constant_range_ = util::UploadRing::get().allocate(GL_UNIFORM_BUFFER, sizeof(Constant));
+  if (constant_range_) *static_cast<Constant*>(constant_range_.data) = packet.get_technique_constant<Constant>();
+
+  // レンダターゲットは画面の大きさで確保したまま、左下の内部解像度の範囲だけに描画する
+  const Constant& c = packet.get_technique_constant<Constant>();
+  viewport_ = garie::Viewport(0.f, 0.f, static_cast<float>(packet.render_width), static_cast<float>(packet.render_height));
+  dispatch_tile_count_[0] = c.tile_count[0];
+  dispatch_tile_count_[1] = c.tile_count[1];
 }
 
 void TiledForwardShading::update_gui() {
   ImGui::Begin("TiledForwardShading");
   ImGui::Combo("debug view", reinterpret_cast<int*>(&mode_), "Default\0Position\0Normal\0Ambient\0Diffuse\0Specular\0SpecularPower\0TileIndex\0TileLightCount\0Shaded\0");
+  graph_.update_gui();
   ImGui::TextWrapped("%s", log_.c_str());
   ImGui::End();
 }
 
 void TiledForwardShading::apply(Scene& scene) {
+  graph_.reset();
+
+  RenderGraph::TextureDesc rt_desc;
+  rt_desc.width = Application::get().screen_width();
+  rt_desc.height = Application::get().screen_height();
+  RenderGraph::TextureDesc depth_desc = rt_desc;
+  depth_desc.internal_format = GL_DEPTH24_STENCIL8;
+  const auto depth = graph_.create_texture("depth", depth_desc);
+  const auto rt0 = graph_.create_texture("rt0", rt_desc);
+
+  const size_t tiled_screen_size = tiled_screen_width_ * tiled_screen_height_;
+  const auto tiles = graph_.create_buffer("tiles", tiled_screen_size * sizeof(Tile));
+  const auto light_indices = graph_.create_buffer("light_indices", MAX_LIGHT_COUNT * tiled_screen_size * sizeof(uint32_t));
+  const auto light_index_count = graph_.create_buffer("light_index_count", sizeof(uint32_t));
+  const auto print = graph_.create_buffer("print", tiled_screen_size * sizeof(Print));
+
   // パス0:Pre-Z
-  {
-    // 深度バッファのみのFBOをバインドする
-    p0_fbo_.bind(GL_DRAW_FRAMEBUFFER);
+  graph_.add_pass("Pre-Z", [this, &scene](const RenderGraph&) {
     viewport_.apply();
 
     // 深度バッファをクリアする
@@ -167,36 +158,39 @@ void TiledForwardShading::apply(Scene& scene) {
     util::depth_test_dss().apply();
 
     // リソースをバインドする
-    constant_ubo_.bind_base(GL_UNIFORM_BUFFER, 15);
+    constant_range_.bind(GL_UNIFORM_BUFFER, 15);
 
     // シーンを描画する
     scene.apply(ApplyType::NO_SHADE);
     scene.draw(DrawType::OPAQUE);
-  }
+  }).depth(depth);
 
   // パス1:ライト割り当て
-  {
+  graph_.add_pass("Light Assignment", [this, &scene, depth, tiles, light_indices, light_index_count, print](const RenderGraph& graph) {
     // パイプラインをバインドする
     p1_prog_.use();
 
     // リソースをバインドする
-    constant_ubo_.bind_base(GL_UNIFORM_BUFFER, 15);
-    depth_tex_.active(8, GL_TEXTURE_2D);
-    tiles_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 8);
-    light_indices_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 9);
-    light_index_count_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 10);
-    print_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 15);
+    constant_range_.bind(GL_UNIFORM_BUFFER, 15);
+    graph.texture(depth).active(8, GL_TEXTURE_2D);
+    graph.buffer(tiles).bind_base(GL_SHADER_STORAGE_BUFFER, 8);
+    graph.buffer(light_indices).bind_base(GL_SHADER_STORAGE_BUFFER, 9);
+    graph.buffer(light_index_count).bind_base(GL_SHADER_STORAGE_BUFFER, 10);
+    graph.buffer(print).bind_base(GL_SHADER_STORAGE_BUFFER, 15);
 
     // ディスパッチ
     scene.apply(ApplyType::LIGHT);
-    glDispatchCompute(tiled_screen_width_, tiled_screen_height_, 1);
-    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-  }
+    glDispatchCompute(dispatch_tile_count_[0], dispatch_tile_count_[1], 1);
+  })
+      .read(depth, RenderGraph::Access::SAMPLED)
+      .write(tiles, RenderGraph::Access::STORAGE_WRITE)
+      .write(light_indices, RenderGraph::Access::STORAGE_WRITE)
+      .write(light_index_count, RenderGraph::Access::STORAGE_WRITE)
+      .write(print, RenderGraph::Access::STORAGE_WRITE);
 
   // パス2:シェーディング
-  {
-    // 深度とカラーを持つFBOをバインドする
-    p2_fbo_.bind(GL_DRAW_FRAMEBUFFER);
+  graph_.add_pass("Shading", [this, &scene, tiles, light_indices, light_index_count](const RenderGraph& graph) {
+    viewport_.apply();
 
     // レンダターゲットをクリアする
     util::clear({0.f, 0.f, 0.f, 0.f});
@@ -208,18 +202,23 @@ void TiledForwardShading::apply(Scene& scene) {
     util::depth_test_no_write_dss().apply();
 
     // リソースをバインドする
-    constant_ubo_.bind_base(GL_UNIFORM_BUFFER, 15);
-    tiles_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 8);
-    light_indices_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 9);
-    light_index_count_ssbo_.bind_base(GL_SHADER_STORAGE_BUFFER, 10);
+    constant_range_.bind(GL_UNIFORM_BUFFER, 15);
+    graph.buffer(tiles).bind_base(GL_SHADER_STORAGE_BUFFER, 8);
+    graph.buffer(light_indices).bind_base(GL_SHADER_STORAGE_BUFFER, 9);
+    graph.buffer(light_index_count).bind_base(GL_SHADER_STORAGE_BUFFER, 10);
 
     // シーンを描画する
     scene.apply(ApplyType::SHADE);
     scene.draw(DrawType::OPAQUE);
-  }
+  })
+      .depth(depth, false)
+      .color(0, rt0)
+      .read(tiles, RenderGraph::Access::STORAGE_READ)
+      .read(light_indices, RenderGraph::Access::STORAGE_READ)
+      .read(light_index_count, RenderGraph::Access::STORAGE_READ);
 
   // パス3:ポストプロセッシング
-  {
+  graph_.add_pass("Post Processing", [this, rt0](const RenderGraph& graph) {
     // バックバッファをフレームバッファにバインドする
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
     util::screen_viewport().apply();
@@ -234,12 +233,17 @@ void TiledForwardShading::apply(Scene& scene) {
     util::default_dss().apply();
 
     // リソースをバインドする
-    constant_ubo_.bind_base(GL_UNIFORM_BUFFER, 15);
-    rt0_tex_.active(8, GL_TEXTURE_2D);
+    constant_range_.bind(GL_UNIFORM_BUFFER, 15);
+    graph.texture(rt0).active(8, GL_TEXTURE_2D);
+    p3_ss_->bind(8);
 
     // 描画する
     util::screen_quad_vao().bind();
     util::draw_screen_quad();
-  }
+  })
+      .read(rt0, RenderGraph::Access::SAMPLED)
+      .side_effect();
+
+  graph_.execute();
 }
 }  // namespace rtrdemo::tech
@@ -3,7 +3,9 @@
 #include <gsl/gsl>
 #include <glm/glm.hpp>
 #include <rtdemo/logging.hpp>
+#include <rtdemo/gpu_profiler.hpp>
 #include <rtdemo/util.hpp>
+#include <rtdemo/upload_ring.hpp>
 
 namespace rtdemo::tech {
 RT_MANAGED_TECHNIQUE(VolumetricFog);
@@ -56,31 +58,12 @@ bool VolumetricFog::restore() {
   if (!p2_prog_) return false;
 
   // froxelの数を計算する
-  const uint32_t screen_width = Application::get().screen_width();
-  const uint32_t screen_height = Application::get().screen_height();
   constant_.froxel_count[0] = 64;
   constant_.froxel_count[1] = 64;
   constant_.froxel_count[2] = 64;
 
-  const uint32_t shadow_width = 1024;
-  const uint32_t shadow_height = 1024;
-
   // リソースを生成する
-  constant_ub_.gen();
-  constant_ub_.bind(GL_UNIFORM_BUFFER);
-  glBufferStorage(GL_UNIFORM_BUFFER, sizeof(Constant), nullptr, GL_MAP_WRITE_BIT);
-
-  shadow_tex_.gen();
-  shadow_tex_.bind(GL_TEXTURE_2D);
-  glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, shadow_width, shadow_height);
-
-  vbuffer_tex_.gen();
-  vbuffer_tex_.bind(GL_TEXTURE_3D);
-  glTexStorage3D(GL_TEXTURE_3D, 1, GL_RGBA32F, constant_.froxel_count[0], constant_.froxel_count[1], constant_.froxel_count[2]);  // TODO:RGBA16Fを使う
-
-  lighting_tex_.gen();
-  lighting_tex_.bind(GL_TEXTURE_3D);
-  glTexStorage3D(GL_TEXTURE_3D, 1, GL_RGBA32F, constant_.froxel_count[0], constant_.froxel_count[1], constant_.froxel_count[2]);
+  // シャドウマップとVバッファはレンダグラフの一時テクスチャにする
 
   lighting_ss_ = garie::SamplerBuilder()
       .min_filter(GL_LINEAR_MIPMAP_NEAREST)
@@ -90,7 +73,7 @@ bool VolumetricFog::restore() {
       .wrap_s(GL_CLAMP_TO_EDGE)
       .wrap_t(GL_CLAMP_TO_EDGE)
       .wrap_r(GL_CLAMP_TO_EDGE)
-      .build();
+      .build_shared();
 
   shadow_ss_ = garie::SamplerBuilder()
       .min_filter(GL_LINEAR_MIPMAP_NEAREST)
@@ -98,12 +81,13 @@ bool VolumetricFog::restore() {
       .wrap_s(GL_CLAMP_TO_EDGE)
       .wrap_t(GL_CLAMP_TO_EDGE)
       .wrap_r(GL_CLAMP_TO_EDGE)
-      .build();
+      .build_shared();
 
-  shadow_fb_ =
-      garie::FramebufferBuilder().depth_texture(shadow_tex_).build();
+  shadow_vp_ = garie::Viewport(0.f, 0.f, SHADOW_WIDTH, SHADOW_HEIGHT);
 
-  shadow_vp_ = garie::Viewport(0.f, 0.f, shadow_width, shadow_height);
+  // GPUメモリの使用量を見積もる
+  // シャドウマップとVバッファはプールのもの、定数はリングバッファのもの
+  memory_usage_ = 0;
 
   log_ = "成功";
 
@@ -112,28 +96,26 @@ bool VolumetricFog::restore() {
 }
 
 bool VolumetricFog::invalidate() {
+  memory_usage_ = 0;
   shadow_prog_.del();
   p0_prog_.del();
   p1_prog_.del();
   p2_prog_.del();
-  shadow_tex_.del();
-  vbuffer_tex_.del();
-  lighting_tex_.del();
-  lighting_ss_.del();
+  lighting_ss_.reset();
+  shadow_ss_.reset();
+  graph_.reset();
   log_ = "利用不可";
   return true;
 }
 
-void VolumetricFog::update() {
-  auto& app = Application::get();
+void VolumetricFog::update(FramePacket& packet) {
+  packet.set_technique_constant(constant_);
+}
 
-  // 定数用バッファを更新する
-  constant_ub_.bind(GL_UNIFORM_BUFFER);
-  auto constant = reinterpret_cast<Constant*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, sizeof(Constant), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
-  if (constant) {
-    *constant = constant_;
-    glUnmapBuffer(GL_UNIFORM_BUFFER);
-  }
+void VolumetricFog::upload(const FramePacket& packet) {
+  // 定数をリングバッファに書き込む
+  constant_range_ = util::UploadRing::get().allocate(GL_UNIFORM_BUFFER, sizeof(Constant));
+  if (constant_range_) *static_cast<Constant*>(constant_range_.data) = packet.get_technique_constant<Constant>();
 }
 
 void VolumetricFog::update_gui() {
@@ -149,15 +131,36 @@ void VolumetricFog::update_gui() {
   ImGui::SliderFloat("fog radius", &constant_.fog_radius, 0.f, 20.f);
   ImGui::SliderFloat3("fog center", constant_.fog_center, -10.f, 10.f);
   ImGui::SliderFloat("fog boundary", &constant_.fog_boundary, 1.f, 20.f);
+  graph_.update_gui();
   ImGui::TextWrapped("%s", log_.c_str());
   ImGui::End();
 }
 
 void VolumetricFog::apply(Scene& scene) {
+  graph_.reset();
+
+  // 表示モードが使わない結果を作るパスは、レンダグラフが除く
+  const Mode mode = constant_.mode;
+  const bool uses_shadow = mode == Mode::DEFAULT || mode == Mode::VLIGHTING;
+  const bool uses_volume = mode == Mode::SCATTERING || mode == Mode::TRANSMITTANCE || mode == Mode::VLIGHTING;
+
+  RenderGraph::TextureDesc shadow_desc;
+  shadow_desc.internal_format = GL_DEPTH_COMPONENT32F;
+  shadow_desc.width = SHADOW_WIDTH;
+  shadow_desc.height = SHADOW_HEIGHT;
+  const auto shadow = graph_.create_texture("shadow", shadow_desc);
+
+  RenderGraph::TextureDesc volume_desc;
+  volume_desc.target = GL_TEXTURE_3D;
+  volume_desc.internal_format = GL_RGBA32F;  // TODO:RGBA16Fを使う
+  volume_desc.width = constant_.froxel_count[0];
+  volume_desc.height = constant_.froxel_count[1];
+  volume_desc.depth = constant_.froxel_count[2];
+  const auto vbuffer = graph_.create_texture("vbuffer", volume_desc);
+  const auto lighting = graph_.create_texture("lighting", volume_desc);
+
   // プリパス:シャドウマップの生成
-  {
-    // 深度バッファのみのFBOをバインドする
-    shadow_fb_.bind(GL_DRAW_FRAMEBUFFER);
+  graph_.add_pass("Shadow Map", [this, &scene](const RenderGraph&) {
     shadow_vp_.apply();
 
     // 深度バッファをクリアする
@@ -171,49 +174,49 @@ void VolumetricFog::apply(Scene& scene) {
     util::depth_test_dss().apply();
 
     // リソースをバインドする
-    constant_ub_.bind_base(GL_UNIFORM_BUFFER, 15);
+    constant_range_.bind(GL_UNIFORM_BUFFER, 15);
 
     // シーンを描画する
     scene.apply(ApplyType::SHADOW);
     scene.draw(DrawType::OPAQUE);
-  }
+  }).depth(shadow);
 
   // パス0:ボリュームのボクセル化
-  {
+  graph_.add_pass("Voxelization", [this, &scene, vbuffer](const RenderGraph& graph) {
     // パイプラインをバインドする
     p0_prog_.use();
 
     // リソースをバインドする
-    constant_ub_.bind_base(GL_UNIFORM_BUFFER, 15);
-    vbuffer_tex_.bind_image(4, GL_WRITE_ONLY, GL_RGBA32F);
+    constant_range_.bind(GL_UNIFORM_BUFFER, 15);
+    graph.texture(vbuffer).bind_image(4, GL_WRITE_ONLY, GL_RGBA32F);
 
     // ディスパッチ
     scene.apply(ApplyType::NO_SHADE);
     glDispatchCompute(constant_.froxel_count[0] / 8, constant_.froxel_count[1] / 8, 1);
-    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-  }
+  }).write(vbuffer, RenderGraph::Access::IMAGE_STORE);
 
   // パス1:ボリューメトリックライティングの計算
-  {
+  graph_.add_pass("Volumetric Lighting", [this, &scene, shadow, vbuffer, lighting](const RenderGraph& graph) {
     // パイプラインをバインドする
     p1_prog_.use();
 
     // リソースをバインドする
-    constant_ub_.bind_base(GL_UNIFORM_BUFFER, 15);
-    // shadow_tex_.bind_image(3, GL_READ_ONLY, GL_R32F);
-    shadow_tex_.active(3, GL_TEXTURE_2D);
-    shadow_ss_.bind(3);
-    vbuffer_tex_.bind_image(4, GL_READ_ONLY, GL_RGBA32F);
-    lighting_tex_.bind_image(5, GL_WRITE_ONLY, GL_RGBA32F);
+    constant_range_.bind(GL_UNIFORM_BUFFER, 15);
+    graph.texture(shadow).active(3, GL_TEXTURE_2D);
+    shadow_ss_->bind(3);
+    graph.texture(vbuffer).bind_image(4, GL_READ_ONLY, GL_RGBA32F);
+    graph.texture(lighting).bind_image(5, GL_WRITE_ONLY, GL_RGBA32F);
 
     // ディスパッチ
     scene.apply(ApplyType::LIGHT_SHADOW);
     glDispatchCompute(constant_.froxel_count[0] / 8, constant_.froxel_count[1] / 8, 1);
-    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-  }
+  })
+      .read(shadow, RenderGraph::Access::SAMPLED)
+      .read(vbuffer, RenderGraph::Access::IMAGE_LOAD)
+      .write(lighting, RenderGraph::Access::IMAGE_STORE);
 
   // パス2:シェーディング
-  {
+  auto shading = graph_.add_pass("Shading", [this, &scene, uses_shadow, uses_volume, shadow, lighting](const RenderGraph& graph) {
     // バックバッファをレンダターゲットにセットする
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     util::screen_viewport().apply();
@@ -228,16 +231,24 @@ void VolumetricFog::apply(Scene& scene) {
     util::depth_test_dss().apply();
 
     // リソースをバインドする
-    constant_ub_.bind_base(GL_UNIFORM_BUFFER, 15);
-    lighting_tex_.active(8, GL_TEXTURE_3D);
-    shadow_tex_.active(9, GL_TEXTURE_2D);
-    lighting_ss_.bind(8);
-    shadow_ss_.bind(9);
-    // lighting_tex_.bind_image(5, GL_WRITE_ONLY, GL_RGBA32F);
+    constant_range_.bind(GL_UNIFORM_BUFFER, 15);
+    if (uses_volume) {
+      graph.texture(lighting).active(8, GL_TEXTURE_3D);
+      lighting_ss_->bind(8);
+    }
+    if (uses_shadow) {
+      graph.texture(shadow).active(9, GL_TEXTURE_2D);
+      shadow_ss_->bind(9);
+    }
 
     // シーンを描画する
     scene.apply(ApplyType::SHADE);
     scene.draw(DrawType::OPAQUE);
-  }
+  });
+  shading.side_effect();
+  if (uses_shadow) shading.read(shadow, RenderGraph::Access::SAMPLED);
+  if (uses_volume) shading.read(lighting, RenderGraph::Access::SAMPLED);
+
+  graph_.execute();
 }
 }  // namespace rtrdemo::tech
@@ -0,0 +1,78 @@
+#include <rtdemo/technique_cache.hpp>
+#include <algorithm>
+#include <imgui.h>
+#include <rtdemo/logging.hpp>
+#include <rtdemo/cpu_profiler.hpp>
+#include <rtdemo/technique.hpp>
+
+namespace rtdemo {
+bool TechniqueCache::acquire(const std::string& name, Technique& technique, bool* restored) {
+  if (restored) *restored = false;
+
+  // 残っていれば、先頭に移すだけでよい
+  auto iter = std::find_if(entries_.begin(), entries_.end(), [&](const Entry& entry) {
+    return entry.technique == &technique;
+  });
+  if (iter != entries_.end()) {
+    entries_.splice(entries_.begin(), entries_, iter);
+    hit_count_++;
+    return true;
+  }
+
+  {
+    RT_CPU_SCOPE("Technique::restore");
+    garie::ResourceTracker::Scope scope("technique:" + name);
+    if (!technique.restore()) return false;
+  }
+  entries_.push_front(Entry{name, &technique});
+  miss_count_++;
+  if (restored) *restored = true;
+  RT_DEBUG("テクニックを用意した (name:{}, memory:{}KiB)", name, technique.memory_usage() >> 10);
+
+  evict();
+  return true;
+}
+
+void TechniqueCache::clear() {
+  for (auto& entry : entries_) {
+    RT_CPU_SCOPE("Technique::invalidate");
+    entry.technique->invalidate();
+  }
+  entries_.clear();
+}
+
+void TechniqueCache::set_budget(size_t budget) {
+  budget_ = budget;
+  evict();
+}
+
+size_t TechniqueCache::memory_usage() const noexcept {
+  size_t usage = 0;
+  for (const auto& entry : entries_) usage += entry.technique->memory_usage();
+  return usage;
+}
+
+void TechniqueCache::update_gui() {
+  int budget_mib = static_cast<int>(budget_ >> 20);
+  if (ImGui::SliderInt("technique budget[MiB]", &budget_mib, 0, 2048)) {
+    set_budget(static_cast<size_t>(budget_mib) << 20);
+  }
+  ImGui::Text("resident:%zu (%zuKiB), hit:%zu, miss:%zu",
+              entries_.size(), memory_usage() >> 10, hit_count_, miss_count_);
+}
+
+void TechniqueCache::evict() {
+  // 先頭は使用中なので破棄しない
+  size_t usage = memory_usage();
+  while (entries_.size() > 1 && usage > budget_) {
+    Entry& entry = entries_.back();
+    usage -= entry.technique->memory_usage();
+    RT_DEBUG("テクニックを破棄した (name:{})", entry.name);
+    {
+      RT_CPU_SCOPE("Technique::invalidate");
+      entry.technique->invalidate();
+    }
+    entries_.pop_back();
+  }
+}
+}  // namespace rtdemo
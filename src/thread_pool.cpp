@@ -0,0 +1,65 @@
+#include <rtdemo/thread_pool.hpp>
+#include <system_error>
+#include <rtdemo/logging.hpp>
+#include <rtdemo/cpu_profiler.hpp>
+
+namespace rtdemo {
+bool ThreadPool::start(size_t thread_count, const std::string& name) {
+  if (!threads_.empty()) return true;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = false;
+  }
+  try {
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+      threads_.emplace_back([this, thread_name = fmt::format("{} {}", name, i)] { run(thread_name); });
+    }
+  } catch (const std::system_error& e) {
+    RT_ERROR("スレッドの起動に失敗した (name:{}, what:{})", name, e.what());
+    stop();
+    return false;
+  }
+  return true;
+}
+
+void ThreadPool::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  cv_.notify_all();
+  for (auto& thread : threads_) thread.join();
+  threads_.clear();
+}
+
+void ThreadPool::push(std::function<void()> task) {
+  if (threads_.empty()) {
+    task();
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+void ThreadPool::run(std::string name) {
+  CpuProfiler::get().set_thread_name(std::move(name));
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] { return quit_ || !tasks_.empty(); });
+    if (tasks_.empty()) break;  // 残りのタスクを実行してから終了する
+
+    auto task = std::move(tasks_.front());
+    tasks_.pop_front();
+    lock.unlock();
+    task();
+    lock.lock();
+  }
+}
+}  // namespace rtdemo
@@ -0,0 +1,105 @@
+#include <rtdemo/upload_ring.hpp>
+#include <algorithm>
+#include <chrono>
+#include <imgui.h>
+#include <rtdemo/gl_trace.hpp>
+#include <rtdemo/logging.hpp>
+
+namespace rtdemo::util {
+UploadRing& UploadRing::get() noexcept {
+  static UploadRing self;
+  return self;
+}
+
+bool UploadRing::init(size_t frame_size) {
+  clear();
+
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment_);
+  glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_alignment_);
+
+  // 領域の境界でもアラインメントが崩れないように切り上げる
+  const size_t alignment = static_cast<size_t>(std::max(uniform_alignment_, storage_alignment_));
+  frame_size_ = (frame_size + alignment - 1) / alignment * alignment;
+
+  constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  garie::ResourceTracker::Scope scope("upload ring");
+  buffer_.gen();
+  buffer_.storage(frame_size_ * MAX_FRAME_COUNT, nullptr, flags);
+  mapped_ = static_cast<uint8_t*>(buffer_.map(0, frame_size_ * MAX_FRAME_COUNT, flags));
+  if (!mapped_) {
+    RT_ERROR("リングバッファをマップできなかった (size:{})", frame_size_ * MAX_FRAME_COUNT);
+    clear();
+    return false;
+  }
+  RT_DEBUG("リングバッファを確保した (size:{}x{})", frame_size_, MAX_FRAME_COUNT);
+  return true;
+}
+
+void UploadRing::clear() {
+  for (auto& region : regions_) {
+    if (region.fence) glDeleteSync(region.fence);
+    region = Region();
+  }
+  if (mapped_) buffer_.unmap();
+  mapped_ = nullptr;
+  buffer_.del();
+  frame_size_ = 0;
+  current_ = 0;
+}
+
+UploadRing::Allocation UploadRing::allocate(GLenum target, size_t size) {
+  if (!mapped_) return Allocation();
+
+  const size_t alignment = static_cast<size_t>(target == GL_SHADER_STORAGE_BUFFER ? storage_alignment_ : uniform_alignment_);
+  Region& region = regions_[current_];
+  const size_t begin = (region.used + alignment - 1) / alignment * alignment;
+  if (begin + size > frame_size_) {
+    if (!overflowed_) RT_ERROR("リングバッファの領域が足りない (size:{}, used:{}/{})", size, region.used, frame_size_);
+    overflowed_ = true;
+    return Allocation();
+  }
+  region.used = begin + size;
+
+  const size_t offset = frame_size_ * current_ + begin;
+  // 記録中は、書き込まれる範囲だけをトレースに残す
+  garie::GlCapture::get().mark_written(mapped_ + offset, size);
+  return Allocation{{&buffer_, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size)}, mapped_ + offset};
+}
+
+void UploadRing::end_frame() {
+  if (!mapped_) return;
+
+  Region& region = regions_[current_];
+  last_used_ = region.used;
+  region.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  overflowed_ = false;
+
+  // 次の領域を前回使ったフレームをGPUが処理し終えるまで待つ
+  // 使う領域を減らしたときは、範囲外になった領域のフェンスを次に使うか破棄するまで残しておく
+  current_ = (current_ + 1) % frame_count_;
+  Region& next = regions_[current_];
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+  const auto begin_tp = std::chrono::steady_clock::now();
+  if (next.fence) {
+    GLenum result = glClientWaitSync(next.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (result == GL_TIMEOUT_EXPIRED) {
+      result = glClientWaitSync(next.fence, 0, 1'000'000);
+    }
+    if (result == GL_WAIT_FAILED) RT_WARN("リングバッファのフェンスを待てなかった");
+    glDeleteSync(next.fence);
+    next.fence = nullptr;
+  }
+  next.used = 0;
+  last_wait_time_ = std::chrono::duration_cast<Milliseconds>(std::chrono::steady_clock::now() - begin_tp).count();
+}
+
+void UploadRing::set_frames_in_flight(uint32_t count) noexcept {
+  frame_count_ = count == 0 ? MAX_FRAME_COUNT : std::min(count + 1, MAX_FRAME_COUNT);
+  // 現在の領域は書き込み中なので、範囲外になっても次のend_frame()まで使い続ける
+}
+
+void UploadRing::update_gui() const {
+  ImGui::Text("upload ring:%zu/%zuKiB x%u, wait:%5.3lf[ms]", last_used_ >> 10, frame_size_ >> 10, frame_count_,
+              last_wait_time_);
+}
+}  // namespace rtdemo::util
@@ -7,6 +7,10 @@
 namespace rtdemo::util {
 namespace {
 std::filesystem::path search_path_ = "./build/assets/shaders";
+garie::VertexArray screen_quad_vao_;  ///< スクリーン全体にまたがる四角形のVAO
+garie::Buffer screen_quad_vbo_;  ///< スクリーン全体にまたがる四角形の頂点バッファ
+garie::VertexArray screen_triangle_vao_;  ///< スクリーン全体にまたがる三角形のVAO
+garie::Buffer screen_triangle_vbo_;  ///< スクリーン全体にまたがる三角形の頂点バッファ
 
 template <GLenum TYPE>
 inline garie::Shader<TYPE> compile_shader_from_file(std::filesystem::path filename,
@@ -153,12 +157,10 @@ garie::Program link_program(const garie::ComputeShader& comp, std::string* log_p
 }
 
 const garie::VertexArray& screen_quad_vao() {
-  static garie::VertexArray vao_;
-  static garie::Buffer vbo_;
-  if (!vao_) {
+  if (!screen_quad_vao_) {
+    garie::ResourceTracker::Scope scope("screen geometry");
     garie::Buffer vbo;
     vbo.gen();
-    vbo.bind(GL_ARRAY_BUFFER);
     const float vertices[] = {
         1.f, 1.f,
         -1.f, -1.f,
@@ -167,17 +169,17 @@ const garie::VertexArray& screen_quad_vao() {
         1.f, 1.f,
         -1.f, 1.f,
     };
-    glBufferStorage(GL_ARRAY_BUFFER, sizeof(vertices), vertices, 0);
+    vbo.storage(sizeof(vertices), vertices, 0);
 
     garie::VertexArray vao = garie::VertexArrayBuilder()
                                  .vertex_buffer(vbo)
                                  .attribute(0, 2, GL_FLOAT, GL_FALSE, 8, 0, 0)
                                  .build();
 
-    vao_ = std::move(vao);
-    vbo_ = std::move(vbo);
+    screen_quad_vao_ = std::move(vao);
+    screen_quad_vbo_ = std::move(vbo);
   }
-  return vao_;
+  return screen_quad_vao_;
 }
 
 void draw_screen_quad() {
@@ -185,123 +187,128 @@ void draw_screen_quad() {
 }
 
 const garie::VertexArray& screen_triangle_vao() {
-  static garie::VertexArray vao_;
-  static garie::Buffer vbo_;
-  if (!vao_) {
+  if (!screen_triangle_vao_) {
+    garie::ResourceTracker::Scope scope("screen geometry");
     garie::Buffer vbo;
     vbo.gen();
-    vbo.bind(GL_ARRAY_BUFFER);
     const float vertices[] = {
         -1.f, -1.f, 3.f, -1.f, -1.f, 3.f,
     };
-    glBufferStorage(GL_ARRAY_BUFFER, sizeof(vertices), vertices, 0);
+    vbo.storage(sizeof(vertices), vertices, 0);
 
     garie::VertexArray vao = garie::VertexArrayBuilder()
                                  .vertex_buffer(vbo)
                                  .attribute(0, 2, GL_FLOAT, GL_FALSE, 8, 0, 0)
                                  .build();
 
-    vao_ = std::move(vao);
-    vbo_ = std::move(vbo);
+    screen_triangle_vao_ = std::move(vao);
+    screen_triangle_vbo_ = std::move(vbo);
   }
-  return vao_;
+  return screen_triangle_vao_;
 }
 
 void draw_screen_triangle() {
   glDrawArrays(GL_TRIANGLES, 0, 3);
 }
 
+void clear_screen_vaos() {
+  screen_quad_vao_.del();
+  screen_quad_vbo_.del();
+  screen_triangle_vao_.del();
+  screen_triangle_vbo_.del();
+}
+
 const garie::RasterizationState& default_rs() {
-  static garie::RasterizationState rs;
+  static const auto& rs = garie::RasterizationStateBuilder().build_shared();
   return rs;
 }
 
 const garie::RasterizationState& discard_rs() {
-  static garie::RasterizationState rs = garie::RasterizationStateBuilder()
+  static const auto& rs = garie::RasterizationStateBuilder()
       .enable_rasterizer_discard()
-      .build();
+      .build_shared();
   return rs;
 }
 
 const garie::RasterizationState& backface_rs() {
-  static auto rs = garie::RasterizationStateBuilder()
+  static const auto& rs = garie::RasterizationStateBuilder()
       .front_face(GL_CW)
-      .build();
+      .build_shared();
   return rs;
 }
 
 const garie::ColorBlendState& default_bs() {
-  static garie::ColorBlendState bs;
+  static const auto& bs = garie::ColorBlendStateBuilder().build_shared();
   return bs;
 }
 
 const garie::ColorBlendState& alpha_blending_bs() {
-  static garie::ColorBlendState bs =
+  static const auto& bs =
       garie::ColorBlendStateBuilder()
           .enable(0, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_FUNC_ADD,
                   GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_FUNC_ADD,
                   {GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE})
-          .build();
+          .build_shared();
   return bs;
 }
 
 const garie::ColorBlendState& additive_bs() {
-  static garie::ColorBlendState bs =
+  static const auto& bs =
       garie::ColorBlendStateBuilder()
           .enable(0, GL_ONE, GL_ONE, GL_FUNC_ADD, GL_ONE, GL_ONE, GL_FUNC_ADD,
                   {GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE})
-          .build();
+          .build_shared();
   return bs;
 }
 
 const garie::DepthStencilState& default_dss() {
-  static garie::DepthStencilState dss;
+  static const auto& dss = garie::DepthStencilStateBuilder().build_shared();
   return dss;
 }
 
 const garie::DepthStencilState& depth_test_dss() {
-  static garie::DepthStencilState dss =
+  static const auto& dss =
       garie::DepthStencilStateBuilder()
           .enable_depth_test(GL_LESS)
           .enable_depth_write()
           .enable_depth_bounds_test(0.f, 1.f)
-          .build();
+          .build_shared();
   return dss;
 }
 
 const garie::DepthStencilState& depth_test_no_write_dss() {
-  static garie::DepthStencilState dss =
+  static const auto& dss =
       garie::DepthStencilStateBuilder()
           .enable_depth_test(GL_LEQUAL)
           .enable_depth_bounds_test(0.f, 1.f)
-          .build();
+          .build_shared();
   return dss;
 }
 
 void clear(std::array<float, 4> color) {
-  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  garie::StateCache::get().color_mask({GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE});
   glClearColor(color[0], color[1], color[2], color[3]);
   glClear(GL_COLOR_BUFFER_BIT);
 }
 
 void clear(float depth) {
-  glDepthMask(GL_TRUE);
+  garie::StateCache::get().depth_mask(GL_TRUE);
   glClearDepthf(depth);
   glClear(GL_DEPTH_BUFFER_BIT);
 }
 
 void clear(std::array<float, 4> color, float depth) {
-  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-  glDepthMask(GL_TRUE);
+  garie::StateCache::get().color_mask({GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE});
+  garie::StateCache::get().depth_mask(GL_TRUE);
   glClearColor(color[0], color[1], color[2], color[3]);
   glClearDepthf(depth);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
 void clear(std::array<float, 4> color, float depth, GLint stencil) {
-  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-  glDepthMask(GL_TRUE);
-  glStencilMask(GL_TRUE);
+  garie::StateCache::get().color_mask({GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE});
+  garie::StateCache::get().depth_mask(GL_TRUE);
+  garie::StateCache::get().stencil_mask(GL_FRONT_AND_BACK, GL_TRUE);
   glClearColor(color[0], color[1], color[2], color[3]);
   glClearDepthf(depth);
   glClearStencil(stencil);
@@ -317,4 +324,13 @@ garie::Scissor screen_scissor() {
   auto& app = Application::get();
   return garie::Scissor(0, 0, app.screen_width(), app.screen_height());
 }
+
+size_t texture_memory_size(GLenum internal_format, size_t width, size_t height, size_t depth) {
+  size_t texel_size = garie::detail::texel_size(internal_format);
+  if (texel_size == 0) {
+    RT_WARN("テクセルのサイズが不明な内部フォーマット (internal_format:{:#x})", internal_format);
+    texel_size = 4;
+  }
+  return texel_size * width * height * depth;
+}
 }  // namespace rtdemo::util
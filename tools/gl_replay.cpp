@@ -0,0 +1,250 @@
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <cstdlib>
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <rtdemo/logging.hpp>
+#include <rtdemo/frame_stats.hpp>
+#include <rtdemo/gl_trace.hpp>
+
+using namespace rtdemo;
+
+// ベンチマークモードで記録したGLのトレースを、アプリケーションを介さずに再生して時間を計測する
+
+namespace {
+/**
+ * @brief コマンドライン引数で指定できる設定
+ */
+struct Options {
+  std::filesystem::path trace_path;  ///< 再生するトレースファイル
+  bool cadence = false;  ///< 記録したときの間隔でフレームを再生するか
+  bool count_gl_calls = false;  ///< GLの呼び出し回数を数えるか
+  double frame_budget = 1000.0 / 60.0;  ///< ヒッチとみなすフレーム時間[ms]
+};
+
+/**
+ * @brief surfacelessプラットフォームのEGLコンテキスト
+ */
+struct EglContext {
+  EGLDisplay display = EGL_NO_DISPLAY;  ///< ディスプレイ
+  EGLContext context = EGL_NO_CONTEXT;  ///< コンテキスト
+  EGLSurface surface = EGL_NO_SURFACE;  ///< バックバッファの代わりのpbuffer
+
+  ~EglContext() {
+    if (display == EGL_NO_DISPLAY) return;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+    if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+    eglTerminate(display);
+  }
+
+  /**
+   * @brief コンテキストを生成してバインドし、GLEWを初期化する
+   * 
+   * llvmpipeなどのソフトウェアラスタライザでも動くように、拡張は要求しない。
+   */
+  bool init(uint32_t width, uint32_t height) {
+    const auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (get_platform_display) {
+      display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+      RT_ERROR("EGLの初期化に失敗した (error:{:#x})", eglGetError());
+      display = EGL_NO_DISPLAY;
+      return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+      RT_ERROR("OpenGL APIのバインドに失敗した (error:{:#x})", eglGetError());
+      return false;
+    }
+
+    const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_STENCIL_SIZE, 8,
+        EGL_NONE,
+    };
+    EGLConfig config = nullptr;
+    EGLint config_count = 0;
+    if (!eglChooseConfig(display, config_attribs, &config, 1, &config_count) || config_count == 0) {
+      RT_ERROR("EGLコンフィグの選択に失敗した (error:{:#x})", eglGetError());
+      return false;
+    }
+
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+    if (context == EGL_NO_CONTEXT) {
+      RT_ERROR("EGLコンテキストの生成に失敗した (error:{:#x})", eglGetError());
+      return false;
+    }
+
+    const EGLint surface_attribs[] = {
+        EGL_WIDTH, static_cast<EGLint>(width),
+        EGL_HEIGHT, static_cast<EGLint>(height),
+        EGL_NONE,
+    };
+    surface = eglCreatePbufferSurface(display, config, surface_attribs);
+    if (surface == EGL_NO_SURFACE) {
+      RT_ERROR("pbufferの生成に失敗した (error:{:#x})", eglGetError());
+      return false;
+    }
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+      RT_ERROR("EGLコンテキストのバインドに失敗した (error:{:#x})", eglGetError());
+      return false;
+    }
+
+    // GLXを持たない環境ではGLX拡張の初期化に失敗するが、GLの関数は読み込まれている
+    glewExperimental = GL_TRUE;
+    const GLenum glew_result = glewInit();
+    if (glew_result != GLEW_OK && glew_result != GLEW_ERROR_NO_GLX_DISPLAY) {
+      RT_ERROR("GLEWの初期化に失敗した (error:{})", glew_result);
+      return false;
+    }
+    return true;
+  }
+};
+
+void print_usage(const char* program) {
+  fmt::print(
+      "usage: {} TRACE [options]\n"
+      "  --cadence            記録したときの間隔でフレームを再生する。指定しなければできるだけ速く再生する\n"
+      "  --count-gl-calls     GLの呼び出し回数を関数ごとに数える\n"
+      "  --budget MS          ヒッチとみなすフレーム時間 (既定値:16.667)\n",
+      program);
+}
+
+/**
+ * @brief コマンドライン引数を解析する
+ * 
+ * @return true 成功した
+ * @return false 失敗した
+ */
+bool parse_options(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--cadence") {
+      options.cadence = true;
+    } else if (arg == "--count-gl-calls") {
+      options.count_gl_calls = true;
+    } else if (arg == "--budget") {
+      if (i + 1 >= argc) {
+        RT_ERROR("引数の値がない (option:{})", arg);
+        return false;
+      }
+      try {
+        options.frame_budget = std::stod(argv[++i]);
+      } catch (const std::exception&) {
+        RT_ERROR("引数の値が数値ではない (option:{}, value:{})", arg, argv[i]);
+        return false;
+      }
+    } else if (!arg.starts_with("--") && options.trace_path.empty()) {
+      options.trace_path = argv[i];
+    } else {
+      RT_ERROR("不明な引数 (arg:{})", arg);
+      return false;
+    }
+  }
+
+  if (options.trace_path.empty()) {
+    RT_ERROR("トレースファイルが必要");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief トレースを再生して結果を表示する
+ */
+bool replay(const Options& options) {
+  using Clock = std::chrono::steady_clock;
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+
+  garie::GlReplayer replayer;
+  if (!replayer.open(options.trace_path)) return false;
+
+  EglContext context;
+  if (!context.init(replayer.width(), replayer.height())) return false;
+  garie::GlDispatch::get().select(garie::GlDispatch::Backend::REAL, options.count_gl_calls);
+  if (!garie::GlDispatch::get().load()) return false;
+  RT_DEBUG("再生を始める (renderer:{})", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+
+  // 準備の部分は計測しない
+  if (!replayer.replay_setup()) return false;
+  glFinish();
+
+  FrameStats cpu_stats;
+  FrameStats frame_stats;
+  cpu_stats.set_budget(options.frame_budget);
+  frame_stats.set_budget(options.frame_budget);
+  uint64_t gl_call_sum = 0;
+
+  const auto begin_tp = Clock::now();
+  auto last_tp = begin_tp;
+  uint64_t timestamp = 0;
+  while (true) {
+    const auto frame_begin_tp = Clock::now();
+    if (!replayer.replay_frame(timestamp)) break;
+    const auto frame_end_tp = Clock::now();
+    garie::GlDispatch::get().end_frame();
+    gl_call_sum += garie::GlDispatch::get().last_call_count();
+
+    // 記録したときのフレームの終わりまで待つ
+    if (options.cadence) std::this_thread::sleep_until(begin_tp + std::chrono::nanoseconds(timestamp));
+
+    const auto now_tp = Clock::now();
+    cpu_stats.add(std::chrono::duration_cast<Milliseconds>(frame_end_tp - frame_begin_tp).count());
+    frame_stats.add(std::chrono::duration_cast<Milliseconds>(now_tp - last_tp).count());
+    last_tp = now_tp;
+  }
+  if (replayer.failed()) return false;
+
+  // GPUが終わるまでを全体の時間に含める
+  glFinish();
+  const double total_time = std::chrono::duration_cast<Milliseconds>(Clock::now() - begin_tp).count();
+
+  const auto print_summary = [](const char* name, const FrameStats::Summary& summary) {
+    fmt::print("{:<6} mean:{:8.3f} min:{:8.3f} p50:{:8.3f} p95:{:8.3f} p99:{:8.3f} max:{:8.3f} hitches:{}\n",
+               name, summary.mean, summary.min, summary.p50, summary.p95, summary.p99, summary.max, summary.hitch_count);
+  };
+  const auto frame_summary = frame_stats.summary();
+  fmt::print("frames:{}, total:{:.3f}[ms]\n", frame_summary.count, total_time);
+  print_summary("cpu", cpu_stats.summary());
+  print_summary("frame", frame_summary);
+  if (options.count_gl_calls && frame_summary.count > 0) {
+    fmt::print("gl calls:{:.1f}/frame\n", static_cast<double>(gl_call_sum) / frame_summary.count);
+  }
+  return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (!Logger::get().init(spdlog::level::trace)) return EXIT_FAILURE;
+  Logger::get().set_pause_on_terminate(false);
+
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    print_usage(argv[0]);
+    Logger::get().terminate();
+    return EXIT_FAILURE;
+  }
+
+  const bool succeeded = replay(options);
+  Logger::get().terminate();
+  return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}